@@ -1,171 +1,721 @@
 #include "colorquantizer.hpp"
 #include <algorithm>
+#include <cmath>
+#include <optional>
 #include <utility>
+#include <vector>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 #include <qatomic.h>
+#include <qbytearray.h>
 #include <qcolor.h>
+#include <qcryptographichash.h>
+#include <qdatastream.h>
 #include <qdatetime.h>
+#include <qdir.h>
+#include <qfile.h>
+#include <qfiledevice.h>
+#include <qfileinfo.h>
 #include <qimage.h>
+#include <qimagereader.h>
+#include <qiodevice.h>
 #include <qlist.h>
 #include <qlogging.h>
 #include <qloggingcategory.h>
 #include <qminmax.h>
+#include <qmutex.h>
 #include <qnamespace.h>
 #include <qnumeric.h>
 #include <qobject.h>
+#include <qpoint.h>
 #include <qqmllist.h>
 #include <qrect.h>
 #include <qrgb.h>
+#include <qsavefile.h>
+#include <qscopeguard.h>
+#include <qsemaphore.h>
+#include <qsize.h>
+#include <qstring.h>
+#include <qthread.h>
 #include <qthreadpool.h>
 #include <qtmetamacros.h>
 #include <qtypes.h>
 
+#include "colorquantizer_p.hpp"
 #include "logcat.hpp"
+#include "paths.hpp"
 
 namespace {
 QS_LOGGING_CATEGORY(logColorQuantizer, "quickshell.colorquantizer", QtWarningMsg);
 }
 
+namespace qs::colorquantizer {
+
+namespace {
+
+constexpr quint32 CHANNEL_SHIFTS[3] = {16, 8, 0};
+
+quint8 channel(QRgb pixel, quint32 shift) { return static_cast<quint8>(pixel >> shift); }
+
+void medianCutStep(
+    QRgb* begin,
+    QRgb* end,
+    qreal depth,
+    qreal maxDepth,
+    const QAtomicInteger<bool>& shouldCancel,
+    QList<QColor>& result
+) {
+	if (begin == end || shouldCancel.loadAcquire()) return;
+
+	if (depth >= maxDepth) {
+		auto sums = channelSums(begin, end);
+		auto count = static_cast<double>(end - begin);
+
+		result.append(QColor(
+		    qRound(static_cast<double>(sums.r) / count),
+		    qRound(static_cast<double>(sums.g) / count),
+		    qRound(static_cast<double>(sums.b) / count)
+		));
+
+		return;
+	}
+
+	auto range = channelRange(begin, end);
+	auto dominant = 0;
+	auto biggestRange = 0;
+
+	// ties prefer r, then g, then b
+	for (auto i = 0; i != 3; i++) {
+		auto spread = range.max[i] - range.min[i];
+		if (spread > biggestRange) {
+			biggestRange = spread;
+			dominant = i;
+		}
+	}
+
+	auto shift = CHANNEL_SHIFTS[dominant];
+	auto* mid = begin + (end - begin) / 2;
+
+	// Only the split point matters, a full sort of each half is wasted work.
+	std::nth_element(begin, mid, end, [shift](QRgb a, QRgb b) {
+		return channel(a, shift) < channel(b, shift);
+	});
+
+	medianCutStep(begin, mid, depth + 1, maxDepth, shouldCancel, result);
+	medianCutStep(mid, end, depth + 1, maxDepth, shouldCancel, result);
+}
+
+} // namespace
+
+ChannelRange channelRange(const QRgb* begin, const QRgb* end) {
+	auto range = ChannelRange();
+
+	auto fold = [&range](QRgb pixel) {
+		for (auto i = 0; i != 3; i++) {
+			auto value = channel(pixel, CHANNEL_SHIFTS[i]);
+			range.min[i] = qMin(range.min[i], value);
+			range.max[i] = qMax(range.max[i], value);
+		}
+	};
+
+	const auto* pixel = begin;
+
+#ifdef __SSE2__
+	// Bytewise min/max over 4 pixels at a time keeps each channel in its own lane.
+	auto vmin = _mm_set1_epi8(static_cast<char>(0xff));
+	auto vmax = _mm_setzero_si128();
+
+	for (; end - pixel >= 4; pixel += 4) {
+		auto v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pixel)); // NOLINT
+		vmin = _mm_min_epu8(vmin, v);
+		vmax = _mm_max_epu8(vmax, v);
+	}
+
+	alignas(16) QRgb lanes[8];
+	_mm_store_si128(reinterpret_cast<__m128i*>(lanes), vmin);     // NOLINT
+	_mm_store_si128(reinterpret_cast<__m128i*>(lanes + 4), vmax); // NOLINT
+
+	if (pixel != begin) {
+		for (auto i = 0; i != 3; i++) {
+			auto shift = CHANNEL_SHIFTS[i];
+
+			range.min[i] = qMin(
+			    qMin(channel(lanes[0], shift), channel(lanes[1], shift)),
+			    qMin(channel(lanes[2], shift), channel(lanes[3], shift))
+			);
+
+			range.max[i] = qMax(
+			    qMax(channel(lanes[4], shift), channel(lanes[5], shift)),
+			    qMax(channel(lanes[6], shift), channel(lanes[7], shift))
+			);
+		}
+	}
+#endif
+
+	for (; pixel != end; ++pixel) fold(*pixel);
+
+	return range;
+}
+
+ChannelSums channelSums(const QRgb* begin, const QRgb* end) {
+	auto sums = ChannelSums();
+	const auto* pixel = begin;
+
+#ifdef __SSE2__
+	// Masking out all but one channel and summing absolute differences against zero
+	// adds up that channel for 2 pixels per 64 bit lane without overflow concerns.
+	auto zero = _mm_setzero_si128();
+	auto maskR = _mm_set1_epi32(0x00ff0000);
+	auto maskG = _mm_set1_epi32(0x0000ff00);
+	auto maskB = _mm_set1_epi32(0x000000ff);
+	auto accR = _mm_setzero_si128();
+	auto accG = _mm_setzero_si128();
+	auto accB = _mm_setzero_si128();
+
+	for (; end - pixel >= 4; pixel += 4) {
+		auto v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pixel)); // NOLINT
+		accR = _mm_add_epi64(accR, _mm_sad_epu8(_mm_and_si128(v, maskR), zero));
+		accG = _mm_add_epi64(accG, _mm_sad_epu8(_mm_and_si128(v, maskG), zero));
+		accB = _mm_add_epi64(accB, _mm_sad_epu8(_mm_and_si128(v, maskB), zero));
+	}
+
+	alignas(16) quint64 lanes[6];
+	_mm_store_si128(reinterpret_cast<__m128i*>(lanes), accR);     // NOLINT
+	_mm_store_si128(reinterpret_cast<__m128i*>(lanes + 2), accG); // NOLINT
+	_mm_store_si128(reinterpret_cast<__m128i*>(lanes + 4), accB); // NOLINT
+
+	sums.r = lanes[0] + lanes[1];
+	sums.g = lanes[2] + lanes[3];
+	sums.b = lanes[4] + lanes[5];
+#endif
+
+	for (; pixel != end; ++pixel) {
+		sums.r += qRed(*pixel);
+		sums.g += qGreen(*pixel);
+		sums.b += qBlue(*pixel);
+	}
+
+	return sums;
+}
+
+QList<QColor> medianCut(
+    QRgb* begin,
+    QRgb* end,
+    qreal maxDepth,
+    const QAtomicInteger<bool>& shouldCancel
+) {
+	QList<QColor> result;
+	if (begin == end) return result;
+
+	auto levels = qBound(0, static_cast<int>(std::ceil(maxDepth)), 24);
+	result.reserve(qMin(static_cast<qsizetype>(1) << levels, static_cast<qsizetype>(end - begin)));
+
+	medianCutStep(begin, end, 0, maxDepth, shouldCancel, result);
+
+	if (shouldCancel.loadAcquire()) return QList<QColor>();
+	return result;
+}
+
+ColorHistogram::ColorHistogram(): bins(BIN_COUNT) {}
+
+void ColorHistogram::add(const QRgb* begin, const QRgb* end) {
+	for (const auto* pixel = begin; pixel != end; ++pixel) {
+		if (qAlpha(*pixel) == 0) continue;
+		this->add(*pixel);
+	}
+}
+
+void ColorHistogram::merge(const ColorHistogram& other) {
+	for (auto i = 0; i != BIN_COUNT; i++) {
+		auto& bin = this->bins[i];
+		const auto& otherBin = other.bins.at(i);
+		bin.count += otherBin.count;
+		bin.r += otherBin.r;
+		bin.g += otherBin.g;
+		bin.b += otherBin.b;
+	}
+}
+
+namespace {
+
+struct HistogramCell {
+	quint8 coord[3] = {0, 0, 0};
+	quint64 count = 0;
+	quint64 sum[3] = {0, 0, 0};
+};
+
+void histogramCutStep(
+    HistogramCell* begin,
+    HistogramCell* end,
+    qreal depth,
+    qreal maxDepth,
+    const QAtomicInteger<bool>& shouldCancel,
+    QList<QColor>& result
+) {
+	if (begin == end || shouldCancel.loadAcquire()) return;
+
+	if (depth >= maxDepth || end - begin == 1) {
+		quint64 count = 0;
+		quint64 sum[3] = {0, 0, 0};
+
+		for (const auto* cell = begin; cell != end; ++cell) {
+			count += cell->count;
+			for (auto i = 0; i != 3; i++) sum[i] += cell->sum[i];
+		}
+
+		auto divisor = static_cast<double>(count);
+
+		result.append(QColor(
+		    qRound(static_cast<double>(sum[0]) / divisor),
+		    qRound(static_cast<double>(sum[1]) / divisor),
+		    qRound(static_cast<double>(sum[2]) / divisor)
+		));
+
+		return;
+	}
+
+	quint8 min[3] = {31, 31, 31};
+	quint8 max[3] = {0, 0, 0};
+	quint64 total = 0;
+
+	for (const auto* cell = begin; cell != end; ++cell) {
+		for (auto i = 0; i != 3; i++) {
+			min[i] = qMin(min[i], cell->coord[i]);
+			max[i] = qMax(max[i], cell->coord[i]);
+		}
+
+		total += cell->count;
+	}
+
+	auto dominant = 0;
+	auto biggestRange = 0;
+
+	// ties prefer r, then g, then b
+	for (auto i = 0; i != 3; i++) {
+		auto spread = max[i] - min[i];
+		if (spread > biggestRange) {
+			biggestRange = spread;
+			dominant = i;
+		}
+	}
+
+	std::sort(begin, end, [dominant](const HistogramCell& a, const HistogramCell& b) {
+		return a.coord[dominant] < b.coord[dominant];
+	});
+
+	// Split at the pixel weighted median, keeping at least one cell on each side.
+	auto* mid = begin;
+	quint64 accumulated = 0;
+	while (mid != end - 1) {
+		accumulated += mid->count;
+		++mid;
+		if (accumulated * 2 >= total) break;
+	}
+
+	histogramCutStep(begin, mid, depth + 1, maxDepth, shouldCancel, result);
+	histogramCutStep(mid, end, depth + 1, maxDepth, shouldCancel, result);
+}
+
+} // namespace
+
+QList<QColor>
+ColorHistogram::medianCut(qreal maxDepth, const QAtomicInteger<bool>& shouldCancel) const {
+	auto cells = QList<HistogramCell>();
+
+	for (auto i = 0; i != BIN_COUNT; i++) {
+		const auto& bin = this->bins.at(i);
+		if (bin.count == 0) continue;
+
+		auto& cell = cells.emplaceBack();
+		cell.coord[0] = static_cast<quint8>((i >> 10) & 0x1f);
+		cell.coord[1] = static_cast<quint8>((i >> 5) & 0x1f);
+		cell.coord[2] = static_cast<quint8>(i & 0x1f);
+		cell.count = bin.count;
+		cell.sum[0] = bin.r;
+		cell.sum[1] = bin.g;
+		cell.sum[2] = bin.b;
+	}
+
+	QList<QColor> result;
+	if (cells.isEmpty()) return result;
+
+	auto levels = qBound(0, static_cast<int>(std::ceil(maxDepth)), 15);
+	result.reserve(qMin(static_cast<qsizetype>(1) << levels, cells.size()));
+
+	histogramCutStep(cells.data(), cells.data() + cells.size(), 0, maxDepth, shouldCancel, result);
+
+	if (shouldCancel.loadAcquire()) return QList<QColor>();
+	return result;
+}
+
+void prunePaletteCache(const QString& dir, qsizetype maxEntries) {
+	// Operations storing palettes at the same time would only find the same entries to remove.
+	static QMutex mutex;
+	if (!mutex.tryLock()) return;
+	auto guard = qScopeGuard([] { mutex.unlock(); });
+
+	// Oldest first. Temporary files of palettes being written have an extension and are skipped.
+	auto entries = QDir(dir).entryInfoList(QDir::Files, QDir::Time | QDir::Reversed);
+	entries.removeIf([](const QFileInfo& entry) { return entry.fileName().contains('.'); });
+
+	if (entries.size() <= maxEntries) return;
+
+	// Pruning below the limit keeps the next few stores from pruning again.
+	auto removeCount = entries.size() - maxEntries * 3 / 4;
+	qCDebug(logColorQuantizer) << "Pruning" << removeCount << "of" << entries.size()
+	                           << "cached palettes in" << dir;
+
+	for (auto i = 0; i != removeCount; i++) {
+		QFile::remove(entries.at(i).filePath());
+	}
+}
+
+} // namespace qs::colorquantizer
+
 ColorQuantizerOperation::ColorQuantizerOperation(
     QUrl source,
     qreal depth,
     QRect imageRect,
-    qreal rescaleSize
+    qreal rescaleSize,
+    ColorQuantizerMode::Enum mode,
+    QString cacheDir
 )
     : source(std::move(source))
     , maxDepth(depth)
     , imageRect(imageRect)
-    , rescaleSize(rescaleSize) {
+    , rescaleSize(rescaleSize)
+    , mode(mode)
+    , cacheDir(std::move(cacheDir)) {
 	this->setAutoDelete(false);
 }
 
-void ColorQuantizerOperation::quantizeImage(const QAtomicInteger<bool>& shouldCancel) {
-	if (shouldCancel.loadAcquire() || this->source.isEmpty()) return;
+namespace {
 
-	this->colors.clear();
+constexpr int SCAN_CHUNK_ROWS = 64;
+// Below this many pixels the cost of waking pool threads outweighs the scan itself.
+constexpr qsizetype PARALLEL_SCAN_THRESHOLD = 256 * 1024;
+
+// Runs work(worker, chunk) for every chunk, spreading chunks across idle global thread pool
+// threads as well as the calling thread. Pool threads are only claimed if they are free
+// right away, as the caller is usually a pool thread itself and waiting for queued work
+// could deadlock a saturated pool. Returns false if cancelled.
+template <typename F>
+bool forEachChunk(qsizetype chunks, const QAtomicInteger<bool>& shouldCancel, F work) {
+	auto next = QAtomicInteger<qsizetype>(0);
+
+	auto runWorker = [&](qsizetype worker) {
+		while (!shouldCancel.loadAcquire()) {
+			auto chunk = next.fetchAndAddRelaxed(1);
+			if (chunk >= chunks) break;
+			work(worker, chunk);
+		}
+	};
+
+	auto finished = QSemaphore();
+	auto started = 0;
+	auto workers = qMin(static_cast<qsizetype>(QThread::idealThreadCount()), chunks);
+	auto* pool = QThreadPool::globalInstance();
+
+	for (auto i = 1; i < workers; i++) {
+		auto claimed = pool->tryStart([&, i]() {
+			runWorker(i);
+			finished.release();
+		});
+
+		if (!claimed) break;
+		started++;
+	}
+
+	runWorker(0);
+	finished.acquire(started);
+
+	return !shouldCancel.loadAcquire();
+}
+
+qsizetype scanChunks(const QImage& image) {
+	auto pixelCount = static_cast<qsizetype>(image.width()) * image.height();
+	if (pixelCount < PARALLEL_SCAN_THRESHOLD) return 1;
+	return (image.height() + SCAN_CHUNK_ROWS - 1) / SCAN_CHUNK_ROWS;
+}
+
+QList<QRgb> scanPixels(const QImage& image, const QAtomicInteger<bool>& shouldCancel) {
+	auto width = static_cast<qsizetype>(image.width());
+	auto chunks = scanChunks(image);
+	auto rowsPerChunk = chunks == 1 ? image.height() : SCAN_CHUNK_ROWS;
+
+	// Each chunk compacts its opaque pixels into the start of its own region of the arena,
+	// then the regions are packed together once every chunk is done.
+	auto pixels = QList<QRgb>(width * image.height());
+	auto counts = QList<qsizetype>(chunks);
+
+	auto completed = forEachChunk(chunks, shouldCancel, [&](qsizetype, qsizetype chunk) {
+		auto firstRow = static_cast<int>(chunk * rowsPerChunk);
+		auto lastRow = qMin(firstRow + static_cast<int>(rowsPerChunk), image.height());
+		auto* out = pixels.data() + firstRow * width;
+		qsizetype count = 0;
+
+		for (auto y = firstRow; y != lastRow; ++y) {
+			const auto* line = reinterpret_cast<const QRgb*>(image.constScanLine(y));
+
+			for (auto x = 0; x != width; ++x) {
+				if (qAlpha(line[x]) == 0) continue;
+				out[count++] = line[x];
+			}
+		}
+
+		counts[chunk] = count;
+	});
 
-	auto image = QImage(this->source.toLocalFile());
+	if (!completed) return QList<QRgb>();
+
+	auto total = counts.at(0);
+	for (auto chunk = 1; chunk < chunks; chunk++) {
+		const auto* region = pixels.constData() + chunk * rowsPerChunk * width;
+		auto* packed = pixels.data() + total;
+
+		// Regions only move towards the start of the arena, which std::copy allows even when the
+		// ranges overlap, as long as a region is not copied onto itself.
+		if (packed != region) std::copy(region, region + counts.at(chunk), packed);
+		total += counts.at(chunk);
+	}
+
+	pixels.resize(total);
+	return pixels;
+}
+
+std::optional<qs::colorquantizer::ColorHistogram>
+scanHistogram(const QImage& image, const QAtomicInteger<bool>& shouldCancel) {
+	auto chunks = scanChunks(image);
+	auto rowsPerChunk = chunks == 1 ? image.height() : SCAN_CHUNK_ROWS;
+
+	// Histograms are 1MB each, only allocate them for workers that actually picked up a chunk.
+	auto histograms = std::vector<std::optional<qs::colorquantizer::ColorHistogram>>(
+	    qMax(1, QThread::idealThreadCount())
+	);
+
+	auto completed = forEachChunk(chunks, shouldCancel, [&](qsizetype worker, qsizetype chunk) {
+		auto& histogram = histograms[worker];
+		if (!histogram) histogram.emplace();
+
+		auto firstRow = static_cast<int>(chunk * rowsPerChunk);
+		auto lastRow = qMin(firstRow + static_cast<int>(rowsPerChunk), image.height());
+
+		for (auto y = firstRow; y != lastRow; ++y) {
+			const auto* line = reinterpret_cast<const QRgb*>(image.constScanLine(y));
+			histogram->add(line, line + image.width());
+		}
+	});
+
+	if (!completed) return std::nullopt;
+
+	auto result = std::move(histograms[0]);
+	if (!result) result.emplace();
+
+	for (auto i = 1; i < static_cast<qsizetype>(histograms.size()); i++) {
+		if (histograms[i]) result->merge(*histograms[i]);
+	}
+
+	return result;
+}
+
+} // namespace
+
+QImage ColorQuantizerOperation::readImage() const {
+	auto reader = QImageReader(this->source.toLocalFile());
+	auto fullSize = reader.size();
+
+	// Without a known size we cannot compute the scaled size up front, fall back to
+	// decoding the whole image and transforming it afterwards.
+	if (!fullSize.isValid()) {
+		auto image = reader.read();
+
+		if (this->imageRect.isValid()) {
+			image = image.copy(this->imageRect);
+		}
+
+		if ((image.width() > this->rescaleSize || image.height() > this->rescaleSize)
+		    && this->rescaleSize > 0)
+		{
+			image = image.scaled(
+			    static_cast<int>(this->rescaleSize),
+			    static_cast<int>(this->rescaleSize),
+			    Qt::KeepAspectRatio,
+			    Qt::SmoothTransformation
+			);
+		}
+
+		return image;
+	}
+
+	auto clip = QRect(QPoint(0, 0), fullSize);
 
 	if (this->imageRect.isValid()) {
-		image = image.copy(this->imageRect);
+		clip = clip.intersected(this->imageRect);
+		if (clip.isEmpty()) return QImage();
+		reader.setClipRect(clip);
 	}
 
-	if ((image.width() > this->rescaleSize || image.height() > this->rescaleSize)
+	if ((clip.width() > this->rescaleSize || clip.height() > this->rescaleSize)
 	    && this->rescaleSize > 0)
 	{
-		image = image.scaled(
-		    static_cast<int>(this->rescaleSize),
-		    static_cast<int>(this->rescaleSize),
-		    Qt::KeepAspectRatio,
-		    Qt::SmoothTransformation
-		);
+		auto bound = static_cast<int>(this->rescaleSize);
+		auto scaledSize = clip.size().scaled(bound, bound, Qt::KeepAspectRatio);
+		reader.setScaledSize(scaledSize.expandedTo(QSize(1, 1)));
 	}
 
+	if (this->shouldCancel.loadAcquire()) return QImage();
+
+	// Formats that support it decode straight to the target size, others are scaled by
+	// QImageReader after decoding, which is no worse than doing it ourselves.
+	auto image = reader.read();
+
 	if (image.isNull()) {
-		qCWarning(logColorQuantizer) << "Failed to load image from" << this->source.toString();
+		qCDebug(logColorQuantizer) << "Image reader error for" << this->source.toString() << ':'
+		                           << reader.errorString();
+	}
+
+	return image;
+}
+
+void ColorQuantizerOperation::quantizeImage() {
+	if (this->shouldCancel.loadAcquire() || this->source.isEmpty()) return;
+
+	this->colors.clear();
+
+	auto cachePath = this->cachePath();
+	if (!cachePath.isEmpty() && this->loadCached(cachePath)) {
+		qCDebug(logColorQuantizer) << "Loaded cached palette for" << this->source.toString();
 		return;
 	}
 
-	QList<QColor> pixels;
-	for (int y = 0; y != image.height(); ++y) {
-		for (int x = 0; x != image.width(); ++x) {
-			auto pixel = image.pixel(x, y);
-			if (qAlpha(pixel) == 0) continue;
+	auto image = this->readImage();
 
-			pixels.append(QColor::fromRgb(pixel));
+	if (image.isNull()) {
+		if (!this->shouldCancel.loadAcquire()) {
+			qCWarning(logColorQuantizer) << "Failed to load image from" << this->source.toString();
 		}
+
+		return;
+	}
+
+	// Both formats are stored as native endian 0xAARRGGBB words, matching QRgb.
+	if (image.format() != QImage::Format_ARGB32 && image.format() != QImage::Format_RGB32) {
+		image.convertTo(QImage::Format_ARGB32);
 	}
 
 	auto startTime = QDateTime::currentDateTime();
 
-	this->colors = this->quantization(pixels, 0);
+	if (this->mode == ColorQuantizerMode::Histogram) {
+		auto histogram = scanHistogram(image, this->shouldCancel);
+		image = QImage();
+
+		if (!histogram) return;
+		this->colors = histogram->medianCut(this->maxDepth, this->shouldCancel);
+	} else {
+		auto pixels = scanPixels(image, this->shouldCancel);
+
+		// The arena holds every pixel we need, the decoded image can go.
+		image = QImage();
+
+		this->colors = qs::colorquantizer::medianCut(
+		    pixels.data(),
+		    pixels.data() + pixels.size(),
+		    this->maxDepth,
+		    this->shouldCancel
+		);
+	}
 
 	auto endTime = QDateTime::currentDateTime();
 	auto milliseconds = startTime.msecsTo(endTime);
 	qCDebug(logColorQuantizer) << "Color Quantization took: " << milliseconds << "ms";
-}
 
-QList<QColor> ColorQuantizerOperation::quantization(
-    QList<QColor>& rgbValues,
-    qreal depth,
-    const QAtomicInteger<bool>& shouldCancel
-) {
-	if (shouldCancel.loadAcquire()) return QList<QColor>();
+	if (!cachePath.isEmpty() && !this->shouldCancel.loadAcquire()) {
+		this->storeCached(cachePath);
+	}
+}
 
-	if (depth >= this->maxDepth || rgbValues.isEmpty()) {
-		if (rgbValues.isEmpty()) return QList<QColor>();
+namespace {
+constexpr quint32 PALETTE_CACHE_MAGIC = 0x51534351; // QSCQ
+constexpr quint8 PALETTE_CACHE_VERSION = 1;
+
+// Palettes are tiny, this bounds the number of files rather than their size.
+constexpr qsizetype PALETTE_CACHE_MAX_ENTRIES = 2048;
+// The cache is pruned on the first store of a run, then every this many stores.
+constexpr quint32 PALETTE_CACHE_PRUNE_INTERVAL = 64;
+QAtomicInteger<quint32> paletteCacheStores = 0; // NOLINT
+} // namespace
+
+QString ColorQuantizerOperation::cachePath() const {
+	if (this->cacheDir.isEmpty() || !this->source.isLocalFile()) return QString();
+
+	auto info = QFileInfo(this->source.toLocalFile());
+	if (!info.exists()) return QString();
+
+	QByteArray key;
+	auto stream = QDataStream(&key, QIODevice::WriteOnly);
+	stream << PALETTE_CACHE_VERSION << info.absoluteFilePath()
+	       << info.lastModified().toMSecsSinceEpoch() << info.size() << this->imageRect
+	       << this->rescaleSize << this->maxDepth << static_cast<quint8>(this->mode);
+
+	auto hash = QCryptographicHash::hash(key, QCryptographicHash::Md5).toHex();
+	return QDir(this->cacheDir).filePath(QString::fromLatin1(hash));
+}
 
-		auto totalR = 0;
-		auto totalG = 0;
-		auto totalB = 0;
+bool ColorQuantizerOperation::loadCached(const QString& path) {
+	auto file = QFile(path);
+	if (!file.open(QFile::ReadOnly)) return false;
 
-		for (const auto& color: rgbValues) {
-			if (shouldCancel.loadAcquire()) return QList<QColor>();
+	auto stream = QDataStream(&file);
+	quint32 magic = 0;
+	quint8 version = 0;
+	QList<QRgb> palette;
+	stream >> magic >> version;
 
-			totalR += color.red();
-			totalG += color.green();
-			totalB += color.blue();
-		}
+	if (magic != PALETTE_CACHE_MAGIC || version != PALETTE_CACHE_VERSION) return false;
 
-		auto avgColor = QColor(
-		    qRound(totalR / static_cast<double>(rgbValues.size())),
-		    qRound(totalG / static_cast<double>(rgbValues.size())),
-		    qRound(totalB / static_cast<double>(rgbValues.size()))
-		);
+	stream >> palette;
+	if (stream.status() != QDataStream::Ok) return false;
 
-		return QList<QColor>() << avgColor;
+	for (auto rgb: palette) {
+		this->colors.append(QColor::fromRgb(rgb));
 	}
 
-	auto dominantChannel = findBiggestColorRange(rgbValues);
-	std::ranges::sort(rgbValues, [dominantChannel](const auto& a, const auto& b) {
-		if (dominantChannel == 'r') return a.red() < b.red();
-		else if (dominantChannel == 'g') return a.green() < b.green();
-		return a.blue() < b.blue();
-	});
-
-	auto mid = rgbValues.size() / 2;
-
-	auto leftHalf = rgbValues.mid(0, mid);
-	auto rightHalf = rgbValues.mid(mid);
-
-	QList<QColor> result;
-	result.append(this->quantization(leftHalf, depth + 1));
-	result.append(this->quantization(rightHalf, depth + 1));
-
-	return result;
+	// Pruning removes the least recently modified entries, so keep used ones fresh.
+	file.setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime);
+	return true;
 }
 
-char ColorQuantizerOperation::findBiggestColorRange(const QList<QColor>& rgbValues) {
-	if (rgbValues.isEmpty()) return 'r';
-
-	auto rMin = 255;
-	auto gMin = 255;
-	auto bMin = 255;
-	auto rMax = 0;
-	auto gMax = 0;
-	auto bMax = 0;
+void ColorQuantizerOperation::storeCached(const QString& path) const {
+	if (!QDir().mkpath(this->cacheDir)) {
+		qCWarning(logColorQuantizer) << "Could not create palette cache directory" << this->cacheDir;
+		return;
+	}
 
-	for (const auto& color: rgbValues) {
-		rMin = qMin(rMin, color.red());
-		gMin = qMin(gMin, color.green());
-		bMin = qMin(bMin, color.blue());
+	QList<QRgb> palette;
+	palette.reserve(this->colors.size());
+	for (const auto& color: this->colors) {
+		palette.append(color.rgb());
+	}
 
-		rMax = qMax(rMax, color.red());
-		gMax = qMax(gMax, color.green());
-		bMax = qMax(bMax, color.blue());
+	auto file = QSaveFile(path);
+	if (!file.open(QFile::WriteOnly)) {
+		qCWarning(logColorQuantizer) << "Could not write palette cache" << path << file.errorString();
+		return;
 	}
 
-	auto rRange = rMax - rMin;
-	auto gRange = gMax - gMin;
-	auto bRange = bMax - bMin;
+	auto stream = QDataStream(&file);
+	stream << PALETTE_CACHE_MAGIC << PALETTE_CACHE_VERSION << palette;
 
-	auto biggestRange = qMax(rRange, qMax(gRange, bRange));
-	if (biggestRange == rRange) {
-		return 'r';
-	} else if (biggestRange == gRange) {
-		return 'g';
-	} else {
-		return 'b';
+	if (!file.commit()) {
+		qCWarning(logColorQuantizer) << "Could not write palette cache" << path << file.errorString();
+		return;
+	}
+
+	if (paletteCacheStores.fetchAndAddRelaxed(1) % PALETTE_CACHE_PRUNE_INTERVAL == 0) {
+		qs::colorquantizer::prunePaletteCache(this->cacheDir, PALETTE_CACHE_MAX_ENTRIES);
 	}
 }
 
@@ -237,6 +787,24 @@ void ColorQuantizer::setRescaleSize(int rescaleSize) {
 	}
 }
 
+void ColorQuantizer::setMode(ColorQuantizerMode::Enum mode) {
+	if (this->mMode != mode) {
+		this->mMode = mode;
+		emit this->modeChanged();
+
+		if (this->componentCompleted && !this->mSource.isEmpty()) this->quantizeAsync();
+	}
+}
+
+void ColorQuantizer::setCache(bool cache) {
+	if (this->mCache != cache) {
+		this->mCache = cache;
+		emit this->cacheChanged();
+
+		if (this->componentCompleted && !this->mSource.isEmpty()) this->quantizeAsync();
+	}
+}
+
 void ColorQuantizer::operationFinished(const QList<QColor>& result) {
 	this->bColors = result;
 	this->liveOperation = nullptr;
@@ -252,7 +820,10 @@ void ColorQuantizer::quantizeAsync() {
 	    this->mSource,
 	    this->mDepth,
 	    this->mImageRect,
-	    this->mRescaleSize
+	    this->mRescaleSize,
+	    this->mMode,
+	    // QsPaths is not safe to use from the worker thread
+	    this->mCache ? QsPaths::instance()->shellCacheDir().filePath("colorquantizer") : QString()
 	);
 
 	QObject::connect(
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <qimage.h>
 #include <qlist.h>
 #include <qobject.h>
 #include <qproperty.h>
@@ -7,18 +8,45 @@
 #include <qqmlparserstatus.h>
 #include <qrect.h>
 #include <qrunnable.h>
+#include <qstring.h>
 #include <qtclasshelpermacros.h>
 #include <qtmetamacros.h>
 #include <qtypes.h>
 #include <qurl.h>
 
+///! Algorithm used by @@ColorQuantizer.
+namespace ColorQuantizerMode { // NOLINT
+Q_NAMESPACE;
+QML_ELEMENT;
+
+enum Enum : quint8 {
+	/// Recursively split the image's pixels at the median of their widest color channel.
+	MedianCut = 0,
+	/// Bucket pixels into a 15 bit color histogram, then median cut the histogram.
+	///
+	/// Cost scales with the pixel count only once, making it much faster for large images,
+	/// at the expense of slightly less accurate colors. Images with very few distinct colors
+	/// may produce fewer than 2ⁿ colors.
+	Histogram = 1,
+};
+Q_ENUM_NS(Enum);
+
+} // namespace ColorQuantizerMode
+
 class ColorQuantizerOperation
     : public QObject
     , public QRunnable {
 	Q_OBJECT;
 
 public:
-	explicit ColorQuantizerOperation(QUrl source, qreal depth, QRect imageRect, qreal rescaleSize);
+	explicit ColorQuantizerOperation(
+	    QUrl source,
+	    qreal depth,
+	    QRect imageRect,
+	    qreal rescaleSize,
+	    ColorQuantizerMode::Enum mode,
+	    QString cacheDir
+	);
 
 	void run() override;
 	void tryCancel();
@@ -30,15 +58,11 @@ private slots:
 	void finished();
 
 private:
-	static char findBiggestColorRange(const QList<QColor>& rgbValues);
-
-	void quantizeImage(const QAtomicInteger<bool>& shouldCancel = false);
-
-	QList<QColor> quantization(
-	    QList<QColor>& rgbValues,
-	    qreal depth,
-	    const QAtomicInteger<bool>& shouldCancel = false
-	);
+	void quantizeImage();
+	[[nodiscard]] QImage readImage() const;
+	[[nodiscard]] QString cachePath() const;
+	[[nodiscard]] bool loadCached(const QString& path);
+	void storeCached(const QString& path) const;
 
 	void finishRun();
 
@@ -48,6 +72,8 @@ private:
 	qreal maxDepth;
 	QRect imageRect;
 	qreal rescaleSize;
+	ColorQuantizerMode::Enum mode;
+	QString cacheDir;
 };
 
 ///! Color Quantization Utility
@@ -92,6 +118,15 @@ class ColorQuantizer
 	/// > [!NOTE] Results from color quantization doesn't suffer much when rescaling, it's
 	/// > recommended to rescale, otherwise the quantization process will take much longer.
 	Q_PROPERTY(qreal rescaleSize READ rescaleSize WRITE setRescaleSize NOTIFY rescaleSizeChanged);
+	/// The quantization algorithm to use. Defaults to `ColorQuantizerMode.MedianCut`.
+	Q_PROPERTY(ColorQuantizerMode::Enum mode READ mode WRITE setMode NOTIFY modeChanged);
+	/// If true, results are stored in the shell's cache directory, keyed by the source file's
+	/// path, modification time and size as well as all quantization parameters.
+	/// Later runs with the same inputs, including after a restart, skip decoding the image entirely.
+	/// The least recently used results are removed once a few thousand have been stored.
+	///
+	/// Only applies to local files. Defaults to false.
+	Q_PROPERTY(bool cache READ cache WRITE setCache NOTIFY cacheChanged);
 
 public:
 	explicit ColorQuantizer(QObject* parent = nullptr): QObject(parent) {}
@@ -116,12 +151,20 @@ public:
 	[[nodiscard]] qreal rescaleSize() const { return this->mRescaleSize; }
 	void setRescaleSize(int rescaleSize);
 
+	[[nodiscard]] ColorQuantizerMode::Enum mode() const { return this->mMode; }
+	void setMode(ColorQuantizerMode::Enum mode);
+
+	[[nodiscard]] bool cache() const { return this->mCache; }
+	void setCache(bool cache);
+
 signals:
 	void colorsChanged();
 	void sourceChanged();
 	void depthChanged();
 	void imageRectChanged();
 	void rescaleSizeChanged();
+	void modeChanged();
+	void cacheChanged();
 
 public slots:
 	void operationFinished(const QList<QColor>& result);
@@ -136,6 +179,8 @@ private:
 	qreal mDepth = 0;
 	QRect mImageRect;
 	qreal mRescaleSize = 0;
+	ColorQuantizerMode::Enum mMode = ColorQuantizerMode::MedianCut;
+	bool mCache = false;
 
 	Q_OBJECT_BINDABLE_PROPERTY(
 	    ColorQuantizer,
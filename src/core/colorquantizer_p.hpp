@@ -0,0 +1,80 @@
+#pragma once
+
+#include <qatomic.h>
+#include <qcolor.h>
+#include <qlist.h>
+#include <qrgb.h>
+#include <qstring.h>
+#include <qtypes.h>
+
+namespace qs::colorquantizer {
+
+struct ChannelRange {
+	quint8 min[3] = {255, 255, 255};
+	quint8 max[3] = {0, 0, 0};
+};
+
+struct ChannelSums {
+	quint64 r = 0;
+	quint64 g = 0;
+	quint64 b = 0;
+};
+
+// Per channel min/max over packed ARGB32 pixels. Channel order is r, g, b.
+ChannelRange channelRange(const QRgb* begin, const QRgb* end);
+// Per channel sums over packed ARGB32 pixels.
+ChannelSums channelSums(const QRgb* begin, const QRgb* end);
+
+// Median cut over a packed ARGB32 pixel arena. The arena is partitioned in place
+// and no other pixel storage is allocated. Produces up to 2^ceil(maxDepth) colors.
+QList<QColor> medianCut(
+    QRgb* begin,
+    QRgb* end,
+    qreal maxDepth,
+    const QAtomicInteger<bool>& shouldCancel = false
+);
+
+// Removes the least recently used palettes from the cache in dir once it holds more than
+// maxEntries, leaving three quarters of that. Loading a palette counts as using it.
+void prunePaletteCache(const QString& dir, qsizetype maxEntries);
+
+// 15 bit (5 bits per channel) color histogram. Each bin keeps full precision channel
+// sums so output colors are exact averages of the pixels they represent.
+class ColorHistogram {
+public:
+	ColorHistogram();
+
+	void add(QRgb pixel) {
+		auto& bin = this->bins[binIndex(pixel)];
+		bin.count++;
+		bin.r += qRed(pixel);
+		bin.g += qGreen(pixel);
+		bin.b += qBlue(pixel);
+	}
+
+	void add(const QRgb* begin, const QRgb* end);
+	void merge(const ColorHistogram& other);
+
+	// Median cut over the non empty bins, weighted by pixel count. Cost depends only on the
+	// number of occupied bins, not the number of pixels added.
+	[[nodiscard]] QList<QColor>
+	medianCut(qreal maxDepth, const QAtomicInteger<bool>& shouldCancel = false) const;
+
+	static constexpr qsizetype BIN_COUNT = 1 << 15;
+
+private:
+	struct Bin {
+		quint64 count = 0;
+		quint64 r = 0;
+		quint64 g = 0;
+		quint64 b = 0;
+	};
+
+	static quint32 binIndex(QRgb pixel) {
+		return ((pixel >> 9) & 0x7c00) | ((pixel >> 6) & 0x03e0) | ((pixel >> 3) & 0x001f);
+	}
+
+	QList<Bin> bins;
+};
+
+} // namespace qs::colorquantizer
@@ -2,11 +2,14 @@
 #include <algorithm>
 #include <utility>
 
+#include <qbytearray.h>
 #include <qcontainerfwd.h>
+#include <qdatastream.h>
 #include <qdebug.h>
 #include <qdir.h>
 #include <qfile.h>
 #include <qfileinfo.h>
+#include <qhash.h>
 #include <qlogging.h>
 #include <qloggingcategory.h>
 #include <qnamespace.h>
@@ -14,16 +17,21 @@
 #include <qobjectdefs.h>
 #include <qpair.h>
 #include <qproperty.h>
+#include <qsavefile.h>
 #include <qscopeguard.h>
+#include <qset.h>
 #include <qtenvironmentvariables.h>
 #include <qthreadpool.h>
 #include <qtmetamacros.h>
 #include <ranges>
+#include <sys/stat.h>
 
 #include "../io/processcore.hpp"
 #include "desktopentrymonitor.hpp"
+#include "desktopentrysearch.hpp"
 #include "logcat.hpp"
 #include "model.hpp"
+#include "paths.hpp"
 #include "qmlglobal.hpp"
 
 namespace {
@@ -346,7 +354,160 @@ void DesktopAction::execute() const {
 	DesktopEntry::doExec(this->bCommand.value(), this->entry->bWorkingDirectory.value());
 }
 
-DesktopEntryScanner::DesktopEntryScanner(DesktopEntryManager* manager): manager(manager) {
+QDataStream& operator<<(QDataStream& stream, const DesktopActionData& data) {
+	stream << data.id << data.name << data.icon << data.execString << data.command << data.entries;
+	return stream;
+}
+
+QDataStream& operator>>(QDataStream& stream, DesktopActionData& data) {
+	stream >> data.id >> data.name >> data.icon >> data.execString >> data.command >> data.entries;
+	return stream;
+}
+
+QDataStream& operator<<(QDataStream& stream, const ParsedDesktopEntryData& data) {
+	stream << data.id << data.name << data.genericName << data.startupClass << data.noDisplay
+	       << data.hidden << data.comment << data.icon << data.execString << data.command
+	       << data.workingDirectory << data.terminal << data.categories << data.keywords
+	       << data.entries << data.actions;
+
+	return stream;
+}
+
+QDataStream& operator>>(QDataStream& stream, ParsedDesktopEntryData& data) {
+	stream >> data.id >> data.name >> data.genericName >> data.startupClass >> data.noDisplay
+	    >> data.hidden >> data.comment >> data.icon >> data.execString >> data.command
+	    >> data.workingDirectory >> data.terminal >> data.categories >> data.keywords >> data.entries
+	    >> data.actions;
+
+	return stream;
+}
+
+namespace {
+
+constexpr quint32 INDEX_MAGIC = 0x51534445; // QSDE
+constexpr quint32 INDEX_VERSION = 1;
+constexpr auto INDEX_STREAM_VERSION = QDataStream::Qt_6_6;
+
+QString indexLocaleKey() {
+	const auto& locale = Locale::system();
+	return locale.language + '_' + locale.territory + '@' + locale.modifier;
+}
+
+struct StatResult {
+	bool ok = false;
+	bool isDir = false;
+	qint64 mtime = 0;
+	quint64 inode = 0;
+};
+
+StatResult statPath(const QString& path) {
+	struct stat st = {};
+	if (::stat(QFile::encodeName(path).constData(), &st) != 0) return StatResult();
+
+	return StatResult {
+	    .ok = true,
+	    .isDir = S_ISDIR(st.st_mode),
+	    .mtime = static_cast<qint64>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec,
+	    .inode = static_cast<quint64>(st.st_ino),
+	};
+}
+
+} // namespace
+
+// NOLINTNEXTLINE(misc-use-internal-linkage)
+QDataStream& operator<<(QDataStream& stream, const DesktopEntryIndex::File& file) {
+	stream << file.mtime << file.inode << file.data;
+	return stream;
+}
+
+// NOLINTNEXTLINE(misc-use-internal-linkage)
+QDataStream& operator>>(QDataStream& stream, DesktopEntryIndex::File& file) {
+	stream >> file.mtime >> file.inode >> file.data;
+	return stream;
+}
+
+// NOLINTNEXTLINE(misc-use-internal-linkage)
+QDataStream& operator<<(QDataStream& stream, const DesktopEntryIndex::Directory& dir) {
+	stream << dir.mtime << dir.children;
+	return stream;
+}
+
+// NOLINTNEXTLINE(misc-use-internal-linkage)
+QDataStream& operator>>(QDataStream& stream, DesktopEntryIndex::Directory& dir) {
+	stream >> dir.mtime >> dir.children;
+	return stream;
+}
+
+bool DesktopEntryIndex::load(const QString& path) {
+	auto file = QFile(path);
+	if (!file.open(QFile::ReadOnly)) return false;
+
+	// Mapping the index avoids reading the whole file into a temporary buffer first. Everything
+	// decoded from it is still copied out, as the mapping is released when the file closes.
+	auto size = file.size();
+	auto* mapped = file.map(0, size);
+	if (!mapped) return false;
+
+	auto data = QByteArray::fromRawData(reinterpret_cast<const char*>(mapped), size);
+	auto stream = QDataStream(data);
+	stream.setVersion(INDEX_STREAM_VERSION);
+
+	quint32 magic = 0;
+	quint32 version = 0;
+	QString locale;
+	QStringList paths;
+	stream >> magic >> version;
+
+	if (magic != INDEX_MAGIC || version != INDEX_VERSION) {
+		qCDebug(logDesktopEntry) << "Ignoring desktop entry index with unknown version at" << path;
+		return false;
+	}
+
+	stream >> locale >> paths;
+
+	if (locale != indexLocaleKey() || paths != DesktopEntryManager::desktopPaths()) {
+		qCDebug(logDesktopEntry) << "Ignoring stale desktop entry index at" << path;
+		return false;
+	}
+
+	auto directories = QHash<QString, Directory>();
+	auto files = QHash<QString, File>();
+	stream >> directories >> files;
+
+	if (stream.status() != QDataStream::Ok) {
+		qCWarning(logDesktopEntry) << "Desktop entry index at" << path << "is corrupt, ignoring";
+		return false;
+	}
+
+	this->directories = std::move(directories);
+	this->files = std::move(files);
+
+	qCDebug(logDesktopEntry) << "Loaded desktop entry index with" << this->files.size() << "entries";
+	return true;
+}
+
+bool DesktopEntryIndex::save(const QString& path) const {
+	auto file = QSaveFile(path);
+	if (!file.open(QFile::WriteOnly)) return false;
+
+	auto stream = QDataStream(&file);
+	stream.setVersion(INDEX_STREAM_VERSION);
+	stream << INDEX_MAGIC << INDEX_VERSION << indexLocaleKey() << DesktopEntryManager::desktopPaths()
+	       << this->directories << this->files;
+
+	return file.commit();
+}
+
+DesktopEntryScanner::DesktopEntryScanner(
+    DesktopEntryManager* manager,
+    DesktopEntryIndex index,
+    QSet<QString> changedDirs,
+    bool validateFiles
+)
+    : manager(manager)
+    , oldIndex(std::move(index))
+    , changedDirs(std::move(changedDirs))
+    , validateFiles(validateFiles) {
 	this->setAutoDelete(true);
 }
 
@@ -355,54 +516,131 @@ void DesktopEntryScanner::run() {
 	auto scanResults = QList<ParsedDesktopEntryData>();
 
 	for (const auto& path: desktopPaths | std::views::reverse) {
-		auto file = QFileInfo(path);
-		if (!file.isDir()) continue;
+		this->scanDirectory(QDir::cleanPath(path), QString(), scanResults);
+	}
 
-		this->scanDirectory(QDir(path), QString(), scanResults);
+	// Anything left in the old index was removed from disk.
+	if (this->newIndex.files.size() != this->oldIndex.files.size()
+	    || this->newIndex.directories.size() != this->oldIndex.directories.size())
+	{
+		this->indexChanged = true;
+	}
+
+	qCDebug(logDesktopEntry) << "Desktop entry scan finished." << this->parsedCount
+	                         << "entries parsed," << this->reusedCount << "reused from index.";
+
+	if (this->indexChanged && !this->manager->indexPath.isEmpty()) {
+		if (!this->newIndex.save(this->manager->indexPath)) {
+			qCWarning(logDesktopEntry) << "Could not write desktop entry index to"
+			                           << this->manager->indexPath;
+		}
 	}
 
 	QMetaObject::invokeMethod(
 	    this->manager,
-	    "onScanCompleted",
-	    Qt::QueuedConnection,
-	    Q_ARG(QList<ParsedDesktopEntryData>, scanResults)
+	    [manager = this->manager,
+	     scanResults = std::move(scanResults),
+	     index = std::move(this->newIndex)]() mutable {
+		    manager->onScanCompleted(scanResults, std::move(index));
+	    },
+	    Qt::QueuedConnection
 	);
 }
 
 void DesktopEntryScanner::scanDirectory(
-    const QDir& dir,
+    const QString& path,
     const QString& idPrefix,
     QList<ParsedDesktopEntryData>& entries
 ) {
-	auto dirEntries = dir.entryInfoList(QDir::Dirs | QDir::Files | QDir::NoDotAndDotDot);
-
-	for (auto& entry: dirEntries) {
-		if (entry.isDir()) {
-			auto subdirPrefix = idPrefix.isEmpty() ? entry.fileName() : idPrefix + '-' + entry.fileName();
-			this->scanDirectory(QDir(entry.absoluteFilePath()), subdirPrefix, entries);
-		} else if (entry.isFile()) {
-			auto path = entry.filePath();
-			if (!path.endsWith(".desktop")) {
-				qCDebug(logDesktopEntry) << "Skipping file" << path << "as it has no .desktop extension";
-				continue;
-			}
+	auto stat = statPath(path);
+	if (!stat.ok || !stat.isDir) return;
 
-			auto file = QFile(path);
-			if (!file.open(QFile::ReadOnly)) {
-				qCDebug(logDesktopEntry) << "Could not open file" << path;
+	auto cached = this->oldIndex.directories.constFind(path);
+	auto changed = cached == this->oldIndex.directories.cend() || cached->mtime != stat.mtime
+	            || this->changedDirs.contains(path);
+
+	auto dir = DesktopEntryIndex::Directory();
+
+	if (changed) {
+		dir.mtime = stat.mtime;
+
+		auto dirEntries = QDir(path).entryInfoList(QDir::Dirs | QDir::Files | QDir::NoDotAndDotDot);
+		for (const auto& entry: dirEntries) {
+			if (entry.isDir()) dir.children.append(entry.fileName() + '/');
+			else if (entry.isFile()) dir.children.append(entry.fileName());
+		}
+
+		if (cached == this->oldIndex.directories.cend() || cached->children != dir.children) {
+			this->indexChanged = true;
+		}
+	} else {
+		dir = *cached;
+	}
+
+	this->newIndex.directories.insert(path, dir);
+
+	for (const auto& child: dir.children) {
+		if (child.endsWith('/')) {
+			auto name = child.sliced(0, child.length() - 1);
+			auto subdirPrefix = idPrefix.isEmpty() ? name : idPrefix + '-' + name;
+			this->scanDirectory(path + '/' + name, subdirPrefix, entries);
+		} else {
+			auto filePath = path + '/' + child;
+			if (!child.endsWith(".desktop")) {
+				qCDebug(logDesktopEntry) << "Skipping file" << filePath << "as it has no .desktop extension";
 				continue;
 			}
 
-			auto basename = QFileInfo(entry.fileName()).completeBaseName();
+			auto basename = QFileInfo(child).completeBaseName();
 			auto id = idPrefix.isEmpty() ? basename : idPrefix + '-' + basename;
-			auto content = QString::fromUtf8(file.readAll());
-
-			auto data = DesktopEntry::parseText(id, content);
-			entries.append(std::move(data));
+			this->scanFile(filePath, id, changed || this->validateFiles, entries);
 		}
 	}
 }
 
+void DesktopEntryScanner::scanFile(
+    const QString& path,
+    const QString& id,
+    bool validate,
+    QList<ParsedDesktopEntryData>& entries
+) {
+	auto cached = this->oldIndex.files.constFind(path);
+	auto stat = StatResult();
+
+	if (validate || cached == this->oldIndex.files.cend()) {
+		stat = statPath(path);
+		if (!stat.ok) return;
+	}
+
+	if (cached != this->oldIndex.files.cend()
+	    && (!validate || (cached->mtime == stat.mtime && cached->inode == stat.inode)))
+	{
+		this->newIndex.files.insert(path, *cached);
+		entries.append(cached->data);
+		this->reusedCount++;
+		return;
+	}
+
+	auto file = QFile(path);
+	if (!file.open(QFile::ReadOnly)) {
+		qCDebug(logDesktopEntry) << "Could not open file" << path;
+		return;
+	}
+
+	auto content = QString::fromUtf8(file.readAll());
+
+	auto indexed = DesktopEntryIndex::File {
+	    .mtime = stat.mtime,
+	    .inode = stat.inode,
+	    .data = DesktopEntry::parseText(id, content),
+	};
+
+	entries.append(indexed.data);
+	this->newIndex.files.insert(path, std::move(indexed));
+	this->indexChanged = true;
+	this->parsedCount++;
+}
+
 DesktopEntryManager::DesktopEntryManager(): monitor(new DesktopEntryMonitor(this)) {
 	QObject::connect(
 	    this->monitor,
@@ -411,12 +649,20 @@ DesktopEntryManager::DesktopEntryManager(): monitor(new DesktopEntryMonitor(this
 	    &DesktopEntryManager::handleFileChanges
 	);
 
-	DesktopEntryScanner(this).run();
+	this->indexPath = QsPaths::instance()->shellCacheDir().filePath("desktopentries.idx");
+	this->index.load(this->indexPath);
+
+	// Files may have been edited in place while we weren't running, which doesn't show up
+	// in directory mtimes, so every file is checked against the index on startup.
+	DesktopEntryScanner(this, this->index, {}, true).run();
 }
 
 void DesktopEntryManager::scanDesktopEntries() {
 	qCDebug(logDesktopEntry) << "Starting desktop entry scan";
+	this->startScan();
+}
 
+void DesktopEntryManager::startScan() {
 	if (this->scanInProgress) {
 		qCDebug(logDesktopEntry) << "Scan already in progress, queuing another scan";
 		this->scanQueued = true;
@@ -425,7 +671,9 @@ void DesktopEntryManager::scanDesktopEntries() {
 
 	this->scanInProgress = true;
 	this->scanQueued = false;
-	auto* scanner = new DesktopEntryScanner(this);
+
+	auto* scanner = new DesktopEntryScanner(this, this->index, std::move(this->changedDirs), false);
+	this->changedDirs.clear();
 	QThreadPool::globalInstance()->start(scanner);
 }
 
@@ -446,38 +694,17 @@ DesktopEntry* DesktopEntryManager::byId(const QString& id) {
 
 DesktopEntry* DesktopEntryManager::heuristicLookup(const QString& name) {
 	if (auto* entry = this->byId(name)) return entry;
-
-	auto list = this->desktopEntries.values();
-
-	auto iter = std::ranges::find_if(list, [&](DesktopEntry* entry) {
-		return name == entry->bStartupClass.value();
-	});
-
-	if (iter != list.end()) return *iter;
-
-	iter = std::ranges::find_if(list, [&](DesktopEntry* entry) {
-		return name.toLower() == entry->bStartupClass.value().toLower();
-	});
-
-	if (iter != list.end()) return *iter;
-	return nullptr;
+	if (auto* entry = this->startupClassEntries.value(name)) return entry;
+	return this->lowercaseStartupClassEntries.value(name.toLower());
 }
 
 ObjectModel<DesktopEntry>* DesktopEntryManager::applications() { return &this->mApplications; }
 
-void DesktopEntryManager::handleFileChanges() {
-	qCDebug(logDesktopEntry) << "Directory change detected, performing full rescan";
-
-	if (this->scanInProgress) {
-		qCDebug(logDesktopEntry) << "Scan already in progress, queuing another scan";
-		this->scanQueued = true;
-		return;
-	}
+void DesktopEntryManager::handleFileChanges(const QStringList& changedDirs) {
+	qCDebug(logDesktopEntry) << "Directory change detected in" << changedDirs << "performing rescan";
 
-	this->scanInProgress = true;
-	this->scanQueued = false;
-	auto* scanner = new DesktopEntryScanner(this);
-	QThreadPool::globalInstance()->start(scanner);
+	for (const auto& dir: changedDirs) this->changedDirs.insert(dir);
+	this->startScan();
 }
 
 const QStringList& DesktopEntryManager::desktopPaths() {
@@ -502,7 +729,12 @@ const QStringList& DesktopEntryManager::desktopPaths() {
 	return paths;
 }
 
-void DesktopEntryManager::onScanCompleted(const QList<ParsedDesktopEntryData>& scanResults) {
+void DesktopEntryManager::onScanCompleted(
+    const QList<ParsedDesktopEntryData>& scanResults,
+    DesktopEntryIndex index
+) {
+	this->index = std::move(index);
+
 	auto guard = qScopeGuard([this] {
 		this->scanInProgress = false;
 		if (this->scanQueued) {
@@ -577,11 +809,29 @@ void DesktopEntryManager::onScanCompleted(const QList<ParsedDesktopEntryData>& s
 	this->desktopEntries = newEntries;
 	this->lowercaseDesktopEntries = newLowercaseEntries;
 
+	this->startupClassEntries.clear();
+	this->lowercaseStartupClassEntries.clear();
+
+	for (auto* entry: this->desktopEntries.values()) {
+		const auto& startupClass = entry->bStartupClass.value();
+		if (startupClass.isEmpty()) continue;
+
+		if (!this->startupClassEntries.contains(startupClass)) {
+			this->startupClassEntries.insert(startupClass, entry);
+		}
+
+		auto lowerClass = startupClass.toLower();
+		if (!this->lowercaseStartupClassEntries.contains(lowerClass)) {
+			this->lowercaseStartupClassEntries.insert(lowerClass, entry);
+		}
+	}
+
 	auto newApplications = QVector<DesktopEntry*>();
 	for (auto* entry: this->desktopEntries.values())
 		if (!entry->bNoDisplay) newApplications.append(entry);
 
 	this->mApplications.diffUpdate(newApplications);
+	this->mSearchIndex = DesktopEntrySearchIndex::build(newApplications);
 
 	emit this->applicationsChanged();
 
@@ -3,12 +3,16 @@
 #include <utility>
 
 #include <qcontainerfwd.h>
+#include <qdatastream.h>
 #include <qdir.h>
 #include <qhash.h>
 #include <qobject.h>
 #include <qproperty.h>
 #include <qqmlintegration.h>
 #include <qrunnable.h>
+#include <qset.h>
+#include <qsharedpointer.h>
+#include <qstringlist.h>
 #include <qtmetamacros.h>
 
 #include "desktopentrymonitor.hpp"
@@ -17,6 +21,7 @@
 
 class DesktopAction;
 class DesktopEntryMonitor;
+struct DesktopEntrySearchIndex;
 
 struct DesktopActionData {
 	QString id;
@@ -46,6 +51,35 @@ struct ParsedDesktopEntryData {
 	QVector<DesktopActionData> actions;
 };
 
+QDataStream& operator<<(QDataStream& stream, const DesktopActionData& data);
+QDataStream& operator>>(QDataStream& stream, DesktopActionData& data);
+QDataStream& operator<<(QDataStream& stream, const ParsedDesktopEntryData& data);
+QDataStream& operator>>(QDataStream& stream, ParsedDesktopEntryData& data);
+
+// Parsed desktop entries from a previous scan, persisted in the cache dir so unchanged
+// entries don't have to be read and parsed again on startup or rescan.
+struct DesktopEntryIndex {
+	struct File {
+		qint64 mtime = 0;
+		quint64 inode = 0;
+		ParsedDesktopEntryData data;
+	};
+
+	struct Directory {
+		qint64 mtime = 0;
+		// Child names in scan order. Directories are suffixed with '/'.
+		QStringList children;
+	};
+
+	QHash<QString, Directory> directories;
+	QHash<QString, File> files;
+
+	// Loads an index written by save(). Fails if the index was written with a different
+	// locale or set of desktop entry paths, as either would change the parse results.
+	bool load(const QString& path);
+	[[nodiscard]] bool save(const QString& path) const;
+};
+
 /// A desktop entry. See @@DesktopEntries for details.
 class DesktopEntry: public QObject {
 	Q_OBJECT;
@@ -238,15 +272,36 @@ class DesktopEntryManager;
 
 class DesktopEntryScanner: public QRunnable {
 public:
-	explicit DesktopEntryScanner(DesktopEntryManager* manager);
+	// Directories in changedDirs and directories with a changed mtime are relisted and have their
+	// entries' mtime and inode checked. If validateFiles is set, all entries are checked.
+	explicit DesktopEntryScanner(
+	    DesktopEntryManager* manager,
+	    DesktopEntryIndex index,
+	    QSet<QString> changedDirs,
+	    bool validateFiles
+	);
 
 	void run() override;
 	// clang-format off
-	void scanDirectory(const QDir& dir, const QString& idPrefix, QList<ParsedDesktopEntryData>& entries);
+	void scanDirectory(const QString& path, const QString& idPrefix, QList<ParsedDesktopEntryData>& entries);
 	// clang-format on
 
 private:
+	void scanFile(
+	    const QString& path,
+	    const QString& id,
+	    bool validate,
+	    QList<ParsedDesktopEntryData>& entries
+	);
+
 	DesktopEntryManager* manager;
+	DesktopEntryIndex oldIndex;
+	DesktopEntryIndex newIndex;
+	QSet<QString> changedDirs;
+	bool validateFiles;
+	bool indexChanged = false;
+	qsizetype parsedCount = 0;
+	qsizetype reusedCount = 0;
 };
 
 class DesktopEntryManager: public QObject {
@@ -259,6 +314,9 @@ public:
 	[[nodiscard]] DesktopEntry* heuristicLookup(const QString& name);
 
 	[[nodiscard]] ObjectModel<DesktopEntry>* applications();
+	[[nodiscard]] QSharedPointer<const DesktopEntrySearchIndex> searchIndex() const {
+		return this->mSearchIndex;
+	}
 
 	static DesktopEntryManager* instance();
 
@@ -268,14 +326,22 @@ signals:
 	void applicationsChanged();
 
 private slots:
-	void handleFileChanges();
-	void onScanCompleted(const QList<ParsedDesktopEntryData>& scanResults);
+	void handleFileChanges(const QStringList& changedDirs);
 
 private:
 	explicit DesktopEntryManager();
 
+	void startScan();
+	void onScanCompleted(const QList<ParsedDesktopEntryData>& scanResults, DesktopEntryIndex index);
+
+	DesktopEntryIndex index;
+	QString indexPath;
+	QSet<QString> changedDirs;
 	QHash<QString, DesktopEntry*> desktopEntries;
 	QHash<QString, DesktopEntry*> lowercaseDesktopEntries;
+	QHash<QString, DesktopEntry*> startupClassEntries;
+	QHash<QString, DesktopEntry*> lowercaseStartupClassEntries;
+	QSharedPointer<const DesktopEntrySearchIndex> mSearchIndex;
 	ObjectModel<DesktopEntry> mApplications {this};
 	DesktopEntryMonitor* monitor = nullptr;
 	bool scanInProgress = false;
@@ -4,6 +4,7 @@
 #include <qfileinfo.h>
 #include <qfilesystemwatcher.h>
 #include <qobject.h>
+#include <qset.h>
 #include <qstring.h>
 #include <qtmetamacros.h>
 
@@ -61,8 +62,13 @@ void DesktopEntryMonitor::scanAndWatch(const QString& dirPath) {
 	for (const auto& subdir: subdirs) this->watcher.addPath(subdir.absoluteFilePath());
 }
 
-void DesktopEntryMonitor::onDirectoryChanged(const QString& /*path*/) {
+void DesktopEntryMonitor::onDirectoryChanged(const QString& path) {
+	this->changedDirs.insert(QDir::cleanPath(path));
 	this->debounceTimer.start();
 }
 
-void DesktopEntryMonitor::processChanges() { emit this->desktopEntriesChanged(); }
\ No newline at end of file
+void DesktopEntryMonitor::processChanges() {
+	auto changedDirs = this->changedDirs.values();
+	this->changedDirs.clear();
+	emit this->desktopEntriesChanged(changedDirs);
+}
\ No newline at end of file
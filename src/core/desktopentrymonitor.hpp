@@ -2,6 +2,7 @@
 
 #include <qfilesystemwatcher.h>
 #include <qobject.h>
+#include <qset.h>
 #include <qstringlist.h>
 #include <qtimer.h>
 
@@ -17,7 +18,7 @@ public:
 	DesktopEntryMonitor& operator=(DesktopEntryMonitor&&) = delete;
 
 signals:
-	void desktopEntriesChanged();
+	void desktopEntriesChanged(const QStringList& changedDirs);
 
 private slots:
 	void onDirectoryChanged(const QString& path);
@@ -29,4 +30,5 @@ private:
 
 	QFileSystemWatcher watcher;
 	QTimer debounceTimer;
+	QSet<QString> changedDirs;
 };
@@ -0,0 +1,310 @@
+#include "desktopentrysearch.hpp"
+#include <algorithm>
+#include <utility>
+
+#include <qatomic.h>
+#include <qlist.h>
+#include <qlogging.h>
+#include <qloggingcategory.h>
+#include <qnamespace.h>
+#include <qobject.h>
+#include <qsharedpointer.h>
+#include <qstring.h>
+#include <qstringview.h>
+#include <qthreadpool.h>
+#include <qtmetamacros.h>
+#include <qtypes.h>
+
+#include "desktopentry.hpp"
+#include "logcat.hpp"
+#include "model.hpp"
+
+namespace {
+QS_LOGGING_CATEGORY(logDesktopEntrySearch, "quickshell.desktopentry.search", QtWarningMsg);
+
+constexpr qint32 FIELD_WEIGHTS[DesktopEntrySearchIndex::FieldCount] = {4, 2, 2, 2, 1};
+
+bool isWordBoundary(QChar c) {
+	return c == u' ' || c == u'-' || c == u'_' || c == u'.' || c == u'/';
+}
+
+} // namespace
+
+QSharedPointer<const DesktopEntrySearchIndex>
+DesktopEntrySearchIndex::build(const QList<DesktopEntry*>& entries) {
+	auto index = QSharedPointer<DesktopEntrySearchIndex>::create();
+	index->entries.reserve(entries.size());
+
+	for (auto* dentry: entries) {
+		auto& entry = index->entries.emplaceBack();
+		entry.id = dentry->mId;
+		entry.fields[Name] = dentry->bName.value().toLower();
+		entry.fields[Id] = dentry->mId.toLower();
+		entry.fields[StartupClass] = dentry->bStartupClass.value().toLower();
+		entry.fields[GenericName] = dentry->bGenericName.value().toLower();
+		entry.fields[Keywords] = dentry->bKeywords.value().join(u' ').toLower();
+
+		for (const auto& field: entry.fields) {
+			entry.charMask |= charMask(field);
+		}
+	}
+
+	return index;
+}
+
+quint64 DesktopEntrySearchIndex::charMask(QStringView text) {
+	quint64 mask = 0;
+
+	for (auto c: text) {
+		mask |= static_cast<quint64>(1) << (c.unicode() % 64);
+	}
+
+	return mask;
+}
+
+qint32 DesktopEntrySearchIndex::fuzzyScore(QStringView haystack, QStringView needle) {
+	if (needle.isEmpty()) return 0;
+	if (needle.length() > haystack.length()) return -1;
+
+	auto best = -1;
+
+	// Try every possible start of the match, as the first occurrence of the first
+	// character is not necessarily the best one (e.g. "fox" in "foo firefox").
+	for (auto start = haystack.indexOf(needle.first()); start != -1;
+	     start = haystack.indexOf(needle.first(), start + 1))
+	{
+		auto score = 0;
+		auto prev = start - 1;
+		auto hi = start;
+
+		for (auto ni = 0; ni != needle.length(); ni++) {
+			hi = haystack.indexOf(needle.at(ni), ni == 0 ? start : prev + 1);
+
+			// No later start can match either, as it would have fewer characters to work with.
+			if (hi == -1) return best;
+
+			if (hi == 0) score += 16;
+			else if (isWordBoundary(haystack.at(hi - 1))) score += 8;
+
+			if (hi == prev + 1 && ni != 0) score += 6;
+			else if (ni != 0) score -= qMin(static_cast<qint32>(hi - prev - 1), 3);
+
+			score += 1;
+			prev = hi;
+		}
+
+		if (start == 0 && needle.length() == haystack.length()) score += 32;
+
+		best = qMax(best, qMax(score, 0));
+	}
+
+	return best;
+}
+
+QList<DesktopEntrySearchIndex::Match> DesktopEntrySearchIndex::search(
+    const QString& query,
+    const QList<qint32>* candidates,
+    const QAtomicInteger<bool>& shouldCancel
+) const {
+	auto tokens = query.toLower().split(u' ', Qt::SkipEmptyParts);
+
+	auto tokenMasks = QList<quint64>();
+	tokenMasks.reserve(tokens.size());
+	for (const auto& token: tokens) tokenMasks.append(charMask(token));
+
+	auto matches = QList<Match>();
+
+	auto tryEntry = [&](qint32 i) {
+		const auto& entry = this->entries.at(i);
+		auto total = 0;
+
+		for (auto t = 0; t != tokens.size(); t++) {
+			if ((tokenMasks.at(t) & ~entry.charMask) != 0) return;
+
+			auto best = -1;
+			for (auto f = 0; f != FieldCount; f++) {
+				auto score = fuzzyScore(entry.fields.at(f), tokens.at(t));
+				if (score >= 0) best = qMax(best, score * FIELD_WEIGHTS[f]);
+			}
+
+			if (best < 0) return;
+			total += best;
+		}
+
+		matches.append({.entry = i, .score = total});
+	};
+
+	if (candidates) {
+		for (auto i: *candidates) {
+			if (shouldCancel.loadAcquire()) return QList<Match>();
+			tryEntry(i);
+		}
+	} else {
+		for (auto i = 0; i != this->entries.size(); i++) {
+			if (shouldCancel.loadAcquire()) return QList<Match>();
+			tryEntry(i);
+		}
+	}
+
+	std::ranges::stable_sort(matches, [this](const Match& a, const Match& b) {
+		if (a.score != b.score) return a.score > b.score;
+		return this->entries.at(a.entry).fields.at(Name) < this->entries.at(b.entry).fields.at(Name);
+	});
+
+	return matches;
+}
+
+DesktopEntrySearchOperation::DesktopEntrySearchOperation(
+    QSharedPointer<const DesktopEntrySearchIndex> index,
+    QString query,
+    QList<qint32> candidates,
+    bool restrictCandidates
+)
+    : index(std::move(index))
+    , query(std::move(query))
+    , candidates(std::move(candidates))
+    , restrictCandidates(restrictCandidates) {
+	this->setAutoDelete(false);
+}
+
+void DesktopEntrySearchOperation::run() {
+	if (!this->shouldCancel.loadAcquire()) {
+		this->matches = this->index->search(
+		    this->query,
+		    this->restrictCandidates ? &this->candidates : nullptr,
+		    this->shouldCancel
+		);
+	}
+
+	QMetaObject::invokeMethod(this, &DesktopEntrySearchOperation::finished, Qt::QueuedConnection);
+}
+
+void DesktopEntrySearchOperation::tryCancel() { this->shouldCancel.storeRelease(true); }
+
+void DesktopEntrySearchOperation::finished() {
+	if (!this->shouldCancel.loadAcquire()) emit this->done(this->matches);
+	delete this;
+}
+
+DesktopEntrySearch::DesktopEntrySearch(QObject* parent): QObject(parent) {
+	QObject::connect(
+	    DesktopEntryManager::instance(),
+	    &DesktopEntryManager::applicationsChanged,
+	    this,
+	    &DesktopEntrySearch::onApplicationsChanged
+	);
+}
+
+DesktopEntrySearch::~DesktopEntrySearch() { this->cancelSearch(); }
+
+void DesktopEntrySearch::componentComplete() {
+	this->componentCompleted = true;
+	this->startSearch();
+}
+
+void DesktopEntrySearch::setQuery(const QString& query) {
+	if (query == this->mQuery) return;
+	this->mQuery = query;
+	emit this->queryChanged();
+
+	this->startSearch();
+}
+
+void DesktopEntrySearch::setLimit(qint32 limit) {
+	limit = qMax(limit, 0);
+	if (limit == this->mLimit) return;
+	this->mLimit = limit;
+	emit this->limitChanged();
+
+	// all matches are kept, so changing the limit does not need another search
+	if (!this->liveOperation) this->applyResults();
+}
+
+void DesktopEntrySearch::onApplicationsChanged() {
+	this->lastIndex.reset();
+	this->lastMatches.clear();
+	this->startSearch();
+}
+
+void DesktopEntrySearch::startSearch() {
+	if (!this->componentCompleted) return;
+
+	auto wasSearching = this->cancelSearch();
+
+	auto index = DesktopEntryManager::instance()->searchIndex();
+	if (!index) {
+		if (wasSearching) emit this->searchingChanged();
+		return;
+	}
+
+	auto query = this->mQuery.toLower();
+
+	// Adding characters to a query can only remove matches, so the previous results
+	// are the only entries worth checking while typing.
+	auto narrow = this->lastIndex == index && !this->lastQuery.isEmpty()
+	           && query.startsWith(this->lastQuery);
+
+	auto candidates = QList<qint32>();
+	if (narrow) {
+		candidates.reserve(this->lastMatches.size());
+		for (const auto& match: this->lastMatches) candidates.append(match.entry);
+	}
+
+	qCDebug(logDesktopEntrySearch) << "Searching for" << query << "narrowed:" << narrow;
+
+	this->pendingIndex = index;
+	this->pendingQuery = query;
+	this->liveOperation = new DesktopEntrySearchOperation(index, query, candidates, narrow);
+
+	QObject::connect(
+	    this->liveOperation,
+	    &DesktopEntrySearchOperation::done,
+	    this,
+	    &DesktopEntrySearch::onSearchFinished
+	);
+
+	QThreadPool::globalInstance()->start(this->liveOperation);
+	if (!wasSearching) emit this->searchingChanged();
+}
+
+bool DesktopEntrySearch::cancelSearch() {
+	if (!this->liveOperation) return false;
+
+	// The operation deletes itself once the worker returns.
+	this->liveOperation->tryCancel();
+	QObject::disconnect(this->liveOperation, nullptr, this, nullptr);
+	this->liveOperation = nullptr;
+	return true;
+}
+
+void DesktopEntrySearch::onSearchFinished(const QList<DesktopEntrySearchIndex::Match>& matches) {
+	this->liveOperation = nullptr;
+	this->lastIndex = this->pendingIndex;
+	this->lastQuery = this->pendingQuery;
+	this->lastMatches = matches;
+	this->pendingIndex.reset();
+
+	this->applyResults();
+	emit this->searchingChanged();
+}
+
+void DesktopEntrySearch::applyResults() {
+	auto* manager = DesktopEntryManager::instance();
+
+	// The index may have been replaced by a rescan since the search started,
+	// in which case another search is already queued.
+	if (!this->lastIndex || this->lastIndex != manager->searchIndex()) return;
+
+	auto count = this->mLimit == 0 ? this->lastMatches.size()
+	                               : qMin(static_cast<qsizetype>(this->mLimit), this->lastMatches.size());
+
+	auto results = QList<DesktopEntry*>();
+	results.reserve(count);
+
+	for (auto i = 0; i != count; i++) {
+		const auto& entry = this->lastIndex->entries.at(this->lastMatches.at(i).entry);
+		if (auto* dentry = manager->byId(entry.id)) results.append(dentry);
+	}
+
+	this->mResults.diffUpdate(results);
+}
@@ -0,0 +1,179 @@
+#pragma once
+
+#include <array>
+
+#include <qatomic.h>
+#include <qcontainerfwd.h>
+#include <qlist.h>
+#include <qobject.h>
+#include <qqmlintegration.h>
+#include <qqmlparserstatus.h>
+#include <qrunnable.h>
+#include <qsharedpointer.h>
+#include <qstring.h>
+#include <qstringview.h>
+#include <qtclasshelpermacros.h>
+#include <qtmetamacros.h>
+#include <qtypes.h>
+
+#include "desktopentry.hpp"
+#include "doc.hpp"
+#include "model.hpp"
+
+// Lowercased searchable fields of every application, rebuilt after each desktop entry scan
+// and shared read only with search workers.
+struct DesktopEntrySearchIndex {
+	enum Field : quint8 {
+		Name = 0,
+		Id,
+		StartupClass,
+		GenericName,
+		Keywords,
+		FieldCount,
+	};
+
+	struct Entry {
+		QString id;
+		std::array<QString, FieldCount> fields;
+		// Bloom style mask of characters present in any field, used to reject entries
+		// that cannot match before running the fuzzy matcher.
+		quint64 charMask = 0;
+	};
+
+	struct Match {
+		qint32 entry = 0;
+		qint32 score = 0;
+	};
+
+	QList<Entry> entries;
+
+	static QSharedPointer<const DesktopEntrySearchIndex> build(const QList<DesktopEntry*>& entries);
+
+	// Returns all matching entries, best first. If candidates is not null only those entries
+	// are considered. Returns nothing if cancelled.
+	[[nodiscard]] QList<Match> search(
+	    const QString& query,
+	    const QList<qint32>* candidates,
+	    const QAtomicInteger<bool>& shouldCancel = false
+	) const;
+
+	static quint64 charMask(QStringView text);
+	// Scores needle as a subsequence of haystack. Returns -1 if it does not match.
+	static qint32 fuzzyScore(QStringView haystack, QStringView needle);
+};
+
+class DesktopEntrySearchOperation
+    : public QObject
+    , public QRunnable {
+	Q_OBJECT;
+
+public:
+	explicit DesktopEntrySearchOperation(
+	    QSharedPointer<const DesktopEntrySearchIndex> index,
+	    QString query,
+	    QList<qint32> candidates,
+	    bool restrictCandidates
+	);
+
+	void run() override;
+	void tryCancel();
+
+signals:
+	void done(const QList<DesktopEntrySearchIndex::Match>& matches);
+
+private slots:
+	void finished();
+
+private:
+	QAtomicInteger<bool> shouldCancel = false;
+	QSharedPointer<const DesktopEntrySearchIndex> index;
+	QString query;
+	QList<qint32> candidates;
+	bool restrictCandidates;
+	QList<DesktopEntrySearchIndex::Match> matches;
+};
+
+///! Ranked fuzzy search over desktop entries.
+/// Searches the name, id, startup class, generic name and keywords of every entry in
+/// @@DesktopEntries.applications, ranking the results by match quality.
+///
+/// Searches are run in the background, and @@results is updated with only the rows
+/// that changed, so delegates and animations are preserved while typing.
+///
+/// #### Example
+/// ```qml
+/// DesktopEntrySearch {
+///   id: search
+///   query: searchField.text
+///   limit: 20
+/// }
+///
+/// ListView {
+///   model: search.results
+///   delegate: Text { required property DesktopEntry modelData; text: modelData.name }
+/// }
+/// ```
+class DesktopEntrySearch
+    : public QObject
+    , public QQmlParserStatus {
+	Q_OBJECT;
+	Q_INTERFACES(QQmlParserStatus);
+	/// The text to search for. Each whitespace separated term must match one of the entry's
+	/// fields, with its characters appearing in order but not necessarily adjacent.
+	/// Matching is case insensitive.
+	///
+	/// If empty, all applications are returned in name order.
+	Q_PROPERTY(QString query READ query WRITE setQuery NOTIFY queryChanged);
+	/// The maximum number of results to return, or 0 for no limit. Defaults to 0.
+	Q_PROPERTY(qint32 limit READ limit WRITE setLimit NOTIFY limitChanged);
+	/// Matching entries, best match first.
+	QSDOC_TYPE_OVERRIDE(ObjectModel<DesktopEntry>*);
+	Q_PROPERTY(UntypedObjectModel* results READ results CONSTANT);
+	/// If a search is currently running. @@results reflects the previous query until it finishes.
+	Q_PROPERTY(bool searching READ searching NOTIFY searchingChanged);
+	QML_ELEMENT;
+
+public:
+	explicit DesktopEntrySearch(QObject* parent = nullptr);
+	~DesktopEntrySearch() override;
+	Q_DISABLE_COPY_MOVE(DesktopEntrySearch);
+
+	void classBegin() override {}
+	void componentComplete() override;
+
+	[[nodiscard]] QString query() const { return this->mQuery; }
+	void setQuery(const QString& query);
+
+	[[nodiscard]] qint32 limit() const { return this->mLimit; }
+	void setLimit(qint32 limit);
+
+	[[nodiscard]] ObjectModel<DesktopEntry>* results() { return &this->mResults; }
+	[[nodiscard]] bool searching() const { return this->liveOperation != nullptr; }
+
+signals:
+	void queryChanged();
+	void limitChanged();
+	void searchingChanged();
+
+private slots:
+	void onApplicationsChanged();
+	void onSearchFinished(const QList<DesktopEntrySearchIndex::Match>& matches);
+
+private:
+	void startSearch();
+	bool cancelSearch();
+	void applyResults();
+
+	bool componentCompleted = false;
+	QString mQuery;
+	qint32 mLimit = 0;
+	ObjectModel<DesktopEntry> mResults {this};
+	DesktopEntrySearchOperation* liveOperation = nullptr;
+
+	// State of the last completed search, used to narrow searches while a query is being typed.
+	QSharedPointer<const DesktopEntrySearchIndex> lastIndex;
+	QString lastQuery;
+	QList<DesktopEntrySearchIndex::Match> lastMatches;
+	QSharedPointer<const DesktopEntrySearchIndex> pendingIndex;
+	QString pendingQuery;
+};
@@ -1,8 +1,12 @@
 #pragma once
 
+#include <array>
+#include <atomic>
+
 #include <qdatetime.h>
 #include <qlogging.h>
 #include <qstring.h>
+#include <qtypes.h>
 #include <sys/types.h>
 
 struct InstanceInfo {
@@ -34,10 +38,32 @@ QDataStream& operator>>(QDataStream& stream, RelaunchInfo& info);
 
 namespace qs::crash {
 
+// Data accepted by a buffered writer but not yet written to its fd. On crash, the handler writes
+// prefix then data, covering only whole records.
+//
+// The handler claims the data by exchanging state with CLAIMED, and the writer takes it back
+// by exchanging it with 0 before writing it itself, so no byte is written by both. A writer
+// that finds the data claimed must leave it and its fd alone until the process is replaced.
+struct PendingWrites {
+	static constexpr qint64 CLAIMED = -1;
+	static constexpr qsizetype MAX_PREFIX = 16;
+
+	const char* data = nullptr;
+	// Written before data, such as a frame header. The writer alternates between two slots so
+	// the published one is never modified.
+	std::array<std::array<char, MAX_PREFIX>, 2> prefixes {};
+	std::array<size_t, 2> prefixSizes {};
+	// Published length of data shifted left by one with the prefix slot in the low bit,
+	// or CLAIMED.
+	std::atomic<qint64> state = 0;
+};
+
 struct CrashInfo {
 	int logFd = -1;
 	int traceFd = -1;
 	int infoFd = -1;
+	// Unflushed tail of logFd.
+	PendingWrites* pendingLog = nullptr;
 
 	static CrashInfo INSTANCE; // NOLINT
 };
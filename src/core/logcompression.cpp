@@ -0,0 +1,187 @@
+#include "logcompression.hpp"
+#include <algorithm>
+#include <cstring>
+
+#include <qbytearray.h>
+#include <qbytearrayview.h>
+#include <qendian.h>
+#include <qtypes.h>
+
+namespace qs::log {
+
+namespace {
+
+quint32 read32(const char* data) { return qFromUnaligned<quint32>(data); }
+
+void writeLength(QByteArray* out, qsizetype length) {
+	while (length >= 0xff) {
+		out->append(static_cast<char>(0xff));
+		length -= 0xff;
+	}
+
+	out->append(static_cast<char>(length));
+}
+
+// Reads the remainder of a length field with a saturated nibble.
+bool readLength(const char** in, const char* end, qsizetype* length) {
+	quint8 byte = 0xff;
+
+	while (byte == 0xff) {
+		if (*in == end) return false;
+		byte = static_cast<quint8>(**in);
+		(*in)++; // NOLINT
+		*length += byte;
+	}
+
+	return true;
+}
+
+} // namespace
+
+void LogCompressor::write(QByteArrayView data) {
+	// Trim between frames so the current frame is never moved.
+	if (this->frameStart == this->history.size() && this->history.size() >= lz::WINDOW_SIZE * 2) {
+		auto drop = this->history.size() - lz::WINDOW_SIZE;
+		this->history.remove(0, drop);
+		this->historyBase += drop;
+		this->frameStart -= drop;
+	}
+
+	this->history.append(data);
+}
+
+bool LogCompressor::finishFrame(QByteArray* out) {
+	auto start = this->frameStart;
+	auto end = this->history.size();
+	this->frameStart = end;
+
+	if (!out) return false;
+	out->clear();
+
+	const auto* data = this->history.constData();
+	auto inputSize = end - start;
+	auto floor = std::max<qsizetype>(this->restartOffset - this->historyBase, 0);
+
+	auto writeSequence = [&](qsizetype literalStart, qsizetype literals, qsizetype matchLength) {
+		auto token = std::min<qsizetype>(literals, 0xf) << 4 | std::min<qsizetype>(matchLength, 0xf);
+		out->append(static_cast<char>(token));
+		if (literals >= 0xf) writeLength(out, literals - 0xf);
+		out->append(data + literalStart, literals); // NOLINT
+	};
+
+	auto anchor = start;
+	auto i = start;
+
+	while (i + lz::MIN_MATCH <= end) {
+		auto sequence = read32(data + i); // NOLINT
+		auto& slot = this->table.at((sequence * 2654435761u) >> (32 - HASH_BITS));
+		auto candidate = static_cast<qsizetype>(slot - this->historyBase);
+		slot = this->historyBase + i;
+
+		if (candidate < floor || candidate >= i || i - candidate > lz::MAX_OFFSET
+		    || read32(data + candidate) != sequence) // NOLINT
+		{
+			i++;
+			continue;
+		}
+
+		auto length = lz::MIN_MATCH;
+		while (i + length < end && data[candidate + length] == data[i + length]) length++; // NOLINT
+
+		while (i > anchor && candidate > floor && data[i - 1] == data[candidate - 1]) { // NOLINT
+			i--;
+			candidate--;
+			length++;
+		}
+
+		auto matchLength = length - lz::MIN_MATCH;
+		writeSequence(anchor, i - anchor, matchLength);
+
+		auto offset = qToLittleEndian(static_cast<quint16>(i - candidate));
+		out->append(reinterpret_cast<const char*>(&offset), 2);
+		if (matchLength >= 0xf) writeLength(out, matchLength - 0xf);
+
+		if (out->size() >= inputSize) return false;
+
+		i += length;
+		anchor = i;
+	}
+
+	// The last sequence has no match, which the decoder knows from reaching the frame's size.
+	writeSequence(anchor, end - anchor, 0);
+	return out->size() < inputSize;
+}
+
+void LogCompressor::restart() {
+	this->historyBase += this->history.size();
+	this->history.clear();
+	this->frameStart = 0;
+	this->restartOffset = this->historyBase;
+}
+
+bool LogDecompressor::decompress(QByteArrayView frame, qsizetype rawSize, QByteArray* out) {
+	this->trimHistory();
+
+	auto start = this->history.size();
+	this->history.resize(start + rawSize);
+
+	auto* dst = this->history.data();
+	auto op = start;
+	auto end = start + rawSize;
+	const auto* ip = frame.constData();
+	const auto* ipEnd = frame.constData() + frame.size(); // NOLINT
+
+	auto fail = [&]() {
+		this->history.resize(start);
+		return false;
+	};
+
+	while (true) {
+		if (ip == ipEnd) return fail();
+		auto token = static_cast<quint8>(*ip++); // NOLINT
+
+		qsizetype literals = token >> 4;
+		if (literals == 0xf && !readLength(&ip, ipEnd, &literals)) return fail();
+		if (ipEnd - ip < literals || end - op < literals) return fail();
+
+		std::memcpy(dst + op, ip, literals); // NOLINT
+		ip += literals;                      // NOLINT
+		op += literals;
+
+		if (op == end) break;
+
+		if (ipEnd - ip < 2) return fail();
+		auto offset = qFromLittleEndian<quint16>(ip);
+		ip += 2; // NOLINT
+
+		qsizetype length = token & 0xf;
+		if (length == 0xf && !readLength(&ip, ipEnd, &length)) return fail();
+		length += lz::MIN_MATCH;
+
+		if (offset == 0 || offset > op || end - op < length) return fail();
+
+		// Byte by byte, as the reference may overlap the output.
+		for (auto* match = dst + op - offset; length != 0; length--) { // NOLINT
+			dst[op++] = *match++;                                       // NOLINT
+		}
+	}
+
+	if (ip != ipEnd) return fail();
+
+	out->append(QByteArrayView(this->history).sliced(start));
+	return true;
+}
+
+void LogDecompressor::store(QByteArrayView data) {
+	this->trimHistory();
+	this->history.append(data);
+}
+
+void LogDecompressor::restart() { this->history.clear(); }
+
+void LogDecompressor::trimHistory() {
+	if (this->history.size() < lz::WINDOW_SIZE * 2) return;
+	this->history.remove(0, this->history.size() - lz::WINDOW_SIZE);
+}
+
+} // namespace qs::log
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <array>
+
+#include <qbytearray.h>
+#include <qbytearrayview.h>
+#include <qtypes.h>
+
+namespace qs::log {
+
+// LZ77 codec for the detailed log's block layer.
+//
+// Frames are encoded as LZ4 style sequences of literals followed by a back reference. References
+// may point into earlier frames, so a frame only decodes after every frame since the last
+// restart has been decoded. Frames are usually a handful of messages, which compress poorly on
+// their own.
+namespace lz {
+
+constexpr qsizetype MIN_MATCH = 4;
+constexpr qsizetype MAX_OFFSET = 0xffff;
+// History kept around for back references. Trimmed down to this when it reaches double the size.
+constexpr qsizetype WINDOW_SIZE = MAX_OFFSET + 1;
+
+} // namespace lz
+
+class LogCompressor {
+public:
+	// Appends data to the current frame.
+	void write(QByteArrayView data);
+
+	// Ends the current frame, compressing it into out if out is not null.
+	// Returns false if the frame was not compressed or compressing it would not make it smaller,
+	// in which case it must be stored as is. Either way the frame becomes part of the history.
+	bool finishFrame(QByteArray* out);
+
+	// Prevents frames after the current one from referencing anything before it.
+	void restart();
+
+private:
+	static constexpr int HASH_BITS = 13;
+
+	QByteArray history;
+	// Stream offset of the first byte in history.
+	qint64 historyBase = 0;
+	// Stream offset of the last restart. References can't cross it.
+	qint64 restartOffset = 0;
+	// Index of the current frame in history.
+	qsizetype frameStart = 0;
+	// Stream offsets of the last position each hashed sequence was seen at.
+	std::array<qint64, 1 << HASH_BITS> table {};
+};
+
+class LogDecompressor {
+public:
+	// Decompresses a frame and appends its rawSize bytes of output to out.
+	// Returns false if the frame is corrupt, in which case nothing is appended.
+	[[nodiscard]] bool decompress(QByteArrayView frame, qsizetype rawSize, QByteArray* out);
+	// Adds a stored frame to the history.
+	void store(QByteArrayView data);
+	void restart();
+
+private:
+	void trimHistory();
+
+	QByteArray history;
+};
+
+} // namespace qs::log
@@ -1,13 +1,20 @@
 #include "logging.hpp"
+#include <algorithm>
 #include <array>
+#include <atomic>
 #include <cerrno>
 #include <cstdio>
+#include <cstring>
 
 #include <fcntl.h>
+#include <qatomic.h>
+#include <qbuffer.h>
 #include <qbytearrayview.h>
 #include <qcoreapplication.h>
 #include <qdatetime.h>
 #include <qendian.h>
+#include <qfile.h>
+#include <qfiledevice.h>
 #include <qfilesystemwatcher.h>
 #include <qhash.h>
 #include <qhashfunctions.h>
@@ -19,22 +26,23 @@
 #include <qobject.h>
 #include <qobjectdefs.h>
 #include <qpair.h>
+#include <qregularexpression.h>
 #include <qstring.h>
 #include <qstringview.h>
 #include <qsysinfo.h>
 #include <qtenvironmentvariables.h>
 #include <qtextstream.h>
 #include <qthread.h>
+#include <qthreadpool.h>
 #include <qtmetamacros.h>
 #include <qtypes.h>
 #include <sys/mman.h>
+#include <sys/uio.h>
 #ifdef __linux__
 #include <sys/sendfile.h>
 #include <sys/types.h>
 #endif
-#ifdef __FreeBSD__
 #include <unistd.h>
-#endif
 
 #include "instanceinfo.hpp"
 #include "logcat.hpp"
@@ -99,6 +107,84 @@ bool copyFileData(int sourceFd, int destFd, qint64 size) {
 	return true;
 #endif
 }
+
+bool writeFully(int fd, iovec* iov, int count) {
+	while (count > 0) {
+		auto r = writev(fd, iov, count);
+		if (r == -1) {
+			if (errno == EINTR) continue;
+			return false;
+		}
+
+		auto written = static_cast<size_t>(r);
+
+		while (count > 0 && written >= iov->iov_len) {
+			written -= iov->iov_len;
+			iov++; // NOLINT
+			count--;
+		}
+
+		if (count > 0) {
+			iov->iov_base = static_cast<char*>(iov->iov_base) + written; // NOLINT
+			iov->iov_len -= written;
+		}
+	}
+
+	return true;
+}
+
+// The crash handler owns pending data once it claims it, and replaces the process after writing
+// it out. Touching the data or the device before then would corrupt what it writes.
+[[noreturn]] void waitForCrashHandler() {
+	while (true) pause();
+}
+
+void writeFrameHeader(char* header, LogFrameType type, qsizetype rawSize, qsizetype size) {
+	header[0] = static_cast<char>(type);                        // NOLINT
+	qToLittleEndian(static_cast<quint32>(rawSize), header + 1); // NOLINT
+	qToLittleEndian(static_cast<quint32>(size), header + 5);    // NOLINT
+}
+
+// Frames are written from a 64KiB arena, unless a single record is larger than that.
+// Anything past this is corrupt.
+constexpr quint32 FRAME_MAX_SIZE = 256 * 1024 * 1024;
+
+constexpr auto SYNC_MAGIC = QByteArrayView("qs-sync");
+// opcode, magic, record length and record checksum
+constexpr qsizetype SYNC_HEADER_SIZE = 1 + SYNC_MAGIC.size() + 4 + 4;
+// previous offset, message index and time
+constexpr qsizetype SYNC_RECORD_FIXED_SIZE = 8 + 8 + 8;
+constexpr quint32 SYNC_RECORD_MAX_SIZE = 64 * 1024 * 1024;
+
+// FNV-1a, used to reject sync point markers that happen to appear in message bodies.
+quint32 syncChecksum(QByteArrayView data) {
+	quint32 hash = 2166136261;
+
+	for (auto byte: data) {
+		hash ^= static_cast<quint8>(byte);
+		hash *= 16777619;
+	}
+
+	return hash;
+}
+
+quint8 categoryFlags(const CategoryFilter& filter) {
+	quint8 flags = 0;
+	flags |= filter.debug << 0;
+	flags |= filter.info << 1;
+	flags |= filter.warn << 2;
+	flags |= filter.critical << 3;
+	return flags;
+}
+
+CategoryFilter categoryFilterFromFlags(quint8 flags) {
+	CategoryFilter filter;
+	filter.debug = (flags >> 0) & 1;
+	filter.info = (flags >> 1) & 1;
+	filter.warn = (flags >> 2) & 1;
+	filter.critical = (flags >> 3) & 1;
+	return filter;
+}
 } // namespace
 
 bool LogMessage::operator==(const LogMessage& other) const {
@@ -401,8 +487,12 @@ void ThreadLogging::init() {
 		}
 	}
 
+	// Logs live in /run, which is usually memory backed.
+	this->detailedWriter.setCompressed(!qEnvironmentVariableIsSet("QS_NO_LOG_COMPRESSION"));
+
 	if (dlogMfd != -1) {
 		crash::CrashInfo::INSTANCE.logFd = dlogMfd;
+		crash::CrashInfo::INSTANCE.pendingLog = this->detailedWriter.pendingWrites();
 
 		this->detailedFile = new QFile();
 		// buffered by WriteBuffer
@@ -546,6 +636,7 @@ void ThreadLogging::initFs() {
 	    Qt::QueuedConnection
 	);
 
+	this->groupCommit = true;
 	qCDebug(logLogging) << "Switched threaded logger to queued event loop connection.";
 }
 
@@ -553,17 +644,41 @@ void ThreadLogging::onMessage(const LogMessage& msg, bool showInSparse) {
 	if (showInSparse) {
 		if (this->fileStream.device() == nullptr) return;
 		LogMessage::formatMessage(this->fileStream, msg, false, true);
-		this->fileStream << Qt::endl;
+		this->fileStream << '\n';
 	}
 
-	if (!this->detailedWriter.write(msg) || (this->detailedFile && !this->detailedFile->flush())) {
-		this->detailedWriter.setDevice(nullptr);
+	if (!this->detailedWriter.write(msg)) {
+		this->endDetailedLogs();
+	}
 
-		if (this->detailedFile) {
-			this->detailedFile->close();
-			this->detailedFile = nullptr;
-			qCCritical(logLogging) << "Detailed logger failed to write. Ending detailed logs.";
-		}
+	// Fatal messages are followed by an abort, so there won't be another chance to write them.
+	if (!this->groupCommit || msg.type == QtFatalMsg) {
+		this->flushLogs();
+	} else if (!this->flushScheduled) {
+		this->flushScheduled = true;
+		// Runs after every message already queued for this thread.
+		QMetaObject::invokeMethod(this, &ThreadLogging::flushLogs, Qt::QueuedConnection);
+	}
+}
+
+void ThreadLogging::flushLogs() {
+	this->flushScheduled = false;
+
+	if (this->fileStream.device() != nullptr) this->fileStream.flush();
+
+	if (this->detailedFile && !this->detailedWriter.flush()) {
+		this->endDetailedLogs();
+	}
+}
+
+void ThreadLogging::endDetailedLogs() {
+	this->detailedWriter.setDevice(nullptr);
+	crash::CrashInfo::INSTANCE.pendingLog = nullptr;
+
+	if (this->detailedFile) {
+		this->detailedFile->close();
+		this->detailedFile = nullptr;
+		qCCritical(logLogging) << "Detailed logger failed to write. Ending detailed logs.";
 	}
 }
 
@@ -590,18 +705,215 @@ QtMsgType typeOfCompressed(CompressedLogType type) {
 	return QtInfoMsg; // unreachable under normal conditions
 }
 
-void WriteBuffer::setDevice(QIODevice* device) { this->device = device; }
+WriteBuffer::WriteBuffer() { this->pending.data = this->arena.data(); }
+
+void WriteBuffer::setDevice(QFileDevice* device) { this->device = device; }
 bool WriteBuffer::hasDevice() const { return this->device; }
 
+void WriteBuffer::setCompressed(bool compressed) {
+	this->compressed = compressed;
+	this->reset();
+}
+
+qsizetype WriteBuffer::bufferedSize() const { return this->size + this->overflow.size(); }
+
+qint64 WriteBuffer::deviceOffset() const {
+	return this->compressed ? this->writtenBytes : this->writtenBytes + this->bufferedSize();
+}
+
+template <typename F>
+void WriteBuffer::forEachChunk(qsizetype start, qsizetype end, F fn) const {
+	if (start < this->size) fn(this->arena.data() + start, std::min(end, this->size) - start);
+
+	if (end > this->size) {
+		auto overflowStart = std::max<qsizetype>(start - this->size, 0);
+		fn(this->overflow.constData() + overflowStart, end - this->size - overflowStart); // NOLINT
+	}
+}
+
+void WriteBuffer::reset() {
+	this->reclaim();
+	this->size = 0;
+	this->overflow.clear();
+	this->committed = 0;
+	this->frameType = LogFrameType::Compressed;
+	this->frameSplit = -1;
+}
+
 bool WriteBuffer::flush() {
-	auto written = this->device->write(this->buffer);
-	auto success = written == this->buffer.length();
-	this->buffer.clear();
+	auto success = !this->failed && this->writeOut();
+	if (!success) this->reset();
+
+	this->failed = false;
+	return success;
+}
+
+void WriteBuffer::startFrame(LogFrameType type) {
+	if (!this->compressed) return;
+
+	if (type == LogFrameType::Restart) {
+		// Everything buffered is committed, so this leaves the restart frame at the start.
+		if (!this->writeOut()) this->failed = true;
+		this->frameType = LogFrameType::Restart;
+	} else if (this->frameType == LogFrameType::Restart && this->frameSplit == -1) {
+		this->frameSplit = this->bufferedSize();
+	}
+}
+
+void WriteBuffer::writeFrame(LogFrameType type, qsizetype start, qsizetype end) {
+	if (type == LogFrameType::Restart) this->compressor.restart();
+
+	this->forEachChunk(start, end, [this](const char* data, qsizetype length) {
+		this->compressor.write(QByteArrayView(data, length));
+	});
+
+	auto header = std::array<char, LOG_FRAME_HEADER_SIZE>();
+	auto size = end - start;
+	auto compress = type == LogFrameType::Compressed;
+
+	if (this->compressor.finishFrame(compress ? &this->compressedFrame : nullptr)) {
+		writeFrameHeader(header.data(), LogFrameType::Compressed, size, this->compressedFrame.size());
+		this->frameOutput.append(header.data(), header.size());
+		this->frameOutput.append(this->compressedFrame);
+	} else {
+		if (type != LogFrameType::Restart) type = LogFrameType::Stored;
+		writeFrameHeader(header.data(), type, size, size);
+		this->frameOutput.append(header.data(), header.size());
+
+		this->forEachChunk(start, end, [this](const char* data, qsizetype length) {
+			this->frameOutput.append(data, length);
+		});
+	}
+}
+
+bool WriteBuffer::writeOut() {
+	auto length = this->committed;
+	auto success = this->device && this->device->handle() != -1;
+	if (length == 0) return success;
+
+	this->reclaim();
+
+	auto iov = std::array<iovec, 2>();
+	auto count = 0;
+
+	if (this->compressed) {
+		this->frameOutput.clear();
+
+		if (this->frameType == LogFrameType::Restart) {
+			auto split = this->frameSplit == -1 ? length : std::min(this->frameSplit, length);
+			this->writeFrame(LogFrameType::Restart, 0, split);
+			if (split != length) this->writeFrame(LogFrameType::Compressed, split, length);
+		} else {
+			this->writeFrame(LogFrameType::Compressed, 0, length);
+		}
+
+		iov.at(count++) = {
+		    .iov_base = this->frameOutput.data(),
+		    .iov_len = static_cast<size_t>(this->frameOutput.size()),
+		};
+	} else {
+		this->forEachChunk(0, length, [&](const char* data, qsizetype chunk) {
+			iov.at(count++) = {
+			    .iov_base = const_cast<char*>(data), // NOLINT
+			    .iov_len = static_cast<size_t>(chunk),
+			};
+		});
+	}
+
+	qint64 written = 0;
+	for (auto i = 0; i != count; i++) written += static_cast<qint64>(iov.at(i).iov_len);
+
+	success = success && writeFully(this->device->handle(), iov.data(), count);
+	if (success) this->writtenBytes += written;
+
+	this->consume(length);
 	return success;
 }
 
+void WriteBuffer::consume(qsizetype length) {
+	// The overflow buffer only holds the end of the last record, so it is never partially consumed.
+	auto fromArena = std::min(length, this->size);
+	auto* data = this->arena.data();
+	std::memmove(data, data + fromArena, this->size - fromArena); // NOLINT
+	this->size -= fromArena;
+	this->overflow.remove(0, length - fromArena);
+
+	// Consumed data always covers the whole restart frame, as it is part of the first record.
+	this->committed -= length;
+	this->frameType = LogFrameType::Compressed;
+	this->frameSplit = -1;
+}
+
+void WriteBuffer::publish() {
+	auto slot = this->prefixSlot ^ 1;
+
+	if (this->compressed) {
+		// The crash handler knows nothing about frames, so it writes everything as one.
+		auto type = this->frameType == LogFrameType::Restart ? LogFrameType::Restart
+		                                                     : LogFrameType::Stored;
+
+		auto& prefix = this->pending.prefixes.at(slot);
+		writeFrameHeader(prefix.data(), type, this->committed, this->committed);
+		this->pending.prefixSizes.at(slot) = LOG_FRAME_HEADER_SIZE;
+	}
+
+	auto state = this->pending.state.load(std::memory_order_relaxed);
+	auto next = (static_cast<qint64>(this->committed) << 1) | slot;
+
+	do {
+		if (state == crash::PendingWrites::CLAIMED) waitForCrashHandler();
+	} while (!this->pending.state.compare_exchange_weak(state, next, std::memory_order_acq_rel));
+
+	this->prefixSlot = slot;
+}
+
+void WriteBuffer::reclaim() {
+	auto state = this->pending.state.load(std::memory_order_relaxed);
+
+	do {
+		if (state == crash::PendingWrites::CLAIMED) waitForCrashHandler();
+	} while (!this->pending.state.compare_exchange_weak(state, 0, std::memory_order_acq_rel));
+}
+
+bool WriteBuffer::commit() {
+	this->committed = this->bufferedSize();
+
+	if (this->overflow.isEmpty()) {
+		this->publish();
+	} else if (!this->writeOut()) {
+		// Records too large for the arena are written out immediately instead of being published.
+		this->failed = true;
+	}
+
+	return !this->failed;
+}
+
 void WriteBuffer::writeBytes(const char* data, qsizetype length) {
-	this->buffer.append(data, length);
+	this->mPosition += length;
+
+	if (!this->overflow.isEmpty()) {
+		this->overflow.append(data, length);
+		return;
+	}
+
+	while (length > 0) {
+		if (this->size == ARENA_SIZE) {
+			if (this->committed == 0) {
+				// The current record fills the arena by itself and continues in the overflow buffer.
+				this->overflow.append(data, length);
+				return;
+			}
+
+			// Size threshold reached, write out complete records now. Failures are reported on commit.
+			if (!this->writeOut()) this->failed = true;
+		}
+
+		auto chunk = std::min(length, ARENA_SIZE - this->size);
+		std::memcpy(this->arena.data() + this->size, data, chunk); // NOLINT
+		this->size += chunk;
+		data += chunk; // NOLINT
+		length -= chunk;
+	}
 }
 
 void WriteBuffer::writeU8(quint8 data) { this->writeBytes(reinterpret_cast<char*>(&data), 1); }
@@ -625,14 +937,138 @@ void DeviceReader::setDevice(QIODevice* device) { this->device = device; }
 bool DeviceReader::hasDevice() const { return this->device; }
 
 bool DeviceReader::readBytes(char* data, qsizetype length) {
-	return this->device->read(data, length) == length;
+	if (!this->mBlockDecoding) {
+		auto r = this->device->read(data, length);
+		if (r == -1) this->mCorrupt = true;
+		return r == length;
+	}
+	if (!this->fill(length)) return false;
+
+	std::memcpy(data, this->decoded.constData() + this->decodedOffset, length); // NOLINT
+	this->decodedOffset += length;
+	this->decodedConsumed += length;
+	return true;
 }
 
 qsizetype DeviceReader::peekBytes(char* data, qsizetype length) {
-	return this->device->peek(data, length);
+	if (!this->mBlockDecoding) return this->device->peek(data, length);
+
+	this->fill(length);
+	length = std::min(length, this->decoded.size() - this->decodedOffset);
+	std::memcpy(data, this->decoded.constData() + this->decodedOffset, length); // NOLINT
+	return length;
+}
+
+bool DeviceReader::skip(qsizetype length) {
+	if (!this->mBlockDecoding) return this->device->skip(length) == length;
+	if (!this->fill(length)) return false;
+
+	this->decodedOffset += length;
+	this->decodedConsumed += length;
+	return true;
+}
+
+bool DeviceReader::readRawBytes(char* data, qsizetype length) {
+	return this->device->read(data, length) == length;
+}
+
+void DeviceReader::startTransaction() {
+	this->inTransaction = true;
+	this->mCorrupt = false;
+
+	if (this->mBlockDecoding) {
+		this->transactionOffset = this->decodedOffset;
+		this->transactionPosition = this->decodedConsumed;
+	} else {
+		this->transactionPosition = this->device->pos();
+	}
 }
 
-bool DeviceReader::skip(qsizetype length) { return this->device->skip(length) == length; }
+void DeviceReader::commitTransaction() { this->inTransaction = false; }
+
+void DeviceReader::rollbackTransaction() {
+	if (!this->inTransaction) return;
+	this->inTransaction = false;
+
+	if (this->mBlockDecoding) {
+		this->decodedOffset = this->transactionOffset;
+		this->decodedConsumed = this->transactionPosition;
+	} else {
+		this->device->seek(this->transactionPosition);
+	}
+}
+
+bool DeviceReader::atEnd() const {
+	if (this->mBlockDecoding && this->decodedOffset != this->decoded.size()) return false;
+	return this->device->atEnd();
+}
+
+bool DeviceReader::fill(qsizetype length) {
+	while (this->decoded.size() - this->decodedOffset < length) {
+		// Data after the start of a transaction may be needed again.
+		auto consumed = this->inTransaction ? this->transactionOffset : this->decodedOffset;
+
+		if (consumed != 0) {
+			this->decoded.remove(0, consumed);
+			this->decodedOffset -= consumed;
+			if (this->inTransaction) this->transactionOffset = 0;
+		}
+
+		if (!this->decodeFrame()) return false;
+	}
+
+	return true;
+}
+
+bool DeviceReader::decodeFrame() {
+	auto header = std::array<char, LOG_FRAME_HEADER_SIZE>();
+	if (this->device->peek(header.data(), header.size()) != LOG_FRAME_HEADER_SIZE) return false;
+
+	auto type = static_cast<LogFrameType>(header[0]);
+	auto rawSize = qFromLittleEndian<quint32>(header.data() + 1); // NOLINT
+	auto size = qFromLittleEndian<quint32>(header.data() + 5);    // NOLINT
+
+	if (type > LogFrameType::Restart || rawSize > FRAME_MAX_SIZE || size > FRAME_MAX_SIZE
+	    || (type != LogFrameType::Compressed && size != rawSize))
+	{
+		qCWarning(logLogging) << "Invalid frame header in log at offset" << this->device->pos();
+		this->mCorrupt = true;
+		return false;
+	}
+
+	// The frame is still being written. It will be read once complete.
+	if (this->device->bytesAvailable() < LOG_FRAME_HEADER_SIZE + size) return false;
+
+	auto start = this->device->pos();
+	this->frame.resize(size);
+
+	if (!this->device->skip(LOG_FRAME_HEADER_SIZE)
+	    || this->device->read(this->frame.data(), size) != size)
+	{
+		this->mCorrupt = true;
+		return false;
+	}
+
+	switch (type) {
+	case LogFrameType::Compressed: {
+		if (!this->decompressor.decompress(this->frame, rawSize, &this->decoded)) {
+			qCWarning(logLogging) << "Failed to decompress log frame at offset" << start;
+			// Leave it unread so it won't be mistaken for the end of the log.
+			this->device->seek(start);
+			this->mCorrupt = true;
+			return false;
+		}
+	} break;
+	case LogFrameType::Restart:
+	case LogFrameType::Stored: {
+		if (type == LogFrameType::Restart) this->decompressor.restart();
+		this->decompressor.store(this->frame);
+		this->decoded.append(this->frame);
+	} break;
+	}
+
+	return true;
+}
 
 bool DeviceReader::readU8(quint8* data) {
 	return this->readBytes(reinterpret_cast<char*>(data), 1);
@@ -650,26 +1086,74 @@ bool DeviceReader::readU64(quint64* data) {
 	return this->readBytes(reinterpret_cast<char*>(data), 8);
 }
 
-void EncodedLogWriter::setDevice(QIODevice* target) { this->buffer.setDevice(target); }
+bool DeviceReader::seek(qint64 position) {
+	this->inTransaction = false;
+	this->mCorrupt = false;
+	this->decoded.clear();
+	this->decodedOffset = 0;
+	this->decompressor.restart();
+	return this->device->seek(position);
+}
+
+bool DeviceReader::atRestartFrame() {
+	char type = 0;
+	return this->device->peek(&type, 1) == 1
+	    && static_cast<LogFrameType>(type) == LogFrameType::Restart;
+}
+
+qint64 DeviceReader::position() const { return this->device->pos(); }
+qint64 DeviceReader::size() const { return this->device->size(); }
+
+qint64 DeviceReader::streamPosition() const {
+	return this->mBlockDecoding ? this->decodedConsumed : this->device->pos();
+}
+
+void EncodedLogWriter::setDevice(QFileDevice* target) { this->buffer.setDevice(target); }
 void EncodedLogReader::setDevice(QIODevice* source) { this->reader.setDevice(source); }
 
-constexpr quint8 LOG_VERSION = 2;
+constexpr quint8 LOG_VERSION = 4;
 
 bool EncodedLogWriter::writeHeader() {
 	this->buffer.writeU8(LOG_VERSION);
-	return this->buffer.flush();
+	this->buffer.writeU8(this->compressed ? EncodedLogFlag::BlockCompression : 0);
+	auto success = this->buffer.commit() && this->buffer.flush();
+
+	// The header itself is never framed.
+	this->buffer.setCompressed(this->compressed);
+	return success;
 }
 
+bool EncodedLogWriter::flush() { return this->buffer.flush(); }
+
 bool EncodedLogReader::readHeader(bool* success, quint8* version, quint8* readerVersion) {
 	if (!this->reader.readU8(version)) return false;
-	*success = *version == LOG_VERSION;
+	// Version 2 is identical aside from lacking sync points, which shifts category ids down by one.
+	// Version 3 lacks the flags byte.
+	*success = *version >= 2 && *version <= LOG_VERSION;
 	*readerVersion = LOG_VERSION;
+
+	if (*version == 2) this->beginCategories = EncodedLogOpcode::SyncPoint;
+
+	if (*version >= 4) {
+		quint8 flags = 0;
+		if (!this->reader.readU8(&flags)) return false;
+		if ((flags & ~EncodedLogFlag::BlockCompression) != 0) *success = false;
+		this->reader.setBlockDecoding(flags & EncodedLogFlag::BlockCompression);
+	}
+
+	this->dataStart = this->reader.position();
 	return true;
 }
 
 bool EncodedLogWriter::write(const LogMessage& message) {
 	if (!this->buffer.hasDevice()) return false;
 
+	if (this->lastSyncPoint == 0
+	    || this->buffer.position() - this->lastSyncPosition >= this->syncInterval)
+	{
+		this->writeSyncPoint();
+	}
+
 	LogMessage* prevMessage = nullptr;
 	auto index = this->recentMessages.indexOf(message, &prevMessage);
 
@@ -731,18 +1215,97 @@ bool EncodedLogWriter::write(const LogMessage& message) {
 finish:
 	// copy with second precision
 	this->lastMessageTime = QDateTime::fromSecsSinceEpoch(message.time.toSecsSinceEpoch());
-	return this->buffer.flush();
+	this->messageCount++;
+	return this->buffer.commit();
+}
+
+void EncodedLogWriter::writeSyncPoint() {
+	auto record = QByteArray();
+
+	auto append = [&record]<typename T>(T value) {
+		value = qToLittleEndian(value);
+		record.append(reinterpret_cast<const char*>(&value), sizeof(T)); // NOLINT
+	};
+
+	auto appendBytes = [&](QByteArrayView bytes) {
+		append(static_cast<quint32>(bytes.size()));
+		record.append(bytes);
+	};
+
+	append(static_cast<quint64>(this->lastSyncPoint));
+	append(static_cast<quint64>(this->messageCount));
+	append(static_cast<quint64>(this->lastMessageTime.toSecsSinceEpoch()));
+
+	auto categoryNames = QList<QLatin1StringView>(this->categories.size());
+	for (auto [name, id]: this->categories.asKeyValueRange()) {
+		categoryNames[id - EncodedLogOpcode::BeginCategories] = name;
+	}
+
+	append(static_cast<quint32>(categoryNames.size()));
+	for (const auto& name: categoryNames) {
+		appendBytes(name);
+		append(categoryFlags(LogManager::instance()->getFilter(name)));
+	}
+
+	// Oldest first, so emplacing them in order rebuilds the ring.
+	append(static_cast<quint32>(this->recentMessages.size()));
+	for (auto i = this->recentMessages.size() - 1; i != -1; i--) {
+		const auto& recent = this->recentMessages.at(i);
+		auto categoryId = this->categories.value(recent.category) - EncodedLogOpcode::BeginCategories;
+
+		append(static_cast<quint16>(categoryId));
+		append(static_cast<quint8>(recent.type == QtFatalMsg ? 0xff : compressedTypeOf(recent.type)));
+		appendBytes(recent.body);
+	}
+
+	// With compression, the marker and fixed fields are left uncompressed at the start of a restart
+	// frame so they can be found by scanning the file. The rest is compressed with what follows.
+	this->buffer.startFrame(LogFrameType::Restart);
+	auto offset = this->buffer.deviceOffset();
+	this->lastSyncPosition = this->buffer.position();
+
+	this->writeOp(EncodedLogOpcode::SyncPoint);
+	this->buffer.writeBytes(SYNC_MAGIC.data(), SYNC_MAGIC.size());
+	this->buffer.writeU32(static_cast<quint32>(record.size()));
+	this->buffer.writeU32(syncChecksum(record));
+	this->buffer.writeBytes(record.constData(), SYNC_RECORD_FIXED_SIZE);
+	this->buffer.startFrame(LogFrameType::Compressed);
+	this->buffer.writeBytes(
+	    record.constData() + SYNC_RECORD_FIXED_SIZE, // NOLINT
+	    record.size() - SYNC_RECORD_FIXED_SIZE
+	);
+
+	this->lastSyncPoint = offset;
 }
 
 bool EncodedLogReader::read(LogMessage* slot) {
+	this->mCorrupt = false;
+
+	if (this->readRecord(slot)) {
+		this->reader.commitTransaction();
+		return true;
+	}
+
+	// Incomplete records are read again from their start once the rest has been written.
+	this->reader.rollbackTransaction();
+	return false;
+}
+
+bool EncodedLogReader::readRecord(LogMessage* slot) {
 start:
+	this->reader.startTransaction();
+
 	quint32 next = 0;
 	if (!this->readVarInt(&next)) return false;
 
-	if (next < EncodedLogOpcode::BeginCategories) {
+	if (next < this->beginCategories) {
 		if (next == EncodedLogOpcode::RegisterCategory) {
 			if (!this->registerCategory()) return false;
 			goto start;
+		} else if (next == EncodedLogOpcode::SyncPoint) {
+			// Reading sequentially, the decoder already has the state it contains.
+			if (!this->skipSyncPoint()) return false;
+			goto start;
 		} else if (next == EncodedLogOpcode::RecentMessageShort
 		           || next == EncodedLogOpcode::RecentMessageLong)
 		{
@@ -759,13 +1322,17 @@ start:
 				if (!this->readVarInt(&secondDelta)) return false;
 			}
 
-			if (index >= this->recentMessages.size()) return false;
+			if (index >= this->recentMessages.size()) {
+				this->mCorrupt = true;
+				return false;
+			}
+
 			*slot = this->recentMessages.at(index);
 			this->lastMessageTime = this->lastMessageTime.addSecs(static_cast<qint64>(secondDelta));
 			slot->time = this->lastMessageTime;
 		}
 	} else {
-		auto categoryId = next - EncodedLogOpcode::BeginCategories;
+		auto categoryId = next - this->beginCategories;
 		auto category = this->categories.value(categoryId);
 
 		quint8 field = 0;
@@ -795,11 +1362,11 @@ start:
 			if (!this->reader.readU64(&secondDelta)) return false;
 		}
 
-		this->lastMessageTime = this->lastMessageTime.addSecs(static_cast<qint64>(secondDelta));
-
 		QByteArray body;
 		if (!this->readString(&body)) return false;
 
+		this->lastMessageTime = this->lastMessageTime.addSecs(static_cast<qint64>(secondDelta));
+
 		*slot = LogMessage(msgType, QLatin1StringView(category.first), body, this->lastMessageTime);
 		slot->readCategoryId = categoryId;
 	}
@@ -873,14 +1440,7 @@ quint16 EncodedLogWriter::getOrCreateCategory(QLatin1StringView category) {
 		auto id = this->nextCategory++;
 		this->categories.insert(category, id);
 
-		auto filter = LogManager::instance()->getFilter(category);
-		quint8 flags = 0;
-		flags |= filter.debug << 0;
-		flags |= filter.info << 1;
-		flags |= filter.warn << 2;
-		flags |= filter.critical << 3;
-
-		this->buffer.writeU8(flags);
+		this->buffer.writeU8(categoryFlags(LogManager::instance()->getFilter(category)));
 		return id;
 	}
 }
@@ -891,16 +1451,189 @@ bool EncodedLogReader::registerCategory() {
 	if (!this->readString(&name)) return false;
 	if (!this->reader.readU8(&flags)) return false;
 
-	CategoryFilter filter;
-	filter.debug = (flags >> 0) & 1;
-	filter.info = (flags >> 1) & 1;
-	filter.warn = (flags >> 2) & 1;
-	filter.critical = (flags >> 3) & 1;
+	this->categories.append(qMakePair(name, categoryFilterFromFlags(flags)));
+	return true;
+}
+
+bool EncodedLogReader::skipSyncPoint() {
+	auto magic = std::array<char, SYNC_MAGIC.size()>();
+	quint32 length = 0;
+	quint32 checksum = 0;
+
+	if (!this->reader.readBytes(magic.data(), magic.size())) return false;
+
+	if (QByteArrayView(magic) != SYNC_MAGIC) {
+		this->mCorrupt = true;
+		return false;
+	}
 
-	this->categories.append(qMakePair(name, filter));
+	if (!this->reader.readU32(&length) || !this->reader.readU32(&checksum)) return false;
+	return this->reader.skip(length);
+}
+
+bool EncodedLogReader::readSyncPoint(qint64 offset, LogSyncPoint* point, QByteArray* record) {
+	if (offset < this->dataStart || !this->reader.seek(offset)) return false;
+	if (this->reader.blockDecoding() && !this->reader.atRestartFrame()) return false;
+
+	auto header = std::array<char, SYNC_HEADER_SIZE>();
+	if (!this->reader.readBytes(header.data(), header.size())) return false;
+
+	auto headerView = QByteArrayView(header);
+	if (headerView.at(0) != EncodedLogOpcode::SyncPoint) return false;
+	if (headerView.sliced(1, SYNC_MAGIC.size()) != SYNC_MAGIC) return false;
+
+	auto length = qFromLittleEndian<quint32>(headerView.sliced(1 + SYNC_MAGIC.size()).data());
+	auto checksum = qFromLittleEndian<quint32>(headerView.sliced(5 + SYNC_MAGIC.size()).data());
+	if (length < SYNC_RECORD_FIXED_SIZE || length > SYNC_RECORD_MAX_SIZE) return false;
+
+	auto data = QByteArray(length, Qt::Uninitialized);
+	if (!this->reader.readBytes(data.data(), data.size())) return false;
+	if (syncChecksum(data) != checksum) return false;
+
+	point->offset = offset;
+	point->previous = qFromLittleEndian<qint64>(data.constData());
+	point->messageIndex = qFromLittleEndian<quint64>(data.constData() + 8); // NOLINT
+	point->time = QDateTime::fromSecsSinceEpoch(
+	    qFromLittleEndian<qint64>(data.constData() + 16) // NOLINT
+	);
+
+	if (record) *record = std::move(data);
 	return true;
 }
 
+QList<LogSyncPoint> EncodedLogReader::findSyncPoints() {
+	auto points = QList<LogSyncPoint>();
+	if (this->beginCategories != EncodedLogOpcode::BeginCategories) return points;
+
+	auto marker = QByteArray(1, EncodedLogOpcode::SyncPoint) + SYNC_MAGIC;
+	constexpr qint64 CHUNK_SIZE = 64 * 1024;
+	// Compressed sync points are offset by the header of the frame they start.
+	auto markerOffset = this->reader.blockDecoding() ? LOG_FRAME_HEADER_SIZE : 0;
+
+	auto size = this->reader.size();
+	auto end = size;
+	auto chunk = QByteArray();
+	auto last = LogSyncPoint();
+	auto found = false;
+
+	// The last sync point is at most one interval plus one message from the end.
+	while (end > this->dataStart && !found) {
+		auto start = std::max<qint64>(this->dataStart, end - CHUNK_SIZE);
+		// Overlap the next chunk so markers crossing the boundary are found.
+		auto length = std::min<qint64>(end + marker.size() - 1, size) - start;
+
+		chunk.resize(length);
+		if (!this->reader.seek(start) || !this->reader.readRawBytes(chunk.data(), length)) {
+			return points;
+		}
+
+		for (auto index = chunk.lastIndexOf(marker); index != -1;
+		     index = index == 0 ? -1 : chunk.lastIndexOf(marker, index - 1))
+		{
+			if (this->readSyncPoint(start + index - markerOffset, &last, nullptr)) {
+				found = true;
+				break;
+			}
+		}
+
+		end = start;
+	}
+
+	if (!found) return points;
+	points.append(last);
+
+	while (points.last().previous != 0) {
+		auto point = LogSyncPoint();
+
+		if (!this->readSyncPoint(points.last().previous, &point, nullptr)
+		    || point.offset >= points.last().offset)
+		{
+			return {};
+		}
+
+		points.append(point);
+	}
+
+	// Only complete chains are usable, as decoding can't start before the first sync point.
+	if (points.last().messageIndex != 0) return {};
+
+	std::ranges::reverse(points);
+	return points;
+}
+
+bool EncodedLogReader::seekToSyncPoint(const LogSyncPoint& point) {
+	auto record = QByteArray();
+	auto parsed = LogSyncPoint();
+	if (!this->readSyncPoint(point.offset, &parsed, &record)) return false;
+
+	auto buffer = QBuffer(&record);
+	buffer.open(QBuffer::ReadOnly);
+	buffer.seek(SYNC_RECORD_FIXED_SIZE);
+
+	auto recordReader = DeviceReader();
+	recordReader.setDevice(&buffer);
+
+	auto readBytes = [&](QByteArray* slot) {
+		quint32 length = 0;
+		if (!recordReader.readU32(&length) || static_cast<qsizetype>(length) > record.size()) {
+			return false;
+		}
+
+		*slot = QByteArray(length, Qt::Uninitialized);
+		return recordReader.readBytes(slot->data(), length);
+	};
+
+	quint32 categoryCount = 0;
+	if (!recordReader.readU32(&categoryCount)) return false;
+
+	this->recentMessages.clear();
+	this->categories.clear();
+
+	for (quint32 i = 0; i != categoryCount; i++) {
+		auto name = QByteArray();
+		quint8 flags = 0;
+		if (!readBytes(&name) || !recordReader.readU8(&flags)) return false;
+		this->categories.append(qMakePair(name, categoryFilterFromFlags(flags)));
+	}
+
+	quint32 recentCount = 0;
+	if (!recordReader.readU32(&recentCount)) return false;
+
+	for (quint32 i = 0; i != recentCount; i++) {
+		quint16 categoryId = 0;
+		quint8 type = 0;
+		auto body = QByteArray();
+
+		if (!recordReader.readU16(&categoryId) || !recordReader.readU8(&type) || !readBytes(&body)) {
+			return false;
+		}
+
+		if (categoryId >= this->categories.size()) return false;
+
+		auto msgType =
+		    type == 0xff ? QtFatalMsg : typeOfCompressed(static_cast<CompressedLogType>(type & 0x07));
+
+		auto& message = this->recentMessages.emplace(
+		    msgType,
+		    QLatin1StringView(this->categories.at(categoryId).first),
+		    body,
+		    parsed.time
+		);
+
+		message.readCategoryId = categoryId;
+	}
+
+	this->lastMessageTime = parsed.time;
+	return true;
+}
+
+bool EncodedLogReader::rewind() {
+	this->categories.clear();
+	this->recentMessages.clear();
+	this->lastMessageTime = QDateTime::fromSecsSinceEpoch(0);
+	return this->reader.seek(this->dataStart);
+}
+
 bool LogReader::initialize() {
 	this->reader.setDevice(this->file);
 
@@ -920,42 +1653,56 @@ bool LogReader::initialize() {
 		return false;
 	}
 
+	if (this->remainingTail == 0 && !this->since.isValid()) return true;
+
+	this->syncPoints = this->reader.findSyncPoints();
+
+	if (this->since.isValid()) {
+		// Messages sharing the sync point's time may come before it, so start from an earlier one.
+		auto first = this->syncPoints.size() - 1;
+		while (first > 0 && this->syncPoints.at(first).time >= this->since) first--;
+		if (first > 0) this->syncPoints.remove(0, first);
+	}
+
+	if (this->syncPoints.isEmpty()) {
+		if (!this->reader.rewind()) return false;
+	} else if (!this->reader.seekToSyncPoint(this->syncPoints.first())) {
+		qCritical() << "Failed to read log sync point.";
+		return false;
+	}
+
 	return true;
 }
 
-bool LogReader::continueReading() {
+bool LogReader::continueReading(bool complete) {
 	auto color = LogManager::instance()->colorLogs;
 	auto tailRing = RingBuffer<LogMessage>(this->remainingTail);
-
-	LogMessage message;
 	auto stream = QTextStream(stdout);
-	auto readCursor = this->file->pos();
-	while (this->reader.read(&message)) {
-		readCursor = this->file->pos();
-
-		CategoryFilter filter;
-		if (this->filters.contains(message.readCategoryId)) {
-			filter = this->filters.value(message.readCategoryId);
-		} else {
-			filter = this->reader.categoryFilterById(message.readCategoryId);
+	auto success = true;
 
-			for (const auto& rule: this->rules) {
-				filter.applyRule(message.category, rule);
-			}
+	if (this->remainingTail != 0 && this->syncPoints.size() > 1) {
+		// Decode from progressively earlier sync points until enough messages pass the filters.
+		for (qsizetype step = 1;; step *= 2) {
+			auto index = std::max<qsizetype>(this->syncPoints.size() - step, 0);
 
-			this->filters.insert(message.readCategoryId, filter);
-		}
+			tailRing.clear();
+			this->reachedUntil = false;
 
-		if (filter.shouldDisplay(message.type)) {
-			if (this->remainingTail == 0) {
-				LogMessage::formatMessage(stream, message, color, this->timestamps);
-				stream << '\n';
-			} else {
-				tailRing.emplace(message);
+			if (!this->reader.seekToSyncPoint(this->syncPoints.at(index))) {
+				qCritical() << "Failed to read log sync point.";
+				return false;
 			}
+
+			success = this->readMessages(stream, tailRing);
+			if (!success || tailRing.size() == this->remainingTail || index == 0) break;
 		}
+	} else {
+		success = this->readMessages(stream, tailRing);
 	}
 
+	// Sync points are only used to find where the first read starts.
+	this->syncPoints.clear();
+
 	if (this->remainingTail != 0) {
 		for (auto i = tailRing.size() - 1; i != -1; i--) {
 			auto& message = tailRing.at(i);
@@ -966,15 +1713,71 @@ bool LogReader::continueReading() {
 
 	stream << Qt::flush;
 
-	if (this->file->pos() != readCursor) {
+	// Reported after the messages before the error, which are still worth showing.
+	if (!success) {
 		qCritical() << "An error occurred parsing the end of this log file.";
-		qCritical() << "Remaining data:" << this->file->readAll();
+		// The rest of the file may be compressed, so only its size is worth printing.
+		qCritical().nospace() << "Parsing stopped at stream position "
+		                      << this->reader.streamPosition() << ", with "
+		                      << this->file->bytesAvailable() << " bytes of the file unread.";
+		return false;
+	}
+
+	// Once nothing more will be written, anything left is a message that was cut off.
+	if (complete && !this->reachedUntil && !this->reader.atEnd()) {
+		qCritical() << "This log file ends with an incomplete message.";
 		return false;
 	}
 
 	return true;
 }
 
+bool LogReader::readMessages(QTextStream& stream, RingBuffer<LogMessage>& tailRing) {
+	if (this->reachedUntil) return true;
+
+	auto color = LogManager::instance()->colorLogs;
+
+	LogMessage message;
+	while (this->reader.read(&message)) {
+		// Message times never decrease, so nothing after this will be in range.
+		if (this->until.isValid() && message.time > this->until) {
+			this->reachedUntil = true;
+			return true;
+		}
+
+		if (!this->shouldDisplay(message)) continue;
+
+		if (this->remainingTail == 0) {
+			LogMessage::formatMessage(stream, message, color, this->timestamps);
+			stream << '\n';
+		} else {
+			tailRing.emplace(message);
+		}
+	}
+
+	// Messages that are still being written are left for the next read.
+	return !this->reader.corrupt();
+}
+
+bool LogReader::shouldDisplay(const LogMessage& message) {
+	if (this->since.isValid() && message.time < this->since) return false;
+
+	CategoryFilter filter;
+	if (this->filters.contains(message.readCategoryId)) {
+		filter = this->filters.value(message.readCategoryId);
+	} else {
+		filter = this->reader.categoryFilterById(message.readCategoryId);
+
+		for (const auto& rule: this->rules) {
+			filter.applyRule(message.category, rule);
+		}
+
+		this->filters.insert(message.readCategoryId, filter);
+	}
+
+	return filter.shouldDisplay(message.type);
+}
+
 void LogFollower::FcntlWaitThread::run() {
 	struct flock lock = {
 	    .l_type = F_RDLCK, // won't block other read locks when we take it
@@ -1011,13 +1814,13 @@ bool LogFollower::follow() {
 }
 
 void LogFollower::onFileChanged() {
-	if (!this->reader->continueReading()) {
+	if (!this->reader->continueReading(false)) {
 		QCoreApplication::exit(1);
 	}
 }
 
 void LogFollower::onFileLocked() {
-	if (!this->reader->continueReading()) {
+	if (!this->reader->continueReading(true)) {
 		QCoreApplication::exit(1);
 	} else {
 		QCoreApplication::exit(0);
@@ -1029,6 +1832,8 @@ bool readEncodedLogs(
     const QString& path,
     bool timestamps,
     int tail,
+    const QDateTime& since,
+    const QDateTime& until,
     bool follow,
     const QString& rulespec
 ) {
@@ -1040,10 +1845,10 @@ bool readEncodedLogs(
 		rules = parser.rules();
 	}
 
-	auto reader = LogReader(file, timestamps, tail, rules);
+	auto reader = LogReader(file, timestamps, tail, since, until, rules);
 
 	if (!reader.initialize()) return false;
-	if (!reader.continueReading()) return false;
+	if (!reader.continueReading(!follow)) return false;
 
 	if (follow) {
 		auto follower = LogFollower(&reader, path);
@@ -1053,4 +1858,248 @@ bool readEncodedLogs(
 	return true;
 }
 
+LogSearch::LogSearch(const LogSearchQuery& query): since(query.since), until(query.until) {
+	for (const auto& category: query.categories) {
+		auto& pattern = this->categoryPatterns.emplaceBack(QRegularExpression::fromWildcard(category));
+		// Like the body pattern, compiled before workers share it.
+		pattern.optimize();
+	}
+
+	{
+		QLoggingSettingsParser parser;
+		parser.setContent(query.rules);
+		this->rules = parser.rules();
+	}
+
+	// QtMsgType is not ordered by severity.
+	this->levelFilter.debug = query.level == QtDebugMsg;
+	this->levelFilter.info = this->levelFilter.debug || query.level == QtInfoMsg;
+	this->levelFilter.warn = this->levelFilter.info || query.level == QtWarningMsg;
+	this->levelFilter.critical = this->levelFilter.warn || query.level == QtCriticalMsg;
+
+	auto options = query.ignoreCase ? QRegularExpression::CaseInsensitiveOption
+	                                : QRegularExpression::NoPatternOption;
+
+	this->pattern = QRegularExpression(query.pattern, options);
+	// Compiled up front so worker threads only ever read it.
+	this->pattern.optimize();
+
+	auto isSpecial = [](QChar c) { return QStringView(u"\\^$.|?*+()[]{}").contains(c); };
+
+	if (!query.ignoreCase && std::ranges::none_of(query.pattern, isSpecial)) {
+		this->literalPattern = true;
+		this->literal.setPattern(query.pattern.toUtf8());
+	}
+}
+
+bool LogSearch::isValid() const { return this->pattern.isValid(); }
+QString LogSearch::errorString() const { return this->pattern.errorString(); }
+
+bool LogSearch::search(const QList<QString>& paths, int threads) {
+	this->mMatches.clear();
+	this->sources = QList<Source>(paths.size());
+
+	auto* sources = this->sources.data();
+	auto next = QAtomicInteger<qsizetype>(0);
+
+	auto runWorker = [&]() {
+		while (true) {
+			auto index = next.fetchAndAddRelaxed(1);
+			if (index >= paths.size()) break;
+			this->searchLog(paths.at(index), &sources[index]); // NOLINT
+		}
+	};
+
+	// The calling thread is one of the workers.
+	auto workers = std::min(static_cast<qsizetype>(std::max(threads, 1)), paths.size());
+	auto pool = QThreadPool();
+	pool.setMaxThreadCount(static_cast<int>(std::max<qsizetype>(workers - 1, 1)));
+
+	for (auto i = 1; i < workers; i++) {
+		pool.start(runWorker);
+	}
+
+	runWorker();
+	pool.waitForDone();
+
+	this->merge();
+
+	return std::ranges::none_of(this->sources, [](const Source& source) { return source.failed; });
+}
+
+void LogSearch::searchLog(const QString& path, Source* source) const {
+	auto file = QFile(path);
+	if (!file.open(QFile::ReadOnly)) {
+		qCWarning(logLogging) << "Skipping log" << path << "which could not be opened.";
+		source->failed = true;
+		return;
+	}
+
+	auto reader = EncodedLogReader();
+	reader.setDevice(&file);
+
+	bool readable = false;
+	quint8 logVersion = 0;
+	quint8 readerVersion = 0;
+	if (!reader.readHeader(&readable, &logVersion, &readerVersion) || !readable) {
+		qCWarning(logLogging) << "Skipping log" << path << "which could not be decoded.";
+		source->failed = true;
+		return;
+	}
+
+	if (this->since.isValid()) {
+		auto points = reader.findSyncPoints();
+
+		// Messages sharing the sync point's time may come before it, so start from an earlier one.
+		auto first = points.size() - 1;
+		while (first > 0 && points.at(first).time >= this->since) first--;
+
+		if (points.isEmpty() ? !reader.rewind() : !reader.seekToSyncPoint(points.at(first))) {
+			qCWarning(logLogging) << "Skipping log" << path << "which could not be seeked.";
+			source->failed = true;
+			return;
+		}
+	}
+
+	auto filters = QHash<quint16, CategoryFilter>();
+
+	LogMessage message;
+	while (reader.read(&message)) {
+		// Message times never decrease, so nothing after this will be in range.
+		if (this->until.isValid() && message.time > this->until) return;
+		if (this->since.isValid() && message.time < this->since) continue;
+
+		auto filter = filters.find(message.readCategoryId);
+		if (filter == filters.end()) {
+			filter = filters.insert(
+			    message.readCategoryId,
+			    this->categoryFilter(message.category, reader.categoryFilterById(message.readCategoryId))
+			);
+		}
+
+		if (!filter->shouldDisplay(message.type) || !this->bodyMatches(message.body)) continue;
+
+		auto name = source->categoryNames.find(message.readCategoryId);
+		if (name == source->categoryNames.end()) {
+			name = source->categoryNames.insert(
+			    message.readCategoryId,
+			    QByteArray(message.category.data(), message.category.size())
+			);
+		}
+
+		message.category = QLatin1StringView(*name);
+		source->matches.append(message);
+	}
+
+	// The log may belong to a running instance, so a message at the end may still be being written.
+	if (reader.corrupt()) {
+		qCWarning(logLogging) << "An error occurred parsing the end of log" << path;
+	}
+}
+
+CategoryFilter LogSearch::categoryFilter(QLatin1StringView category, CategoryFilter filter) const {
+	if (!this->categoryPatterns.isEmpty()) {
+		auto name = QString(category);
+
+		auto included = std::ranges::any_of(this->categoryPatterns, [&](const auto& pattern) {
+			return pattern.match(name).hasMatch();
+		});
+
+		if (!included) {
+			filter.debug = filter.info = filter.warn = filter.critical = false;
+			return filter;
+		}
+	}
+
+	for (const auto& rule: this->rules) {
+		filter.applyRule(category, rule);
+	}
+
+	filter.debug = filter.debug && this->levelFilter.debug;
+	filter.info = filter.info && this->levelFilter.info;
+	filter.warn = filter.warn && this->levelFilter.warn;
+	filter.critical = filter.critical && this->levelFilter.critical;
+	return filter;
+}
+
+bool LogSearch::bodyMatches(const QByteArray& body) const {
+	if (this->literalPattern) {
+		return this->literal.pattern().isEmpty() || this->literal.indexIn(body) != -1;
+	}
+
+	return this->pattern.match(QString::fromUtf8(body)).hasMatch();
+}
+
+void LogSearch::merge() {
+	qsizetype total = 0;
+	for (const auto& source: this->sources) {
+		total += source.matches.size();
+	}
+
+	this->mMatches.reserve(total);
+
+	// Min-heap of logs by their next unmerged match.
+	auto cursors = QList<qsizetype>(this->sources.size());
+	auto heap = QList<qsizetype>();
+
+	auto later = [&](qsizetype a, qsizetype b) {
+		const auto& timeA = this->sources.at(a).matches.at(cursors.at(a)).time;
+		const auto& timeB = this->sources.at(b).matches.at(cursors.at(b)).time;
+		return timeA != timeB ? timeA > timeB : a > b;
+	};
+
+	for (auto i = 0; i != this->sources.size(); i++) {
+		if (!this->sources.at(i).matches.isEmpty()) heap.append(i);
+	}
+
+	std::make_heap(heap.begin(), heap.end(), later);
+
+	while (!heap.isEmpty()) {
+		std::pop_heap(heap.begin(), heap.end(), later);
+		auto log = heap.last();
+		auto& source = this->sources[log];
+
+		this->mMatches.append({.log = log, .message = source.matches.at(cursors.at(log))});
+
+		if (++cursors[log] == source.matches.size()) {
+			heap.removeLast();
+			source.matches.clear();
+		} else {
+			std::push_heap(heap.begin(), heap.end(), later);
+		}
+	}
+}
+
+bool searchEncodedLogs(
+    const QList<QPair<QString, QString>>& logs,
+    const LogSearchQuery& query,
+    bool timestamps,
+    int threads
+) {
+	auto search = LogSearch(query);
+
+	if (!search.isValid()) {
+		qCritical().noquote() << "Invalid search pattern:" << search.errorString();
+		return false;
+	}
+
+	auto paths = QList<QString>();
+	for (const auto& log: logs) {
+		paths.append(log.second);
+	}
+
+	auto complete = search.search(paths, threads);
+
+	auto color = LogManager::instance()->colorLogs;
+	auto stream = QTextStream(stdout);
+
+	for (const auto& match: search.matches()) {
+		LogMessage::formatMessage(stream, match.message, color, timestamps, logs.at(match.log).first);
+		stream << '\n';
+	}
+
+	stream << Qt::flush;
+	return complete;
+}
+
 } // namespace qs::log
@@ -8,10 +8,13 @@
 #include <qfile.h>
 #include <qhash.h>
 #include <qlatin1stringview.h>
+#include <qlist.h>
 #include <qlogging.h>
 #include <qloggingcategory.h>
 #include <qmutex.h>
 #include <qobject.h>
+#include <qpair.h>
+#include <qstring.h>
 #include <qtmetamacros.h>
 
 #include "logcat.hpp"
@@ -147,10 +150,36 @@ bool readEncodedLogs(
     const QString& path,
     bool timestamps,
     int tail,
+    const QDateTime& since,
+    const QDateTime& until,
     bool follow,
     const QString& rulespec
 );
 
+struct LogSearchQuery {
+	// Wildcard patterns of categories to include. All categories are included if empty.
+	QList<QString> categories;
+	// Messages less severe than this are excluded.
+	QtMsgType level = QtDebugMsg;
+	QDateTime since;
+	QDateTime until;
+	// Regular expression matched against message bodies. All messages match if empty.
+	QString pattern;
+	bool ignoreCase = false;
+	// Applied on top of the filters recorded in each log, in the format of QT_LOGGING_RULES.
+	QString rules;
+};
+
+// Searches several detailed logs using up to the given number of threads, then prints the
+// matches from all of them in time order. Logs are given as pairs of the prefix to print
+// before their messages and their path.
+bool searchEncodedLogs(
+    const QList<QPair<QString, QString>>& logs,
+    const LogSearchQuery& query,
+    bool timestamps,
+    int threads
+);
+
 } // namespace qs::log
 
 using LogManager = qs::log::LogManager;
@@ -1,16 +1,26 @@
 #pragma once
+#include <array>
 #include <utility>
 
+#include <qbytearray.h>
+#include <qbytearraymatcher.h>
 #include <qbytearrayview.h>
 #include <qcontainerfwd.h>
+#include <qdatetime.h>
 #include <qfile.h>
+#include <qfiledevice.h>
 #include <qfilesystemwatcher.h>
+#include <qhash.h>
+#include <qlist.h>
 #include <qlogging.h>
 #include <qobject.h>
+#include <qregularexpression.h>
 #include <qthread.h>
 #include <qtmetamacros.h>
 #include <qtypes.h>
 
+#include "instanceinfo.hpp"
+#include "logcompression.hpp"
 #include "logging.hpp"
 #include "logging_qtprivate.hpp"
 #include "ringbuf.hpp"
@@ -21,9 +31,25 @@ enum EncodedLogOpcode : quint8 {
 	RegisterCategory = 0,
 	RecentMessageShort,
 	RecentMessageLong,
+	SyncPoint,
 	BeginCategories,
 };
 
+enum EncodedLogFlag : quint8 {
+	BlockCompression = 1 << 0,
+};
+
+// With block compression, everything after the log header is split into frames, each starting
+// with its type, its decoded size and its encoded size.
+enum class LogFrameType : quint8 {
+	Stored = 0,
+	Compressed = 1,
+	// Stored, and frames after it never reference data before it. Decoding may start here.
+	Restart = 2,
+};
+
+constexpr qsizetype LOG_FRAME_HEADER_SIZE = 1 + 4 + 4;
+
 enum CompressedLogType : quint8 {
 	Debug = 0,
 	Info = 1,
@@ -34,26 +60,93 @@ enum CompressedLogType : quint8 {
 CompressedLogType compressedTypeOf(QtMsgType type);
 QtMsgType typeOfCompressed(CompressedLogType type);
 
+// Accumulates writes in a fixed arena which is written to the device on flush. Only committed
+// data, made of whole records, is ever written. If the arena fills up, committed data is written
+// early, and a single record too large for the arena continues in a heap buffer until committed.
+//
+// Committed data is published to pendingWrites(), so the crash handler can recover records
+// that were never flushed.
+//
+// With compression, each flush writes the data as one compressed frame, or two if it starts
+// with a restart frame. Published data is written by the crash handler as a single stored frame.
 class WriteBuffer {
 public:
-	void setDevice(QIODevice* device);
+	WriteBuffer();
+
+	void setDevice(QFileDevice* device);
 	[[nodiscard]] bool hasDevice() const;
+	// Must be called while nothing is buffered.
+	void setCompressed(bool compressed);
 	[[nodiscard]] bool flush();
+	// Starts a new frame of the given type at the current position. Does nothing without
+	// compression. Restart frames must be started between records, and end at the next
+	// compressed frame started. Failures are reported on commit.
+	void startFrame(LogFrameType type);
+	// Marks the data written so far as complete records.
+	// Returns false if an early flush caused by a full arena failed.
+	[[nodiscard]] bool commit();
+	[[nodiscard]] crash::PendingWrites* pendingWrites() { return &this->pending; }
 	void writeBytes(const char* data, qsizetype length);
 	void writeU8(quint8 data);
 	void writeU16(quint16 data);
 	void writeU32(quint32 data);
 	void writeU64(quint64 data);
+	// Total number of bytes written, including unflushed ones.
+	[[nodiscard]] qint64 position() const { return this->mPosition; }
+	// Offset in the device the next written byte will end up at, or with compression, the offset
+	// the next frame started will end up at. Only valid while everything buffered is committed.
+	[[nodiscard]] qint64 deviceOffset() const;
 
 private:
-	QIODevice* device = nullptr;
-	QByteArray buffer;
+	static constexpr qsizetype ARENA_SIZE = 64ll * 1024;
+
+	// Writes out committed data, keeping anything written after it.
+	[[nodiscard]] bool writeOut();
+	void writeFrame(LogFrameType type, qsizetype start, qsizetype end);
+	// Drops the first length bytes of buffered data.
+	void consume(qsizetype length);
+	void publish();
+	// Takes published data back from the crash handler before it is written or overwritten.
+	void reclaim();
+	void reset();
+	[[nodiscard]] qsizetype bufferedSize() const;
+	// Calls fn with each contiguous piece of buffered data between start and end.
+	template <typename F>
+	void forEachChunk(qsizetype start, qsizetype end, F fn) const;
+
+	QFileDevice* device = nullptr;
+	std::array<char, ARENA_SIZE> arena {};
+	qsizetype size = 0;
+	// Continuation of a record that did not fit in the arena.
+	QByteArray overflow;
+	qsizetype committed = 0;
+	bool failed = false;
+	qint64 mPosition = 0;
+	qint64 writtenBytes = 0;
+	crash::PendingWrites pending;
+	int prefixSlot = 0;
+
+	bool compressed = false;
+	// Type of the frame buffered data starts with.
+	LogFrameType frameType = LogFrameType::Compressed;
+	// Offset of the compressed frame following a restart frame, or -1.
+	qsizetype frameSplit = -1;
+	LogCompressor compressor;
+	QByteArray compressedFrame;
+	QByteArray frameOutput;
 };
 
+// Reads log data from a device. With block decoding enabled, reads return the decoded contents
+// of frames, which are only consumed once completely written.
+//
+// Records may be read before their writer has finished writing them. Reading one inside a
+// transaction allows returning to its start if it turns out to be incomplete.
 class DeviceReader {
 public:
 	void setDevice(QIODevice* device);
 	[[nodiscard]] bool hasDevice() const;
+	void setBlockDecoding(bool blockDecoding) { this->mBlockDecoding = blockDecoding; }
+	[[nodiscard]] bool blockDecoding() const { return this->mBlockDecoding; }
 	[[nodiscard]] bool readBytes(char* data, qsizetype length);
 	// peek UP TO length
 	[[nodiscard]] qsizetype peekBytes(char* data, qsizetype length);
@@ -62,21 +155,77 @@ public:
 	[[nodiscard]] bool readU16(quint16* data);
 	[[nodiscard]] bool readU32(quint32* data);
 	[[nodiscard]] bool readU64(quint64* data);
+	// Reads from the device directly, bypassing block decoding.
+	[[nodiscard]] bool readRawBytes(char* data, qsizetype length);
+	// Marks the current position as the start of a record, replacing any previous mark.
+	void startTransaction();
+	void commitTransaction();
+	// Returns to the position marked by startTransaction().
+	void rollbackTransaction();
+	// True if the last failed read found corrupt data, rather than running out of it.
+	[[nodiscard]] bool corrupt() const { return this->mCorrupt; }
+	// True if every byte written to the device so far has been read.
+	[[nodiscard]] bool atEnd() const;
+	// Seeks the device and drops decoder state and any transaction. With block decoding, the
+	// position must be the start of the stream or of a restart frame.
+	[[nodiscard]] bool seek(qint64 position);
+	// Returns true if the device is at the start of a restart frame.
+	[[nodiscard]] bool atRestartFrame();
+	[[nodiscard]] qint64 position() const;
+	[[nodiscard]] qint64 size() const;
+	// Bytes consumed from the decoded stream, or the device position without block decoding.
+	[[nodiscard]] qint64 streamPosition() const;
 
 private:
+	// Decodes frames until at least length bytes are available or no complete frames are left.
+	bool fill(qsizetype length);
+	bool decodeFrame();
+
 	QIODevice* device = nullptr;
+	bool mBlockDecoding = false;
+	QByteArray decoded;
+	qsizetype decodedOffset = 0;
+	qint64 decodedConsumed = 0;
+	QByteArray frame;
+	LogDecompressor decompressor;
+	bool mCorrupt = false;
+
+	bool inTransaction = false;
+	// decodedOffset and decodedConsumed with block decoding, or the device position without it.
+	qsizetype transactionOffset = 0;
+	qint64 transactionPosition = 0;
+};
+
+// A point in the log the decoder can start from without reading anything before it.
+struct LogSyncPoint {
+	qint64 offset = 0;
+	qint64 previous = 0;
+	quint64 messageIndex = 0;
+	QDateTime time;
 };
 
 class EncodedLogWriter {
 public:
-	void setDevice(QIODevice* target);
+	void setDevice(QFileDevice* target);
+	// Must be called before writeHeader().
+	void setCompressed(bool compressed) { this->compressed = compressed; }
 	[[nodiscard]] bool writeHeader();
+	// Buffers a message until the next flush().
 	[[nodiscard]] bool write(const LogMessage& message);
+	[[nodiscard]] bool flush();
+	[[nodiscard]] crash::PendingWrites* pendingWrites() { return this->buffer.pendingWrites(); }
+
+	// Bytes written between sync points. Sync points are written before the first message
+	// past the interval.
+	void setSyncInterval(qint64 interval) { this->syncInterval = interval; }
+
+	static constexpr qint64 DEFAULT_SYNC_INTERVAL = 1024ll * 1024;
 
 private:
 	void writeOp(EncodedLogOpcode opcode);
 	void writeVarInt(quint32 n);
 	void writeString(QByteArrayView bytes);
+	void writeSyncPoint();
 	quint16 getOrCreateCategory(QLatin1StringView category);
 
 	WriteBuffer buffer;
@@ -84,6 +233,12 @@ private:
 	QHash<QLatin1StringView, quint16> categories;
 	quint16 nextCategory = EncodedLogOpcode::BeginCategories;
 
+	bool compressed = false;
+	qint64 syncInterval = DEFAULT_SYNC_INTERVAL;
+	qint64 lastSyncPoint = 0;
+	qint64 lastSyncPosition = 0;
+	quint64 messageCount = 0;
+
 	QDateTime lastMessageTime = QDateTime::fromSecsSinceEpoch(0);
 	HashBuffer<LogMessage> recentMessages {256};
 };
@@ -93,18 +248,42 @@ public:
 	void setDevice(QIODevice* source);
 	[[nodiscard]] bool readHeader(bool* success, quint8* logVersion, quint8* readerVersion);
 	// WARNING: log messages written to the given slot are invalidated when the log reader is destroyed.
+	// If the next message has not been completely written yet, nothing is consumed and it can be
+	// read once it has.
 	[[nodiscard]] bool read(LogMessage* slot);
+	// True if the last failed read() found corrupt data, rather than the end of what was written.
+	[[nodiscard]] bool corrupt() const { return this->mCorrupt || this->reader.corrupt(); }
+	// True if every message written so far has been read.
+	[[nodiscard]] bool atEnd() const { return this->reader.atEnd(); }
 	[[nodiscard]] CategoryFilter categoryFilterById(quint16 id);
+	// Position in the decoded stream, which only advances over complete messages.
+	[[nodiscard]] qint64 streamPosition() const { return this->reader.streamPosition(); }
+
+	// Finds the last sync point by scanning backwards from the end of the log, then follows
+	// its links to earlier ones. Returns an empty list if the log has no usable sync points.
+	// Leaves the device at an unspecified position.
+	[[nodiscard]] QList<LogSyncPoint> findSyncPoints();
+	// Restores decoder state from the given sync point and continues reading after it.
+	[[nodiscard]] bool seekToSyncPoint(const LogSyncPoint& point);
+	// Returns to the first message, after the header.
+	[[nodiscard]] bool rewind();
 
 private:
+	[[nodiscard]] bool readRecord(LogMessage* slot);
 	[[nodiscard]] bool readVarInt(quint32* slot);
 	[[nodiscard]] bool readString(QByteArray* slot);
 	[[nodiscard]] bool registerCategory();
+	[[nodiscard]] bool readSyncPoint(qint64 offset, LogSyncPoint* point, QByteArray* record);
+	[[nodiscard]] bool skipSyncPoint();
 
 	DeviceReader reader;
+	// Opcodes were added in later log versions, shifting category ids.
+	quint32 beginCategories = EncodedLogOpcode::BeginCategories;
+	qint64 dataStart = 0;
 	QVector<QPair<QByteArray, CategoryFilter>> categories;
 	QDateTime lastMessageTime = QDateTime::fromSecsSinceEpoch(0);
 	RingBuffer<LogMessage> recentMessages {256};
+	bool mCorrupt = false;
 };
 
 class ThreadLogging: public QObject {
@@ -119,12 +298,19 @@ public:
 
 private slots:
 	void onMessage(const LogMessage& msg, bool showInSparse);
+	void flushLogs();
 
 private:
+	void endDetailedLogs();
+
 	QFile* file = nullptr;
 	QTextStream fileStream;
 	QFile* detailedFile = nullptr;
 	EncodedLogWriter detailedWriter;
+	// Once messages are delivered on the logging thread's event loop, they are written
+	// together once per event loop iteration instead of individually.
+	bool groupCommit = false;
+	bool flushScheduled = false;
 };
 
 class LogFollower;
@@ -135,21 +321,35 @@ public:
 	    QFile* file,
 	    bool timestamps,
 	    int tail,
+	    QDateTime since,
+	    QDateTime until,
 	    QList<qt_logging_registry::QLoggingRule> rules
 	)
 	    : file(file)
 	    , timestamps(timestamps)
 	    , remainingTail(tail)
+	    , since(std::move(since))
+	    , until(std::move(until))
 	    , rules(std::move(rules)) {}
 
 	bool initialize();
-	bool continueReading();
+	// Prints messages written since the last call. If complete is false, the writer may still be
+	// writing, and a message at the end that is not completely written is printed on a later call.
+	bool continueReading(bool complete);
 
 private:
+	bool readMessages(QTextStream& stream, RingBuffer<LogMessage>& tailRing);
+	bool shouldDisplay(const LogMessage& message);
+
 	QFile* file;
 	EncodedLogReader reader;
 	bool timestamps;
 	int remainingTail;
+	QDateTime since;
+	QDateTime until;
+	bool reachedUntil = false;
+	// Sync points usable by the first read, which may start from any of them.
+	QList<LogSyncPoint> syncPoints;
 	QHash<quint16, CategoryFilter> filters;
 	QList<qt_logging_registry::QLoggingRule> rules;
 
@@ -187,4 +387,54 @@ private:
 	FcntlWaitThread waitThread {this};
 };
 
+struct LogSearchMatch {
+	// Index of the log the message was found in.
+	qsizetype log = 0;
+	LogMessage message;
+};
+
+class LogSearch {
+public:
+	explicit LogSearch(const LogSearchQuery& query);
+
+	// Returns false if the body pattern is not a valid regular expression.
+	[[nodiscard]] bool isValid() const;
+	[[nodiscard]] QString errorString() const;
+
+	// Decodes each log on its own thread, up to the given number of threads at once, then merges
+	// their matches. Logs that cannot be read are skipped, in which case false is returned.
+	bool search(const QList<QString>& paths, int threads);
+
+	// Matches from every log, ordered by time. Matches logged at the same time keep their order
+	// within a log, and are otherwise ordered by log.
+	// Messages are invalidated when the search is destroyed or run again.
+	[[nodiscard]] const QList<LogSearchMatch>& matches() const { return this->mMatches; }
+
+private:
+	struct Source {
+		QList<LogMessage> matches;
+		// Matches outlive the reader their category names point into, so the names are kept here.
+		QHash<quint16, QByteArray> categoryNames;
+		bool failed = false;
+	};
+
+	void searchLog(const QString& path, Source* source) const;
+	[[nodiscard]] CategoryFilter categoryFilter(QLatin1StringView category, CategoryFilter filter)
+	    const;
+	[[nodiscard]] bool bodyMatches(const QByteArray& body) const;
+	void merge();
+
+	QDateTime since;
+	QDateTime until;
+	QList<QRegularExpression> categoryPatterns;
+	QList<qt_logging_registry::QLoggingRule> rules;
+	CategoryFilter levelFilter;
+	QRegularExpression pattern;
+	// Patterns without special characters are matched directly against encoded bodies.
+	bool literalPattern = false;
+	QByteArrayMatcher literal;
+	QList<Source> sources;
+	QList<LogSearchMatch> mMatches;
+};
+
 } // namespace qs::log
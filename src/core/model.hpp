@@ -67,6 +67,8 @@ signals:
 	void objectRemovedPre(QObject* object, qsizetype index);
 	/// Sent immediately after an object is removed from the list.
 	void objectRemovedPost(QObject* object, qsizetype index);
+	/// Sent immediately after an object is moved within the list.
+	void objectMoved(QObject* object, qsizetype from, qsizetype to);
 
 private:
 	static qsizetype valuesCount(QQmlListProperty<QObject>* property);
@@ -128,6 +130,23 @@ public:
 		emit this->objectRemovedPost(object, index);
 	}
 
+	void moveObject(qsizetype from, qsizetype to) {
+		if (from == to) return;
+		auto* object = this->mValuesList.at(from);
+
+		auto intFrom = static_cast<qint32>(from);
+		auto intTo = static_cast<qint32>(to);
+		// Qt expects the destination index from before the move.
+		auto destination = to > from ? intTo + 1 : intTo;
+
+		this->beginMoveRows(QModelIndex(), intFrom, intFrom, QModelIndex(), destination);
+		this->mValuesList.move(from, to);
+		this->endMoveRows();
+
+		emit this->valuesChanged();
+		emit this->objectMoved(object, from, to);
+	}
+
 	// Assumes only one instance of a specific value
 	void diffUpdate(const QList<T*>& newValues) {
 		for (qsizetype i = 0; i < this->mValuesList.length();) {
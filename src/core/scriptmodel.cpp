@@ -1,9 +1,11 @@
 #include "scriptmodel.hpp"
 #include <algorithm>
-#include <iterator>
+#include <numeric>
 
 #include <qabstractitemmodel.h>
 #include <qcontainerfwd.h>
+#include <qhash.h>
+#include <qhashfunctions.h>
 #include <qjsvalue.h>
 #include <qjsvalueiterator.h>
 #include <qlist.h>
@@ -61,16 +63,102 @@ bool qjsValueStructuralEq(
 
 	return !bIter.hasNext();
 }
+
+// Hash consistent with both strict and structural equality. Nested values past a small depth
+// only contribute their type, which keeps hashing cheap for deep or cyclic objects.
+size_t qjsValueHash(const QJSValue& value, bool identity, qint32 depth = 0) {
+	if (value.isBool()) return qHash(value.toBool());
+	if (value.isNumber()) return qHash(value.toNumber());
+	if (value.isString()) return qHash(value.toString());
+	if (!value.isObject()) return qHash(value.isNull());
+	if (identity && value.isQObject()) return qHash(value.toQObject());
+
+	size_t hash = value.isArray() ? 1 : 2;
+	if (depth == 2) return hash;
+
+	// Structural equality doesn't depend on property order, so neither can the hash.
+	auto iter = QJSValueIterator(value);
+	while (iter.hasNext()) {
+		iter.next();
+		hash += qHashMulti(0, iter.name(), qjsValueHash(iter.value(), identity, depth + 1));
+	}
+
+	return hash;
+}
+
+// Tracks which values of a list have not been removed, with logarithmic rank queries.
+class RemainingValues {
+public:
+	explicit RemainingValues(qsizetype count): tree(count + 1), skip(count + 1) {
+		for (qint32 i = 1; i <= count; i++) {
+			this->tree[i] += 1;
+			auto parent = i + (i & -i);
+			if (parent <= count) this->tree[parent] += this->tree[i];
+		}
+
+		std::iota(this->skip.begin(), this->skip.end(), 0);
+	}
+
+	// The first remaining index at or after index, or the value count if there is none.
+	qint32 next(qint32 index) {
+		auto root = index;
+		while (this->skip.at(root) != root) root = this->skip.at(root);
+
+		while (index != root) {
+			auto next = this->skip.at(index);
+			this->skip[index] = root;
+			index = next;
+		}
+
+		return root;
+	}
+
+	// The number of remaining values before index.
+	[[nodiscard]] qint32 rank(qint32 index) const {
+		qint32 rank = 0;
+		for (auto i = index; i > 0; i -= i & -i) rank += this->tree.at(i);
+		return rank;
+	}
+
+	void remove(qint32 index) {
+		for (auto i = index + 1; i < this->tree.size(); i += i & -i) this->tree[i] -= 1;
+		this->skip[index] = index + 1;
+	}
+
+private:
+	QList<qint32> tree; // fenwick tree of remaining values
+	QList<qint32> skip; // union-find over removed values
+};
 } // namespace
 
 bool ScriptModel::updateValuesUnique(const QList<QJSValue>& newValues) {
 	auto anyChanges = false;
 
 	this->isModifying = true;
-	this->mValues.reserve(newValues.size());
 
-	auto iter = this->mValues.begin();
-	auto newIter = newValues.begin();
+	// Values strictly equal at the start or end of both lists are kept in place, and only the window
+	// between them is hashed and diffed. Most updates only touch a few values, and hashing can be
+	// expensive for objects compared by structure.
+	const auto minCount = std::min(this->mValues.length(), newValues.length());
+
+	qint32 prefix = 0;
+	while (prefix != minCount && newValues.at(prefix).strictlyEquals(this->mValues.at(prefix))) {
+		prefix++;
+	}
+
+	qint32 suffix = 0;
+	while (suffix != minCount - prefix
+	       && newValues.at(newValues.length() - suffix - 1)
+	              .strictlyEquals(this->mValues.at(this->mValues.length() - suffix - 1)))
+	{
+		suffix++;
+	}
+
+	// Everything past the current position in the window is always the unprocessed old values in
+	// their original order, so old values are tracked by their index in the window and their
+	// current position is recovered by counting the remaining values before them.
+	const auto oldValues = this->mValues.sliced(prefix, this->mValues.length() - prefix - suffix);
+	this->mValues.reserve(newValues.size());
 
 	auto comparisonValue = [this](const QJSValue& value) {
 		if (value.hasProperty(this->cmpKey)) return value.property(this->cmpKey);
@@ -91,118 +179,180 @@ bool ScriptModel::updateValuesUnique(const QList<QJSValue>& newValues) {
 		}
 	};
 
-	auto eqPredicate = [&](const QJSValue& b) {
-		return [&](const QJSValue& a) { return valueCmp(a, b); };
+	auto identity = this->mComparisonMode == ObjectComparison::Identity;
+	auto valueHash = [&, this](const QJSValue& value) {
+		return qjsValueHash(this->cmpKey.isEmpty() ? value : comparisonValue(value), identity);
 	};
 
-	while (true) {
-		if (newIter == newValues.end()) {
-			if (iter == this->mValues.end()) break;
+	auto oldHashes = QList<size_t>();
+	auto oldByHash = QMultiHash<size_t, qint32>();
+	oldHashes.reserve(oldValues.size());
+	oldByHash.reserve(oldValues.size());
 
-			auto startIndex = static_cast<qint32>(newValues.length());
-			auto endIndex = static_cast<qint32>(this->mValues.length() - 1);
+	for (auto i = 0; i != oldValues.size(); i++) {
+		oldHashes.append(valueHash(oldValues.at(i)));
+		oldByHash.insert(oldHashes.last(), i);
+	}
+
+	auto newEnd = static_cast<qint32>(newValues.length() - suffix);
+	// Indexed from prefix, unlike oldHashes which is indexed like oldValues.
+	auto newHashes = QList<size_t>();
+	auto newByHash = QMultiHash<size_t, qint32>();
+	newHashes.reserve(newEnd - prefix);
+	newByHash.reserve(newEnd - prefix);
+
+	for (auto i = prefix; i != newEnd; i++) {
+		newHashes.append(valueHash(newValues.at(i)));
+		newByHash.insert(newHashes.last(), i);
+	}
 
-			this->beginRemoveRows(QModelIndex(), startIndex, endIndex);
-			this->mValues.erase(iter, this->mValues.end());
+	auto remaining = RemainingValues(oldValues.size());
+
+	// Window index of the first unprocessed old value equal to the given new value, or -1.
+	auto findOld = [&](qint32 newIndex) {
+		const auto& newValue = newValues.at(newIndex);
+		qint32 found = -1;
+
+		auto [begin, end] = oldByHash.equal_range(newHashes.at(newIndex - prefix));
+		for (auto it = begin; it != end; ++it) {
+			auto i = it.value();
+			if ((found == -1 || i < found) && remaining.next(i) == i
+			    && valueCmp(oldValues.at(i), newValue))
+			{
+				found = i;
+			}
+		}
+
+		return found;
+	};
+
+	// If the given old value is equal to a new value at or after fromNewIndex.
+	auto inNew = [&](qint32 oldIndex, qint32 fromNewIndex) {
+		const auto& oldValue = oldValues.at(oldIndex);
+
+		auto [begin, end] = newByHash.equal_range(oldHashes.at(oldIndex));
+		for (auto it = begin; it != end; ++it) {
+			if (it.value() >= fromNewIndex && valueCmp(newValues.at(it.value()), oldValue)) return true;
+		}
+
+		return false;
+	};
+
+	// End of the window in mValues, which moves as values are inserted or removed.
+	auto windowEnd = [&, this]() { return static_cast<qint32>(this->mValues.length() - suffix); };
+
+	auto insertNew = [&, this](qint32 index, qint32 from, qint32 to) {
+		auto len = to - from;
+#if QT_VERSION <= QT_VERSION_CHECK(6, 8, 0)
+		this->mValues.resize(this->mValues.length() + len);
+#else
+		this->mValues.resizeForOverwrite(this->mValues.length() + len);
+#endif
+		auto iter = this->mValues.begin() + index;
+		std::move_backward(iter, this->mValues.end() - len, this->mValues.end());
+		std::copy(newValues.begin() + from, newValues.begin() + to, iter);
+	};
+
+	qint32 index = prefix;
+	qint32 newIndex = prefix;
+	// Window index of the old value at index.
+	auto current = remaining.next(0);
+
+	auto consumeCurrent = [&]() {
+		remaining.remove(current);
+		current = remaining.next(current);
+	};
+
+	while (true) {
+		if (newIndex == newEnd) {
+			if (index == windowEnd()) break;
+
+			this->beginRemoveRows(QModelIndex(), index, windowEnd() - 1);
+			this->mValues.erase(this->mValues.begin() + index, this->mValues.begin() + windowEnd());
 			this->endRemoveRows();
 			anyChanges = true;
 
 			break;
-		} else if (iter == this->mValues.end()) {
+		} else if (index == windowEnd()) {
 			// Prior branch ensures length is at least 1.
-			auto startIndex = static_cast<qint32>(this->mValues.length());
-			auto endIndex = static_cast<qint32>(newValues.length() - 1);
-
-			this->beginInsertRows(QModelIndex(), startIndex, endIndex);
-			this->mValues.append(newValues.sliced(startIndex));
+			this->beginInsertRows(QModelIndex(), index, index + newEnd - newIndex - 1);
+			insertNew(index, newIndex, newEnd);
 			this->endInsertRows();
 			anyChanges = true;
 
 			break;
-		} else if (!valueCmp(*newIter, *iter)) {
-			auto oldIter = std::find_if(iter, this->mValues.end(), eqPredicate(*newIter));
+		} else if (!valueCmp(newValues.at(newIndex), this->mValues.at(index))) {
+			auto oldMatch = findOld(newIndex);
 
-			if (oldIter != this->mValues.end()) {
-				if (std::find_if(newIter, newValues.end(), eqPredicate(*iter)) == newValues.end()) {
+			if (oldMatch != -1) {
+				if (!inNew(current, newIndex)) {
 					// Remove any entries we would otherwise move around that aren't in the new list.
-					auto startIter = iter;
+					auto startIndex = index;
 
 					do {
-						++iter;
-					} while (iter != this->mValues.end()
-					         && std::find_if(newIter, newValues.end(), eqPredicate(*iter))
-					                == newValues.end());
-
-					auto index = static_cast<qint32>(std::distance(this->mValues.begin(), iter));
-					auto startIndex = static_cast<qint32>(std::distance(this->mValues.begin(), startIter));
+						consumeCurrent();
+						++index;
+					} while (index != windowEnd() && !inNew(current, newIndex));
 
 					this->beginRemoveRows(QModelIndex(), startIndex, index - 1);
-					iter = this->mValues.erase(startIter, iter);
+					this->mValues.erase(this->mValues.begin() + startIndex, this->mValues.begin() + index);
 					this->endRemoveRows();
+					index = startIndex;
 					anyChanges = true;
 				} else {
-					// Advance iters to capture a whole move sequence as a single operation if possible.
-					auto oldStartIter = oldIter;
+					// Advance indexes to capture a whole move sequence as a single operation if possible.
+					auto oldStartIndex = index + remaining.rank(oldMatch);
+					auto oldIndex = oldStartIndex;
+					auto moved = oldMatch;
+
 					do {
-						++oldIter;
-						++newIter;
-					} while (oldIter != this->mValues.end() && newIter != newValues.end()
-					         && valueCmp(*oldIter, *newIter));
-
-					auto index = static_cast<qint32>(std::distance(this->mValues.begin(), iter));
-					auto oldStartIndex =
-					    static_cast<qint32>(std::distance(this->mValues.begin(), oldStartIter));
-					auto oldIndex = static_cast<qint32>(std::distance(this->mValues.begin(), oldIter));
+						remaining.remove(moved);
+						moved = remaining.next(moved);
+						++oldIndex;
+						++newIndex;
+					} while (oldIndex != windowEnd() && newIndex != newEnd
+					         && valueCmp(this->mValues.at(oldIndex), newValues.at(newIndex)));
+
+					current = remaining.next(current);
 					auto len = oldIndex - oldStartIndex;
 
 					this->beginMoveRows(QModelIndex(), oldStartIndex, oldIndex - 1, QModelIndex(), index);
 
-					// While it is possible to optimize this further, it is currently not worth the time.
-					for (auto i = 0; i != len; i++) {
-						this->mValues.move(oldStartIndex + i, index + i);
-					}
+					std::rotate(
+					    this->mValues.begin() + index,
+					    this->mValues.begin() + oldStartIndex,
+					    this->mValues.begin() + oldIndex
+					);
 
-					iter = this->mValues.begin() + (index + len);
+					index += len;
 					this->endMoveRows();
 					anyChanges = true;
 				}
 			} else {
-				auto startNewIter = newIter;
+				auto startNewIndex = newIndex;
 
 				do {
-					newIter++;
-				} while (newIter != newValues.end()
-				         && std::find_if(iter, this->mValues.end(), eqPredicate(*newIter))
-				                == this->mValues.end());
-
-				auto index = static_cast<qint32>(std::distance(this->mValues.begin(), iter));
-				auto newIndex = static_cast<qint32>(std::distance(newValues.begin(), newIter));
-				auto startNewIndex = static_cast<qint32>(std::distance(newValues.begin(), startNewIter));
+					newIndex++;
+				} while (newIndex != newEnd && findOld(newIndex) == -1);
+
 				auto len = newIndex - startNewIndex;
 
 				this->beginInsertRows(QModelIndex(), index, index + len - 1);
-#if QT_VERSION <= QT_VERSION_CHECK(6, 8, 0)
-				this->mValues.resize(this->mValues.length() + len);
-#else
-				this->mValues.resizeForOverwrite(this->mValues.length() + len);
-#endif
-				iter = this->mValues.begin() + index; // invalidated
-				std::move_backward(iter, this->mValues.end() - len, this->mValues.end());
-				iter = std::copy(startNewIter, newIter, iter);
+				insertNew(index, startNewIndex, newIndex);
+				index += len;
 				this->endInsertRows();
 				anyChanges = true;
 			}
-		} else if (!newIter->strictlyEquals(*iter)) {
-			auto first = static_cast<qint32>(std::distance(this->mValues.begin(), iter));
-			auto index = first;
+		} else if (!newValues.at(newIndex).strictlyEquals(this->mValues.at(index))) {
+			auto first = index;
 
 			do {
-				this->mValues.replace(index, *newIter);
-				++iter;
-				++newIter;
+				this->mValues.replace(index, newValues.at(newIndex));
+				consumeCurrent();
 				++index;
-			} while (iter != this->mValues.end() && newIter != newValues.end()
-			         && !newIter->strictlyEquals(*iter));
+				++newIndex;
+			} while (index != windowEnd() && newIndex != newEnd
+			         && !newValues.at(newIndex).strictlyEquals(this->mValues.at(index)));
 
 			this->dataChanged(
 			    this->index(first, 0, QModelIndex()),
@@ -212,8 +362,9 @@ bool ScriptModel::updateValuesUnique(const QList<QJSValue>& newValues) {
 
 			anyChanges = true;
 		} else {
-			++iter;
-			++newIter;
+			consumeCurrent();
+			++index;
+			++newIndex;
 		}
 	}
 
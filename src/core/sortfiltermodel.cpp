@@ -0,0 +1,271 @@
+#include "sortfiltermodel.hpp"
+#include <algorithm>
+#include <utility>
+
+#include <qcompare.h>
+#include <qcontainerfwd.h>
+#include <qlist.h>
+#include <qlogging.h>
+#include <qloggingcategory.h>
+#include <qmetaobject.h>
+#include <qnamespace.h>
+#include <qobject.h>
+#include <qtmetamacros.h>
+#include <qtypes.h>
+#include <qvariant.h>
+
+#include "logcat.hpp"
+#include "model.hpp"
+
+namespace {
+QS_LOGGING_CATEGORY(logSortFilterModel, "quickshell.sortfiltermodel", QtWarningMsg);
+}
+
+void SortFilterObjectModel::setSource(UntypedObjectModel* source) {
+	if (source == this->mSource) return;
+
+	if (this->mSource) {
+		QObject::disconnect(this->mSource, nullptr, this, nullptr);
+	}
+
+	this->mSource = source;
+
+	if (source) {
+		// clang-format off
+		QObject::connect(source, &UntypedObjectModel::objectInsertedPost, this, &SortFilterObjectModel::onSourceInserted);
+		QObject::connect(source, &UntypedObjectModel::objectRemovedPost, this, &SortFilterObjectModel::onSourceRemoved);
+		QObject::connect(source, &UntypedObjectModel::objectMoved, this, &SortFilterObjectModel::onSourceMoved);
+		QObject::connect(source, &QObject::destroyed, this, &SortFilterObjectModel::onSourceDestroyed);
+		// clang-format on
+	}
+
+	this->rebuild();
+	emit this->sourceChanged();
+}
+
+void SortFilterObjectModel::setSortProperty(const QString& sortProperty) {
+	if (sortProperty == this->mSortProperty) return;
+	this->mSortProperty = sortProperty;
+	this->rebuild();
+	emit this->sortPropertyChanged();
+}
+
+void SortFilterObjectModel::setSortOrder(Qt::SortOrder sortOrder) {
+	if (sortOrder == this->mSortOrder) return;
+	this->mSortOrder = sortOrder;
+	this->rebuild();
+	emit this->sortOrderChanged();
+}
+
+void SortFilterObjectModel::setFilterProperty(const QString& filterProperty) {
+	if (filterProperty == this->mFilterProperty) return;
+	this->mFilterProperty = filterProperty;
+	this->rebuild();
+	emit this->filterPropertyChanged();
+}
+
+void SortFilterObjectModel::setFilterValue(const QVariant& filterValue) {
+	if (filterValue == this->mFilterValue) return;
+	this->mFilterValue = filterValue;
+	this->rebuild();
+	emit this->filterValueChanged();
+}
+
+void SortFilterObjectModel::setInvertFilter(bool invertFilter) {
+	if (invertFilter == this->mInvertFilter) return;
+	this->mInvertFilter = invertFilter;
+	this->rebuild();
+	emit this->invertFilterChanged();
+}
+
+void SortFilterObjectModel::onSourceInserted(QObject* object, qsizetype /*index*/) {
+	this->trackObject(object);
+	if (this->accepts(object)) this->insertAccepted(object);
+}
+
+void SortFilterObjectModel::onSourceRemoved(QObject* object, qsizetype /*index*/) {
+	QObject::disconnect(object, nullptr, this, nullptr);
+	this->tracked.remove(object);
+
+	if (this->included.contains(object)) {
+		this->removeAccepted(this->valueList().indexOf(object));
+	}
+}
+
+void SortFilterObjectModel::onSourceMoved(QObject* object, qsizetype /*from*/, qsizetype /*to*/) {
+	// Source order only matters when it isn't overridden by sorting.
+	if (!this->mSortProperty.isEmpty() || !this->included.contains(object)) return;
+	this->reposition(object, QVariant());
+}
+
+void SortFilterObjectModel::onSourceDestroyed() {
+	this->mSource = nullptr;
+	this->rebuild();
+	emit this->sourceChanged();
+}
+
+void SortFilterObjectModel::onObjectPropertyChanged() {
+	auto* object = this->sender();
+	if (!this->tracked.contains(object)) return;
+
+	auto accepted = this->accepts(object);
+	auto wasIncluded = this->included.contains(object);
+
+	if (accepted && !wasIncluded) {
+		this->insertAccepted(object);
+	} else if (!accepted && wasIncluded) {
+		this->removeAccepted(this->valueList().indexOf(object));
+	} else if (accepted && !this->mSortProperty.isEmpty()) {
+		this->reposition(object, this->sortKey(object));
+	}
+}
+
+QVariant SortFilterObjectModel::sortKey(QObject* object) const {
+	if (this->mSortProperty.isEmpty()) return QVariant();
+
+	auto property = this->tracked.value(object).sort;
+	if (!property.isValid()) return QVariant();
+
+	return property.read(object);
+}
+
+bool SortFilterObjectModel::accepts(QObject* object) const {
+	if (this->mFilterProperty.isEmpty()) return true;
+
+	auto property = this->tracked.value(object).filter;
+	auto value = property.isValid() ? property.read(object) : QVariant();
+	auto matches = this->mFilterValue.isValid() ? value == this->mFilterValue : value.toBool();
+
+	return matches != this->mInvertFilter;
+}
+
+bool SortFilterObjectModel::lessThan(const QVariant& a, const QVariant& b) const {
+	auto order = QVariant::compare(a, b);
+
+	if (this->mSortOrder == Qt::DescendingOrder) return order == QPartialOrdering::Greater;
+	else return order == QPartialOrdering::Less;
+}
+
+qsizetype SortFilterObjectModel::insertionIndex(QObject* object, const QVariant& key) const {
+	if (this->mSortProperty.isEmpty()) {
+		qsizetype index = 0;
+
+		for (auto* sourceObject: this->mSource->values()) {
+			if (sourceObject == object) break;
+			if (this->included.contains(sourceObject)) index++;
+		}
+
+		return index;
+	}
+
+	// Upper bound keeps objects with equal keys in insertion order.
+	auto iter = std::ranges::upper_bound(
+	    this->sortKeys,
+	    key,
+	    [this](const QVariant& a, const QVariant& b) { return this->lessThan(a, b); }
+	);
+
+	return iter - this->sortKeys.begin();
+}
+
+void SortFilterObjectModel::trackObject(QObject* object) {
+	static const auto notifySlot =
+	    SortFilterObjectModel::staticMetaObject.indexOfSlot("onObjectPropertyChanged()");
+
+	const auto* metaObject = object->metaObject();
+	auto properties = Properties();
+
+	if (!this->mSortProperty.isEmpty()) {
+		auto index = metaObject->indexOfProperty(this->mSortProperty.toUtf8());
+
+		if (index == -1) {
+			qCDebug(logSortFilterModel) << "Sort property" << this->mSortProperty << "not found on"
+			                            << object;
+		} else properties.sort = metaObject->property(index);
+	}
+
+	if (!this->mFilterProperty.isEmpty()) {
+		auto index = metaObject->indexOfProperty(this->mFilterProperty.toUtf8());
+
+		if (index == -1) {
+			qCDebug(logSortFilterModel) << "Filter property" << this->mFilterProperty << "not found on"
+			                            << object;
+		} else properties.filter = metaObject->property(index);
+	}
+
+	for (const auto& property: {properties.sort, properties.filter}) {
+		if (property.hasNotifySignal()) {
+			QMetaObject::connect(
+			    object,
+			    property.notifySignalIndex(),
+			    this,
+			    notifySlot,
+			    Qt::UniqueConnection
+			);
+		}
+	}
+
+	this->tracked.insert(object, properties);
+}
+
+void SortFilterObjectModel::insertAccepted(QObject* object) {
+	auto key = this->sortKey(object);
+	auto index = this->insertionIndex(object, key);
+
+	this->sortKeys.insert(index, key);
+	this->included.insert(object);
+	this->insertObject(object, index);
+}
+
+void SortFilterObjectModel::removeAccepted(qsizetype index) {
+	this->sortKeys.removeAt(index);
+	this->included.remove(this->valueList().at(index));
+	this->removeAt(index);
+}
+
+void SortFilterObjectModel::reposition(QObject* object, const QVariant& key) {
+	auto index = this->valueList().indexOf(object);
+	// Don't reorder objects with equal keys when an unrelated property changes.
+	if (!this->mSortProperty.isEmpty() && key == this->sortKeys.at(index)) return;
+
+	this->sortKeys.removeAt(index);
+	auto newIndex = this->insertionIndex(object, key);
+	this->sortKeys.insert(newIndex, key);
+
+	this->moveObject(index, newIndex);
+}
+
+void SortFilterObjectModel::rebuild() {
+	for (auto* object: this->tracked.keys()) {
+		QObject::disconnect(object, nullptr, this, nullptr);
+	}
+
+	this->tracked.clear();
+
+	auto entries = QList<std::pair<QVariant, QObject*>>();
+
+	if (this->mSource) {
+		for (auto* object: this->mSource->values()) {
+			this->trackObject(object);
+			if (this->accepts(object)) entries.append({this->sortKey(object), object});
+		}
+	}
+
+	if (!this->mSortProperty.isEmpty()) {
+		std::ranges::stable_sort(entries, [this](const auto& a, const auto& b) {
+			return this->lessThan(a.first, b.first);
+		});
+	}
+
+	auto values = QList<QObject*>();
+	values.reserve(entries.size());
+	for (const auto& entry: entries) values.append(entry.second);
+
+	this->diffUpdate(values);
+
+	this->sortKeys.clear();
+	this->sortKeys.reserve(entries.size());
+	for (auto& entry: entries) this->sortKeys.append(std::move(entry.first));
+
+	this->included = QSet<QObject*>(values.begin(), values.end());
+}
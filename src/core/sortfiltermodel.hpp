@@ -0,0 +1,128 @@
+#pragma once
+
+#include <qcontainerfwd.h>
+#include <qhash.h>
+#include <qlist.h>
+#include <qmetaobject.h>
+#include <qnamespace.h>
+#include <qobject.h>
+#include <qqmlintegration.h>
+#include <qset.h>
+#include <qtmetamacros.h>
+#include <qtypes.h>
+#include <qvariant.h>
+
+#include "doc.hpp"
+#include "model.hpp"
+
+///! Sorted and filtered view of an ObjectModel.
+/// An @@ObjectModel reflecting a sorted and filtered subset of another @@ObjectModel,
+/// which is kept up to date as objects are added to or removed from the source model,
+/// and as the sorted and filtered properties of its objects change.
+///
+/// Compared to sorting or filtering @@ObjectModel.values in javascript and passing the result
+/// to a @@ScriptModel, a change to a single object only costs a binary search and a single
+/// row operation, instead of rebuilding and diffing the whole list.
+///
+/// The source model may be another SortFilterObjectModel.
+///
+/// #### Example
+/// ```qml
+/// SortFilterObjectModel {
+///   source: ToplevelManager.toplevels
+///   sortProperty: "title"
+///   filterProperty: "minimized"
+///   filterValue: false
+/// }
+/// ```
+class SortFilterObjectModel: public ObjectModel<QObject> {
+	Q_OBJECT;
+	QSDOC_BASECLASS(ObjectModel);
+	// clang-format off
+	/// The model to sort and filter.
+	Q_PROPERTY(UntypedObjectModel* source READ source WRITE setSource NOTIFY sourceChanged);
+	/// The name of the property objects are sorted by. Defaults to `""`, which keeps the order
+	/// of @@source.
+	///
+	/// Objects with equal sort keys are kept in the order they were added in.
+	Q_PROPERTY(QString sortProperty READ sortProperty WRITE setSortProperty NOTIFY sortPropertyChanged);
+	/// The direction objects are sorted in. Defaults to `Qt.AscendingOrder`.
+	Q_PROPERTY(Qt::SortOrder sortOrder READ sortOrder WRITE setSortOrder NOTIFY sortOrderChanged);
+	/// The name of the property objects are filtered by. Defaults to `""`, meaning no filter.
+	Q_PROPERTY(QString filterProperty READ filterProperty WRITE setFilterProperty NOTIFY filterPropertyChanged);
+	/// The value @@filterProperty must be equal to for an object to be included.
+	///
+	/// If undefined (the default), objects are included if @@filterProperty is truthy.
+	Q_PROPERTY(QVariant filterValue READ filterValue WRITE setFilterValue NOTIFY filterValueChanged);
+	/// If true (default false), objects matching the filter are excluded instead of included.
+	Q_PROPERTY(bool invertFilter READ invertFilter WRITE setInvertFilter NOTIFY invertFilterChanged);
+	// clang-format on
+	QML_ELEMENT;
+
+public:
+	explicit SortFilterObjectModel(QObject* parent = nullptr): ObjectModel(parent) {}
+
+	[[nodiscard]] UntypedObjectModel* source() const { return this->mSource; }
+	void setSource(UntypedObjectModel* source);
+
+	[[nodiscard]] QString sortProperty() const { return this->mSortProperty; }
+	void setSortProperty(const QString& sortProperty);
+
+	[[nodiscard]] Qt::SortOrder sortOrder() const { return this->mSortOrder; }
+	void setSortOrder(Qt::SortOrder sortOrder);
+
+	[[nodiscard]] QString filterProperty() const { return this->mFilterProperty; }
+	void setFilterProperty(const QString& filterProperty);
+
+	[[nodiscard]] QVariant filterValue() const { return this->mFilterValue; }
+	void setFilterValue(const QVariant& filterValue);
+
+	[[nodiscard]] bool invertFilter() const { return this->mInvertFilter; }
+	void setInvertFilter(bool invertFilter);
+
+signals:
+	void sourceChanged();
+	void sortPropertyChanged();
+	void sortOrderChanged();
+	void filterPropertyChanged();
+	void filterValueChanged();
+	void invertFilterChanged();
+
+private slots:
+	void onSourceInserted(QObject* object, qsizetype index);
+	void onSourceRemoved(QObject* object, qsizetype index);
+	void onSourceMoved(QObject* object, qsizetype from, qsizetype to);
+	void onSourceDestroyed();
+	void onObjectPropertyChanged();
+
+private:
+	struct Properties {
+		QMetaProperty sort;
+		QMetaProperty filter;
+	};
+
+	[[nodiscard]] QVariant sortKey(QObject* object) const;
+	[[nodiscard]] bool accepts(QObject* object) const;
+	[[nodiscard]] bool lessThan(const QVariant& a, const QVariant& b) const;
+	// Index an object should be inserted at, given the current list without it.
+	[[nodiscard]] qsizetype insertionIndex(QObject* object, const QVariant& key) const;
+
+	void trackObject(QObject* object);
+	void insertAccepted(QObject* object);
+	void removeAccepted(qsizetype index);
+	void reposition(QObject* object, const QVariant& key);
+	void rebuild();
+
+	UntypedObjectModel* mSource = nullptr;
+	QString mSortProperty;
+	Qt::SortOrder mSortOrder = Qt::AscendingOrder;
+	QString mFilterProperty;
+	QVariant mFilterValue;
+	bool mInvertFilter = false;
+
+	// Sort keys of valueList(), in the same order.
+	QList<QVariant> sortKeys;
+	QSet<QObject*> included;
+	// All objects in the source model, which are connected to onObjectPropertyChanged.
+	QHash<QObject*, Properties> tracked;
+};
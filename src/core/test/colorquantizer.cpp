@@ -0,0 +1,186 @@
+#include "colorquantizer.hpp"
+#include <algorithm>
+
+#include <qbenchmark.h>
+#include <qbytearray.h>
+#include <qcolor.h>
+#include <qdatetime.h>
+#include <qfile.h>
+#include <qfiledevice.h>
+#include <qiodevice.h>
+#include <qlist.h>
+#include <qobject.h>
+#include <qrandom.h>
+#include <qrgb.h>
+#include <qsize.h>
+#include <qstring.h>
+#include <qtemporarydir.h>
+#include <qtest.h>
+#include <qtestcase.h>
+#include <qtypes.h>
+#include <unistd.h>
+
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+#include "../colorquantizer_p.hpp"
+
+namespace {
+
+QList<QRgb> noisePixels(QSize size) {
+	auto pixels = QList<QRgb>(static_cast<qsizetype>(size.width()) * size.height());
+
+	// fixed seed so runs are comparable
+	auto rng = QRandomGenerator(0x5eed);
+	for (auto& pixel: pixels) {
+		pixel = rng.generate() | 0xff000000;
+	}
+
+	return pixels;
+}
+
+void addSizes() {
+	QTest::addColumn<QSize>("size");
+	QTest::addColumn<qreal>("depth");
+
+	for (auto size: {QSize(256, 256), QSize(1920, 1080), QSize(3840, 2160)}) {
+		for (auto depth: {3, 6, 10}) {
+			QTest::addRow("%dx%d@%d", size.width(), size.height(), depth)
+			    << size << static_cast<qreal>(depth);
+		}
+	}
+}
+
+// Resets the kernel's peak resident set size for this process to its current resident set size.
+bool resetPeakResident() {
+#ifdef __GLIBC__
+	// Return freed heap to the kernel first so reusing it counts towards the peak.
+	malloc_trim(0);
+#endif
+
+	auto file = QFile("/proc/self/clear_refs");
+	return file.open(QIODevice::WriteOnly) && file.write("5") == 1;
+}
+
+// Peak resident set size in bytes since the last reset, including mmapped allocations.
+qint64 peakResident() {
+	auto file = QFile("/proc/self/status");
+	if (!file.open(QIODevice::ReadOnly)) return -1;
+
+	for (const auto& line: file.readAll().split('\n')) {
+		if (line.startsWith("VmHWM:")) {
+			return line.sliced(6).trimmed().split(' ').first().toLongLong() * 1024;
+		}
+	}
+
+	return -1;
+}
+
+qint64 currentResident() {
+	auto file = QFile("/proc/self/statm");
+	if (!file.open(QIODevice::ReadOnly)) return -1;
+	return file.readAll().split(' ').value(1).toLongLong() * sysconf(_SC_PAGESIZE);
+}
+
+} // namespace
+
+void BenchColorQuantizer::medianCut_data() { addSizes(); }
+
+void BenchColorQuantizer::medianCut() {
+	QFETCH(const QSize, size);
+	QFETCH(const qreal, depth);
+
+	auto source = noisePixels(size);
+	auto arena = source;
+
+	QList<QColor> colors;
+
+	QBENCHMARK {
+		// medianCut partitions in place, restore the original order each iteration
+		std::copy(source.cbegin(), source.cend(), arena.begin());
+		colors = qs::colorquantizer::medianCut(arena.data(), arena.data() + arena.size(), depth);
+	}
+
+	QCOMPARE(colors.length(), 1 << static_cast<int>(depth));
+}
+
+void BenchColorQuantizer::medianCutMemory_data() { addSizes(); }
+
+// Reports how far the arena plus the quantizer itself raise the peak resident set size.
+void BenchColorQuantizer::medianCutMemory() {
+	QFETCH(const QSize, size);
+	QFETCH(const qreal, depth);
+
+	if (!resetPeakResident()) QSKIP("peak memory accounting requires /proc/self/clear_refs");
+
+	auto before = currentResident();
+
+	auto arena = noisePixels(size);
+	auto colors = qs::colorquantizer::medianCut(arena.data(), arena.data() + arena.size(), depth);
+
+	auto peak = peakResident() - before;
+	QVERIFY(before >= 0 && peak >= 0);
+	QTest::setBenchmarkResult(static_cast<qreal>(peak), QTest::BytesAllocated);
+
+	QCOMPARE(colors.length(), 1 << static_cast<int>(depth));
+
+	// Resident memory is counted in whole pages and includes the first touch of code and stack,
+	// so allow some slack over the arena and the palette.
+	auto bound = arena.size() * qint64(sizeof(QRgb)) + 4096 * qint64(sizeof(QColor)) + 1024 * 1024;
+	QCOMPARE_LE(peak, bound);
+}
+
+void BenchColorQuantizer::histogram_data() { addSizes(); }
+
+void BenchColorQuantizer::histogram() {
+	QFETCH(const QSize, size);
+	QFETCH(const qreal, depth);
+
+	auto pixels = noisePixels(size);
+
+	QList<QColor> colors;
+
+	QBENCHMARK {
+		auto histogram = qs::colorquantizer::ColorHistogram();
+		histogram.add(pixels.data(), pixels.data() + pixels.size());
+		colors = histogram.medianCut(depth);
+	}
+
+	QVERIFY(!colors.isEmpty());
+	QCOMPARE_LE(colors.length(), 1 << static_cast<int>(depth));
+}
+
+void BenchColorQuantizer::pruneCache() {
+	auto dir = QTemporaryDir();
+	QVERIFY(dir.isValid());
+
+	auto entryPath = [&](int i) { return dir.filePath(QString("%1").arg(i, 32, 10, QChar('0'))); };
+	auto now = QDateTime::currentDateTime();
+
+	// Entry 0 is the least recently used.
+	for (auto i = 0; i != 10; i++) {
+		auto file = QFile(entryPath(i));
+		QVERIFY(file.open(QIODevice::WriteOnly));
+		file.write("palette");
+		QVERIFY(file.flush());
+		QVERIFY(file.setFileTime(now.addSecs(i - 100), QFileDevice::FileModificationTime));
+	}
+
+	// A palette still being written.
+	auto temporary = dir.filePath(QString("%1.AbCdEf").arg(0, 32, 10, QChar('0')));
+	QVERIFY(QFile(temporary).open(QIODevice::WriteOnly));
+
+	qs::colorquantizer::prunePaletteCache(dir.path(), 10);
+	QVERIFY(QFile::exists(entryPath(0)));
+
+	qs::colorquantizer::prunePaletteCache(dir.path(), 8);
+
+	for (auto i = 0; i != 10; i++) {
+		QCOMPARE(QFile::exists(entryPath(i)), i >= 4);
+	}
+
+	QVERIFY(QFile::exists(temporary));
+}
+
+QTEST_MAIN(BenchColorQuantizer);
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <qobject.h>
+#include <qtmetamacros.h>
+
+class BenchColorQuantizer: public QObject {
+	Q_OBJECT;
+
+private slots:
+	static void medianCut_data(); // NOLINT
+	static void medianCut();
+	static void medianCutMemory_data(); // NOLINT
+	static void medianCutMemory();
+	static void histogram_data(); // NOLINT
+	static void histogram();
+	static void pruneCache();
+};
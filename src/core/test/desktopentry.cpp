@@ -0,0 +1,206 @@
+#include "desktopentry.hpp"
+
+#include <qbytearray.h>
+#include <qdatastream.h>
+#include <qdir.h>
+#include <qfile.h>
+#include <qfileinfo.h>
+#include <qiodevice.h>
+#include <qlist.h>
+#include <qnamespace.h>
+#include <qobject.h>
+#include <qsavefile.h>
+#include <qstring.h>
+#include <qstringlist.h>
+#include <qtenvironmentvariables.h>
+#include <qtest.h>
+#include <qtestcase.h>
+
+#include "../desktopentry.hpp"
+#include "../paths.hpp"
+
+namespace {
+
+bool writeEntry(const QString& path, const QString& contents) {
+	QDir().mkpath(QFileInfo(path).path());
+
+	// Replaced rather than written in place, so the inode changes as it would for most editors.
+	auto file = QSaveFile(path);
+	if (!file.open(QIODevice::WriteOnly)) return false;
+
+	file.write(QString("[Desktop Entry]\nType=Application\n" + contents).toUtf8());
+	return file.commit();
+}
+
+// Reports changes as DesktopEntryMonitor would.
+void reportChanges(const QStringList& dirs) {
+	QMetaObject::invokeMethod(
+	    DesktopEntryManager::instance(),
+	    "handleFileChanges",
+	    Qt::DirectConnection,
+	    Q_ARG(QStringList, dirs)
+	);
+}
+
+QString indexPath() { return QsPaths::instance()->shellCacheDir().filePath("desktopentries.idx"); }
+
+} // namespace
+
+QString TestDesktopEntry::homeApps() const {
+	return QDir::cleanPath(this->dir.filePath("home/applications"));
+}
+
+QString TestDesktopEntry::systemApps() const {
+	return QDir::cleanPath(this->dir.filePath("system/applications"));
+}
+
+void TestDesktopEntry::initTestCase() {
+	QVERIFY(this->dir.isValid());
+
+	// Read once by DesktopEntryManager, so they must be set before it is created.
+	qputenv("XDG_DATA_HOME", this->dir.filePath("home").toUtf8());
+	qputenv("XDG_DATA_DIRS", this->dir.filePath("system").toUtf8());
+	QsPaths::init("test", "test", "", "", this->dir.filePath("cache"));
+
+	auto home = this->homeApps();
+	auto system = this->systemApps();
+
+	QVERIFY(writeEntry(home + "/firefox.desktop", "Name=Firefox\nStartupWMClass=Navigator\n"));
+	QVERIFY(writeEntry(
+	    system + "/org.example.Editor.desktop",
+	    "Name=Editor\nStartupWMClass=editor-bin\n"
+	));
+	QVERIFY(writeEntry(system + "/vendor/tool.desktop", "Name=Tool\n"));
+	QVERIFY(writeEntry(system + "/shadowed.desktop", "Name=System\n"));
+	QVERIFY(writeEntry(home + "/shadowed.desktop", "Name=Home\n"));
+	QVERIFY(writeEntry(system + "/masked.desktop", "Name=Masked\n"));
+	QVERIFY(writeEntry(home + "/masked.desktop", "Name=Masked\nHidden=true\n"));
+	QVERIFY(writeEntry(system + "/settings.desktop", "Name=Settings\nNoDisplay=true\n"));
+	QVERIFY(writeEntry(system + "/readme.txt", "Name=Not an entry\n"));
+
+	auto* manager = DesktopEntryManager::instance();
+	QTRY_VERIFY(manager->byId("firefox") != nullptr);
+}
+
+void TestDesktopEntry::lookup() {
+	auto* manager = DesktopEntryManager::instance();
+
+	auto* firefox = manager->byId("firefox");
+	QVERIFY(firefox);
+	QCOMPARE(firefox->bName.value(), "Firefox");
+
+	// Ids of entries in subdirectories are prefixed with the directory name.
+	QVERIFY(manager->byId("vendor-tool"));
+	QCOMPARE(manager->byId("org.example.editor"), manager->byId("org.example.Editor"));
+	QCOMPARE(manager->heuristicLookup("editor-bin"), manager->byId("org.example.Editor"));
+	QCOMPARE(manager->heuristicLookup("navigator"), firefox);
+
+	// Entries in XDG_DATA_HOME take precedence, and can hide others.
+	QCOMPARE(manager->byId("shadowed")->bName.value(), "Home");
+	QVERIFY(!manager->byId("masked"));
+	QVERIFY(!manager->byId("readme"));
+
+	// NoDisplay entries can be looked up but are not listed as applications.
+	auto* settings = manager->byId("settings");
+	QVERIFY(settings);
+	QVERIFY(!manager->applications()->valueList().contains(settings));
+	QVERIFY(manager->applications()->valueList().contains(firefox));
+}
+
+void TestDesktopEntry::indexRoundTrip() {
+	auto index = DesktopEntryIndex();
+	QVERIFY(index.load(indexPath()));
+
+	auto firefox = index.files.constFind(this->homeApps() + "/firefox.desktop");
+	QVERIFY(firefox != index.files.cend());
+	QCOMPARE(firefox->data.name, "Firefox");
+	QVERIFY(firefox->mtime != 0);
+	QVERIFY(index.directories.value(this->systemApps()).children.contains("vendor/"));
+
+	auto copyPath = this->dir.filePath("index-copy.idx");
+	QVERIFY(index.save(copyPath));
+
+	auto copy = DesktopEntryIndex();
+	QVERIFY(copy.load(copyPath));
+	QCOMPARE(copy.files.keys(), index.files.keys());
+	QCOMPARE(copy.directories.keys(), index.directories.keys());
+	QCOMPARE(copy.files.value(firefox.key()).data.startupClass, "Navigator");
+}
+
+void TestDesktopEntry::indexRejected() {
+	auto path = this->dir.filePath("rejected.idx");
+
+	{
+		auto file = QFile(path);
+		QVERIFY(file.open(QIODevice::WriteOnly));
+		file.write("not a desktop entry index");
+	}
+
+	auto index = DesktopEntryIndex();
+	QVERIFY(!index.load(path));
+
+	// An index written for other desktop entry paths would give different ids.
+	{
+		auto file = QFile(path);
+		QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+
+		auto valid = QFile(indexPath());
+		QVERIFY(valid.open(QIODevice::ReadOnly));
+		auto header = QDataStream(&valid);
+		header.setVersion(QDataStream::Qt_6_6);
+
+		quint32 magic = 0;
+		quint32 version = 0;
+		QString locale;
+		header >> magic >> version >> locale;
+
+		auto stream = QDataStream(&file);
+		stream.setVersion(QDataStream::Qt_6_6);
+		stream << magic << version << locale << QStringList({"/nonexistent/applications"});
+	}
+
+	QVERIFY(!index.load(path));
+	QVERIFY(index.files.isEmpty());
+}
+
+void TestDesktopEntry::rescanChanged() {
+	auto* manager = DesktopEntryManager::instance();
+	auto* firefox = manager->byId("firefox");
+	QVERIFY(firefox);
+
+	QVERIFY(writeEntry(this->homeApps() + "/firefox.desktop", "Name=Firefox Nightly\n"));
+	QVERIFY(writeEntry(this->homeApps() + "/added.desktop", "Name=Added\n"));
+	reportChanges({this->homeApps()});
+
+	QTRY_VERIFY(manager->byId("added"));
+	QCOMPARE(manager->byId("firefox"), firefox);
+	QCOMPARE(firefox->bName.value(), "Firefox Nightly");
+	QCOMPARE(manager->heuristicLookup("Navigator"), nullptr);
+
+	auto index = DesktopEntryIndex();
+	QVERIFY(index.load(indexPath()));
+	QCOMPARE(index.files.value(this->homeApps() + "/firefox.desktop").data.name, "Firefox Nightly");
+	QVERIFY(index.files.contains(this->homeApps() + "/added.desktop"));
+}
+
+void TestDesktopEntry::rescanRemoved() {
+	auto* manager = DesktopEntryManager::instance();
+	auto vendor = this->systemApps() + "/vendor";
+
+	QVERIFY(QFile::remove(vendor + "/tool.desktop"));
+	QVERIFY(QFile::remove(this->homeApps() + "/shadowed.desktop"));
+	reportChanges({vendor, this->homeApps()});
+
+	QTRY_VERIFY(!manager->byId("vendor-tool"));
+
+	// The shadowed entry is visible again.
+	QCOMPARE(manager->byId("shadowed")->bName.value(), "System");
+
+	auto index = DesktopEntryIndex();
+	QVERIFY(index.load(indexPath()));
+	QVERIFY(!index.files.contains(vendor + "/tool.desktop"));
+	QVERIFY(!index.files.contains(this->homeApps() + "/shadowed.desktop"));
+	QVERIFY(index.files.contains(this->systemApps() + "/shadowed.desktop"));
+}
+
+QTEST_MAIN(TestDesktopEntry);
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <qobject.h>
+#include <qstring.h>
+#include <qtemporarydir.h>
+#include <qtmetamacros.h>
+
+class TestDesktopEntry: public QObject {
+	Q_OBJECT;
+
+private slots:
+	void initTestCase();
+	void lookup();
+	void indexRoundTrip();
+	void indexRejected();
+	void rescanChanged();
+	void rescanRemoved();
+
+private:
+	[[nodiscard]] QString homeApps() const;
+	[[nodiscard]] QString systemApps() const;
+
+	QTemporaryDir dir;
+};
@@ -0,0 +1,142 @@
+#include "desktopentrysearch.hpp"
+
+#include <qatomic.h>
+#include <qlist.h>
+#include <qobject.h>
+#include <qsharedpointer.h>
+#include <qstring.h>
+#include <qstringlist.h>
+#include <qtest.h>
+#include <qtestcase.h>
+#include <qtypes.h>
+
+#include "../desktopentry.hpp"
+#include "../desktopentrysearch.hpp"
+
+namespace {
+
+DesktopEntry* makeEntry(QObject* parent, const QString& id, const QString& fields) {
+	auto* entry = new DesktopEntry(id, parent);
+	entry->updateState(DesktopEntry::parseText(id, "[Desktop Entry]\nType=Application\n" + fields));
+	return entry;
+}
+
+QSharedPointer<const DesktopEntrySearchIndex> makeIndex(QObject* parent) {
+	return DesktopEntrySearchIndex::build({
+	    makeEntry(parent, "foot", "Name=Foot\nGenericName=Terminal Emulator\n"),
+	    makeEntry(
+	        parent,
+	        "firefox",
+	        "Name=Firefox\nGenericName=Web Browser\nKeywords=internet;www;\n"
+	    ),
+	    makeEntry(parent, "org.example.Terminal", "Name=Terminal\n"),
+	    makeEntry(parent, "xterm", "Name=XTerm\nStartupWMClass=XTerm\n"),
+	});
+}
+
+QStringList resultIds(
+    const DesktopEntrySearchIndex& index,
+    const QList<DesktopEntrySearchIndex::Match>& matches
+) {
+	auto ids = QStringList();
+	for (const auto& match: matches) ids.append(index.entries.at(match.entry).id);
+	return ids;
+}
+
+} // namespace
+
+void TestDesktopEntrySearch::fuzzyScore() {
+	auto score = [](const QString& haystack, const QString& needle) {
+		return DesktopEntrySearchIndex::fuzzyScore(haystack, needle);
+	};
+
+	// The first occurrence of the first character is not always the best place to start.
+	QCOMPARE(score("foo fox", "fox"), score("a fox", "fox"));
+	QCOMPARE(score("firefox", ""), 0);
+	QCOMPARE(score("firefox", "fireofx"), -1);
+	QCOMPARE(score("fox", "firefox"), -1);
+
+	// Exact matches beat prefixes, which beat matches at a word boundary, which beat
+	// matches in the middle of a word, which beat scattered characters.
+	QVERIFY(score("firefox", "firefox") > score("firefox nightly", "firefox"));
+	QVERIFY(score("firefox", "fire") > score("mozilla firefox", "fire"));
+	QVERIFY(score("mozilla firefox", "fire") > score("campfire", "fire"));
+	QVERIFY(score("campfire", "fire") > score("xfxixrxe", "fire"));
+}
+
+void TestDesktopEntrySearch::ranking() {
+	auto parent = QObject();
+	auto index = makeIndex(&parent);
+
+	// A match in the name outweighs a better one in the generic name.
+	QCOMPARE(
+	    resultIds(*index, index->search("term", nullptr)),
+	    QStringList({"org.example.Terminal", "xterm", "foot"})
+	);
+
+	QCOMPARE(resultIds(*index, index->search("TERM", nullptr)).first(), "org.example.Terminal");
+
+	// Each term must match a field, though not necessarily the same one.
+	QCOMPARE(resultIds(*index, index->search("web fire", nullptr)), QStringList({"firefox"}));
+	QCOMPARE(resultIds(*index, index->search("www", nullptr)), QStringList({"firefox"}));
+	QVERIFY(index->search("web term", nullptr).isEmpty());
+	QVERIFY(index->search("zzz", nullptr).isEmpty());
+}
+
+void TestDesktopEntrySearch::ties() {
+	auto parent = QObject();
+	auto index = DesktopEntrySearchIndex::build({
+	    makeEntry(&parent, "charlie", "Name=Charlie Tool\n"),
+	    makeEntry(&parent, "bravo", "Name=Bravo Tool\n"),
+	    makeEntry(&parent, "alpha", "Name=Alpha Tool\n"),
+	});
+
+	auto matches = index->search("tool", nullptr);
+	QCOMPARE(matches.size(), 3);
+	QCOMPARE(matches.at(0).score, matches.at(1).score);
+	QCOMPARE(matches.at(1).score, matches.at(2).score);
+
+	// Equal scores fall back to name order rather than index order.
+	QCOMPARE(resultIds(*index, matches), QStringList({"alpha", "bravo", "charlie"}));
+}
+
+void TestDesktopEntrySearch::emptyQuery_data() { // NOLINT
+	QTest::addColumn<QString>("query");
+	QTest::addRow("empty") << QString();
+	QTest::addRow("whitespace") << QString("   ");
+}
+
+void TestDesktopEntrySearch::emptyQuery() {
+	QFETCH(QString, query);
+
+	auto parent = QObject();
+	auto index = makeIndex(&parent);
+
+	// Every entry matches, in name order.
+	QCOMPARE(
+	    resultIds(*index, index->search(query, nullptr)),
+	    QStringList({"firefox", "foot", "org.example.Terminal", "xterm"})
+	);
+}
+
+void TestDesktopEntrySearch::candidates() {
+	auto parent = QObject();
+	auto index = makeIndex(&parent);
+
+	// Narrowing a previous search only considers its matches.
+	auto candidates = QList<qint32>({0, 3});
+	QCOMPARE(resultIds(*index, index->search("term", &candidates)), QStringList({"xterm", "foot"}));
+
+	candidates.clear();
+	QVERIFY(index->search("term", &candidates).isEmpty());
+}
+
+void TestDesktopEntrySearch::cancelled() {
+	auto parent = QObject();
+	auto index = makeIndex(&parent);
+
+	auto cancel = QAtomicInteger<bool>(true);
+	QVERIFY(index->search("", nullptr, cancel).isEmpty());
+}
+
+QTEST_MAIN(TestDesktopEntrySearch);
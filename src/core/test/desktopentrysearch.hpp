@@ -0,0 +1,17 @@
+#pragma once
+
+#include <qobject.h>
+#include <qtmetamacros.h>
+
+class TestDesktopEntrySearch: public QObject {
+	Q_OBJECT;
+
+private slots:
+	void fuzzyScore();
+	void ranking();
+	void ties();
+	void emptyQuery_data(); // NOLINT
+	void emptyQuery();
+	void candidates();
+	void cancelled();
+};
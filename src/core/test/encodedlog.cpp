@@ -0,0 +1,487 @@
+#include "encodedlog.hpp"
+#include <algorithm>
+#include <array>
+
+#include <qbenchmark.h>
+#include <qbytearray.h>
+#include <qdatetime.h>
+#include <qfile.h>
+#include <qlatin1stringview.h>
+#include <qlist.h>
+#include <qlogging.h>
+#include <qobject.h>
+#include <qrandom.h>
+#include <qregularexpression.h>
+#include <qstring.h>
+#include <qtemporaryfile.h>
+#include <qtenvironmentvariables.h>
+#include <qtest.h>
+#include <qtestcase.h>
+#include <qtypes.h>
+
+#include "../logging.hpp"
+#include "../logging_p.hpp"
+#include "../ringbuf.hpp"
+
+using namespace qs::log;
+
+namespace {
+
+constexpr auto CATEGORIES = std::array<QLatin1StringView, 4> {
+    QLatin1StringView("quickshell.test.a"),
+    QLatin1StringView("quickshell.test.b"),
+    QLatin1StringView("qt.test"),
+    QLatin1StringView("default"),
+};
+
+// Generates messages with a mix of repeated and unique bodies and irregular time gaps.
+class MessageGenerator {
+public:
+	explicit MessageGenerator(quint32 seed = 0x5eed): rng(seed) {}
+
+	LogMessage next() {
+		auto roll = this->rng.bounded(1000);
+		if (roll < 300) this->time = this->time.addSecs(this->rng.bounded(3));
+		else if (roll < 302) this->time = this->time.addSecs(0x1d + this->rng.bounded(0x1000));
+		else if (roll == 302) this->time = this->time.addSecs(0x10000);
+
+		auto body = roll < 600
+		              ? QByteArray("repeated message ") + QByteArray::number(this->rng.bounded(24))
+		              : QByteArray("unique message ") + QByteArray::number(this->index);
+
+		this->index++;
+
+		return LogMessage(
+		    static_cast<QtMsgType>(this->rng.bounded(4)),
+		    CATEGORIES.at(this->rng.bounded(static_cast<quint32>(CATEGORIES.size()))),
+		    body,
+		    this->time
+		);
+	}
+
+private:
+	// fixed seed so runs are comparable
+	QRandomGenerator rng;
+	QDateTime time = QDateTime::fromSecsSinceEpoch(1790000000);
+	qsizetype index = 0;
+};
+
+bool writeLog(
+    QFile* file,
+    qsizetype count,
+    bool compressed,
+    qint64 syncInterval,
+    QList<LogMessage>* written,
+    quint32 seed = 0x5eed
+) {
+	auto writer = EncodedLogWriter();
+	writer.setDevice(file);
+	writer.setCompressed(compressed);
+	writer.setSyncInterval(syncInterval);
+	if (!writer.writeHeader()) return false;
+
+	auto generator = MessageGenerator(seed);
+
+	for (qsizetype i = 0; i != count; i++) {
+		auto message = generator.next();
+		if (!writer.write(message)) return false;
+		if (written) written->append(message);
+
+		// Flush at irregular points like the logging thread would.
+		if (i % 7 == 0 && !writer.flush()) return false;
+	}
+
+	return writer.flush();
+}
+
+void addCompressionRows() {
+	QTest::addColumn<bool>("compressed");
+	QTest::addRow("uncompressed") << false;
+	QTest::addRow("compressed") << true;
+}
+
+bool openReader(QFile* file, EncodedLogReader* reader) {
+	if (!file->open(QFile::ReadOnly)) return false;
+	reader->setDevice(file);
+
+	bool readable = false;
+	quint8 logVersion = 0;
+	quint8 readerVersion = 0;
+	return reader->readHeader(&readable, &logVersion, &readerVersion) && readable;
+}
+
+QList<LogMessage> readAll(EncodedLogReader* reader) {
+	auto messages = QList<LogMessage>();
+	auto message = LogMessage();
+	while (reader->read(&message)) messages.append(message);
+	return messages;
+}
+
+bool sameMessages(const QList<LogMessage>& a, const QList<LogMessage>& b) {
+	if (a.size() != b.size()) return false;
+
+	for (auto i = 0; i != a.size(); i++) {
+		if (a.at(i) != b.at(i) || a.at(i).time != b.at(i).time) return false;
+	}
+
+	return true;
+}
+
+// Writes out committed data the way the crash handler does. The writer can't be used afterwards.
+void writeCrashData(EncodedLogWriter* writer, const QString& path) {
+	auto* pending = writer->pendingWrites();
+	auto state = pending->state.exchange(qs::crash::PendingWrites::CLAIMED);
+	if (state <= 0) return;
+
+	auto crashFile = QFile(path);
+	QVERIFY(crashFile.open(QFile::Append));
+
+	auto slot = state & 1;
+	auto prefixSize = static_cast<qint64>(pending->prefixSizes.at(slot));
+	QCOMPARE(crashFile.write(pending->prefixes.at(slot).data(), prefixSize), prefixSize);
+	QCOMPARE(crashFile.write(pending->data, state >> 1), state >> 1);
+}
+
+} // namespace
+
+void TestEncodedLog::sequentialRead_data() { addCompressionRows(); } // NOLINT
+
+void TestEncodedLog::sequentialRead() {
+	QFETCH(bool, compressed);
+
+	auto file = QTemporaryFile();
+	QVERIFY(file.open());
+
+	auto written = QList<LogMessage>();
+	QVERIFY(writeLog(&file, 5000, compressed, 4096, &written));
+
+	auto readFile = QFile(file.fileName());
+	auto reader = EncodedLogReader();
+	QVERIFY(openReader(&readFile, &reader));
+
+	QVERIFY(sameMessages(readAll(&reader), written));
+	QVERIFY(readFile.atEnd());
+}
+
+void TestEncodedLog::growingRead_data() { addCompressionRows(); } // NOLINT
+
+void TestEncodedLog::growingRead() {
+	QFETCH(bool, compressed);
+
+	auto file = QTemporaryFile();
+	QVERIFY(file.open());
+
+	auto written = QList<LogMessage>();
+	QVERIFY(writeLog(&file, 3000, compressed, 4096, &written));
+	QVERIFY(file.seek(0));
+	auto data = file.readAll();
+
+	// Copy the log over in pieces that cut through records and frames, like a follower sees it.
+	auto growing = QTemporaryFile();
+	QVERIFY(growing.open());
+	QCOMPARE(growing.write(data.first(2)), 2);
+	QVERIFY(growing.flush());
+
+	auto readFile = QFile(growing.fileName());
+	auto reader = EncodedLogReader();
+	QVERIFY(openReader(&readFile, &reader));
+
+	auto messages = QList<LogMessage>();
+	for (qsizetype offset = 2; offset < data.size(); offset += 97) {
+		auto chunk = data.sliced(offset, std::min<qsizetype>(97, data.size() - offset));
+		QCOMPARE(growing.write(chunk), chunk.size());
+		QVERIFY(growing.flush());
+
+		messages.append(readAll(&reader));
+		QVERIFY(!reader.corrupt());
+	}
+
+	QVERIFY(reader.atEnd());
+	QVERIFY(sameMessages(messages, written));
+}
+
+void TestEncodedLog::syncPoints_data() { addCompressionRows(); } // NOLINT
+
+void TestEncodedLog::syncPoints() {
+	QFETCH(bool, compressed);
+
+	auto file = QTemporaryFile();
+	QVERIFY(file.open());
+
+	auto written = QList<LogMessage>();
+	QVERIFY(writeLog(&file, 5000, compressed, 4096, &written));
+
+	auto readFile = QFile(file.fileName());
+	auto reader = EncodedLogReader();
+	QVERIFY(openReader(&readFile, &reader));
+
+	auto points = reader.findSyncPoints();
+	QVERIFY(points.size() > 10);
+	// directly after the header
+	QCOMPARE(points.first().offset, 2);
+	QCOMPARE(points.first().messageIndex, 0);
+
+	for (auto i = 1; i != points.size(); i++) {
+		QCOMPARE(points.at(i).previous, points.at(i - 1).offset);
+		QVERIFY(points.at(i).messageIndex > points.at(i - 1).messageIndex);
+	}
+
+	// Decoding from any sync point must match decoding from the start.
+	for (const auto& point: points) {
+		QVERIFY(reader.seekToSyncPoint(point));
+		auto expected = written.mid(static_cast<qsizetype>(point.messageIndex));
+		QVERIFY(sameMessages(readAll(&reader), expected));
+	}
+}
+
+void TestEncodedLog::seekByTime_data() { addCompressionRows(); } // NOLINT
+
+void TestEncodedLog::seekByTime() {
+	QFETCH(bool, compressed);
+
+	auto file = QTemporaryFile();
+	QVERIFY(file.open());
+
+	auto written = QList<LogMessage>();
+	QVERIFY(writeLog(&file, 5000, compressed, 4096, &written));
+
+	auto readFile = QFile(file.fileName());
+	auto reader = EncodedLogReader();
+	QVERIFY(openReader(&readFile, &reader));
+
+	auto points = reader.findSyncPoints();
+	auto since = written.at(3000).time;
+
+	auto first = points.size() - 1;
+	while (first > 0 && points.at(first).time >= since) first--;
+	QVERIFY(first > 0);
+	QVERIFY(reader.seekToSyncPoint(points.at(first)));
+
+	auto expectedIndex = 0;
+	while (written.at(expectedIndex).time < since) expectedIndex++;
+
+	auto messages = readAll(&reader);
+	auto readIndex = 0;
+	while (messages.at(readIndex).time < since) readIndex++;
+
+	QVERIFY(sameMessages(messages.mid(readIndex), written.mid(expectedIndex)));
+}
+
+void TestEncodedLog::compressedSize() {
+	auto uncompressed = QTemporaryFile();
+	auto compressed = QTemporaryFile();
+	QVERIFY(uncompressed.open());
+	QVERIFY(compressed.open());
+
+	QVERIFY(writeLog(&uncompressed, 20000, false, EncodedLogWriter::DEFAULT_SYNC_INTERVAL, nullptr));
+	QVERIFY(writeLog(&compressed, 20000, true, EncodedLogWriter::DEFAULT_SYNC_INTERVAL, nullptr));
+
+	qInfo() << "Compressed" << uncompressed.size() << "bytes to" << compressed.size();
+	QVERIFY(compressed.size() < uncompressed.size() / 2);
+}
+
+void TestEncodedLog::crashRecovery_data() { addCompressionRows(); } // NOLINT
+
+void TestEncodedLog::crashRecovery() {
+	QFETCH(bool, compressed);
+
+	auto file = QTemporaryFile();
+	QVERIFY(file.open());
+
+	auto writer = EncodedLogWriter();
+	writer.setDevice(&file);
+	writer.setCompressed(compressed);
+	QVERIFY(writer.writeHeader());
+
+	auto generator = MessageGenerator();
+	auto written = QList<LogMessage>();
+
+	for (auto i = 0; i != 200; i++) {
+		written.append(generator.next());
+		QVERIFY(writer.write(written.last()));
+	}
+
+	QVERIFY(writer.flush());
+
+	for (auto i = 0; i != 50; i++) {
+		written.append(generator.next());
+		QVERIFY(writer.write(written.last()));
+	}
+
+	writeCrashData(&writer, file.fileName());
+
+	auto readFile = QFile(file.fileName());
+	auto reader = EncodedLogReader();
+	QVERIFY(openReader(&readFile, &reader));
+	QVERIFY(sameMessages(readAll(&reader), written));
+}
+
+void TestEncodedLog::largeRecords_data() { addCompressionRows(); } // NOLINT
+
+void TestEncodedLog::largeRecords() {
+	QFETCH(bool, compressed);
+
+	auto file = QTemporaryFile();
+	QVERIFY(file.open());
+
+	auto writer = EncodedLogWriter();
+	writer.setDevice(&file);
+	writer.setCompressed(compressed);
+	QVERIFY(writer.writeHeader());
+
+	auto generator = MessageGenerator();
+	auto written = QList<LogMessage>();
+
+	// Bodies around and past the arena size, written without flushing so it fills mid-record.
+	for (auto i = 0; i != 40; i++) {
+		auto message = generator.next();
+		if (i % 3 == 0) message.body = QByteArray(i * 4096 + 1000, static_cast<char>('a' + i % 26));
+		written.append(message);
+		QVERIFY(writer.write(message));
+
+		// Only whole records may reach the file before a flush.
+		auto readFile = QFile(file.fileName());
+		auto reader = EncodedLogReader();
+		QVERIFY(openReader(&readFile, &reader));
+
+		auto partial = readAll(&reader);
+		QVERIFY(partial.size() <= written.size());
+		QVERIFY(sameMessages(partial, written.first(partial.size())));
+		if (!compressed) QCOMPARE(reader.streamPosition(), readFile.size());
+	}
+
+	writeCrashData(&writer, file.fileName());
+
+	auto readFile = QFile(file.fileName());
+	auto reader = EncodedLogReader();
+	QVERIFY(openReader(&readFile, &reader));
+	QVERIFY(sameMessages(readAll(&reader), written));
+}
+
+void TestEncodedLog::search_data() { // NOLINT
+	QTest::addColumn<QString>("pattern");
+	QTest::addColumn<bool>("ignoreCase");
+	QTest::addRow("literal") << "repeated message 1" << false;
+	QTest::addRow("regex") << "message [0-9]*7$" << false;
+	QTest::addRow("ignore case") << "REPEATED message 1" << true;
+}
+
+void TestEncodedLog::search() {
+	QFETCH(QString, pattern);
+	QFETCH(bool, ignoreCase);
+
+	auto files = std::array<QTemporaryFile, 3>();
+	auto paths = QList<QString>();
+	auto written = std::array<QList<LogMessage>, 3>();
+
+	for (auto i = 0; i != 3; i++) {
+		QVERIFY(files.at(i).open());
+		QVERIFY(writeLog(&files.at(i), 3000, i != 0, 4096, &written.at(i), 0x5eed + i));
+		paths.append(files.at(i).fileName());
+	}
+
+	auto query = LogSearchQuery();
+	query.categories = {"quickshell.test.*"};
+	query.level = QtWarningMsg;
+	query.since = written.at(0).at(1000).time;
+	query.until = written.at(0).at(2000).time;
+	query.pattern = pattern;
+	query.ignoreCase = ignoreCase;
+
+	auto regex = QRegularExpression(
+	    pattern,
+	    ignoreCase ? QRegularExpression::CaseInsensitiveOption : QRegularExpression::NoPatternOption
+	);
+
+	auto expected = QList<LogSearchMatch>();
+	for (auto log = 0; log != 3; log++) {
+		for (const auto& message: written.at(log)) {
+			if (message.time < query.since || message.time > query.until) continue;
+			if (message.type == QtDebugMsg || message.category == "qt.test") continue;
+			if (message.category == "default") continue;
+			if (!regex.match(QString::fromUtf8(message.body)).hasMatch()) continue;
+			expected.append({.log = log, .message = message});
+		}
+	}
+
+	std::ranges::stable_sort(expected, [](const LogSearchMatch& a, const LogSearchMatch& b) {
+		return a.message.time < b.message.time;
+	});
+
+	QVERIFY(expected.size() > 10);
+
+	auto search = LogSearch(query);
+	QVERIFY(search.isValid());
+	QVERIFY(search.search(paths, 2));
+
+	const auto& matches = search.matches();
+	QCOMPARE(matches.size(), expected.size());
+
+	for (auto i = 0; i != matches.size(); i++) {
+		QCOMPARE(matches.at(i).log, expected.at(i).log);
+		QCOMPARE(matches.at(i).message, expected.at(i).message);
+		QCOMPARE(matches.at(i).message.time, expected.at(i).message.time);
+	}
+}
+
+QString TestEncodedLog::largeLogPath() {
+	if (this->largeLog.isOpen()) return this->largeLog.fileName();
+	if (!this->largeLog.open()) return QString();
+
+	auto writer = EncodedLogWriter();
+	writer.setDevice(&this->largeLog);
+	writer.setCompressed(true);
+	if (!writer.writeHeader()) return QString();
+
+	// How well messages compress varies, so write until the file itself is large enough.
+	auto size = static_cast<qint64>(qEnvironmentVariableIntValue("QS_BENCH_LOG_MB")) * 1024 * 1024;
+	auto generator = MessageGenerator();
+
+	while (this->largeLog.size() < size) {
+		for (auto i = 0; i != 1000; i++) {
+			if (!writer.write(generator.next())) return QString();
+		}
+
+		if (!writer.flush()) return QString();
+	}
+
+	qInfo() << "Benchmarking with a" << this->largeLog.size() / 1024 / 1024 << "MiB log.";
+	return this->largeLog.fileName();
+}
+
+void TestEncodedLog::benchmarkTail_data() { // NOLINT
+	QTest::addColumn<bool>("indexed");
+	QTest::addRow("sequential") << false;
+	QTest::addRow("indexed") << true;
+}
+
+void TestEncodedLog::benchmarkTail() {
+	QFETCH(bool, indexed);
+
+	if (qEnvironmentVariableIntValue("QS_BENCH_LOG_MB") <= 0) {
+		QSKIP("Set QS_BENCH_LOG_MB to the size of the log to benchmark with, in MiB.");
+	}
+
+	auto path = this->largeLogPath();
+	QVERIFY(!path.isEmpty());
+
+	QBENCHMARK {
+		auto file = QFile(path);
+		auto reader = EncodedLogReader();
+		QVERIFY(openReader(&file, &reader));
+
+		if (indexed) {
+			auto points = reader.findSyncPoints();
+			QVERIFY(points.size() > 2);
+			// The second to last sync point is at least one interval from the end.
+			QVERIFY(reader.seekToSyncPoint(points.at(points.size() - 2)));
+		}
+
+		auto tail = RingBuffer<LogMessage>(50);
+		auto message = LogMessage();
+		while (reader.read(&message)) tail.emplace(message);
+		QCOMPARE(tail.size(), 50);
+	}
+}
+
+QTEST_MAIN(TestEncodedLog);
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <qobject.h>
+#include <qstring.h>
+#include <qtemporaryfile.h>
+#include <qtmetamacros.h>
+
+class TestEncodedLog: public QObject {
+	Q_OBJECT;
+
+private slots:
+	void sequentialRead_data(); // NOLINT
+	void sequentialRead();
+	void growingRead_data(); // NOLINT
+	void growingRead();
+	void syncPoints_data(); // NOLINT
+	void syncPoints();
+	void seekByTime_data(); // NOLINT
+	void seekByTime();
+	void compressedSize();
+	void crashRecovery_data(); // NOLINT
+	void crashRecovery();
+	void largeRecords_data(); // NOLINT
+	void largeRecords();
+	void search_data(); // NOLINT
+	void search();
+
+	void benchmarkTail_data(); // NOLINT
+	void benchmarkTail();
+
+private:
+	QString largeLogPath();
+
+	QTemporaryFile largeLog;
+};
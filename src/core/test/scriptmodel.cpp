@@ -150,6 +150,13 @@ void TestScriptModel::unique_data() {
 	                                      {ModelOperation::Move, 4, 2, 2}, // ABEFCDG
 	                                      {ModelOperation::Insert, 4, 2},  // ABEFXYCDG
 	                                  });
+
+	// Values matching at both ends are kept in place, even where they repeat in the changed range.
+	QTest::addRow("prefix_suffix_ok") << "ABCAB" << "ABXAB"
+	                                  << OpList({
+	                                         {ModelOperation::Insert, 2, 1}, // ABXCAB
+	                                         {ModelOperation::Remove, 3, 1}, // ABXAB
+	                                     });
 }
 
 void TestScriptModel::unique() {
@@ -280,4 +287,65 @@ void TestScriptModel::comparisonModes() {
 	QCOMPARE_EQ(observer.operations(), OpList());
 }
 
+void TestScriptModel::benchmarkDiff_data() {
+	QTest::addColumn<QString>("objectProp");
+	QTest::addColumn<bool>("reverse");
+
+	QTest::addRow("structure_update") << "" << false;
+	QTest::addRow("structure_reverse") << "" << true;
+	QTest::addRow("keyed_update") << "id" << false;
+	QTest::addRow("keyed_reverse") << "id" << true;
+}
+
+void TestScriptModel::benchmarkDiff() {
+	QFETCH(const QString, objectProp);
+	QFETCH(const bool, reverse);
+
+	QJSEngine engine;
+
+	auto makeValue = [&engine](qint32 id) {
+		auto value = engine.newObject();
+		value.setProperty("id", id);
+		value.setProperty("name", QString("entry %1").arg(id));
+		auto nested = engine.newObject();
+		nested.setProperty("value", id * 2);
+		value.setProperty("nested", nested);
+		return value;
+	};
+
+	QJSValueList oldList;
+	for (auto i = 0; i != 10000; i++) {
+		oldList.append(makeValue(i));
+	}
+
+	QJSValueList newList;
+	if (reverse) {
+		for (auto i = 9999; i != -1; i--) {
+			newList.append(makeValue(i));
+		}
+	} else {
+		// Drop every tenth value, insert new ones in their place, and move the first block to the end.
+		for (auto i = 100; i != 10000; i++) {
+			newList.append(makeValue(i % 10 == 0 ? i + 10000 : i));
+		}
+
+		for (auto i = 0; i != 100; i++) {
+			newList.append(makeValue(i));
+		}
+	}
+
+	QBENCHMARK {
+		ScriptModel model;
+		model.setObjectProp(objectProp);
+		model.setValues(oldList);
+		model.setValues(newList);
+	}
+
+	ScriptModel model;
+	model.setObjectProp(objectProp);
+	model.setValues(oldList);
+	model.setValues(newList);
+	QCOMPARE_EQ(model.values().length(), newList.length());
+}
+
 QTEST_MAIN(TestScriptModel);
@@ -61,4 +61,7 @@ private slots:
 	static void unique();
 	static void structuralEquality();
 	static void comparisonModes();
+
+	static void benchmarkDiff_data(); // NOLINT
+	static void benchmarkDiff();
 };
@@ -0,0 +1,133 @@
+#include "sortfiltermodel.hpp"
+
+#include <qabstractitemmodel.h>
+#include <qabstractitemmodeltester.h>
+#include <qlist.h>
+#include <qnamespace.h>
+#include <qobject.h>
+#include <qsignalspy.h>
+#include <qtest.h>
+#include <qtestcase.h>
+
+#include "../model.hpp"
+#include "../sortfiltermodel.hpp"
+
+void TestSortFilterModel::sortedInsert() {
+	TestValue a(3);
+	TestValue b(1);
+	TestValue c(2);
+	TestValue d(2);
+
+	auto source = ObjectModel<QObject>(nullptr);
+	source.insertObject(&a);
+
+	SortFilterObjectModel model;
+	auto tester = QAbstractItemModelTester(&model);
+	model.setSortProperty("rank");
+	model.setSource(&source);
+	QCOMPARE(model.valueList(), (QList<QObject*> {&a}));
+
+	source.insertObject(&b);
+	source.insertObject(&c);
+	source.insertObject(&d);
+	QCOMPARE(model.valueList(), (QList<QObject*> {&b, &c, &d, &a}));
+
+	model.setSortOrder(Qt::DescendingOrder);
+	QCOMPARE(model.valueList(), (QList<QObject*> {&a, &c, &d, &b}));
+
+	source.removeObject(&c);
+	QCOMPARE(model.valueList(), (QList<QObject*> {&a, &d, &b}));
+}
+
+void TestSortFilterModel::sortKeyChange() {
+	TestValue a(1);
+	TestValue b(2);
+	TestValue c(3);
+
+	auto source = ObjectModel<QObject>(nullptr);
+	source.insertObject(&a);
+	source.insertObject(&b);
+	source.insertObject(&c);
+
+	SortFilterObjectModel model;
+	auto tester = QAbstractItemModelTester(&model);
+	model.setSortProperty("rank");
+	model.setSource(&source);
+
+	auto moveSpy = QSignalSpy(&model, &QAbstractItemModel::rowsMoved);
+	auto insertSpy = QSignalSpy(&model, &QAbstractItemModel::rowsInserted);
+	auto removeSpy = QSignalSpy(&model, &QAbstractItemModel::rowsRemoved);
+
+	a.setRank(4);
+	QCOMPARE(model.valueList(), (QList<QObject*> {&b, &c, &a}));
+
+	c.setRank(0);
+	QCOMPARE(model.valueList(), (QList<QObject*> {&c, &b, &a}));
+
+	// Does not change order.
+	b.setRank(2);
+	QCOMPARE(model.valueList(), (QList<QObject*> {&c, &b, &a}));
+
+	QCOMPARE(moveSpy.count(), 2);
+	QCOMPARE(insertSpy.count(), 0);
+	QCOMPARE(removeSpy.count(), 0);
+}
+
+void TestSortFilterModel::filter() {
+	TestValue a(1);
+	TestValue b(2, false);
+	TestValue c(3);
+
+	auto source = ObjectModel<QObject>(nullptr);
+	source.insertObject(&a);
+	source.insertObject(&b);
+	source.insertObject(&c);
+
+	SortFilterObjectModel model;
+	auto tester = QAbstractItemModelTester(&model);
+	model.setSource(&source);
+	model.setFilterProperty("shown");
+	QCOMPARE(model.valueList(), (QList<QObject*> {&a, &c}));
+
+	b.setShown(true);
+	QCOMPARE(model.valueList(), (QList<QObject*> {&a, &b, &c}));
+
+	a.setShown(false);
+	QCOMPARE(model.valueList(), (QList<QObject*> {&b, &c}));
+
+	model.setInvertFilter(true);
+	QCOMPARE(model.valueList(), (QList<QObject*> {&a}));
+
+	model.setInvertFilter(false);
+	model.setFilterProperty("rank");
+	model.setFilterValue(3);
+	QCOMPARE(model.valueList(), (QList<QObject*> {&c}));
+}
+
+void TestSortFilterModel::sourceOrder() {
+	TestValue a(1);
+	TestValue b(2, false);
+	TestValue c(3);
+	TestValue d(4);
+
+	auto source = ObjectModel<QObject>(nullptr);
+	source.insertObject(&a);
+	source.insertObject(&b);
+	source.insertObject(&c);
+
+	SortFilterObjectModel model;
+	auto tester = QAbstractItemModelTester(&model);
+	model.setFilterProperty("shown");
+	model.setSource(&source);
+
+	source.insertObject(&d, 1);
+	QCOMPARE(model.valueList(), (QList<QObject*> {&a, &d, &c}));
+
+	b.setShown(true);
+	QCOMPARE(model.valueList(), (QList<QObject*> {&a, &d, &b, &c}));
+
+	source.moveObject(0, 3);
+	QCOMPARE(model.valueList(), (QList<QObject*> {&d, &b, &c, &a}));
+}
+
+QTEST_MAIN(TestSortFilterModel);
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <qobject.h>
+#include <qtmetamacros.h>
+#include <qtypes.h>
+
+class TestValue: public QObject {
+	Q_OBJECT;
+	Q_PROPERTY(qint32 rank MEMBER mRank NOTIFY rankChanged);
+	Q_PROPERTY(bool shown MEMBER mShown NOTIFY shownChanged);
+
+public:
+	explicit TestValue(qint32 rank, bool shown = true): mRank(rank), mShown(shown) {}
+
+	void setRank(qint32 rank) {
+		this->mRank = rank;
+		emit this->rankChanged();
+	}
+
+	void setShown(bool shown) {
+		this->mShown = shown;
+		emit this->shownChanged();
+	}
+
+signals:
+	void rankChanged();
+	void shownChanged();
+
+private:
+	qint32 mRank;
+	bool mShown;
+};
+
+class TestSortFilterModel: public QObject {
+	Q_OBJECT;
+
+private slots:
+	static void sortedInsert();
+	static void sortKeyChange();
+	static void filter();
+	static void sourceOrder();
+};
@@ -1,6 +1,7 @@
 #include "handler.hpp"
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include <cerrno>
 #include <csignal>
 #include <cstdio>
@@ -15,6 +16,7 @@
 #include <qlogging.h>
 #include <qloggingcategory.h>
 #include <sys/mman.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
 #include "../core/instanceinfo.hpp"
@@ -87,6 +89,28 @@ void signalHandler(
 	fail:;
 	}
 
+	if (auto* pending = CrashInfo::INSTANCE.pendingLog; pending && CrashInfo::INSTANCE.logFd != -1) {
+		// Recover messages waiting for the next group commit so the crash reporter can see them.
+		// Claiming them stops the logging thread from writing or reusing them concurrently.
+		auto state = pending->state.exchange(PendingWrites::CLAIMED, std::memory_order_acq_rel);
+
+		if (state > 0) {
+			auto slot = state & 1;
+
+			auto iov = std::array<iovec, 2>();
+			iov[0] = {
+			    .iov_base = pending->prefixes[slot].data(),
+			    .iov_len = pending->prefixSizes[slot],
+			};
+			iov[1] = {
+			    .iov_base = const_cast<char*>(pending->data), // NOLINT
+			    .iov_len = static_cast<size_t>(state >> 1),
+			};
+
+			writev(CrashInfo::INSTANCE.logFd, iov.data(), static_cast<int>(iov.size()));
+		}
+	}
+
 	// TODO: coredump fork and crash reporter remain as zombies, fix
 	auto coredumpPid = fork();
 	if (coredumpPid == 0) {
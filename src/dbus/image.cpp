@@ -0,0 +1,209 @@
+#include "image.hpp"
+
+#include <qbytearray.h>
+#include <qbytearrayview.h>
+#include <qcryptographichash.h>
+#include <qendian.h>
+#include <qhash.h>
+#include <qhashfunctions.h>
+#include <qimage.h>
+#include <qlogging.h>
+#include <qloggingcategory.h>
+#include <qnamespace.h>
+#include <qrgb.h>
+#include <qsize.h>
+#include <qtypes.h>
+
+#include "../core/logcat.hpp"
+
+namespace qs::dbus {
+
+namespace {
+QS_LOGGING_CATEGORY(logDbusImage, "quickshell.dbus.image", QtWarningMsg);
+
+// Images are rarely sent once, so dead entries are only swept once the table holds this many
+// bytes of images, or twice what was live after the last sweep.
+constexpr qsizetype MIN_PRUNE_BYTES = 4ll * 1024 * 1024;
+
+struct IngestKey {
+	// Strong enough that images with different data never share a key.
+	QByteArray digest;
+	DBusImageInfo info;
+	QSize maxSize;
+
+	[[nodiscard]] bool operator==(const IngestKey& other) const {
+		return this->digest == other.digest && this->info.width == other.info.width
+		    && this->info.height == other.info.height && this->info.stride == other.info.stride
+		    && this->info.layout == other.info.layout && this->maxSize == other.maxSize;
+	}
+};
+
+size_t qHash(const IngestKey& key, size_t seed = 0) {
+	return qHashMulti(
+	    seed,
+	    key.digest,
+	    key.info.width,
+	    key.info.height,
+	    key.info.stride,
+	    static_cast<quint8>(key.info.layout),
+	    key.maxSize.width(),
+	    key.maxSize.height()
+	);
+}
+
+class IngestedImages {
+public:
+	static IngestedImages& instance() {
+		static auto instance = IngestedImages();
+		return instance;
+	}
+
+	[[nodiscard]] QImage find(const IngestKey& key) const { return this->images.value(key); }
+
+	void insert(const IngestKey& key, const QImage& image) {
+		if (this->bytes + image.sizeInBytes() > this->pruneBytes) {
+			// An image only referenced by this table is no longer used by anything.
+			for (auto it = this->images.begin(); it != this->images.end();) {
+				if (it->isDetached()) {
+					this->bytes -= it->sizeInBytes();
+					it = this->images.erase(it);
+				} else {
+					++it;
+				}
+			}
+
+			this->pruneBytes = qMax(MIN_PRUNE_BYTES, this->bytes * 2);
+		}
+
+		this->images.insert(key, image);
+		this->bytes += image.sizeInBytes();
+	}
+
+private:
+	QHash<IngestKey, QImage> images;
+	// Size of every image in the table, live or not.
+	qsizetype bytes = 0;
+	qsizetype pruneBytes = MIN_PRUNE_BYTES;
+};
+
+// Checks the alpha of every pixel of an unpremultiplied ARGB32 or RGBA8888 image. Most icons
+// with an alpha channel have transparent corners, so this rarely reads more than a few pixels
+// of images that are not opaque.
+bool isOpaque(const QImage& image) {
+	auto rgba = image.format() == QImage::Format_RGBA8888;
+
+	for (auto y = 0; y != image.height(); y++) {
+		if (rgba) {
+			const auto* line = image.constScanLine(y);
+			for (auto x = 0; x != image.width(); x++) {
+				if (line[x * 4 + 3] != 0xff) return false; // NOLINT
+			}
+		} else {
+			const auto* line = reinterpret_cast<const QRgb*>(image.constScanLine(y));
+			for (auto x = 0; x != image.width(); x++) {
+				if (qAlpha(line[x]) != 0xff) return false; // NOLINT
+			}
+		}
+	}
+
+	return true;
+}
+
+QImage convertImage(const DBusImageInfo& info, qsizetype stride, const QByteArray& data) {
+	const auto* bits = reinterpret_cast<const uchar*>(data.constData()); // NOLINT
+
+	switch (info.layout) {
+	case DBusImageLayout::Argb32BigEndian: {
+		auto image = QImage(info.width, info.height, QImage::Format_ARGB32);
+		if (image.isNull()) return image;
+
+		// qFromBigEndian uses vectorized byte swaps for arrays, and copies on big endian machines.
+		for (auto y = 0; y != info.height; y++) {
+			qFromBigEndian<quint32>(bits + y * stride, info.width, image.scanLine(y)); // NOLINT
+		}
+
+		// Opaque ARGB32 pixels are already valid RGB32 pixels.
+		if (isOpaque(image)) image.reinterpretAsFormat(QImage::Format_RGB32);
+		else image.convertTo(QImage::Format_ARGB32_Premultiplied);
+		return image;
+	}
+	case DBusImageLayout::Rgb888:
+	case DBusImageLayout::Rgba8888: {
+		auto hasAlpha = info.layout == DBusImageLayout::Rgba8888;
+
+		// Wraps the dbus buffer without copying it. The conversion creates an image owning its data.
+		auto view = QImage(
+		    bits,
+		    info.width,
+		    info.height,
+		    stride,
+		    hasAlpha ? QImage::Format_RGBA8888 : QImage::Format_RGB888
+		);
+
+		return view.convertToFormat(
+		    hasAlpha && !isOpaque(view) ? QImage::Format_ARGB32_Premultiplied : QImage::Format_RGB32
+		);
+	}
+	}
+
+	return QImage();
+}
+
+} // namespace
+
+QImage ingestDBusImage(const DBusImageInfo& info, const QByteArray& data, const QSize& maxSize) {
+	if (info.width <= 0 || info.height <= 0) {
+		qCWarning(logDbusImage) << "Refusing image with invalid size" << info.width << "x"
+		                        << info.height;
+		return QImage();
+	}
+
+	auto pixelSize = info.layout == DBusImageLayout::Rgb888 ? 3 : 4;
+	auto rowSize = static_cast<qsizetype>(info.width) * pixelSize;
+	auto stride = info.stride == 0 ? rowSize : static_cast<qsizetype>(info.stride);
+
+	if (stride < rowSize) {
+		qCWarning(logDbusImage) << "Refusing image with rowstride" << stride
+		                        << "shorter than its rows of" << rowSize << "bytes";
+		return QImage();
+	}
+
+	// The last row is not required to be padded.
+	auto expectedSize = stride * (info.height - 1) + rowSize;
+
+	if (data.size() < expectedSize) {
+		qCWarning(logDbusImage) << "Refusing" << info.width << "x" << info.height
+		                        << "image with only" << data.size() << "bytes of data, expected"
+		                        << expectedSize;
+		return QImage();
+	}
+
+	auto key = IngestKey {
+	    .digest = QCryptographicHash::hash(
+	        QByteArrayView(data).first(expectedSize),
+	        QCryptographicHash::Blake2b_256
+	    ),
+	    .info = info,
+	    .maxSize = maxSize,
+	};
+
+	auto& images = IngestedImages::instance();
+
+	if (auto image = images.find(key); !image.isNull()) {
+		qCDebug(logDbusImage) << "Reusing ingested" << info.width << "x" << info.height << "image";
+		return image;
+	}
+
+	auto image = convertImage(info, stride, data);
+	if (image.isNull()) return image;
+
+	if (image.width() > maxSize.width() || image.height() > maxSize.height()) {
+		qCDebug(logDbusImage) << "Scaling down" << image.size() << "image to fit" << maxSize;
+		image = image.scaled(maxSize, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+	}
+
+	images.insert(key, image);
+	return image;
+}
+
+} // namespace qs::dbus
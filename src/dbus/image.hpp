@@ -0,0 +1,37 @@
+#pragma once
+
+#include <qbytearray.h>
+#include <qimage.h>
+#include <qsize.h>
+#include <qtypes.h>
+
+namespace qs::dbus {
+
+enum class DBusImageLayout : quint8 {
+	// 32 bit ARGB pixels in network byte order, as sent by StatusNotifierItems.
+	Argb32BigEndian,
+	// 8 bit RGB samples, as sent in notification image hints.
+	Rgb888,
+	// 8 bit RGBA samples, as sent in notification image hints.
+	Rgba8888,
+};
+
+struct DBusImageInfo {
+	qint32 width = 0;
+	qint32 height = 0;
+	// Length of a row in bytes, including any padding. 0 if rows are not padded.
+	qint32 stride = 0;
+	DBusImageLayout layout = DBusImageLayout::Argb32BigEndian;
+};
+
+// Converts raw image data received over dbus into an image that can be drawn or uploaded
+// without further conversion, in Format_ARGB32_Premultiplied, or Format_RGB32 if every pixel
+// is opaque, whether or not the layout has an alpha channel.
+//
+// Images larger than maxSize are scaled down to fit it. If an image with identical content is
+// still in use, it is shared instead of converted again.
+//
+// Returns a null image if the data does not match info. Main thread only.
+QImage ingestDBusImage(const DBusImageInfo& info, const QByteArray& data, const QSize& maxSize);
+
+} // namespace qs::dbus
@@ -1,5 +1,4 @@
 #include "properties.hpp"
-#include <algorithm>
 #include <utility>
 
 #include <qcontainerfwd.h>
@@ -12,10 +11,13 @@
 #include <qdbuspendingcall.h>
 #include <qdbuspendingreply.h>
 #include <qdebug.h>
+#include <qhash.h>
+#include <qlist.h>
 #include <qlogging.h>
 #include <qloggingcategory.h>
 #include <qmetatype.h>
 #include <qobject.h>
+#include <qtimer.h>
 #include <qtmetamacros.h>
 #include <qtversionchecks.h>
 #include <qvariant.h>
@@ -112,9 +114,91 @@ void asyncReadPropertyInternal(
 	QObject::connect(call, &QDBusPendingCallWatcher::finished, &interface, responseCallback);
 }
 
+namespace {
+
+// Number of stale properties at which a group refreshes them with one GetAll call.
+constexpr qsizetype GETALL_THRESHOLD = 3;
+
+// Maximum number of refresh calls in flight to a single service.
+constexpr qsizetype MAX_IN_FLIGHT_REFRESHES = 8;
+
+} // namespace
+
+// Limits refresh calls in flight to each service across all property groups, so a service
+// spamming change signals cannot build up an unbounded number of pending calls.
+class DBusRefreshLimiter {
+public:
+	// Takes a call slot for the service. If none are free, the group is flushed again once one is.
+	static bool acquire(const QString& service, DBusPropertyGroup* group) {
+		auto& state = DBusRefreshLimiter::services()[service];
+
+		if (state.inFlight < MAX_IN_FLIGHT_REFRESHES) {
+			state.inFlight++;
+			return true;
+		}
+
+		if (!state.waiting.contains(group)) {
+			qCDebug(logDbusProperties).noquote()
+			    << "Deferring property refreshes of" << group->toString()
+			    << "until a call to the service finishes";
+
+			state.waiting.append(group);
+		}
+
+		return false;
+	}
+
+	static void release(const QString& service) {
+		auto& services = DBusRefreshLimiter::services();
+		auto state = services.find(service);
+		if (state == services.end()) return;
+
+		state->inFlight--;
+
+		if (!state->waiting.isEmpty()) {
+			// Queued as this may run while the group that made the call is being destroyed.
+			QMetaObject::invokeMethod(
+			    state->waiting.takeFirst(),
+			    &DBusPropertyGroup::flushRefreshes,
+			    Qt::QueuedConnection
+			);
+		} else if (state->inFlight == 0) {
+			services.erase(state);
+		}
+	}
+
+	static void forget(DBusPropertyGroup* group) {
+		for (auto& state: DBusRefreshLimiter::services()) {
+			state.waiting.removeOne(group);
+		}
+	}
+
+private:
+	struct ServiceState {
+		qsizetype inFlight = 0;
+		QList<DBusPropertyGroup*> waiting;
+	};
+
+	static QHash<QString, ServiceState>& services() {
+		static auto services = QHash<QString, ServiceState>();
+		return services;
+	}
+};
+
 DBusPropertyGroup::DBusPropertyGroup(QVector<DBusPropertyCore*> properties, QObject* parent)
     : QObject(parent)
-    , properties(std::move(properties)) {}
+    , properties(std::move(properties)) {
+	for (auto* property: this->properties) {
+		this->indexProperty(property);
+	}
+
+	this->refreshTimer.setSingleShot(true);
+	this->refreshTimer.setInterval(0);
+
+	QObject::connect(&this->refreshTimer, &QTimer::timeout, this, &DBusPropertyGroup::flushRefreshes);
+}
+
+DBusPropertyGroup::~DBusPropertyGroup() { DBusRefreshLimiter::forget(this); }
 
 void DBusPropertyGroup::setInterface(QDBusAbstractInterface* interface) {
 	if (this->interface != nullptr) {
@@ -143,6 +227,12 @@ void DBusPropertyGroup::setInterface(QDBusAbstractInterface* interface) {
 
 void DBusPropertyGroup::attachProperty(DBusPropertyCore* property) {
 	this->properties.append(property);
+	this->indexProperty(property);
+}
+
+void DBusPropertyGroup::indexProperty(DBusPropertyCore* property) {
+	this->propertiesByName.insert(property->nameRef(), property);
+	if (property->isRequired()) this->requiredProperties++;
 }
 
 void DBusPropertyGroup::updateAllDirect() {
@@ -154,7 +244,7 @@ void DBusPropertyGroup::updateAllDirect() {
 	}
 
 	for (auto* property: this->properties) {
-		this->requestPropertyUpdate(property);
+		this->queueRefresh(property, true);
 	}
 }
 
@@ -191,20 +281,22 @@ void DBusPropertyGroup::updateAllViaGetAll() {
 }
 
 void DBusPropertyGroup::updatePropertySet(const QVariantMap& properties, bool complainMissing) {
+	qsizetype requiredSeen = 0;
+
 	for (const auto [name, value]: properties.asKeyValueRange()) {
-		auto prop = std::ranges::find_if(this->properties, [&name](DBusPropertyCore* prop) {
-			return prop->nameRef() == name;
-		});
+		auto* prop = this->propertiesByName.value(name);
 
-		if (prop == this->properties.end()) {
+		if (prop == nullptr) {
 			qCDebug(logDbusProperties) << "Ignoring untracked property update" << name << "for"
 			                           << this->toString();
 		} else {
-			this->tryUpdateProperty(*prop, value);
+			if (prop->isRequired()) requiredSeen++;
+			this->tryUpdateProperty(prop, value);
 		}
 	}
 
-	if (complainMissing) {
+	// Property names are only rebuilt as keys if something is actually missing.
+	if (complainMissing && requiredSeen != this->requiredProperties) {
 		for (const auto* prop: this->properties) {
 			if (prop->isRequired() && !properties.contains(prop->name())) {
 				qCWarning(logDbusProperties)
@@ -232,27 +324,79 @@ void DBusPropertyGroup::tryUpdateProperty(
 }
 
 void DBusPropertyGroup::requestPropertyUpdate(DBusPropertyCore* property) {
-	const QString propStr = this->propertyString(property);
-
+	// propertyString() is only called inside log statements so it is skipped when disabled.
 	if (this->interface == nullptr) {
 		qFatal(logDbusProperties).noquote()
-		    << "Tried to update property" << propStr << "of a disconnected interface";
+		    << "Tried to update property" << this->propertyString(property)
+		    << "of a disconnected interface";
+	}
+
+	this->queueRefresh(property, false);
+}
+
+void DBusPropertyGroup::queueRefresh(DBusPropertyCore* property, bool direct) {
+	if (property->mDirty) {
+		if (!direct || property->mDirect) return;
+		this->dirtyProperties.removeOne(property);
 	}
 
-	qCDebug(logDbusProperties).noquote() << "Updating property" << propStr;
+	property->mDirty = true;
+	property->mDirect = direct;
+	(direct ? this->directProperties : this->dirtyProperties).append(property);
+
+	// Not restarted by later requests, so a constant stream of them cannot starve the refresh.
+	if (!this->refreshTimer.isActive()) this->refreshTimer.start();
+}
+
+void DBusPropertyGroup::flushRefreshes() {
+	if (this->interface == nullptr) return;
+	const auto service = this->interface->service();
+
+	if (this->dirtyProperties.length() >= GETALL_THRESHOLD && !this->getAllBroken) {
+		if (!DBusRefreshLimiter::acquire(service, this)) return;
+
+		auto properties = std::exchange(this->dirtyProperties, {});
+		for (auto* property: properties) {
+			property->mDirty = false;
+		}
+
+		this->fetchViaGetAll(std::move(properties), service);
+	}
+
+	for (auto* list: {&this->directProperties, &this->dirtyProperties}) {
+		while (!list->isEmpty()) {
+			if (!DBusRefreshLimiter::acquire(service, this)) return;
+
+			auto* property = list->takeFirst();
+			property->mDirty = false;
+			property->mDirect = false;
+			this->fetchProperty(property, service);
+		}
+	}
+}
+
+void DBusPropertyGroup::fetchProperty(DBusPropertyCore* property, const QString& service) {
+	qCDebug(logDbusProperties).noquote() << "Updating property" << this->propertyString(property);
 
 	auto pendingCall = this->propertyInterface->Get(this->interface->interface(), property->name());
 	auto* call = new QDBusPendingCallWatcher(pendingCall, this);
 
-	auto responseCallback = [this, propStr, property](QDBusPendingCallWatcher* call) {
+	// Released on destruction, which also covers calls dropped with the group.
+	QObject::connect(call, &QObject::destroyed, [service]() {
+		DBusRefreshLimiter::release(service);
+	});
+
+	auto responseCallback = [this, property](QDBusPendingCallWatcher* call) {
 		const QDBusPendingReply<QDBusVariant> reply = *call;
 
 		if (reply.isError()) {
 			if (!property->isRequired() && reply.error().type() == QDBusError::InvalidArgs) {
-				qCDebug(logDbusProperties) << "Error updating non-required property" << propStr;
+				qCDebug(logDbusProperties).noquote()
+				    << "Error updating non-required property" << this->propertyString(property);
 				qCDebug(logDbusProperties) << reply.error();
 			} else {
-				qCWarning(logDbusProperties).noquote() << "Error updating property" << propStr;
+				qCWarning(logDbusProperties).noquote()
+				    << "Error updating property" << this->propertyString(property);
 				qCWarning(logDbusProperties) << reply.error();
 			}
 		} else {
@@ -265,15 +409,69 @@ void DBusPropertyGroup::requestPropertyUpdate(DBusPropertyCore* property) {
 	QObject::connect(call, &QDBusPendingCallWatcher::finished, this, responseCallback);
 }
 
-void DBusPropertyGroup::pushPropertyUpdate(DBusPropertyCore* property) {
-	const QString propStr = this->propertyString(property);
+void DBusPropertyGroup::fetchViaGetAll(
+    QVector<DBusPropertyCore*> properties,
+    const QString& service
+) {
+	qCDebug(logDbusProperties).noquote() << "Updating" << properties.length() << "properties of"
+	                                     << this->toString() << "via GetAll";
+
+	auto pendingCall = this->propertyInterface->GetAll(this->interface->interface());
+	auto* call = new QDBusPendingCallWatcher(pendingCall, this);
 
+	QObject::connect(call, &QObject::destroyed, [service]() {
+		DBusRefreshLimiter::release(service);
+	});
+
+	// Only the stale properties are applied, as storing the others may trigger update handlers.
+	// Properties the reply does not cover are queried individually, as some services implement
+	// GetAll incompletely or not at all.
+	auto responseCallback = [this, properties](QDBusPendingCallWatcher* call) {
+		const QDBusPendingReply<QVariantMap> reply = *call;
+
+		if (reply.isError()) {
+			qCWarning(logDbusProperties).noquote()
+			    << "Error updating properties of" << this->toString()
+			    << "via GetAll, falling back to individual queries";
+			qCWarning(logDbusProperties) << reply.error();
+
+			this->getAllBroken = true;
+
+			for (auto* property: properties) {
+				this->queueRefresh(property, true);
+			}
+		} else {
+			const auto values = reply.value();
+
+			for (auto* property: properties) {
+				auto value = values.find(property->name());
+
+				if (value != values.end()) {
+					this->tryUpdateProperty(property, *value);
+				} else {
+					qCDebug(logDbusProperties).noquote()
+					    << "Missing property" << this->propertyString(property)
+					    << "in GetAll reply, querying it individually";
+
+					this->queueRefresh(property, true);
+				}
+			}
+		}
+
+		delete call;
+	};
+
+	QObject::connect(call, &QDBusPendingCallWatcher::finished, this, responseCallback);
+}
+
+void DBusPropertyGroup::pushPropertyUpdate(DBusPropertyCore* property) {
 	if (this->interface == nullptr) {
 		qFatal(logDbusProperties).noquote()
-		    << "Tried to write property" << propStr << "of a disconnected interface";
+		    << "Tried to write property" << this->propertyString(property)
+		    << "of a disconnected interface";
 	}
 
-	qCDebug(logDbusProperties).noquote() << "Writing property" << propStr;
+	qCDebug(logDbusProperties).noquote() << "Writing property" << this->propertyString(property);
 
 	auto pendingCall = this->propertyInterface->Set(
 	    this->interface->interface(),
@@ -283,11 +481,12 @@ void DBusPropertyGroup::pushPropertyUpdate(DBusPropertyCore* property) {
 
 	auto* call = new QDBusPendingCallWatcher(pendingCall, this);
 
-	auto responseCallback = [propStr](QDBusPendingCallWatcher* call) {
+	auto responseCallback = [this, property](QDBusPendingCallWatcher* call) {
 		const QDBusPendingReply<> reply = *call;
 
 		if (reply.isError()) {
-			qCWarning(logDbusProperties).noquote() << "Error writing property" << propStr;
+			qCWarning(logDbusProperties).noquote()
+			    << "Error writing property" << this->propertyString(property);
 			qCWarning(logDbusProperties) << reply.error();
 		}
 		delete call;
@@ -319,15 +518,13 @@ void DBusPropertyGroup::onPropertiesChanged(
 	    << "Received property change set and invalidations for" << this->toString();
 
 	for (const auto& name: invalidatedProperties) {
-		auto prop = std::ranges::find_if(this->properties, [&name](DBusPropertyCore* prop) {
-			return prop->nameRef() == name;
-		});
+		auto* prop = this->propertiesByName.value(name);
 
-		if (prop == this->properties.end()) {
+		if (prop == nullptr) {
 			qCDebug(logDbusProperties) << "Ignoring untracked property invalidation" << name << "for"
 			                           << this;
 		} else {
-			this->requestPropertyUpdate(*prop);
+			this->requestPropertyUpdate(prop);
 		}
 	}
 
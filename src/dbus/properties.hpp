@@ -13,11 +13,13 @@
 #include <qdbusreply.h>
 #include <qdbusservicewatcher.h>
 #include <qdebug.h>
+#include <qhash.h>
 #include <qlogging.h>
 #include <qloggingcategory.h>
 #include <qobject.h>
 #include <qoverload.h>
 #include <qstringview.h>
+#include <qtimer.h>
 #include <qtclasshelpermacros.h>
 #include <qtmetamacros.h>
 #include <qtversionchecks.h>
@@ -102,6 +104,9 @@ protected:
 
 private:
 	bool mExists : 1 = false;
+	bool mDirty : 1 = false;
+	// Set on dirty properties that must be refreshed with Get, not as part of a GetAll.
+	bool mDirect : 1 = false;
 
 	friend class DBusPropertyGroup;
 };
@@ -225,22 +230,32 @@ private:
 	[[nodiscard]] constexpr Bindable* bindable() const { return &(this->owner()->*bindablePtr); }
 };
 
+class DBusRefreshLimiter;
+
 class DBusPropertyGroup: public QObject {
 	Q_OBJECT;
 
 public:
 	explicit DBusPropertyGroup(QVector<DBusPropertyCore*> properties = {}, QObject* parent = nullptr);
 	explicit DBusPropertyGroup(QObject* parent): DBusPropertyGroup({}, parent) {}
+	~DBusPropertyGroup() override;
+	Q_DISABLE_COPY_MOVE(DBusPropertyGroup);
 
 	void setInterface(QDBusAbstractInterface* interface);
 	void attachProperty(DBusPropertyCore* property);
+	// Refreshes every property with its own Get call, for services with a broken GetAll.
 	void updateAllDirect();
 	void updateAllViaGetAll();
 	void updatePropertySet(const QVariantMap& properties, bool complainMissing = true);
 	[[nodiscard]] QString toString() const;
 	[[nodiscard]] bool isConnected() const { return this->interface; }
 
+	// Sets how long refresh requests are collected before being sent, in milliseconds.
+	// Defaults to 0, which collects requests made in the same event loop iteration.
+	void setRefreshWindow(int window) { this->refreshTimer.setInterval(window); }
+
 	void pushPropertyUpdate(DBusPropertyCore* property);
+	// Marks the property as stale. Stale properties are refreshed together after the refresh window.
 	void requestPropertyUpdate(DBusPropertyCore* property);
 
 signals:
@@ -254,15 +269,30 @@ private slots:
 	    const QStringList& invalidatedProperties
 	);
 
+	void flushRefreshes();
+
 private:
+	void indexProperty(DBusPropertyCore* property);
+	void queueRefresh(DBusPropertyCore* property, bool direct);
+	void fetchProperty(DBusPropertyCore* property, const QString& service);
+	void fetchViaGetAll(QVector<DBusPropertyCore*> properties, const QString& service);
 	void tryUpdateProperty(DBusPropertyCore* property, const QVariant& variant) const;
 	[[nodiscard]] QString propertyString(const DBusPropertyCore* property) const;
 
 	DBusPropertiesInterface* propertyInterface = nullptr;
 	QDBusAbstractInterface* interface = nullptr;
 	QVector<DBusPropertyCore*> properties;
+	// Keyed by nameRef(), which points to static storage.
+	QHash<QStringView, DBusPropertyCore*> propertiesByName;
+	qsizetype requiredProperties = 0;
+	QVector<DBusPropertyCore*> dirtyProperties;
+	QVector<DBusPropertyCore*> directProperties;
+	QTimer refreshTimer;
+	// Set once a GetAll refresh fails, after which stale properties are always refreshed with Get.
+	bool getAllBroken = false;
 
 	friend class AbstractDBusProperty;
+	friend class DBusRefreshLimiter;
 };
 
 } // namespace qs::dbus
@@ -0,0 +1,171 @@
+#include "image.hpp"
+
+#include <qbytearray.h>
+#include <qcolor.h>
+#include <qimage.h>
+#include <qobject.h>
+#include <qregularexpression.h>
+#include <qsize.h>
+#include <qtest.h>
+#include <qtestcase.h>
+#include <qtypes.h>
+
+#include "../image.hpp"
+
+using namespace qs::dbus;
+
+namespace {
+
+const QSize MAX_SIZE = QSize(512, 512);
+
+// Rows of opaque red RGB pixels, each followed by padding bytes.
+QByteArray rgbRows(qint32 width, qint32 height, qint32 padding) {
+	auto data = QByteArray();
+
+	for (auto y = 0; y != height; y++) {
+		for (auto x = 0; x != width; x++) {
+			data.append('\xff').append('\0').append('\0');
+		}
+
+		if (y != height - 1) data.append(padding, '\x7f');
+	}
+
+	return data;
+}
+
+} // namespace
+
+void TestDBusImage::validation_data() { // NOLINT
+	QTest::addColumn<qint32>("width");
+	QTest::addColumn<qint32>("height");
+	QTest::addColumn<qint32>("stride");
+	QTest::addColumn<qsizetype>("dataSize");
+	QTest::addColumn<bool>("valid");
+
+	QTest::addRow("packed") << 4 << 4 << 12 << qsizetype(48) << true;
+	QTest::addRow("unpadded-last-row") << 4 << 4 << 16 << qsizetype(60) << true;
+	QTest::addRow("zero-width") << 0 << 4 << 0 << qsizetype(48) << false;
+	QTest::addRow("negative-height") << 4 << -4 << 12 << qsizetype(48) << false;
+	QTest::addRow("short-stride") << 4 << 4 << 8 << qsizetype(48) << false;
+	QTest::addRow("short-data") << 4 << 4 << 12 << qsizetype(47) << false;
+}
+
+void TestDBusImage::validation() {
+	QFETCH(qint32, width);
+	QFETCH(qint32, height);
+	QFETCH(qint32, stride);
+	QFETCH(qsizetype, dataSize);
+	QFETCH(bool, valid);
+
+	if (!valid) QTest::ignoreMessage(QtWarningMsg, QRegularExpression("^Refusing"));
+
+	auto info = DBusImageInfo {
+	    .width = width,
+	    .height = height,
+	    .stride = stride,
+	    .layout = DBusImageLayout::Rgb888,
+	};
+
+	auto image = ingestDBusImage(info, QByteArray(dataSize, '\0'), MAX_SIZE);
+	QCOMPARE(!image.isNull(), valid);
+}
+
+void TestDBusImage::rowstride() {
+	auto info = DBusImageInfo {
+	    .width = 3,
+	    .height = 3,
+	    .stride = 12,
+	    .layout = DBusImageLayout::Rgb888,
+	};
+
+	auto image = ingestDBusImage(info, rgbRows(3, 3, 3), MAX_SIZE);
+	QCOMPARE(image.format(), QImage::Format_RGB32);
+	QCOMPARE(image.size(), QSize(3, 3));
+
+	for (auto y = 0; y != 3; y++) {
+		for (auto x = 0; x != 3; x++) {
+			QCOMPARE(image.pixel(x, y), qRgb(255, 0, 0));
+		}
+	}
+}
+
+void TestDBusImage::argbByteOrder() {
+	// Half transparent blue, in network byte order.
+	auto data = QByteArray("\x80\x00\x00\xff", 4).repeated(4);
+
+	auto info = DBusImageInfo {
+	    .width = 2,
+	    .height = 2,
+	    .layout = DBusImageLayout::Argb32BigEndian,
+	};
+
+	auto image = ingestDBusImage(info, data, MAX_SIZE);
+	QCOMPARE(image.format(), QImage::Format_ARGB32_Premultiplied);
+	QCOMPARE(image.pixelColor(1, 1), QColor(0, 0, 255, 128));
+}
+
+void TestDBusImage::downscale() {
+	auto info = DBusImageInfo {
+	    .width = 1024,
+	    .height = 512,
+	    .layout = DBusImageLayout::Rgba8888,
+	};
+
+	auto image = ingestDBusImage(info, QByteArray(1024 * 512 * 4, '\xff'), MAX_SIZE);
+	QCOMPARE(image.size(), QSize(512, 256));
+	QCOMPARE(image.format(), QImage::Format_RGB32);
+}
+
+void TestDBusImage::opacity_data() { // NOLINT
+	QTest::addColumn<bool>("rgba");
+	QTest::addColumn<quint8>("alpha");
+
+	QTest::addRow("argb-opaque") << false << quint8(0xff);
+	QTest::addRow("argb-translucent") << false << quint8(0xfe);
+	QTest::addRow("rgba-opaque") << true << quint8(0xff);
+	QTest::addRow("rgba-translucent") << true << quint8(0xfe);
+}
+
+void TestDBusImage::opacity() {
+	QFETCH(bool, rgba);
+	QFETCH(quint8, alpha);
+
+	auto info = DBusImageInfo {
+	    .width = 4,
+	    .height = 4,
+	    .layout = rgba ? DBusImageLayout::Rgba8888 : DBusImageLayout::Argb32BigEndian,
+	};
+
+	auto pixel = [&](quint8 a) {
+		return rgba ? QByteArray("\x10\x20\x30").append(static_cast<char>(a))
+		            : QByteArray(1, static_cast<char>(a)).append("\x10\x20\x30");
+	};
+
+	// Only the last pixel varies, so every pixel must be checked to pick the format.
+	auto data = pixel(0xff).repeated(15) + pixel(alpha);
+
+	auto image = ingestDBusImage(info, data, MAX_SIZE);
+	auto format = alpha == 0xff ? QImage::Format_RGB32 : QImage::Format_ARGB32_Premultiplied;
+	QCOMPARE(image.format(), format);
+	QCOMPARE(image.pixelColor(0, 0), QColor(0x10, 0x20, 0x30));
+	QCOMPARE(image.pixelColor(3, 3).alpha(), static_cast<int>(alpha));
+}
+
+void TestDBusImage::deduplication() {
+	auto info = DBusImageInfo {
+	    .width = 16,
+	    .height = 16,
+	    .layout = DBusImageLayout::Rgba8888,
+	};
+
+	auto data = QByteArray(16 * 16 * 4, '\x40');
+	auto first = ingestDBusImage(info, data, MAX_SIZE);
+	auto second = ingestDBusImage(info, QByteArray(data.constData(), data.size()), MAX_SIZE);
+	QCOMPARE(first.constBits(), second.constBits());
+
+	data[0] = '\x41';
+	auto changed = ingestDBusImage(info, data, MAX_SIZE);
+	QVERIFY(changed.constBits() != first.constBits());
+}
+
+QTEST_MAIN(TestDBusImage);
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <qobject.h>
+#include <qtmetamacros.h>
+
+class TestDBusImage: public QObject {
+	Q_OBJECT;
+
+private slots:
+	void validation_data(); // NOLINT
+	void validation();
+	void rowstride();
+	void argbByteOrder();
+	void downscale();
+	void opacity_data(); // NOLINT
+	void opacity();
+	void deduplication();
+};
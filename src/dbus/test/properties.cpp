@@ -0,0 +1,401 @@
+#include "properties.hpp"
+#include <algorithm>
+#include <memory>
+#include <utility>
+
+#include <qbytearray.h>
+#include <qcontainerfwd.h>
+#include <qdbusabstractinterface.h>
+#include <qdbusconnection.h>
+#include <qdbuserror.h>
+#include <qdbusextratypes.h>
+#include <qdbusmessage.h>
+#include <qdbusserver.h>
+#include <qlogging.h>
+#include <qobject.h>
+#include <qregularexpression.h>
+#include <qstring.h>
+#include <qtclasshelpermacros.h>
+#include <qtest.h>
+#include <qtestcase.h>
+#include <qtypes.h>
+#include <qvariant.h>
+
+namespace {
+
+const QString INTERFACE = QStringLiteral("org.freedesktop.NetworkManager.AccessPoint");
+const QString PROPERTIES_INTERFACE = QStringLiteral("org.freedesktop.DBus.Properties");
+const QString SERVICE_ROOT = QStringLiteral("/org/quickshell/test");
+const QString AP_PATH = SERVICE_ROOT + "/ap1";
+const QString AP2_PATH = SERVICE_ROOT + "/ap2";
+
+void deliverChanges(AccessPoint& ap, const QVariantMap& changed) {
+	// onPropertiesChanged is a private slot, normally invoked by the properties interface.
+	QMetaObject::invokeMethod(
+	    &ap.properties,
+	    "onPropertiesChanged",
+	    Qt::DirectConnection,
+	    Q_ARG(QString, INTERFACE),
+	    Q_ARG(QVariantMap, changed),
+	    Q_ARG(QStringList, QStringList())
+	);
+}
+
+QVariantMap fullPropertySet() {
+	return {
+	    {"Ssid", QByteArray("quickshell")},
+	    {"HwAddress", QString("00:11:22:33:44:55")},
+	    {"Strength", QVariant::fromValue<quint8>(72)},
+	    {"Frequency", QVariant::fromValue<quint32>(5180)},
+	    {"MaxBitrate", QVariant::fromValue<quint32>(866700)},
+	    {"Flags", QVariant::fromValue<quint32>(1)},
+	    {"WpaFlags", QVariant::fromValue<quint32>(0)},
+	    {"RsnFlags", QVariant::fromValue<quint32>(392)},
+	    {"LastSeen", QVariant::fromValue<qint32>(1024)},
+	};
+}
+
+// A private peer to peer bus, so refreshes can be observed without a session bus.
+class PeerBus {
+public:
+	explicit PeerBus()
+	    : name(QString("qs-test-peer-%1").arg(PeerBus::nextId++))
+	    , service(fullPropertySet()) {
+		QObject::connect(
+		    &this->server,
+		    &QDBusServer::newConnection,
+		    &this->service,
+		    &FakeAccessPointService::attach
+		);
+
+		this->client = QDBusConnection::connectToPeer(this->server.address(), this->name);
+	}
+
+	~PeerBus() { QDBusConnection::disconnectFromPeer(this->name); }
+	Q_DISABLE_COPY_MOVE(PeerBus);
+
+	[[nodiscard]] bool waitConnected() {
+		return QTest::qWaitFor([this]() {
+			return this->client.isConnected() && this->service.isAttached();
+		});
+	}
+
+	QString name;
+	QDBusServer server;
+	FakeAccessPointService service;
+	QDBusConnection client {QString()};
+
+private:
+	static inline qsizetype nextId = 0;
+};
+
+void requestUpdates(AccessPoint& ap) {
+	ap.pStrength.requestUpdate();
+	ap.pFrequency.requestUpdate();
+	ap.pFlags.requestUpdate();
+}
+
+} // namespace
+
+DisconnectedInterface::DisconnectedInterface(QObject* parent)
+    : QDBusAbstractInterface(
+          "org.freedesktop.NetworkManager",
+          "/org/freedesktop/NetworkManager/AccessPoint/1",
+          INTERFACE.toUtf8().constData(),
+          QDBusConnection("qs-test-disconnected"),
+          parent
+      ) {}
+
+PeerInterface::PeerInterface(const QDBusConnection& connection, const QString& path)
+    : QDBusAbstractInterface(
+          QString(),
+          path,
+          INTERFACE.toUtf8().constData(),
+          connection,
+          nullptr
+      ) {}
+
+FakeAccessPointService::FakeAccessPointService(QVariantMap values): values(std::move(values)) {}
+
+QString FakeAccessPointService::introspect(const QString& /*path*/) const { return QString(); }
+
+bool FakeAccessPointService::handleMessage(
+    const QDBusMessage& message,
+    const QDBusConnection& connection
+) {
+	if (message.interface() != PROPERTIES_INTERFACE) return false;
+
+	auto property = message.member() == "Get" ? message.arguments().value(1).toString() : QString();
+	this->calls.append({.path = message.path(), .method = message.member(), .property = property});
+
+	if (this->holdReplies) {
+		message.setDelayedReply(true);
+		this->held.append(message);
+	} else {
+		connection.send(this->reply(message));
+	}
+
+	return true;
+}
+
+QDBusMessage FakeAccessPointService::reply(const QDBusMessage& message) const {
+	if (message.member() == "GetAll") {
+		if (this->failGetAll) {
+			return message.createErrorReply(QDBusError::Failed, "GetAll is not implemented");
+		}
+
+		auto values = this->values;
+		for (const auto& name: this->omitFromGetAll) {
+			values.remove(name);
+		}
+
+		return message.createReply(QVariant::fromValue(values));
+	}
+
+	auto value = this->values.find(message.arguments().value(1).toString());
+	if (value == this->values.end()) {
+		return message.createErrorReply(QDBusError::InvalidArgs, "No such property");
+	}
+
+	return message.createReply(QVariant::fromValue(QDBusVariant(*value)));
+}
+
+void FakeAccessPointService::releaseHeld(qsizetype count) {
+	for (auto i = 0; i != count && !this->held.isEmpty(); i++) {
+		this->connection.send(this->reply(this->held.takeFirst()));
+	}
+}
+
+qsizetype FakeAccessPointService::callCount(const QString& method) const {
+	return std::ranges::count_if(this->calls, [&](const Call& call) {
+		return call.method == method;
+	});
+}
+
+void FakeAccessPointService::attach(const QDBusConnection& connection) {
+	this->connection = connection;
+	this->connection.registerVirtualObject(SERVICE_ROOT, this, QDBusConnection::SubPath);
+}
+
+AccessPoint::AccessPoint(QDBusAbstractInterface* interface) {
+	this->properties.setInterface(interface);
+}
+
+void TestDBusProperties::propertiesChanged() { // NOLINT
+	auto interface = DisconnectedInterface();
+	auto ap = AccessPoint(&interface);
+
+	deliverChanges(ap, fullPropertySet());
+	QCOMPARE(ap.bSsid.value(), QByteArray("quickshell"));
+	QCOMPARE(ap.bStrength.value(), quint8(72));
+	QCOMPARE(ap.bLastSeen.value(), 1024);
+	QVERIFY(ap.pRsnFlags.exists());
+
+	deliverChanges(
+	    ap,
+	    {
+	        {"Strength", QVariant::fromValue<quint8>(40)},
+	        {"Bandwidth", QVariant::fromValue<quint32>(80)},
+	    }
+	);
+
+	QCOMPARE(ap.bStrength.value(), quint8(40));
+	QCOMPARE(ap.bFrequency.value(), quint32(5180));
+}
+
+void TestDBusProperties::missingRequired() { // NOLINT
+	auto interface = DisconnectedInterface();
+	auto ap = AccessPoint(&interface);
+
+	// LastSeen is optional, so only the required properties are reported.
+	auto set = fullPropertySet();
+	set.remove("LastSeen");
+	ap.properties.updatePropertySet(set, true);
+
+	set.remove("Strength");
+	QTest::ignoreMessage(QtWarningMsg, QRegularExpression("\"Strength\" missing from property set"));
+	ap.properties.updatePropertySet(set, true);
+}
+
+void TestDBusProperties::refreshCoalesced() { // NOLINT
+	auto bus = PeerBus();
+	QVERIFY(bus.waitConnected());
+
+	auto interface = PeerInterface(bus.client, AP_PATH);
+	auto ap = AccessPoint(&interface);
+
+	for (auto i = 0; i != 5; i++) {
+		ap.pStrength.requestUpdate();
+	}
+
+	ap.pFrequency.requestUpdate();
+
+	QTRY_COMPARE(ap.bFrequency.value(), quint32(5180));
+	QCOMPARE(ap.bStrength.value(), quint8(72));
+	QCOMPARE(bus.service.callCount("Get"), 2);
+	QCOMPARE(bus.service.callCount("GetAll"), 0);
+}
+
+void TestDBusProperties::refreshWindow() { // NOLINT
+	auto bus = PeerBus();
+	QVERIFY(bus.waitConnected());
+
+	auto interface = PeerInterface(bus.client, AP_PATH);
+	auto ap = AccessPoint(&interface);
+	ap.properties.setRefreshWindow(200);
+
+	ap.pStrength.requestUpdate();
+	QTest::qWait(50);
+	ap.pStrength.requestUpdate();
+	ap.pFrequency.requestUpdate();
+	QCOMPARE(bus.service.calls.length(), 0);
+
+	QTRY_COMPARE(ap.bFrequency.value(), quint32(5180));
+	QCOMPARE(bus.service.callCount("Get"), 2);
+}
+
+void TestDBusProperties::refreshViaGetAll() { // NOLINT
+	auto bus = PeerBus();
+	QVERIFY(bus.waitConnected());
+
+	auto interface = PeerInterface(bus.client, AP_PATH);
+	auto ap = AccessPoint(&interface);
+
+	requestUpdates(ap);
+
+	QTRY_COMPARE(ap.bFlags.value(), quint32(1));
+	QCOMPARE(ap.bStrength.value(), quint8(72));
+	QCOMPARE(ap.bFrequency.value(), quint32(5180));
+	QCOMPARE(bus.service.callCount("GetAll"), 1);
+	QCOMPARE(bus.service.callCount("Get"), 0);
+
+	// Only the stale properties are applied from the reply.
+	QVERIFY(!ap.pSsid.exists());
+	QCOMPARE(ap.bSsid.value(), QByteArray());
+}
+
+void TestDBusProperties::refreshGetAllFailed() { // NOLINT
+	auto bus = PeerBus();
+	QVERIFY(bus.waitConnected());
+	bus.service.failGetAll = true;
+
+	auto interface = PeerInterface(bus.client, AP_PATH);
+	auto ap = AccessPoint(&interface);
+
+	QTest::ignoreMessage(QtWarningMsg, QRegularExpression("falling back to individual queries"));
+	QTest::ignoreMessage(QtWarningMsg, QRegularExpression("GetAll is not implemented"));
+	requestUpdates(ap);
+
+	QTRY_COMPARE(ap.bFlags.value(), quint32(1));
+	QCOMPARE(ap.bStrength.value(), quint8(72));
+	QCOMPARE(ap.bFrequency.value(), quint32(5180));
+	QCOMPARE(bus.service.callCount("GetAll"), 1);
+	QCOMPARE(bus.service.callCount("Get"), 3);
+
+	// GetAll is not tried again once it has failed.
+	bus.service.values.insert("Flags", QVariant::fromValue<quint32>(3));
+	requestUpdates(ap);
+
+	QTRY_COMPARE(ap.bFlags.value(), quint32(3));
+	QCOMPARE(bus.service.callCount("GetAll"), 1);
+	QCOMPARE(bus.service.callCount("Get"), 6);
+}
+
+void TestDBusProperties::refreshGetAllPartial() { // NOLINT
+	auto bus = PeerBus();
+	QVERIFY(bus.waitConnected());
+	bus.service.omitFromGetAll = {"Flags"};
+
+	auto interface = PeerInterface(bus.client, AP_PATH);
+	auto ap = AccessPoint(&interface);
+
+	requestUpdates(ap);
+
+	QTRY_COMPARE(ap.bFlags.value(), quint32(1));
+	QCOMPARE(ap.bStrength.value(), quint8(72));
+	QCOMPARE(bus.service.callCount("GetAll"), 1);
+	QCOMPARE(bus.service.callCount("Get"), 1);
+	QCOMPARE(bus.service.calls.last().property, QString("Flags"));
+}
+
+void TestDBusProperties::refreshDirect() { // NOLINT
+	auto bus = PeerBus();
+	QVERIFY(bus.waitConnected());
+
+	auto interface = PeerInterface(bus.client, AP_PATH);
+	auto ap = AccessPoint(&interface);
+
+	ap.properties.updateAllDirect();
+
+	QTRY_VERIFY(ap.pLastSeen.exists());
+	QCOMPARE(ap.bSsid.value(), QByteArray("quickshell"));
+	QCOMPARE(bus.service.callCount("GetAll"), 0);
+	QCOMPARE(bus.service.callCount("Get"), 9);
+}
+
+void TestDBusProperties::refreshInFlightLimit() { // NOLINT
+	auto bus = PeerBus();
+	QVERIFY(bus.waitConnected());
+	bus.service.holdReplies = true;
+
+	auto firstInterface = PeerInterface(bus.client, AP_PATH);
+	auto secondInterface = PeerInterface(bus.client, AP2_PATH);
+	auto first = std::make_unique<AccessPoint>(&firstInterface);
+	auto second = AccessPoint(&secondInterface);
+
+	// Nine properties, one more than the limit.
+	first->properties.updateAllDirect();
+	QTRY_COMPARE(bus.service.held.length(), 8);
+
+	second.properties.updateAllDirect();
+	QTest::qWait(50);
+	QCOMPARE(bus.service.calls.length(), 8);
+
+	// A finished call lets the first waiting group through.
+	bus.service.releaseHeld(1);
+	QTRY_COMPARE(bus.service.calls.length(), 9);
+	QCOMPARE(bus.service.calls.last().path, AP_PATH);
+	QCOMPARE(bus.service.calls.last().property, QString("LastSeen"));
+	QTest::qWait(50);
+	QCOMPARE(bus.service.calls.length(), 9);
+
+	// Calls dropped with their group free their slots.
+	first.reset();
+	QTRY_COMPARE(bus.service.calls.length(), 17);
+
+	auto secondCalls = std::ranges::count_if(bus.service.calls, [](const auto& call) {
+		return call.path == AP2_PATH;
+	});
+
+	QCOMPARE(secondCalls, 8);
+}
+
+void TestDBusProperties::benchmarkPropertiesChanged_data() { // NOLINT
+	QTest::addColumn<QVariantMap>("changed");
+
+	QTest::addRow("single") << QVariantMap {{"Strength", QVariant::fromValue<quint8>(64)}};
+	QTest::addRow("full") << fullPropertySet();
+
+	auto untracked = fullPropertySet();
+	untracked.insert("Bandwidth", QVariant::fromValue<quint32>(80));
+	untracked.insert("Mode", QVariant::fromValue<quint32>(2));
+	QTest::addRow("untracked") << untracked;
+}
+
+void TestDBusProperties::benchmarkPropertiesChanged() { // NOLINT
+	QFETCH(QVariantMap, changed);
+
+	auto interface = DisconnectedInterface();
+	auto ap = AccessPoint(&interface);
+
+	// Real property change bursts arrive in the hundreds when scanning or during playback.
+	QBENCHMARK {
+		for (auto i = 0; i != 1000; i++) {
+			deliverChanges(ap, changed);
+		}
+	}
+
+	QVERIFY(ap.pStrength.exists());
+}
+
+QTEST_MAIN(TestDBusProperties);
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <qbytearray.h>
+#include <qcontainerfwd.h>
+#include <qdbusabstractinterface.h>
+#include <qdbusconnection.h>
+#include <qdbusmessage.h>
+#include <qdbusvirtualobject.h>
+#include <qlist.h>
+#include <qobject.h>
+#include <qproperty.h>
+#include <qstring.h>
+#include <qtmetamacros.h>
+#include <qtypes.h>
+#include <qvariant.h>
+
+#include "../properties.hpp"
+
+// Never connected to a bus, so property groups using it only see manually delivered changes.
+class DisconnectedInterface: public QDBusAbstractInterface {
+	Q_OBJECT;
+
+public:
+	explicit DisconnectedInterface(QObject* parent = nullptr);
+};
+
+// Talks to a FakeAccessPointService over a peer connection.
+class PeerInterface: public QDBusAbstractInterface {
+	Q_OBJECT;
+
+public:
+	explicit PeerInterface(const QDBusConnection& connection, const QString& path);
+};
+
+// Serves access point properties to a peer connection, recording the calls made to it.
+class FakeAccessPointService: public QDBusVirtualObject {
+	Q_OBJECT;
+
+public:
+	struct Call {
+		QString path;
+		QString method;
+		QString property;
+	};
+
+	explicit FakeAccessPointService(QVariantMap values);
+
+	[[nodiscard]] QString introspect(const QString& path) const override;
+	bool handleMessage(const QDBusMessage& message, const QDBusConnection& connection) override;
+
+	// Sends the replies of the oldest held calls.
+	void releaseHeld(qsizetype count);
+
+	[[nodiscard]] bool isAttached() const { return this->connection.isConnected(); }
+	[[nodiscard]] qsizetype callCount(const QString& method) const;
+
+	QVariantMap values;
+	// If set, replies are held until released with releaseHeld().
+	bool holdReplies = false;
+	bool failGetAll = false;
+	QStringList omitFromGetAll;
+
+	QList<Call> calls;
+	QList<QDBusMessage> held;
+
+public slots:
+	void attach(const QDBusConnection& connection);
+
+private:
+	[[nodiscard]] QDBusMessage reply(const QDBusMessage& message) const;
+
+	QDBusConnection connection {QString()};
+};
+
+// Mirrors the property set of a NetworkManager access point.
+class AccessPoint: public QObject {
+	Q_OBJECT;
+
+public:
+	explicit AccessPoint(QDBusAbstractInterface* interface);
+
+signals:
+	void changed();
+
+public:
+	// clang-format off
+	Q_OBJECT_BINDABLE_PROPERTY(AccessPoint, QByteArray, bSsid, &AccessPoint::changed);
+	Q_OBJECT_BINDABLE_PROPERTY(AccessPoint, QString, bHwAddress, &AccessPoint::changed);
+	Q_OBJECT_BINDABLE_PROPERTY(AccessPoint, quint8, bStrength, &AccessPoint::changed);
+	Q_OBJECT_BINDABLE_PROPERTY(AccessPoint, quint32, bFrequency, &AccessPoint::changed);
+	Q_OBJECT_BINDABLE_PROPERTY(AccessPoint, quint32, bMaxBitrate, &AccessPoint::changed);
+	Q_OBJECT_BINDABLE_PROPERTY(AccessPoint, quint32, bFlags, &AccessPoint::changed);
+	Q_OBJECT_BINDABLE_PROPERTY(AccessPoint, quint32, bWpaFlags, &AccessPoint::changed);
+	Q_OBJECT_BINDABLE_PROPERTY(AccessPoint, quint32, bRsnFlags, &AccessPoint::changed);
+	Q_OBJECT_BINDABLE_PROPERTY(AccessPoint, qint32, bLastSeen, &AccessPoint::changed);
+
+	QS_DBUS_BINDABLE_PROPERTY_GROUP(AccessPoint, properties);
+	QS_DBUS_PROPERTY_BINDING(AccessPoint, pSsid, bSsid, properties, "Ssid");
+	QS_DBUS_PROPERTY_BINDING(AccessPoint, pHwAddress, bHwAddress, properties, "HwAddress");
+	QS_DBUS_PROPERTY_BINDING(AccessPoint, pStrength, bStrength, properties, "Strength");
+	QS_DBUS_PROPERTY_BINDING(AccessPoint, pFrequency, bFrequency, properties, "Frequency");
+	QS_DBUS_PROPERTY_BINDING(AccessPoint, pMaxBitrate, bMaxBitrate, properties, "MaxBitrate");
+	QS_DBUS_PROPERTY_BINDING(AccessPoint, pFlags, bFlags, properties, "Flags");
+	QS_DBUS_PROPERTY_BINDING(AccessPoint, pWpaFlags, bWpaFlags, properties, "WpaFlags");
+	QS_DBUS_PROPERTY_BINDING(AccessPoint, pRsnFlags, bRsnFlags, properties, "RsnFlags");
+	QS_DBUS_PROPERTY_BINDING(AccessPoint, pLastSeen, bLastSeen, properties, "LastSeen", false);
+	// clang-format on
+};
+
+class TestDBusProperties: public QObject {
+	Q_OBJECT;
+
+private slots:
+	void propertiesChanged();
+	void missingRequired();
+	void refreshCoalesced();
+	void refreshWindow();
+	void refreshViaGetAll();
+	void refreshGetAllFailed();
+	void refreshGetAllPartial();
+	void refreshDirect();
+	void refreshInFlightLimit();
+
+	void benchmarkPropertiesChanged_data(); // NOLINT
+	void benchmarkPropertiesChanged();
+};
@@ -1,11 +1,30 @@
 #include "datastream.hpp"
 #include <algorithm>
+#include <cstring>
+#include <limits>
 #include <utility>
 
+#include <qbytearray.h>
+#include <qbytearrayview.h>
+#include <qendian.h>
+#include <qjsondocument.h>
+#include <qjsonparseerror.h>
+#include <qlist.h>
 #include <qlocalsocket.h>
+#include <qlogging.h>
+#include <qloggingcategory.h>
+#include <qnamespace.h>
 #include <qobject.h>
+#include <qobjectdefs.h>
 #include <qtmetamacros.h>
 #include <qtypes.h>
+#include <qvariant.h>
+
+#include "../core/logcat.hpp"
+
+namespace {
+QS_LOGGING_CATEGORY(logDataStream, "quickshell.io.datastream", QtWarningMsg);
+}
 
 DataStreamParser* DataStream::reader() const { return this->mReader; }
 
@@ -20,6 +39,7 @@ void DataStream::setReader(DataStreamParser* reader) {
 
 	if (reader != nullptr) {
 		QObject::connect(reader, &QObject::destroyed, this, &DataStream::onReaderDestroyed);
+		QObject::connect(reader, &DataStreamParser::readyForData, this, &DataStream::onBytesAvailable);
 	}
 
 	emit this->readerChanged();
@@ -35,19 +55,48 @@ void DataStream::onReaderDestroyed() {
 }
 
 void DataStream::onBytesAvailable() {
-	if (this->mReader == nullptr) return;
-	auto buf = this->ioDevice()->readAll();
+	if (this->mReader == nullptr || !this->mReader->acceptingData()) return;
+	auto* device = this->ioDevice();
+	auto buf = device == nullptr ? QByteArray() : device->readAll();
 	this->mReader->parseBytes(buf, this->buffer);
 }
 
+namespace {
+
+// Finds the first occurrence of marker in data at or after from, or returns -1.
+// Candidates are found with memchr before checking the rest of the marker.
+qsizetype findMarker(const QByteArray& data, qsizetype from, const QByteArray& marker) {
+	const auto* begin = data.constData();
+	const auto* markerData = marker.constData();
+	auto mlen = marker.length();
+	auto last = data.length() - mlen;
+
+	while (from <= last) {
+		const auto* hit = static_cast<const char*>(
+		    std::memchr(begin + from, markerData[0], last - from + 1) // NOLINT
+		);
+
+		if (hit == nullptr) return -1;
+
+		// NOLINTNEXTLINE
+		if (mlen == 1 || std::memcmp(hit + 1, markerData + 1, mlen - 1) == 0) return hit - begin;
+		from = hit - begin + 1;
+	}
+
+	return -1;
+}
+
+} // namespace
+
 void SplitParser::parseBytes(QByteArray& incoming, QByteArray& buffer) {
-	if (this->mSplitMarker.isEmpty()) {
+	if (this->marker.isEmpty()) {
 		if (!buffer.isEmpty()) {
-			emit this->read(QString(buffer));
+			this->emitChunk(buffer.constData(), buffer.length());
 			buffer.clear();
 		}
 
-		emit this->read(QString(incoming));
+		this->emitChunk(incoming.constData(), incoming.length());
+		this->flushBatch();
 		return;
 	}
 
@@ -57,49 +106,57 @@ void SplitParser::parseBytes(QByteArray& incoming, QByteArray& buffer) {
 		this->parseBytes(buffer, buffer);
 	}
 
-	auto marker = this->mSplitMarker.toUtf8();
-	auto mlen = marker.length();
+	auto mlen = this->marker.length();
 
-	auto blen = buffer.size();
-	auto ilen = incoming.size();
+	// The buffer never contains a whole marker after parsing, so only the end of it
+	// which may hold the start of a marker split across reads needs to be searched again.
+	// If there is nothing buffered the incoming data is parsed in place.
+	qsizetype searchStart = 0;
+	auto parseInPlace = &incoming != &buffer && buffer.isEmpty();
+	if (&incoming != &buffer && !parseInPlace) {
+		searchStart = std::max(static_cast<qsizetype>(0), buffer.length() - (mlen - 1));
+		buffer.append(incoming);
+	}
 
-	qsizetype start = &incoming == &buffer ? 0 : -blen;
-	for (auto readi = -std::min(blen, mlen - 1); readi <= ilen - mlen; readi++) {
-		for (auto marki = 0; marki < mlen; marki++) {
-			qint8 byte; // NOLINT
-			if (readi + marki < 0) byte = buffer[blen + readi + marki];
-			else byte = incoming[readi + marki];
+	const auto& data = parseInPlace ? incoming : buffer;
 
-			if (byte != marker[marki]) goto fail;
-		}
+	qsizetype start = 0;
+	for (auto i = findMarker(data, searchStart, this->marker); i != -1;
+	     i = findMarker(data, start, this->marker))
+	{
+		this->emitChunk(data.constData() + start, i - start); // NOLINT
+		start = i + mlen;
+	}
 
-		{
-			QByteArray slice;
-			if (start < 0) slice = buffer.sliced(0, std::min(blen, blen + readi));
-			if (readi > 0) {
-				auto sstart = std::max(static_cast<qsizetype>(0), start);
-				slice.append(incoming.sliced(sstart, readi - sstart));
-			}
-			readi += mlen;
-			start = readi;
-			emit this->read(QString(slice));
-		}
+	if (parseInPlace) {
+		buffer = incoming.sliced(start);
+	} else {
+		buffer.remove(0, start);
+	}
 
-	fail:;
+	this->flushBatch();
+}
+
+void SplitParser::streamEnded(QByteArray& buffer) {
+	if (!buffer.isEmpty()) {
+		this->emitChunk(buffer.constData(), buffer.length());
+		this->flushBatch();
 	}
+}
 
-	if (start < 0) {
-		buffer.append(incoming);
+void SplitParser::emitChunk(const char* data, qsizetype length) {
+	auto chunk = QString::fromUtf8(data, length);
+
+	if (this->mBatched) {
+		this->batch.push_back(std::move(chunk));
 	} else {
-		// Will break the init case if inlined. Must be before clear.
-		auto slice = incoming.sliced(start);
-		buffer.clear();
-		buffer.insert(0, slice);
+		emit this->read(std::move(chunk));
 	}
 }
 
-void SplitParser::streamEnded(QByteArray& buffer) {
-	if (!buffer.isEmpty()) emit this->read(QString(buffer));
+void SplitParser::flushBatch() {
+	if (this->batch.isEmpty()) return;
+	emit this->readBatch(std::exchange(this->batch, {}));
 }
 
 QString SplitParser::splitMarker() const { return this->mSplitMarker; }
@@ -108,10 +165,19 @@ void SplitParser::setSplitMarker(QString marker) {
 	if (marker == this->mSplitMarker) return;
 
 	this->mSplitMarker = std::move(marker);
+	this->marker = this->mSplitMarker.toUtf8();
 	this->mSplitMarkerChanged = true;
 	emit this->splitMarkerChanged();
 }
 
+bool SplitParser::batched() const { return this->mBatched; }
+
+void SplitParser::setBatched(bool batched) {
+	if (batched == this->mBatched) return;
+	this->mBatched = batched;
+	emit this->batchedChanged();
+}
+
 void StdioCollector::parseBytes(QByteArray& incoming, QByteArray& buffer) {
 	buffer.append(incoming);
 
@@ -135,3 +201,185 @@ void StdioCollector::setWaitForEnd(bool waitForEnd) {
 	this->mWaitForEnd = waitForEnd;
 	emit this->waitForEndChanged();
 }
+
+void RecordParser::parseBytes(QByteArray& incoming, QByteArray& buffer) {
+	if (&incoming != &buffer) buffer.append(incoming);
+	this->parseRecords(buffer, false);
+}
+
+void RecordParser::streamEnded(QByteArray& buffer) {
+	if (this->mPaused) {
+		this->endedBuffer.append(buffer);
+		return;
+	}
+
+	this->parseRecords(buffer, true);
+
+	// paused by a handler before the end of the stream was reached
+	if (!buffer.isEmpty()) this->endedBuffer.append(buffer);
+}
+
+void RecordParser::parseRecords(QByteArray& buffer, bool end) {
+	auto batch = QVariantList();
+	qsizetype start = 0;
+	this->parsing = true;
+
+	// handlers may pause the parser, which must stop it before the next record
+	while (!this->mPaused && start < buffer.length()) {
+		auto record = QVariant();
+		auto consumed = this->parseRecord(QByteArrayView(buffer).sliced(start), end, record);
+		if (consumed == 0) break;
+		start += consumed;
+
+		if (!record.isValid()) continue;
+
+		if (this->mBatched) {
+			batch.push_back(std::move(record));
+		} else {
+			emit this->parsed(std::move(record));
+		}
+	}
+
+	buffer.remove(0, start);
+	if (!batch.isEmpty()) emit this->parsedBatch(batch);
+	this->parsing = false;
+}
+
+void RecordParser::setBatched(bool batched) {
+	if (batched == this->mBatched) return;
+	this->mBatched = batched;
+	emit this->batchedChanged();
+}
+
+void RecordParser::setPaused(bool paused) {
+	if (paused == this->mPaused) return;
+	this->mPaused = paused;
+	emit this->pausedChanged();
+	if (paused) return;
+
+	if (this->parsing) {
+		// Resuming now would parse the buffer again before the records already emitted from it
+		// are removed, emitting them twice.
+		QMetaObject::invokeMethod(this, &RecordParser::resume, Qt::QueuedConnection);
+	} else {
+		this->resume();
+	}
+}
+
+void RecordParser::resume() {
+	if (this->mPaused) return;
+
+	if (!this->endedBuffer.isEmpty()) {
+		auto buffer = std::exchange(this->endedBuffer, {});
+		this->streamEnded(buffer);
+	}
+
+	emit this->readyForData();
+}
+
+qsizetype JsonLinesParser::parseRecord(QByteArrayView data, bool end, QVariant& record) {
+	auto length = data.indexOf('\n');
+	auto consumed = length + 1;
+
+	if (length == -1) {
+		if (!end) return 0;
+		length = data.length();
+		consumed = length;
+	}
+
+	auto line = data.first(length).trimmed();
+	if (line.isEmpty()) return consumed;
+
+	auto error = QJsonParseError();
+	auto json = QJsonDocument::fromJson(QByteArray::fromRawData(line.data(), line.length()), &error);
+
+	if (error.error != QJsonParseError::NoError) {
+		qCWarning(logDataStream) << "Skipping invalid JSON line in" << this << ":"
+		                         << error.errorString();
+	} else {
+		record = json.toVariant();
+	}
+
+	return consumed;
+}
+
+void LengthPrefixParser::setPrefixSize(int prefixSize) {
+	if (prefixSize == this->mPrefixSize) return;
+
+	if (prefixSize != 1 && prefixSize != 2 && prefixSize != 4 && prefixSize != 8) {
+		qCWarning(logDataStream) << "Invalid prefix size" << prefixSize << "for" << this
+		                         << "- must be 1, 2, 4 or 8.";
+		return;
+	}
+
+	this->mPrefixSize = prefixSize;
+	emit this->prefixSizeChanged();
+}
+
+void LengthPrefixParser::setLittleEndian(bool littleEndian) {
+	if (littleEndian == this->mLittleEndian) return;
+	this->mLittleEndian = littleEndian;
+	emit this->littleEndianChanged();
+}
+
+void LengthPrefixParser::setMaxFrameSize(qint64 maxFrameSize) {
+	maxFrameSize = std::max(static_cast<qint64>(0), maxFrameSize);
+	if (maxFrameSize == this->mMaxFrameSize) return;
+	this->mMaxFrameSize = maxFrameSize;
+	emit this->maxFrameSizeChanged();
+}
+
+qsizetype LengthPrefixParser::parseRecord(QByteArrayView data, bool end, QVariant& record) {
+	if (this->skipRemaining != 0) {
+		auto skipped = std::min(static_cast<qint64>(data.length()), this->skipRemaining);
+		this->skipRemaining -= skipped;
+		return skipped;
+	}
+
+	if (data.length() < this->mPrefixSize) {
+		if (!end) return 0;
+		qCWarning(logDataStream) << "Stream ended with an incomplete frame prefix in" << this;
+		return data.length();
+	}
+
+	const auto* prefix = data.data();
+	auto length = quint64();
+
+	switch (this->mPrefixSize) {
+	case 1: length = static_cast<quint8>(*prefix); break;
+	case 2:
+		length = this->mLittleEndian ? qFromLittleEndian<quint16>(prefix)
+		                             : qFromBigEndian<quint16>(prefix);
+		break;
+	case 4:
+		length = this->mLittleEndian ? qFromLittleEndian<quint32>(prefix)
+		                             : qFromBigEndian<quint32>(prefix);
+		break;
+	default:
+		length = this->mLittleEndian ? qFromLittleEndian<quint64>(prefix)
+		                             : qFromBigEndian<quint64>(prefix);
+		break;
+	}
+
+	if (length > static_cast<quint64>(this->mMaxFrameSize)) {
+		qCWarning(logDataStream) << "Skipping frame of" << length << "bytes in" << this
+		                         << "which is larger than maxFrameSize.";
+		// clamped so an absurd prefix can't overflow, which would skip the rest of the stream anyway
+		this->skipRemaining = static_cast<qint64>(
+		    std::min(length, static_cast<quint64>(std::numeric_limits<qint64>::max()))
+		);
+		return this->mPrefixSize;
+	}
+
+	auto frameLength = static_cast<qsizetype>(length);
+	auto frameEnd = this->mPrefixSize + frameLength;
+
+	if (data.length() < frameEnd) {
+		if (!end) return 0;
+		qCWarning(logDataStream) << "Stream ended with an incomplete frame in" << this;
+		return data.length();
+	}
+
+	record = QVariant::fromValue(data.sliced(this->mPrefixSize, frameLength).toByteArray());
+	return frameEnd;
+}
@@ -1,13 +1,17 @@
 #pragma once
 
 #include <qbytearray.h>
+#include <qbytearrayview.h>
 #include <qcontainerfwd.h>
+#include <qlist.h>
 #include <qlocalsocket.h>
 #include <qobject.h>
 #include <qqmlintegration.h>
 #include <qtmetamacros.h>
 #include <qvariant.h>
 
+#include "../core/doc.hpp"
+
 class DataStreamParser;
 
 ///! Data source that can be streamed into a parser.
@@ -57,9 +61,13 @@ public:
 	virtual void parseBytes(QByteArray& incoming, QByteArray& buffer) = 0;
 	virtual void streamEnded(QByteArray& /*buffer*/) {}
 
+	// If false, sources should leave data unread until readyForData is emitted.
+	[[nodiscard]] virtual bool acceptingData() const { return true; }
+
 signals:
 	/// Emitted when data is read from the stream.
 	void read(QString data);
+	QSDOC_HIDE void readyForData();
 };
 
 ///! DataStreamParser for delimited data streams.
@@ -71,6 +79,12 @@ class SplitParser: public DataStreamParser {
 	/// If the delimiter is empty read lengths may be arbitrary (whatever is returned by the
 	/// underlying read call.)
 	Q_PROPERTY(QString splitMarker READ splitMarker WRITE setSplitMarker NOTIFY splitMarkerChanged);
+	/// If true, chunks are emitted together through @@readBatch(s) once for each read from the
+	/// stream, instead of through @@DataStreamParser.read(s). Defaults to false.
+	///
+	/// Handling a batch is much cheaper than handling each chunk separately for streams which
+	/// produce a large number of small chunks.
+	Q_PROPERTY(bool batched READ batched WRITE setBatched NOTIFY batchedChanged);
 	QML_ELEMENT;
 
 public:
@@ -82,12 +96,25 @@ public:
 	[[nodiscard]] QString splitMarker() const;
 	void setSplitMarker(QString marker);
 
+	[[nodiscard]] bool batched() const;
+	void setBatched(bool batched);
+
 signals:
+	/// Emitted with all chunks parsed from a single read when @@batched is true.
+	void readBatch(QList<QString> data);
 	void splitMarkerChanged();
+	void batchedChanged();
 
 private:
+	void emitChunk(const char* data, qsizetype length);
+	void flushBatch();
+
 	QString mSplitMarker = "\n";
+	// mSplitMarker as utf8, as matched against the stream.
+	QByteArray marker = "\n";
 	bool mSplitMarkerChanged = false;
+	bool mBatched = false;
+	QList<QString> batch;
 };
 
 ///! DataStreamParser that collects all output into a buffer
@@ -127,3 +154,124 @@ private:
 	bool mWaitForEnd = true;
 	QByteArray mData;
 };
+
+///! Base class for parsers which read discrete records from a stream.
+/// See also: @@JsonLinesParser, @@LengthPrefixParser.
+class RecordParser: public DataStreamParser {
+	Q_OBJECT;
+	/// If true, records are emitted together through @@parsedBatch(s) once for each read from the
+	/// stream, instead of through @@parsed(s). Defaults to false.
+	Q_PROPERTY(bool batched READ batched WRITE setBatched NOTIFY batchedChanged);
+	/// If true, no more records will be parsed until this is set back to false. Defaults to false.
+	///
+	/// The writer is not blocked while paused. Data it keeps writing is buffered in memory
+	/// until parsing resumes, so memory use grows for as long as the parser stays paused.
+	///
+	/// This can be bound to the length of a queue of unhandled records to keep a fast
+	/// producer from outpacing the consumer. Pausing from a @@parsed(s) handler takes
+	/// effect immediately, while unpausing from a @@parsed(s) or @@parsedBatch(s) handler
+	/// resumes reading once control returns to the event loop.
+	Q_PROPERTY(bool paused READ paused WRITE setPaused NOTIFY pausedChanged);
+	QML_ELEMENT;
+	QML_UNCREATABLE("base class");
+
+public:
+	explicit RecordParser(QObject* parent = nullptr): DataStreamParser(parent) {}
+
+	void parseBytes(QByteArray& incoming, QByteArray& buffer) final;
+	void streamEnded(QByteArray& buffer) final;
+	[[nodiscard]] bool acceptingData() const final { return !this->mPaused; }
+
+	[[nodiscard]] bool batched() const { return this->mBatched; }
+	void setBatched(bool batched);
+
+	[[nodiscard]] bool paused() const { return this->mPaused; }
+	void setPaused(bool paused);
+
+signals:
+	/// Emitted for each record parsed from the stream.
+	void parsed(QVariant value);
+	/// Emitted with all records parsed from a single read when @@batched is true.
+	void parsedBatch(QVariantList values);
+	void batchedChanged();
+	void pausedChanged();
+
+protected:
+	// Parses one record from the start of data, returning the number of bytes consumed or 0 if
+	// a complete record is not available. Consumed bytes may leave record invalid to skip them.
+	// If end is set no more data will follow, and any remaining data should be consumed.
+	virtual qsizetype parseRecord(QByteArrayView data, bool end, QVariant& record) = 0;
+
+private:
+	void parseRecords(QByteArray& buffer, bool end);
+	void resume();
+
+	bool mBatched = false;
+	bool mPaused = false;
+	// Set while records are being emitted, which may be before they are removed from the buffer.
+	bool parsing = false;
+	// Data left over from a stream which ended while paused.
+	QByteArray endedBuffer;
+};
+
+///! RecordParser for newline delimited JSON.
+/// Parses each line of a stream as a JSON object or array, emitting the result
+/// through @@RecordParser.parsed(s) without going through a string.
+///
+/// Empty lines are skipped, and lines which are not a valid JSON object or array
+/// are skipped with a warning.
+class JsonLinesParser: public RecordParser {
+	Q_OBJECT;
+	QML_ELEMENT;
+
+public:
+	explicit JsonLinesParser(QObject* parent = nullptr): RecordParser(parent) {}
+
+protected:
+	qsizetype parseRecord(QByteArrayView data, bool end, QVariant& record) override;
+};
+
+///! RecordParser for length prefixed binary frames.
+/// Splits a stream into frames, each starting with its length as an unsigned integer,
+/// and emits each frame without its prefix as an [ArrayBuffer] through @@RecordParser.parsed(s).
+///
+/// [ArrayBuffer]: https://developer.mozilla.org/en-US/docs/Web/JavaScript/Reference/Global_Objects/ArrayBuffer
+class LengthPrefixParser: public RecordParser {
+	Q_OBJECT;
+	// clang-format off
+	/// The size of the length prefix in bytes. Must be 1, 2, 4 or 8. Defaults to 4.
+	Q_PROPERTY(int prefixSize READ prefixSize WRITE setPrefixSize NOTIFY prefixSizeChanged);
+	/// If true, the length prefix is read as little endian instead of big endian. Defaults to false.
+	Q_PROPERTY(bool littleEndian READ littleEndian WRITE setLittleEndian NOTIFY littleEndianChanged);
+	/// Frames longer than this many bytes are skipped with a warning. Defaults to 16MiB.
+	Q_PROPERTY(qint64 maxFrameSize READ maxFrameSize WRITE setMaxFrameSize NOTIFY maxFrameSizeChanged);
+	// clang-format on
+	QML_ELEMENT;
+
+public:
+	explicit LengthPrefixParser(QObject* parent = nullptr): RecordParser(parent) {}
+
+	[[nodiscard]] int prefixSize() const { return this->mPrefixSize; }
+	void setPrefixSize(int prefixSize);
+
+	[[nodiscard]] bool littleEndian() const { return this->mLittleEndian; }
+	void setLittleEndian(bool littleEndian);
+
+	[[nodiscard]] qint64 maxFrameSize() const { return this->mMaxFrameSize; }
+	void setMaxFrameSize(qint64 maxFrameSize);
+
+signals:
+	void prefixSizeChanged();
+	void littleEndianChanged();
+	void maxFrameSizeChanged();
+
+protected:
+	qsizetype parseRecord(QByteArrayView data, bool end, QVariant& record) override;
+
+private:
+	int mPrefixSize = 4;
+	bool mLittleEndian = false;
+	qint64 mMaxFrameSize = 16 * 1024 * 1024;
+	// Bytes left to discard from an oversized frame.
+	qint64 skipRemaining = 0;
+};
@@ -1,8 +1,10 @@
 #include "fileview.hpp"
+#include <algorithm>
 #include <array>
 #include <utility>
 
 #include <qatomic.h>
+#include <qbytearray.h>
 #include <qdir.h>
 #include <qfiledevice.h>
 #include <qfileinfo.h>
@@ -16,9 +18,11 @@
 #include <qqmlinfo.h>
 #include <qsavefile.h>
 #include <qscopedpointer.h>
+#include <qsharedpointer.h>
 #include <qthreadpool.h>
 #include <qtmetamacros.h>
 #include <qtypes.h>
+#include <sys/stat.h>
 
 #include "../core/logcat.hpp"
 #include "../core/util.hpp"
@@ -27,8 +31,38 @@ namespace qs::io {
 
 namespace {
 QS_LOGGING_CATEGORY(logFileView, "quickshell.io.fileview", QtWarningMsg);
+
+// Below this, page table setup and the fault on first access cost more than copying.
+constexpr qint64 MEMORY_MAP_THRESHOLD = 64 * 1024;
+
+qint64 modificationTime(const struct stat& info) {
+	return static_cast<qint64>(info.st_mtim.tv_sec) * 1000000000 + info.st_mtim.tv_nsec;
 }
 
+void recordIdentity(FileViewState& state, int fd) {
+	struct stat info {};
+	if (::fstat(fd, &info) != 0) return;
+
+	state.device = info.st_dev;
+	state.inode = info.st_ino;
+}
+
+// Length of bytes excluding a trailing partial UTF-8 sequence.
+qsizetype completeUtf8Length(const QByteArray& bytes) {
+	for (qsizetype i = 1; i <= std::min<qsizetype>(4, bytes.size()); i++) {
+		auto c = static_cast<quint8>(bytes.at(bytes.size() - i));
+		if ((c & 0xc0) == 0x80) continue; // continuation byte
+		if (c < 0xc0) break;              // ascii
+
+		auto sequenceLength = c >= 0xf0 ? 4 : c >= 0xe0 ? 3 : 2;
+		if (sequenceLength > i) return bytes.size() - i;
+		break;
+	}
+
+	return bytes.size();
+}
+} // namespace
+
 QString FileViewError::toString(FileViewError::Enum value) {
 	switch (value) {
 	case Success: return "Success";
@@ -41,6 +75,11 @@ QString FileViewError::toString(FileViewError::Enum value) {
 }
 
 bool FileViewData::operator==(const FileViewData& other) const {
+	if (this->mapping || other.mapping) {
+		// The mapped bytes follow in place writes to the file, so they can't show a change.
+		return this->mapping && other.mapping && this->mapping->isSameVersion(*other.mapping);
+	}
+
 	if (this->data == other.data && !this->data.isEmpty()) return true;
 	if (this->text == other.text && !this->text.isEmpty()) return true;
 	return this->operator const QByteArray&() == other.operator const QByteArray&();
@@ -64,6 +103,56 @@ FileViewData::operator const QByteArray&() const {
 	return this->data;
 }
 
+void FileViewData::unmap() {
+	if (!this->mapping) return;
+
+	if (this->mapping->isIntact()) {
+		this->data = QByteArray(this->data.constData(), this->data.size());
+	} else {
+		this->data = QByteArray();
+	}
+
+	this->mapping.reset();
+}
+
+void FileViewData::append(const QByteArray& bytes, const QString& text) {
+	if (!this->data.isEmpty() || this->text.isEmpty()) this->data.append(bytes);
+	if (!this->text.isEmpty()) this->text.append(text);
+	// Appending detached the bytes from the mapping.
+	this->mapping.reset();
+}
+
+bool FileViewMapping::map() {
+	if (!this->file.open(QFile::ReadOnly)) return false;
+
+	auto size = this->file.size();
+	if (size == 0) return false;
+
+	struct stat info {};
+	if (::fstat(this->file.handle(), &info) != 0) return false;
+
+	auto* data = this->file.map(0, size);
+	if (!data) return false;
+
+	this->device = info.st_dev;
+	this->inode = info.st_ino;
+	this->size = info.st_size;
+	this->mtime = modificationTime(info);
+	this->mBytes = QByteArray::fromRawData(reinterpret_cast<const char*>(data), size);
+	return true;
+}
+
+bool FileViewMapping::isIntact() const {
+	struct stat info {};
+	if (::fstat(this->file.handle(), &info) != 0) return false;
+	return info.st_size == this->size && modificationTime(info) == this->mtime;
+}
+
+bool FileViewMapping::isSameVersion(const FileViewMapping& other) const {
+	return this->device == other.device && this->inode == other.inode && this->size == other.size
+	    && this->mtime == other.mtime;
+}
+
 FileViewOperation::FileViewOperation(FileView* owner): owner(owner) {
 	this->setAutoDelete(false);
 	this->blockMutex.lock();
@@ -139,6 +228,25 @@ void FileViewReader::read(
 
 	if (shouldCancel.loadAcquire()) return;
 
+	if (state.memoryMap && info.size() >= MEMORY_MAP_THRESHOLD) {
+		auto mapping = QSharedPointer<FileViewMapping>::create(state.path);
+
+		if (mapping->map()) {
+			qCDebug(logFileView) << "Mapped" << info.size() << "bytes of" << state.path;
+			recordIdentity(state, mapping->handle());
+			state.offset = info.size();
+			state.data = FileViewData(std::move(mapping));
+
+			if (doStringConversion && !shouldCancel.loadAcquire()) {
+				state.data.operator const QString&();
+			}
+
+			return;
+		}
+
+		qCDebug(logFileView) << "Could not map" << state.path << "falling back to reading it";
+	}
+
 	auto file = QFile(state.path);
 
 	if (!file.open(QFile::ReadOnly)) {
@@ -149,6 +257,8 @@ void FileViewReader::read(
 
 	if (shouldCancel.loadAcquire()) return;
 
+	recordIdentity(state, file.handle());
+
 	if (file.size() != 0) {
 		auto data = QByteArray(file.size(), Qt::Uninitialized);
 		qint64 i = 0;
@@ -171,6 +281,7 @@ void FileViewReader::read(
 			i += r;
 		}
 
+		state.offset = data.size();
 		state.data = data;
 	} else { // Mostly happens in /proc and friends, which have zero sized files with content.
 		QByteArray data;
@@ -192,6 +303,7 @@ void FileViewReader::read(
 			}
 		}
 
+		state.offset = data.size();
 		state.data = data;
 	}
 
@@ -284,6 +396,10 @@ void FileViewWriter::write(
 
 	if (shouldCancel.loadAcquire()) return;
 
+	// An atomic write's temporary file is renamed over the target, keeping its identity.
+	recordIdentity(state, file->handle());
+	state.offset = data.length();
+
 	if (doAtomicWrite) {
 		if (!reinterpret_cast<QSaveFile*>(file.get())->commit()) {
 			qmlWarning(view) << "Write of " << state.path << " failed: Atomic commit failed.";
@@ -291,6 +407,47 @@ void FileViewWriter::write(
 	}
 }
 
+void FileViewTailReader::run() {
+	if (this->shouldCancel.loadAcquire()) {
+		this->finishRun();
+		return;
+	}
+
+	auto file = QFile(this->state.path);
+
+	if (!file.open(QFile::ReadOnly)) {
+		qCDebug(logFileView) << "Tail read of" << this->state.path << "could not open file.";
+		this->finishRun();
+		return;
+	}
+
+	struct stat info {};
+	if (::fstat(file.handle(), &info) != 0) {
+		this->finishRun();
+		return;
+	}
+
+	if (static_cast<quint64>(info.st_dev) != this->state.device
+	    || static_cast<quint64>(info.st_ino) != this->state.inode
+	    || info.st_size < this->state.offset)
+	{
+		qCDebug(logFileView) << "Tail read of" << this->state.path << "found a replaced file.";
+		this->result = Result::Replaced;
+		this->finishRun();
+		return;
+	}
+
+	if (info.st_size != this->state.offset && file.seek(this->state.offset)) {
+		this->chunk = file.read(info.st_size - this->state.offset);
+	}
+
+	this->chunk.truncate(completeUtf8Length(this->chunk));
+	this->text = QString::fromUtf8(this->chunk);
+	this->state.offset += this->chunk.size();
+	this->result = Result::Appended;
+	this->finishRun();
+}
+
 FileView::~FileView() {
 	if (this->mAdapter) {
 		this->mAdapter->setFileView(nullptr);
@@ -311,6 +468,7 @@ void FileView::loadAsync(bool doStringConversion) {
 			auto* reader = new FileViewReader(this, doStringConversion);
 			reader->state.path = this->targetPath;
 			reader->state.printErrors = this->bPrintErrors;
+			reader->state.memoryMap = this->bMemoryMap;
 			QObject::connect(reader, &FileViewOperation::done, this, &FileView::operationFinished);
 			QThreadPool::globalInstance()->start(reader); // takes ownership
 			this->liveOperation = reader;
@@ -328,6 +486,9 @@ void FileView::saveAsync() {
 
 		this->cancelAsync();
 
+		// A non-atomic write truncates the file in place, which would fault the mapping.
+		if (!this->bAtomicWrites) this->state.data.unmap();
+
 		qCDebug(logFileView) << "Starting async save for" << this << "of" << this->targetPath;
 		auto* writer = new FileViewWriter(this, this->bAtomicWrites);
 		writer->state.path = this->targetPath;
@@ -340,6 +501,9 @@ void FileView::saveAsync() {
 }
 
 void FileView::cancelAsync() {
+	// Any operation started after this makes the tail read's offset outdated.
+	this->cancelTailRead();
+
 	if (!this->liveOperation) return;
 	this->liveOperation->tryCancel();
 
@@ -355,6 +519,69 @@ void FileView::cancelAsync() {
 	}
 }
 
+void FileView::startTailRead() {
+	if (this->liveOperation || this->liveTailReader) {
+		this->mTailPending = true;
+		return;
+	}
+
+	this->mTailPending = false;
+
+	qCDebug(logFileView) << "Starting tail read for" << this << "from" << this->state.offset;
+	auto* reader = new FileViewTailReader(this);
+	reader->state.path = this->state.path;
+	reader->state.offset = this->state.offset;
+	reader->state.device = this->state.device;
+	reader->state.inode = this->state.inode;
+	QObject::connect(reader, &FileViewOperation::done, this, &FileView::tailReadFinished);
+	QThreadPool::globalInstance()->start(reader); // takes ownership
+	this->liveTailReader = reader;
+}
+
+void FileView::cancelTailRead() {
+	this->mTailPending = false;
+	if (!this->liveTailReader) return;
+
+	qCDebug(logFileView) << "Disowning tail read for" << this;
+	this->liveTailReader->tryCancel();
+	QObject::disconnect(this->liveTailReader, nullptr, this, nullptr);
+	this->liveTailReader = nullptr;
+}
+
+void FileView::tailReadFinished() {
+	auto* reader = this->liveTailReader;
+	this->liveTailReader = nullptr;
+
+	if (this->sender() != reader) {
+		qCWarning(logFileView) << "got tail read finished from dropped operation" << this->sender();
+		return;
+	}
+
+	switch (reader->result) {
+	case FileViewTailReader::Result::Appended:
+		this->state.offset = reader->state.offset;
+
+		if (!reader->chunk.isEmpty()) {
+			this->state.data.append(reader->chunk, reader->text);
+			this->emitDataChanged();
+			emit this->appended(reader->text);
+		}
+
+		if (this->mTailPending) this->startTailRead();
+		break;
+	case FileViewTailReader::Result::Replaced:
+		// A truncated file can't be read through the old mapping.
+		this->state.data.unmap();
+		this->reload();
+		emit this->fileChanged();
+		break;
+	case FileViewTailReader::Result::Failed:
+		// Usually the file was removed. Leave handling that to the user, as without tail.
+		emit this->fileChanged();
+		break;
+	}
+}
+
 void FileView::operationFinished() {
 	if (this->sender() != this->liveOperation) {
 		qCWarning(logFileView) << "got operation finished from dropped operation" << this->sender();
@@ -374,6 +601,8 @@ void FileView::operationFinished() {
 	}
 
 	this->liveOperation = nullptr;
+
+	if (this->mTailPending) this->startTailRead();
 }
 
 void FileView::reload() { this->updatePath(); }
@@ -394,6 +623,7 @@ bool FileView::waitForJob() {
 		}
 
 		this->liveOperation = nullptr;
+		if (this->mTailPending) this->startTailRead();
 		return true;
 	} else return false;
 }
@@ -405,6 +635,7 @@ void FileView::loadSync() {
 	} else if (!this->waitForJob()) {
 		auto state = FileViewState(this->targetPath);
 		state.printErrors = this->bPrintErrors;
+		state.memoryMap = this->bMemoryMap;
 		FileViewReader::read(this, state, false);
 		this->updateState(state);
 
@@ -421,6 +652,8 @@ void FileView::saveSync() {
 		// Both reads and writes will be outdated.
 		if (this->liveOperation) this->cancelAsync();
 
+		if (!this->bAtomicWrites) this->state.data.unmap();
+
 		auto state = FileViewState(this->targetPath);
 		state.data = this->writeData;
 		state.printErrors = this->bPrintErrors;
@@ -444,12 +677,16 @@ void FileView::updateState(FileViewState& newState) {
 
 	this->state.path = std::move(newState.path);
 
-	if (dataChanged) {
+	// Always take the newest mapping so the previous one can be released.
+	if (dataChanged || newState.data.isMapped() || this->state.data.isMapped()) {
 		this->state.data = newState.data;
 	}
 
 	this->state.exists = newState.exists;
 	this->state.error = newState.error;
+	this->state.offset = newState.offset;
+	this->state.device = newState.device;
+	this->state.inode = newState.inode;
 
 	DropEmitter::call(
 	    pathChanged,
@@ -478,6 +715,7 @@ void FileView::setPath(const QString& path) {
 
 void FileView::updatePath() {
 	this->mPrepared = false;
+	this->cancelTailRead();
 
 	if (this->targetPath.isEmpty()) {
 		auto state = FileViewState();
@@ -534,13 +772,36 @@ void FileView::onWatchedFileChanged() {
 		this->watcher->addPath(this->targetPath);
 	}
 
+	if (this->bTail && this->mPrepared && this->state.exists) {
+		this->startTailRead();
+		return;
+	}
+
+	this->checkMapping();
 	emit this->fileChanged();
 }
 
+void FileView::checkMapping() {
+	if (this->state.data.isMappingIntact()) return;
+
+	// Dropped before anything can read it, as the file may have been truncated.
+	qCDebug(logFileView) << "Mapped file for" << this << "was modified in place, reloading";
+	this->state.data.unmap();
+	this->reload();
+}
+
 void FileView::onWatchedDirectoryChanged() {
 	if (!this->watcher->files().contains(this->targetPath) && QFileInfo(this->targetPath).exists()) {
 		// the file was just created
 		this->watcher->addPath(this->targetPath);
+
+		// A tailed file that was removed and recreated, as by log rotation, shares nothing
+		// with the content read so far.
+		if (this->bTail && this->mPrepared && this->state.exists) {
+			this->state.data.unmap();
+			this->reload();
+		}
+
 		emit this->fileChanged();
 	}
 }
@@ -557,11 +818,26 @@ FileViewWriter* FileView::liveWriter() const {
 	return dynamic_cast<FileViewWriter*>(this->liveOperation);
 }
 
-const FileViewData& FileView::writeCmpData() const {
-	return this->writeData.isEmpty() ? this->state.data : this->writeData;
+const FileViewData& FileView::writeCmpData() {
+	if (!this->writeData.isEmpty()) return this->writeData;
+
+	this->checkMapping();
+	return this->state.data;
 }
 
 QByteArray FileView::data() {
+	auto data = this->dataView();
+
+	// The buffer is handed to the JS engine, which may keep it around after the mapping is gone.
+	if (this->state.data.isMapped()) {
+		data = QByteArray(data.constData(), data.size());
+	}
+
+	return data;
+}
+
+QByteArray FileView::dataView() {
+	this->checkMapping();
 	auto guard = this->dataChangedEmitter.block();
 
 	if (!this->mPrepared) {
@@ -573,6 +849,7 @@ QByteArray FileView::data() {
 }
 
 QString FileView::text() {
+	this->checkMapping();
 	auto guard = this->textChangedEmitter.block();
 
 	if (!this->mPrepared) {
@@ -699,6 +976,6 @@ void FileViewAdapter::setFileView(FileView* fileView) {
 	}
 }
 
-void FileViewAdapter::onDataChanged() { this->deserializeAdapter(this->mFileView->data()); }
+void FileViewAdapter::onDataChanged() { this->deserializeAdapter(this->mFileView->dataView()); }
 
 } // namespace qs::io
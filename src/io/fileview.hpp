@@ -3,7 +3,9 @@
 #include <utility>
 
 #include <qatomic.h>
+#include <qbytearray.h>
 #include <qdebug.h>
+#include <qfile.h>
 #include <qfilesystemwatcher.h>
 #include <qlogging.h>
 #include <qmutex.h>
@@ -13,6 +15,7 @@
 #include <qqmlintegration.h>
 #include <qqmlparserstatus.h>
 #include <qrunnable.h>
+#include <qsharedpointer.h>
 #include <qstringview.h>
 #include <qtclasshelpermacros.h>
 #include <qtmetamacros.h>
@@ -46,13 +49,58 @@ public:
 	Q_INVOKABLE static QString toString(qs::io::FileViewError::Enum value);
 };
 
+// A read only memory mapping of a file. Unmapped when the last FileViewData referencing it
+// is destroyed.
+//
+// Mapped pages follow later writes to the same inode, so the bytes are only a stable snapshot
+// while the file is left alone or replaced by rename.
+class FileViewMapping {
+public:
+	explicit FileViewMapping(const QString& path): file(path) {}
+	Q_DISABLE_COPY_MOVE(FileViewMapping);
+
+	// Maps the whole file. Returns false if the file could not be opened or mapped.
+	[[nodiscard]] bool map();
+	[[nodiscard]] const QByteArray& bytes() const { return this->mBytes; }
+	[[nodiscard]] int handle() const { return this->file.handle(); }
+
+	// If the mapped file has not been modified in place since it was mapped. The bytes of a
+	// mapping that is not intact may have changed, or fault if the file was truncated.
+	[[nodiscard]] bool isIntact() const;
+	// If both mappings were made from the same version of the same file.
+	[[nodiscard]] bool isSameVersion(const FileViewMapping& other) const;
+
+private:
+	QFile file;
+	QByteArray mBytes;
+	quint64 device = 0;
+	quint64 inode = 0;
+	qint64 size = 0;
+	qint64 mtime = 0;
+};
+
 struct FileViewData {
 	FileViewData() = default;
 	FileViewData(QString text): text(std::move(text)) {}
 	FileViewData(QByteArray data): data(std::move(data)) {}
+	FileViewData(QSharedPointer<FileViewMapping> mapping)
+	    : data(mapping->bytes())
+	    , mapping(std::move(mapping)) {}
 
+	// Mapped data is compared by file version, as its bytes may have changed since mapping.
 	[[nodiscard]] bool operator==(const FileViewData& other) const;
 	[[nodiscard]] bool isEmpty() const;
+	// If the bytes reference a memory mapping. They are only valid while this object is alive.
+	[[nodiscard]] bool isMapped() const { return this->mapping != nullptr; }
+	[[nodiscard]] bool isMappingIntact() const { return !this->mapping || this->mapping->isIntact(); }
+
+	// Detaches from the mapping, copying the bytes if the file is unmodified and dropping them
+	// otherwise. Text that was already converted is kept either way.
+	void unmap();
+
+	// Appends bytes read from the end of the file. Text is only appended if it has already
+	// been converted, otherwise it stays lazy.
+	void append(const QByteArray& bytes, const QString& text);
 
 	operator const QString&() const;
 	operator const QByteArray&() const;
@@ -60,6 +108,7 @@ struct FileViewData {
 private:
 	mutable QString text;
 	mutable QByteArray data;
+	QSharedPointer<FileViewMapping> mapping;
 };
 
 struct FileViewState {
@@ -70,7 +119,13 @@ struct FileViewState {
 	FileViewData data;
 	bool exists = false;
 	bool printErrors = true;
+	bool memoryMap = false;
 	FileViewError::Enum error = FileViewError::Success;
+
+	// Position and identity of the file as of the last read or write, used by tail reads.
+	qint64 offset = 0;
+	quint64 device = 0;
+	quint64 inode = 0;
 };
 
 class FileView;
@@ -141,6 +196,25 @@ public:
 	bool doAtomicWrite;
 };
 
+// Reads only the bytes appended to a file since the last read.
+class FileViewTailReader: public FileViewOperation {
+public:
+	explicit FileViewTailReader(FileView* owner): FileViewOperation(owner) {}
+
+	void run() override;
+
+	enum class Result : quint8 {
+		Appended,
+		// The file was truncated or replaced, and must be fully reloaded.
+		Replaced,
+		Failed,
+	};
+
+	Result result = Result::Failed;
+	QByteArray chunk;
+	QString text;
+};
+
 class FileViewAdapter;
 
 ///! Simple accessor for small files.
@@ -220,6 +294,52 @@ class FileView: public QObject {
 	/// > }
 	/// > ```
 	Q_PROPERTY(bool watchChanges READ default WRITE default NOTIFY watchChangesChanged BINDABLE bindableWatchChanges);
+	/// If true (default false), regular files larger than 64KiB are memory mapped instead of
+	/// being copied into memory, and @@text() is converted directly from the mapping the first
+	/// time it is requested.
+	///
+	/// A mapping keeps showing the file it was made from, so this is meant for files that are
+	/// replaced by renaming a new file over them, such as files written with @@atomicWrites.
+	/// Changes to mapped files are detected by their identity, size and modification time
+	/// instead of by comparing content.
+	///
+	/// If a mapped file is modified in place, the mapping is dropped as soon as that is noticed,
+	/// keeping only text that was already converted, and the file is reloaded in the background.
+	/// With @@watchChanges this happens before @@fileChanged() is emitted, but like any other
+	/// @@reload() the new content only arrives after it.
+	///
+	/// > [!NOTE] @@data() still returns a copy of mapped files, as the returned buffer may
+	/// > outlive the mapping. Adapters read mapped content without copying.
+	///
+	/// > [!WARNING] Truncating a file in place while it is mapped can crash quickshell if the
+	/// > truncated region is read before the change is noticed. Do not use this for files that
+	/// > may be rewritten in place by other programs, such as logs rotated with `copytruncate`
+	/// > or files written with shell redirection. Writes made through this FileView are safe.
+	Q_PROPERTY(bool memoryMap READ default WRITE default NOTIFY memoryMapChanged BINDABLE bindableMemoryMap);
+	/// If true (default false) and @@watchChanges is true, changes to the file will only read
+	/// the bytes written past the end of the previously read content, and emit them as
+	/// @@appended(s) instead of emitting @@fileChanged().
+	///
+	/// If the file is truncated or replaced (for example by log rotation), it is fully reloaded
+	/// and @@fileChanged() is emitted.
+	///
+	/// Appended content is also added to @@text() and @@data(), though bindings to them will
+	/// still process the whole file. Use @@appended(s) to keep updates proportional to the
+	/// amount of new content.
+	///
+	/// > [!NOTE] An incomplete UTF-8 sequence at the end of the file is held back until the
+	/// > rest of it is written.
+	///
+	/// #### Example: Following a log file
+	/// ```qml
+	/// FileView {
+	///   path: "/var/log/example.log"
+	///   watchChanges: true
+	///   tail: true
+	///   onAppended: text => logModel.append(text)
+	/// }
+	/// ```
+	Q_PROPERTY(bool tail READ default WRITE default NOTIFY tailChanged BINDABLE bindableTail);
 	/// In addition to directly reading/writing the file as text, *adapters* can be used to
 	/// expose a file's content in new ways.
 	///
@@ -329,6 +449,8 @@ public:
 
 	[[nodiscard]] QBindable<bool> bindablePrintErrors() { return &this->bPrintErrors; }
 	[[nodiscard]] QBindable<bool> bindableWatchChanges() { return &this->bWatchChanges; }
+	[[nodiscard]] QBindable<bool> bindableMemoryMap() { return &this->bMemoryMap; }
+	[[nodiscard]] QBindable<bool> bindableTail() { return &this->bTail; }
 
 	[[nodiscard]] FileViewAdapter* adapter() const;
 	void setAdapter(FileViewAdapter* adapter);
@@ -344,6 +466,8 @@ signals:
 	void saveFailed(qs::io::FileViewError::Enum error);
 	/// Emitted if the file changes on disk and @@watchChanges is true.
 	void fileChanged();
+	/// Emitted with the newly written content of the file if @@tail and @@watchChanges are true.
+	void appended(const QString& text);
 	/// Emitted when the active @@adapter$'s data is changed.
 	void adapterUpdated();
 
@@ -360,16 +484,21 @@ signals:
 	void atomicWritesChanged();
 	void printErrorsChanged();
 	void watchChangesChanged();
+	void memoryMapChanged();
+	void tailChanged();
 	void adapterChanged();
 
 private slots:
 	void operationFinished();
+	void tailReadFinished();
 	void onAdapterDestroyed();
 
 private:
 	void loadAsync(bool doStringConversion);
 	void saveAsync();
 	void cancelAsync();
+	void startTailRead();
+	void cancelTailRead();
 	void loadSync();
 	void saveSync();
 	void updateState(FileViewState& newState);
@@ -377,15 +506,21 @@ private:
 	void updateWatchedFiles();
 	void onWatchedFileChanged();
 	void onWatchedDirectoryChanged();
+	// Drops a mapping whose file was modified in place and reloads the file.
+	void checkMapping();
 
+	// Like data(), but returns mapped content without copying it.
+	[[nodiscard]] QByteArray dataView();
 	[[nodiscard]] bool shouldBlockRead() const;
 	[[nodiscard]] FileViewReader* liveReader() const;
 	[[nodiscard]] FileViewWriter* liveWriter() const;
-	[[nodiscard]] const FileViewData& writeCmpData() const;
+	[[nodiscard]] const FileViewData& writeCmpData();
 
 	FileViewState state;
 	FileViewData writeData;
 	FileViewOperation* liveOperation = nullptr;
+	FileViewTailReader* liveTailReader = nullptr;
+	bool mTailPending = false;
 	QString pathInFlight;
 
 	QString targetPath;
@@ -423,6 +558,8 @@ public:
 	Q_OBJECT_BINDABLE_PROPERTY_WITH_ARGS(FileView, bool, bAtomicWrites, true, &FileView::atomicWritesChanged);
 	Q_OBJECT_BINDABLE_PROPERTY_WITH_ARGS(FileView, bool, bPrintErrors, true, &FileView::printErrorsChanged);
 	Q_OBJECT_BINDABLE_PROPERTY(FileView, bool, bWatchChanges, &FileView::watchChangesChanged);
+	Q_OBJECT_BINDABLE_PROPERTY(FileView, bool, bMemoryMap, &FileView::memoryMapChanged);
+	Q_OBJECT_BINDABLE_PROPERTY(FileView, bool, bTail, &FileView::tailChanged);
 	// clang-format on
 
 	QS_BINDING_SUBSCRIBE_METHOD(FileView, bWatchChanges, updateWatchedFiles, onValueChanged);
@@ -430,6 +567,8 @@ public:
 	void setPreload(bool preload);
 	void setBlockLoading(bool blockLoading);
 	void setBlockAllReads(bool blockAllReads);
+
+	friend class FileViewAdapter;
 };
 
 /// See @@FileView.adapter.
@@ -1,13 +1,24 @@
 #include "ipccomm.hpp"
+#include <algorithm>
+#include <array>
+#include <cerrno>
 #include <utility>
 #include <variant>
 
+#include <poll.h>
+#include <qbytearray.h>
 #include <qcontainerfwd.h>
+#include <qdatastream.h>
+#include <qlist.h>
+#include <qlocalsocket.h>
 #include <qlogging.h>
 #include <qloggingcategory.h>
 #include <qobject.h>
+#include <qprocess.h>
+#include <qstring.h>
 #include <qtextstream.h>
 #include <qtypes.h>
+#include <unistd.h>
 
 #include "../core/generation.hpp"
 #include "../core/logging.hpp"
@@ -131,86 +142,62 @@ using StringCallResponse = std::variant<
     ArgParseFailed,
     Completed>;
 
-void StringCallCommand::exec(qs::ipc::IpcServerConnection* conn) const {
-	auto resp = conn->responseStream<StringCallResponse>();
+namespace {
 
-	if (auto* generation = EngineGeneration::currentGeneration()) {
-		auto* registry = IpcHandlerRegistry::forGeneration(generation);
+StringCallResponse runStringCall(const StringCallCommand& command) {
+	auto* generation = EngineGeneration::currentGeneration();
+	if (!generation) return NoCurrentGeneration();
 
-		auto* handler = registry->findHandler(this->target);
-		if (!handler) {
-			resp << TargetNotFound();
-			return;
-		}
+	auto* registry = IpcHandlerRegistry::forGeneration(generation);
 
-		auto* func = handler->findFunction(this->function);
-		if (!func) {
-			resp << EntryNotFound();
-			return;
-		}
-
-		if (func->argumentTypes.length() != this->arguments.length()) {
-			resp << ArgParseFailed {
-			    .definition = func->wireDef(),
-			    .isCountMismatch = true,
-			};
+	auto* handler = registry->findHandler(command.target);
+	if (!handler) return TargetNotFound();
 
-			return;
-		}
+	auto* func = handler->findFunction(command.function);
+	if (!func) return EntryNotFound();
 
-		auto storage = IpcCallStorage(*func);
-		for (auto i = 0; i < this->arguments.length(); i++) {
-			if (!storage.setArgumentStr(i, this->arguments.value(i))) {
-				resp << ArgParseFailed {
-				    .definition = func->wireDef(),
-				    .paramIndex = static_cast<quint8>(i),
-				};
+	if (func->argumentTypes.length() != command.arguments.length()) {
+		return ArgParseFailed {
+		    .definition = func->wireDef(),
+		    .isCountMismatch = true,
+		};
+	}
 
-				return;
-			}
+	auto storage = IpcCallStorage(*func);
+	for (auto i = 0; i < command.arguments.length(); i++) {
+		if (!storage.setArgumentStr(i, command.arguments.value(i))) {
+			return ArgParseFailed {
+			    .definition = func->wireDef(),
+			    .paramIndex = static_cast<quint8>(i),
+			};
 		}
+	}
 
-		func->invoke(handler, storage);
+	func->invoke(handler, storage);
 
-		resp << Completed {
-		    .isVoid = func->returnType.isVoid(),
-		    .returnValue = storage.getReturnStr(),
-		};
-	} else {
-		conn->respond(StringCallResponse(NoCurrentGeneration()));
-	}
+	return Completed {
+	    .isVoid = func->returnType.isVoid(),
+	    .returnValue = storage.getReturnStr(),
+	};
 }
 
-int callFunction(
+int printCallResponse(
     IpcClient* client,
-    const QString& target,
-    const QString& function,
-    const QVector<QString>& arguments
+    const StringCallResponse& slot,
+    const QVector<QString>& arguments,
+    bool singleLine = false
 ) {
-	if (target.isEmpty()) {
-		qCCritical(logBare) << "Target required to send message.";
-		return -1;
-	} else if (function.isEmpty()) {
-		qCCritical(logBare) << "Function required to send message.";
-		return -1;
-	}
-
-	client->sendMessage(
-	    IpcCommand(StringCallCommand {.target = target, .function = function, .arguments = arguments})
-	);
-
-	StringCallResponse slot;
-	if (!client->waitForResponse(slot)) return -1;
-
 	if (std::holds_alternative<Completed>(slot)) {
-		auto& result = std::get<Completed>(slot);
+		const auto& result = std::get<Completed>(slot);
 		if (!result.isVoid) {
-			QTextStream(stdout) << result.returnValue << Qt::endl;
+			QTextStream(stdout) << (singleLine ? escapeResultLine(result.returnValue)
+			                                   : result.returnValue)
+			                    << Qt::endl;
 		}
 
 		return 0;
 	} else if (std::holds_alternative<ArgParseFailed>(slot)) {
-		auto& error = std::get<ArgParseFailed>(slot);
+		const auto& error = std::get<ArgParseFailed>(slot);
 
 		if (error.isCountMismatch) {
 			auto correctCount = error.definition.arguments.length();
@@ -242,6 +229,222 @@ int callFunction(
 	return -1;
 }
 
+} // namespace
+
+QString escapeResultLine(const QString& result) {
+	auto escaped = QString();
+	escaped.reserve(result.size());
+
+	for (auto c: result) {
+		switch (c.unicode()) {
+		case u'\\': escaped.append(u'\\').append(u'\\'); break;
+		case u'\n': escaped.append(u'\\').append(u'n'); break;
+		case u'\r': escaped.append(u'\\').append(u'r'); break;
+		default: escaped.append(c);
+		}
+	}
+
+	return escaped;
+}
+
+void StringCallCommand::exec(qs::ipc::IpcServerConnection* conn) const {
+	conn->respond(runStringCall(*this));
+}
+
+int callFunction(
+    IpcClient* client,
+    const QString& target,
+    const QString& function,
+    const QVector<QString>& arguments
+) {
+	if (target.isEmpty()) {
+		qCCritical(logBare) << "Target required to send message.";
+		return -1;
+	} else if (function.isEmpty()) {
+		qCCritical(logBare) << "Function required to send message.";
+		return -1;
+	}
+
+	client->sendMessage(
+	    IpcCommand(StringCallCommand {.target = target, .function = function, .arguments = arguments})
+	);
+
+	StringCallResponse slot;
+	if (!client->waitForResponse(slot)) return -1;
+
+	return printCallResponse(client, slot, arguments);
+}
+
+struct StringCallBatchResponse {
+	quint32 id = 0;
+	QVector<StringCallResponse> results;
+};
+
+// The variant stream operators are declared in the global namespace, which isn't searched
+// when QVector streams its elements, so results are streamed one at a time.
+QDataStream& operator<<(QDataStream& stream, const StringCallBatchResponse& data) {
+	stream << data.id << static_cast<quint32>(data.results.length());
+
+	for (const auto& result: data.results) {
+		::operator<<(stream, result);
+	}
+
+	return stream;
+}
+
+QDataStream& operator>>(QDataStream& stream, StringCallBatchResponse& data) {
+	quint32 count = 0;
+	stream >> data.id >> count;
+
+	data.results.clear();
+
+	for (quint32 i = 0; i != count && stream.status() == QDataStream::Ok; i++) {
+		::operator>>(stream, data.results.emplace_back());
+	}
+
+	return stream;
+}
+
+void StringCallBatchCommand::exec(qs::ipc::IpcServerConnection* conn) const {
+	conn->persistent = true;
+
+	auto response = StringCallBatchResponse {.id = this->id};
+	response.results.reserve(this->calls.length());
+
+	for (const auto& call: this->calls) {
+		response.results.push_back(runStringCall(call));
+	}
+
+	conn->respond(response);
+}
+
+namespace {
+
+struct PendingBatch {
+	quint32 id = 0;
+	QVector<QVector<QString>> arguments;
+};
+
+// Batches sent before waiting on responses, bounding how far input can run ahead.
+constexpr qsizetype MAX_IN_FLIGHT_BATCHES = 16;
+
+} // namespace
+
+int callFunctionsFromStdin(IpcClient* client) {
+	auto pending = QList<PendingBatch>();
+	auto input = QByteArray();
+	auto inputOpen = true;
+	auto failed = false;
+	quint32 nextId = 1;
+
+	// Every call prints exactly one line, so output can be matched up with input lines.
+	// Results are escaped to keep line breaks in them from breaking that.
+	auto readResponses = [&] {
+		while (!pending.isEmpty()) {
+			auto response = StringCallBatchResponse();
+			client->stream.startTransaction();
+			client->stream >> response;
+			if (!client->stream.commitTransaction()) return true;
+
+			auto batch = pending.takeFirst();
+			if (response.id != batch.id || response.results.length() != batch.arguments.length()) {
+				qCCritical(logIpc) << "Received mismatched IPC response from" << client;
+				return false;
+			}
+
+			for (auto i = 0; i != response.results.length(); i++) {
+				const auto& result = response.results.at(i);
+				auto r = printCallResponse(client, result, batch.arguments.at(i), true);
+
+				if (r != 0) failed = true;
+				if (r != 0 || std::get<Completed>(result).isVoid) QTextStream(stdout) << Qt::endl;
+			}
+		}
+
+		return true;
+	};
+
+	auto sendLines = [&] {
+		auto batch = StringCallBatchCommand {.id = nextId};
+		auto pendingBatch = PendingBatch {.id = nextId};
+		qsizetype start = 0;
+
+		while (start < input.length()) {
+			auto end = input.indexOf('\n', start);
+			if (end == -1) {
+				if (inputOpen) break;
+				end = input.length();
+			}
+
+			auto words = QProcess::splitCommand(QString::fromUtf8(input.sliced(start, end - start)));
+			start = end + 1;
+
+			if (words.isEmpty()) continue;
+
+			auto call = StringCallCommand {
+			    .target = words.value(0),
+			    .function = words.value(1),
+			    .arguments = words.mid(2),
+			};
+
+			pendingBatch.arguments.push_back(call.arguments);
+			batch.calls.push_back(std::move(call));
+		}
+
+		input.remove(0, std::min(start, input.length()));
+		if (batch.calls.isEmpty()) return;
+
+		client->sendMessage(IpcCommand(batch));
+		pending.push_back(std::move(pendingBatch));
+		nextId++;
+	};
+
+	while (true) {
+		if (!readResponses()) return -1;
+		if (!inputOpen && pending.isEmpty()) break;
+
+		auto readInput = inputOpen && pending.length() < MAX_IN_FLIGHT_BATCHES;
+		auto fds = std::array<pollfd, 2> {{
+		    {.fd = readInput ? STDIN_FILENO : -1, .events = POLLIN, .revents = 0},
+		    {.fd = pending.isEmpty() ? -1 : static_cast<int>(client->socket.socketDescriptor()),
+		     .events = POLLIN,
+		     .revents = 0},
+		}};
+
+		if (poll(fds.data(), fds.size(), -1) == -1) {
+			if (errno == EINTR) continue;
+			qCCritical(logIpc) << "Failed to poll stdin and IPC socket:" << qt_error_string(errno);
+			return -1;
+		}
+
+		if (fds[1].revents != 0 && !client->socket.waitForReadyRead(0)
+		    && client->socket.state() != QLocalSocket::ConnectedState)
+		{
+			qCCritical(logBare) << "Lost connection to the instance.";
+			return -1;
+		}
+
+		if (fds[0].revents != 0) {
+			auto buffer = std::array<char, 16384>();
+			auto length = read(STDIN_FILENO, buffer.data(), buffer.size());
+
+			if (length == -1) {
+				if (errno == EINTR || errno == EAGAIN) continue;
+				qCCritical(logIpc) << "Failed to read stdin:" << qt_error_string(errno);
+				inputOpen = false;
+			} else if (length == 0) {
+				inputOpen = false;
+			} else {
+				input.append(buffer.data(), length);
+			}
+
+			sendLines();
+		}
+	}
+
+	return failed ? -1 : 0;
+}
+
 struct PropertyValue {
 	QString value;
 };
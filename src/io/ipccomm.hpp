@@ -39,6 +39,23 @@ int callFunction(
     const QVector<QString>& arguments
 );
 
+// Runs a batch of calls in one round trip. The connection is kept open afterwards so more
+// batches can be pipelined through it, and each response carries the id of its batch.
+struct StringCallBatchCommand {
+	quint32 id = 0;
+	QVector<StringCallCommand> calls;
+
+	void exec(qs::ipc::IpcServerConnection* conn) const;
+};
+
+DEFINE_SIMPLE_DATASTREAM_OPS(StringCallBatchCommand, data.id, data.calls);
+
+// Calls functions read line by line from stdin, pipelining them through a single connection.
+int callFunctionsFromStdin(qs::ipc::IpcClient* client);
+
+// Escapes backslashes and line breaks in a call result so it prints as exactly one line.
+QString escapeResultLine(const QString& result);
+
 struct StringPropReadCommand {
 	QString target;
 	QString property;
@@ -117,6 +117,7 @@ void Process::setStdoutParser(DataStreamParser* parser) {
 
 	if (parser != nullptr) {
 		QObject::connect(parser, &QObject::destroyed, this, &Process::onStdoutParserDestroyed);
+		QObject::connect(parser, &DataStreamParser::readyForData, this, &Process::onStdoutReadyRead);
 	}
 
 	emit this->stdoutParserChanged();
@@ -150,6 +151,7 @@ void Process::setStderrParser(DataStreamParser* parser) {
 
 	if (parser != nullptr) {
 		QObject::connect(parser, &QObject::destroyed, this, &Process::onStderrParserDestroyed);
+		QObject::connect(parser, &DataStreamParser::readyForData, this, &Process::onStderrReadyRead);
 	}
 
 	emit this->stderrParserChanged();
@@ -272,6 +274,17 @@ void Process::onStarted() {
 }
 
 void Process::onFinished(qint32 exitCode, QProcess::ExitStatus exitStatus) {
+	// output left unread by a paused parser is handed over before the process goes away
+	if (this->mStdoutParser) {
+		auto buf = this->process->readAllStandardOutput();
+		if (!buf.isEmpty()) this->mStdoutParser->parseBytes(buf, this->stdoutBuffer);
+	}
+
+	if (this->mStderrParser) {
+		auto buf = this->process->readAllStandardError();
+		if (!buf.isEmpty()) this->mStderrParser->parseBytes(buf, this->stderrBuffer);
+	}
+
 	this->process->deleteLater();
 	this->process = nullptr;
 	if (this->mStdoutParser) this->mStdoutParser->streamEnded(this->stdoutBuffer);
@@ -297,13 +310,15 @@ void Process::onErrorOccurred(QProcess::ProcessError error) {
 }
 
 void Process::onStdoutReadyRead() {
-	if (this->mStdoutParser == nullptr) return;
+	if (this->mStdoutParser == nullptr || !this->mStdoutParser->acceptingData()) return;
+	if (this->process == nullptr) return;
 	auto buf = this->process->readAllStandardOutput();
 	this->mStdoutParser->parseBytes(buf, this->stdoutBuffer);
 }
 
 void Process::onStderrReadyRead() {
-	if (this->mStderrParser == nullptr) return;
+	if (this->mStderrParser == nullptr || !this->mStderrParser->acceptingData()) return;
+	if (this->process == nullptr) return;
 	auto buf = this->process->readAllStandardError();
 	this->mStderrParser->parseBytes(buf, this->stderrBuffer);
 }
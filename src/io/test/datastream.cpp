@@ -38,6 +38,14 @@ void TestSplitParser::splits_data() { // NOLINT
 	QTest::addRow("longsplit-incomplete") << "123"
 		<< "foo12" << "3bar123baz"
 		<< QList<QString>({ "foo", "bar" }) << "baz";
+
+	QTest::addRow("repeated-prefix") << "aab"
+		<< "fooa" << "aabbaraab"
+		<< QList<QString>({ "fooa", "bar" }) << "";
+
+	QTest::addRow("partial-marker") << "123"
+		<< "foo12" << "124bar1"
+		<< QList<QString>() << "foo12124bar1";
 	// clang-format on
 	// NOLINTEND
 }
@@ -103,4 +111,28 @@ void TestSplitParser::initBuffer() { // NOLINT
 	QCOMPARE(buf, "baz");
 }
 
+void TestSplitParser::batched() { // NOLINT
+	auto parser = SplitParser();
+	auto readSpy = QSignalSpy(&parser, &DataStreamParser::read);
+	auto batchSpy = QSignalSpy(&parser, &SplitParser::readBatch);
+
+	auto buf = QByteArray();
+	auto incoming = QString("foo-bar-baz").toUtf8();
+
+	parser.setSplitMarker("-");
+	parser.setBatched(true);
+	parser.parseBytes(incoming, buf);
+
+	QCOMPARE(readSpy.count(), 0);
+	QCOMPARE(batchSpy.count(), 1);
+	QCOMPARE(batchSpy.at(0).at(0).toStringList(), QList<QString>({"foo", "bar"}));
+	QCOMPARE(buf, "baz");
+
+	parser.streamEnded(buf);
+
+	QCOMPARE(readSpy.count(), 0);
+	QCOMPARE(batchSpy.count(), 2);
+	QCOMPARE(batchSpy.at(1).at(0).toStringList(), QList<QString>({"baz"}));
+}
+
 QTEST_MAIN(TestSplitParser);
@@ -10,4 +10,5 @@ private slots:
 	void splits_data(); // NOLINT
 	void splits();
 	void initBuffer();
+	void batched();
 };
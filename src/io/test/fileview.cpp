@@ -0,0 +1,306 @@
+#include "fileview.hpp"
+
+#include <qbytearray.h>
+#include <qfile.h>
+#include <qiodevice.h>
+#include <qobject.h>
+#include <qsharedpointer.h>
+#include <qsignalspy.h>
+#include <qstring.h>
+#include <qtemporarydir.h>
+#include <qtest.h>
+#include <qtestcase.h>
+#include <qtypes.h>
+#include <qvariant.h>
+
+#include "../fileview.hpp"
+
+using namespace qs::io;
+
+namespace {
+
+// Comfortably above the size files start being mapped at.
+QByteArray makeContent(qsizetype size) {
+	auto content = QByteArray();
+	content.reserve(size);
+
+	for (auto i = 0; content.size() < size; i++) {
+		content.append(QString("line %1 é\n").arg(i).toUtf8());
+	}
+
+	return content;
+}
+
+bool writeFile(const QString& path, const QByteArray& content) {
+	auto file = QFile(path);
+	if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) return false;
+	return file.write(content) == content.size();
+}
+
+bool appendFile(const QString& path, const QByteArray& content) {
+	auto file = QFile(path);
+	if (!file.open(QIODevice::Append)) return false;
+	return file.write(content) == content.size();
+}
+
+void openTailed(FileView& view, const QString& path) {
+	view.setBlockLoading(true);
+	view.bindableWatchChanges().setValue(true);
+	view.bindableTail().setValue(true);
+	view.setPath(path);
+}
+
+void openMapped(FileView& view, const QString& path) {
+	view.setBlockLoading(true);
+	view.bindableMemoryMap().setValue(true);
+	view.setPath(path);
+}
+
+} // namespace
+
+void TestFileView::readPath_data() { // NOLINT
+	QTest::addColumn<qsizetype>("size");
+	QTest::addColumn<bool>("memoryMap");
+	QTest::addColumn<bool>("mapped");
+
+	QTest::addRow("large mapped") << qsizetype(256 * 1024) << true << true;
+	QTest::addRow("large read") << qsizetype(256 * 1024) << false << false;
+	QTest::addRow("small") << qsizetype(1024) << true << false;
+}
+
+void TestFileView::readPath() {
+	QFETCH(qsizetype, size);
+	QFETCH(bool, memoryMap);
+	QFETCH(bool, mapped);
+
+	auto dir = QTemporaryDir();
+	QVERIFY(dir.isValid());
+	auto path = dir.filePath("file");
+	auto content = makeContent(size);
+	QVERIFY(writeFile(path, content));
+
+	auto state = FileViewState(path);
+	state.memoryMap = memoryMap;
+	FileViewReader::read(nullptr, state, true);
+
+	QCOMPARE(state.error, FileViewError::Success);
+	QCOMPARE(state.data.isMapped(), mapped);
+	QCOMPARE(state.offset, content.size());
+	QCOMPARE(state.data.operator const QByteArray&(), content);
+	QCOMPARE(state.data.operator const QString&(), QString::fromUtf8(content));
+}
+
+void TestFileView::mappedContent() {
+	auto dir = QTemporaryDir();
+	QVERIFY(dir.isValid());
+	auto path = dir.filePath("file");
+	auto content = makeContent(256 * 1024);
+	QVERIFY(writeFile(path, content));
+
+	auto data = QByteArray();
+
+	{
+		auto view = FileView();
+		openMapped(view, path);
+
+		QCOMPARE(view.text(), QString::fromUtf8(content));
+		data = view.data();
+	}
+
+	// data() must not reference the mapping, which is gone with the view.
+	QCOMPARE(data, content);
+}
+
+void TestFileView::truncatedWhileMapped() {
+	auto dir = QTemporaryDir();
+	QVERIFY(dir.isValid());
+	auto path = dir.filePath("file");
+	QVERIFY(writeFile(path, makeContent(256 * 1024)));
+
+	auto state = FileViewState(path);
+	state.memoryMap = true;
+	FileViewReader::read(nullptr, state, false);
+	QVERIFY(state.data.isMapped());
+
+	auto view = FileView();
+	openMapped(view, path);
+	QVERIFY(!view.data().isEmpty());
+
+	// Reading past the new end of the file through the mapping would fault.
+	QVERIFY(writeFile(path, "truncated"));
+
+	QVERIFY(!state.data.isMappingIntact());
+	state.data.unmap();
+	QVERIFY(!state.data.isMapped());
+	QVERIFY(state.data.isEmpty());
+
+	// The view drops the mapping before reading it, and reloads.
+	QVERIFY(view.data().isEmpty());
+	view.waitForJob();
+	QCOMPARE(view.data(), "truncated");
+	QCOMPARE(view.text(), "truncated");
+}
+
+void TestFileView::writeWhileMapped_data() { // NOLINT
+	QTest::addColumn<bool>("atomic");
+	QTest::addRow("atomic") << true;
+	QTest::addRow("in place") << false;
+}
+
+void TestFileView::writeWhileMapped() {
+	QFETCH(bool, atomic);
+
+	auto dir = QTemporaryDir();
+	QVERIFY(dir.isValid());
+	auto path = dir.filePath("file");
+	auto content = makeContent(256 * 1024);
+	QVERIFY(writeFile(path, content));
+
+	auto view = FileView();
+	openMapped(view, path);
+	view.bindableBlockWrites().setValue(true);
+	view.bindableAtomicWrites().setValue(atomic);
+	QCOMPARE(view.data(), content);
+
+	auto newContent = makeContent(128 * 1024);
+	newContent.prepend("new ");
+	view.setData(newContent);
+
+	QCOMPARE(view.data(), newContent);
+
+	auto file = QFile(path);
+	QVERIFY(file.open(QIODevice::ReadOnly));
+	QCOMPARE(file.readAll(), newContent);
+}
+
+void TestFileView::mapFailure() {
+	auto dir = QTemporaryDir();
+	QVERIFY(dir.isValid());
+	auto path = dir.filePath("file");
+
+	// Missing and empty files cannot be mapped, and are handled by the read path instead.
+	auto missing = FileViewMapping(path);
+	QVERIFY(!missing.map());
+
+	QVERIFY(writeFile(path, QByteArray()));
+	auto empty = FileViewMapping(path);
+	QVERIFY(!empty.map());
+
+	auto view = FileView();
+	openMapped(view, path);
+	QVERIFY(view.text().isEmpty());
+	QVERIFY(view.property("loaded").toBool());
+
+	auto content = makeContent(256 * 1024);
+	QVERIFY(writeFile(dir.filePath("other"), content));
+
+	auto mapping = FileViewMapping(dir.filePath("other"));
+	QVERIFY(mapping.map());
+	QCOMPARE(mapping.bytes(), content);
+	QVERIFY(mapping.isIntact());
+}
+
+void TestFileView::tailAppend() {
+	auto dir = QTemporaryDir();
+	QVERIFY(dir.isValid());
+	auto path = dir.filePath("log");
+	QVERIFY(writeFile(path, "first\n"));
+
+	auto view = FileView();
+	auto appendedSpy = QSignalSpy(&view, &FileView::appended);
+	auto changedSpy = QSignalSpy(&view, &FileView::fileChanged);
+	openTailed(view, path);
+	QCOMPARE(view.text(), "first\n");
+
+	QVERIFY(appendFile(path, "second\n"));
+	QTRY_COMPARE(appendedSpy.count(), 1);
+	QCOMPARE(appendedSpy.at(0).at(0).toString(), "second\n");
+	QCOMPARE(view.text(), "first\nsecond\n");
+
+	QVERIFY(appendFile(path, "third\n"));
+	QTRY_COMPARE(appendedSpy.count(), 2);
+	QCOMPARE(appendedSpy.at(1).at(0).toString(), "third\n");
+	QCOMPARE(view.data(), "first\nsecond\nthird\n");
+
+	QCOMPARE(changedSpy.count(), 0);
+}
+
+void TestFileView::tailPartialUtf8() {
+	auto dir = QTemporaryDir();
+	QVERIFY(dir.isValid());
+	auto path = dir.filePath("log");
+	QVERIFY(writeFile(path, "a\n"));
+
+	auto view = FileView();
+	auto appendedSpy = QSignalSpy(&view, &FileView::appended);
+	openTailed(view, path);
+	QCOMPARE(view.text(), "a\n");
+
+	auto character = QString("é").toUtf8();
+	QCOMPARE(character.size(), 2);
+
+	// The first byte alone is held back until the sequence is complete.
+	QVERIFY(appendFile(path, "b" + character.first(1)));
+	QTRY_COMPARE(appendedSpy.count(), 1);
+	QCOMPARE(appendedSpy.at(0).at(0).toString(), "b");
+
+	QVERIFY(appendFile(path, character.sliced(1) + "\n"));
+	QTRY_COMPARE(appendedSpy.count(), 2);
+	QCOMPARE(appendedSpy.at(1).at(0).toString(), "é\n");
+	QCOMPARE(view.text(), "a\nbé\n");
+}
+
+void TestFileView::tailTruncated() {
+	auto dir = QTemporaryDir();
+	QVERIFY(dir.isValid());
+	auto path = dir.filePath("log");
+	QVERIFY(writeFile(path, "first\nsecond\n"));
+
+	auto view = FileView();
+	auto appendedSpy = QSignalSpy(&view, &FileView::appended);
+	auto changedSpy = QSignalSpy(&view, &FileView::fileChanged);
+	openTailed(view, path);
+	QCOMPARE(view.text(), "first\nsecond\n");
+
+	// As done by copytruncate log rotation.
+	QVERIFY(writeFile(path, "new\n"));
+
+	QTRY_VERIFY(changedSpy.count() != 0);
+	QTRY_COMPARE(view.text(), "new\n");
+	QCOMPARE(appendedSpy.count(), 0);
+
+	// Tailing continues from the reloaded content.
+	QVERIFY(appendFile(path, "more\n"));
+	QTRY_COMPARE(appendedSpy.count(), 1);
+	QCOMPARE(appendedSpy.at(0).at(0).toString(), "more\n");
+	QCOMPARE(view.text(), "new\nmore\n");
+}
+
+void TestFileView::tailRotated() {
+	auto dir = QTemporaryDir();
+	QVERIFY(dir.isValid());
+	auto path = dir.filePath("log");
+	QVERIFY(writeFile(path, "old\n"));
+
+	auto view = FileView();
+	auto appendedSpy = QSignalSpy(&view, &FileView::appended);
+	auto changedSpy = QSignalSpy(&view, &FileView::fileChanged);
+	openTailed(view, path);
+	QCOMPARE(view.text(), "old\n");
+
+	// The new file is longer than the old one, so it can only be told apart by identity.
+	QVERIFY(QFile::rename(path, dir.filePath("log.1")));
+	QVERIFY(writeFile(path, "old\nrotated\n"));
+
+	QTRY_VERIFY(changedSpy.count() != 0);
+	QTRY_COMPARE(view.text(), "old\nrotated\n");
+	QCOMPARE(appendedSpy.count(), 0);
+
+	// Writes to the rotated file are no longer followed.
+	QVERIFY(appendFile(dir.filePath("log.1"), "late\n"));
+	QVERIFY(appendFile(path, "next\n"));
+	QTRY_COMPARE(appendedSpy.count(), 1);
+	QCOMPARE(appendedSpy.at(0).at(0).toString(), "next\n");
+}
+
+QTEST_MAIN(TestFileView);
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <qobject.h>
+#include <qtmetamacros.h>
+
+class TestFileView: public QObject {
+	Q_OBJECT;
+
+private slots:
+	void readPath_data(); // NOLINT
+	void readPath();
+	void mappedContent();
+	void truncatedWhileMapped();
+	void writeWhileMapped_data(); // NOLINT
+	void writeWhileMapped();
+	void mapFailure();
+	void tailAppend();
+	void tailPartialUtf8();
+	void tailTruncated();
+	void tailRotated();
+};
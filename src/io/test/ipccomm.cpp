@@ -0,0 +1,123 @@
+#include "ipccomm.hpp"
+#include <variant>
+
+#include <qbytearray.h>
+#include <qdatastream.h>
+#include <qiodevice.h>
+#include <qlocalserver.h>
+#include <qlocalsocket.h>
+#include <qobject.h>
+#include <qscopedpointer.h>
+#include <qstring.h>
+#include <qtemporarydir.h>
+#include <qtest.h>
+#include <qtestcase.h>
+#include <qtypes.h>
+
+#include "../../ipc/ipc.hpp"
+#include "../../ipc/ipccommand.hpp"
+#include "../ipccomm.hpp"
+
+using namespace qs::io::ipc::comm;
+
+void TestIpcComm::escapeResultLine_data() { // NOLINT
+	QTest::addColumn<QString>("result");
+	QTest::addColumn<QString>("escaped");
+
+	QTest::addRow("empty") << QString() << QString();
+	QTest::addRow("plain") << QString("some result") << QString("some result");
+	QTest::addRow("newline") << QString("a\nb\n") << QString("a\\nb\\n");
+	QTest::addRow("crlf") << QString("a\r\nb") << QString("a\\r\\nb");
+	QTest::addRow("backslash") << QString("C:\\dir") << QString("C:\\\\dir");
+	// Must not be confused with an escaped newline.
+	QTest::addRow("literal-escape") << QString("a\\nb") << QString("a\\\\nb");
+}
+
+void TestIpcComm::escapeResultLine() {
+	QFETCH(QString, result);
+	QFETCH(QString, escaped);
+
+	auto line = qs::io::ipc::comm::escapeResultLine(result);
+	QCOMPARE(line, escaped);
+	QVERIFY(!line.contains(u'\n'));
+	QVERIFY(!line.contains(u'\r'));
+}
+
+void TestIpcComm::batchRoundTrip() {
+	auto batch = StringCallBatchCommand {
+	    .id = 7,
+	    .calls = {
+	        StringCallCommand {.target = "a", .function = "f", .arguments = {"1", "two words"}},
+	        StringCallCommand {.target = "b", .function = "g"},
+	    },
+	};
+
+	auto buffer = QByteArray();
+
+	{
+		auto stream = QDataStream(&buffer, QIODevice::WriteOnly);
+		stream << qs::ipc::IpcCommand(batch);
+	}
+
+	auto stream = QDataStream(buffer);
+	auto command = qs::ipc::IpcCommand();
+	stream >> command;
+	QCOMPARE(stream.status(), QDataStream::Ok);
+	QVERIFY(stream.atEnd());
+
+	QVERIFY(std::holds_alternative<StringCallBatchCommand>(command));
+	const auto& read = std::get<StringCallBatchCommand>(command);
+	QCOMPARE(read.id, 7u);
+	QCOMPARE(read.calls.length(), 2);
+	QCOMPARE(read.calls.at(0).target, "a");
+	QCOMPARE(read.calls.at(0).function, "f");
+	QCOMPARE(read.calls.at(0).arguments, QVector<QString>({"1", "two words"}));
+	QCOMPARE(read.calls.at(1).target, "b");
+	QVERIFY(read.calls.at(1).arguments.isEmpty());
+}
+
+void TestIpcComm::batchExec() {
+	auto dir = QTemporaryDir();
+	QVERIFY(dir.isValid());
+
+	auto server = QLocalServer();
+	QVERIFY(server.listen(dir.filePath("ipc.sock")));
+
+	auto client = QLocalSocket();
+	client.connectToServer(server.fullServerName());
+	QVERIFY(client.waitForConnected());
+	QVERIFY(server.waitForNewConnection(1000));
+
+	auto* conn = new qs::ipc::IpcServerConnection(server.nextPendingConnection(), nullptr);
+	auto connGuard = QScopedPointer(conn);
+
+	auto batch = StringCallBatchCommand {
+	    .id = 3,
+	    .calls = {StringCallCommand {.target = "a", .function = "f"}, StringCallCommand()},
+	};
+
+	batch.exec(conn);
+
+	// Kept open for the next batch.
+	QVERIFY(conn->persistent);
+
+	// With no shell loaded, every call in the batch gets its own response.
+	auto stream = QDataStream(&client);
+	quint32 id = 0;
+	quint32 count = 0;
+	quint8 first = 0;
+	quint8 second = 0;
+
+	while (client.bytesAvailable() < 10) QVERIFY(client.waitForReadyRead(1000));
+	stream >> id >> count >> first >> second;
+
+	QCOMPARE(stream.status(), QDataStream::Ok);
+	QCOMPARE(id, 3u);
+	QCOMPARE(count, 2u);
+
+	// Index of NoCurrentGeneration in the call response variant.
+	QCOMPARE(first, quint8(1));
+	QCOMPARE(second, quint8(1));
+}
+
+QTEST_MAIN(TestIpcComm);
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <qobject.h>
+#include <qtmetamacros.h>
+
+class TestIpcComm: public QObject {
+	Q_OBJECT;
+
+private slots:
+	void escapeResultLine_data(); // NOLINT
+	void escapeResultLine();
+	void batchRoundTrip();
+	void batchExec();
+};
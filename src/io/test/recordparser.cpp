@@ -0,0 +1,194 @@
+#include "recordparser.hpp"
+
+#include <qbytearray.h>
+#include <qendian.h>
+#include <qlist.h>
+#include <qobject.h>
+#include <qsignalspy.h>
+#include <qtest.h>
+#include <qtestcase.h>
+#include <qvariant.h>
+
+#include "../datastream.hpp"
+
+namespace {
+
+QVariantList spyValues(const QSignalSpy& spy) {
+	auto values = QVariantList();
+	for (const auto& args: spy) {
+		values.push_back(args[0]);
+	}
+
+	return values;
+}
+
+} // namespace
+
+void TestRecordParser::jsonLines() { // NOLINT
+	auto parser = JsonLinesParser();
+	auto spy = QSignalSpy(&parser, &RecordParser::parsed);
+
+	auto buffer = QByteArray();
+	auto first = QByteArray("{\"a\": \"x\"}\n[\"y\", \"z\"]\n\nnot json\n{\"b\"");
+	auto second = QByteArray(": []}");
+
+	parser.parseBytes(first, buffer);
+	QCOMPARE(spy.count(), 2);
+	QCOMPARE(buffer, "{\"b\"");
+
+	parser.parseBytes(second, buffer);
+	QCOMPARE(spy.count(), 2);
+
+	parser.streamEnded(buffer);
+
+	auto expected = QVariantList {
+	    QVariantMap {{"a", "x"}},
+	    QVariantList {"y", "z"},
+	    QVariantMap {{"b", QVariantList()}},
+	};
+
+	QCOMPARE(spyValues(spy), expected);
+	QVERIFY(buffer.isEmpty());
+}
+
+void TestRecordParser::lengthPrefix_data() { // NOLINT
+	QTest::addColumn<int>("prefixSize");
+	QTest::addColumn<bool>("littleEndian");
+
+	QTest::addRow("u8") << 1 << false;
+	QTest::addRow("u16be") << 2 << false;
+	QTest::addRow("u32le") << 4 << true;
+	QTest::addRow("u64be") << 8 << false;
+}
+
+void TestRecordParser::lengthPrefix() { // NOLINT
+	QFETCH(int, prefixSize);
+	QFETCH(bool, littleEndian);
+
+	auto frames = QList<QByteArray> {"foo", "", QByteArray("b\0r", 3), QByteArray(200, 'x')};
+
+	auto stream = QByteArray();
+	for (const auto& frame: frames) {
+		auto prefix = QByteArray(prefixSize, '\0');
+		auto length = static_cast<quint64>(frame.length());
+
+		for (auto i = 0; i < prefixSize; i++) {
+			auto shift = littleEndian ? i : prefixSize - i - 1;
+			prefix[i] = static_cast<char>((length >> (shift * 8)) & 0xff);
+		}
+
+		stream.append(prefix);
+		stream.append(frame);
+	}
+
+	auto parser = LengthPrefixParser();
+	auto spy = QSignalSpy(&parser, &RecordParser::parsed);
+	parser.setPrefixSize(prefixSize);
+	parser.setLittleEndian(littleEndian);
+
+	// one byte at a time to split every frame and prefix
+	auto buffer = QByteArray();
+	for (auto byte: stream) {
+		auto incoming = QByteArray(1, byte);
+		parser.parseBytes(incoming, buffer);
+	}
+
+	auto actual = QList<QByteArray>();
+	for (const auto& value: spyValues(spy)) {
+		actual.push_back(value.toByteArray());
+	}
+
+	QCOMPARE(actual, frames);
+	QVERIFY(buffer.isEmpty());
+}
+
+void TestRecordParser::oversizedFrame() { // NOLINT
+	auto parser = LengthPrefixParser();
+	auto spy = QSignalSpy(&parser, &RecordParser::parsed);
+	parser.setPrefixSize(1);
+	parser.setMaxFrameSize(4);
+
+	auto buffer = QByteArray();
+	auto first = QByteArray("\x03" "foo" "\x06" "toob");
+	auto second = QByteArray("ig" "\x03" "bar");
+
+	parser.parseBytes(first, buffer);
+	parser.parseBytes(second, buffer);
+
+	QCOMPARE(spyValues(spy), QVariantList({QByteArray("foo"), QByteArray("bar")}));
+	QVERIFY(buffer.isEmpty());
+}
+
+void TestRecordParser::pause() { // NOLINT
+	auto parser = JsonLinesParser();
+	auto spy = QSignalSpy(&parser, &RecordParser::parsed);
+	auto readySpy = QSignalSpy(&parser, &DataStreamParser::readyForData);
+
+	QObject::connect(&parser, &RecordParser::parsed, &parser, [&] { parser.setPaused(true); });
+
+	auto buffer = QByteArray();
+	auto incoming = QByteArray("[]\n[]\n[]\n");
+
+	parser.parseBytes(incoming, buffer);
+	QCOMPARE(spy.count(), 1);
+	QVERIFY(!parser.acceptingData());
+	QCOMPARE(buffer, "[]\n[]\n");
+
+	parser.setPaused(false);
+	QCOMPARE(readySpy.count(), 1);
+
+	parser.parseBytes(buffer, buffer);
+	QCOMPARE(spy.count(), 2);
+	QCOMPARE(buffer, "[]\n");
+}
+
+void TestRecordParser::unpauseFromHandler() { // NOLINT
+	auto parser = JsonLinesParser();
+	auto spy = QSignalSpy(&parser, &RecordParser::parsed);
+	auto readySpy = QSignalSpy(&parser, &DataStreamParser::readyForData);
+
+	auto buffer = QByteArray();
+	auto empty = QByteArray();
+
+	// Resume reading the way DataStream does.
+	QObject::connect(&parser, &DataStreamParser::readyForData, &parser, [&] {
+		parser.parseBytes(empty, buffer);
+	});
+
+	QObject::connect(&parser, &RecordParser::parsed, &parser, [&] {
+		parser.setPaused(true);
+		parser.setPaused(false);
+	});
+
+	auto incoming = QByteArray("[\"a\"]\n[\"b\"]\n[\"c\"]\n");
+	parser.parseBytes(incoming, buffer);
+	QCOMPARE(readySpy.count(), 0);
+	QVERIFY(buffer.isEmpty());
+
+	QTRY_COMPARE(readySpy.count(), 3);
+
+	auto expected = QVariantList {QVariantList {"a"}, QVariantList {"b"}, QVariantList {"c"}};
+	QCOMPARE(spyValues(spy), expected);
+}
+
+void TestRecordParser::pauseAtEnd() { // NOLINT
+	auto parser = JsonLinesParser();
+	auto spy = QSignalSpy(&parser, &RecordParser::parsed);
+	parser.setBatched(true);
+	auto batchSpy = QSignalSpy(&parser, &RecordParser::parsedBatch);
+
+	auto buffer = QByteArray("[\"a\"]\n[\"b\"]\n[\"c\"]");
+	parser.setPaused(true);
+	parser.streamEnded(buffer);
+	buffer.clear();
+
+	QCOMPARE(batchSpy.count(), 0);
+
+	parser.setPaused(false);
+	QCOMPARE(spy.count(), 0);
+	QCOMPARE(batchSpy.count(), 1);
+	auto expected = QVariantList {QVariantList {"a"}, QVariantList {"b"}, QVariantList {"c"}};
+	QCOMPARE(batchSpy.at(0).at(0).toList(), expected);
+}
+
+QTEST_MAIN(TestRecordParser);
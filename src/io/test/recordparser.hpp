@@ -0,0 +1,17 @@
+#pragma once
+
+#include <qobject.h>
+#include <qtmetamacros.h>
+
+class TestRecordParser: public QObject {
+	Q_OBJECT;
+
+private slots:
+	void jsonLines();
+	void lengthPrefix_data(); // NOLINT
+	void lengthPrefix();
+	void oversizedFrame();
+	void pause();
+	void unpauseFromHandler();
+	void pauseAtEnd();
+};
@@ -66,31 +66,45 @@ void IpcServerConnection::onDisconnected() {
 }
 
 void IpcServerConnection::onReadyRead() {
-	this->stream.startTransaction();
-
-	this->stream.startTransaction();
-	IpcCommand command;
-	this->stream >> command;
-	if (!this->stream.commitTransaction()) return;
-
-	std::visit(
-	    [this]<typename Command>(Command& command) {
-		    if constexpr (std::is_same_v<std::monostate, Command>) {
-			    qCCritical(logIpc) << "Received invalid IPC command from" << this;
-			    this->socket->disconnectFromServer();
-		    } else {
-			    command.exec(this);
-		    }
-	    },
-	    command
-	);
-
-	if (!this->stream.commitTransaction()) return;
-
-	// async connections reparent
-	if (dynamic_cast<IpcServer*>(this->parent()) != nullptr) {
-		this->deleteLater();
+	// persistent clients may pipeline several commands into one read
+	this->flushDeferred = true;
+
+	while (true) {
+		this->stream.startTransaction();
+		IpcCommand command;
+		this->stream >> command;
+		if (!this->stream.commitTransaction()) break;
+
+		auto valid = std::visit(
+		    [this]<typename Command>(Command& command) {
+			    if constexpr (std::is_same_v<std::monostate, Command>) {
+				    qCCritical(logIpc) << "Received invalid IPC command from" << this;
+				    return false;
+			    } else {
+				    command.exec(this);
+				    return true;
+			    }
+		    },
+		    command
+		);
+
+		if (!valid) {
+			this->socket->disconnectFromServer();
+			break;
+		}
+
+		if (!this->persistent) {
+			// async connections reparent
+			if (dynamic_cast<IpcServer*>(this->parent()) != nullptr) {
+				this->deleteLater();
+			}
+
+			break;
+		}
 	}
+
+	this->flushDeferred = false;
+	this->socket->flush();
 }
 
 IpcClient::IpcClient(const QString& path) {
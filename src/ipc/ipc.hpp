@@ -114,23 +114,7 @@ namespace qs::ipc {
 QS_DECLARE_LOGGING_CATEGORY(logIpc);
 
 template <typename T>
-class MessageStream {
-public:
-	explicit MessageStream(QDataStream* stream, QLocalSocket* socket)
-	    : stream(stream)
-	    , socket(socket) {}
-
-	template <typename V>
-	MessageStream& operator<<(V value) {
-		*this->stream << T(value);
-		this->socket->flush();
-		return *this;
-	}
-
-private:
-	QDataStream* stream;
-	QLocalSocket* socket;
-};
+class MessageStream;
 
 class IpcServer: public QObject {
 	Q_OBJECT;
@@ -156,21 +140,42 @@ public:
 	template <typename T>
 	void respond(const T& message) {
 		this->stream << message;
-		this->socket->flush();
+		if (!this->flushDeferred) this->socket->flush();
 	}
 
 	template <typename T>
 	MessageStream<T> responseStream() {
-		return MessageStream<T>(&this->stream, this->socket);
+		return MessageStream<T>(this);
 	}
 
 	// public for access by nonlocal handlers
 	QLocalSocket* socket;
 	QDataStream stream;
+	// If set, the connection is kept open for more commands once a command completes.
+	bool persistent = false;
 
 private slots:
 	void onDisconnected();
 	void onReadyRead();
+
+private:
+	// Set while handling a read, so responses to every command in it share one flush.
+	bool flushDeferred = false;
+};
+
+template <typename T>
+class MessageStream {
+public:
+	explicit MessageStream(IpcServerConnection* conn): conn(conn) {}
+
+	template <typename V>
+	MessageStream& operator<<(V value) {
+		this->conn->respond(T(value));
+		return *this;
+	}
+
+private:
+	IpcServerConnection* conn;
 };
 
 class IpcClient: public QObject {
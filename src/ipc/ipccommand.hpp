@@ -17,6 +17,7 @@ using IpcCommand = std::variant<
     qs::io::ipc::comm::QueryMetadataCommand,
     qs::io::ipc::comm::StringCallCommand,
     qs::io::ipc::comm::SignalListenCommand,
-    qs::io::ipc::comm::StringPropReadCommand>;
+    qs::io::ipc::comm::StringPropReadCommand,
+    qs::io::ipc::comm::StringCallBatchCommand>;
 
 } // namespace qs::ipc
@@ -19,8 +19,10 @@
 #include <qlogging.h>
 #include <qloggingcategory.h>
 #include <qnamespace.h>
+#include <qpair.h>
 #include <qstandardpaths.h>
 #include <qtenvironmentvariables.h>
+#include <qthread.h>
 #include <qtversion.h>
 #include <unistd.h>
 
@@ -300,7 +302,29 @@ int selectInstance(
 	return 0;
 }
 
+bool parseLogTime(const QString& str, QDateTime* time) {
+	if (str.isEmpty()) return true;
+
+	*time = QDateTime::fromString(str, Qt::ISODate);
+
+	if (!time->isValid()) {
+		auto timeOfDay = QTime::fromString(str, Qt::ISODate);
+		if (timeOfDay.isValid()) *time = QDateTime(QDate::currentDate(), timeOfDay);
+	}
+
+	if (!time->isValid()) {
+		qCCritical(logBare) << "Could not parse time" << str;
+		return false;
+	}
+
+	return true;
+}
+
 int readLogFile(CommandState& cmd) {
+	auto since = QDateTime();
+	auto until = QDateTime();
+	if (!parseLogTime(*cmd.log.since, &since) || !parseLogTime(*cmd.log.until, &until)) return -1;
+
 	auto path = *cmd.log.file;
 
 	if (path.isEmpty()) {
@@ -322,6 +346,8 @@ int readLogFile(CommandState& cmd) {
 	           path,
 	           cmd.log.timestamp,
 	           cmd.log.tail,
+	           since,
+	           until,
 	           cmd.log.follow,
 	           *cmd.log.readoutRules
 	       )
@@ -329,6 +355,75 @@ int readLogFile(CommandState& cmd) {
 	         : -1;
 }
 
+int searchLogs(CommandState& cmd) {
+	auto query = qs::log::LogSearchQuery();
+	if (!parseLogTime(*cmd.log.since, &query.since) || !parseLogTime(*cmd.log.until, &query.until)) {
+		return -1;
+	}
+
+	query.pattern = *cmd.search.pattern;
+	query.ignoreCase = cmd.search.ignoreCase;
+	query.rules = *cmd.log.readoutRules;
+
+	for (auto& category: cmd.search.categories) {
+		query.categories.append(*category);
+	}
+
+	auto& level = *cmd.search.level;
+	if (level == "info") query.level = QtInfoMsg;
+	else if (level == "warn") query.level = QtWarningMsg;
+	else if (level == "error") query.level = QtCriticalMsg;
+
+	auto* basePath = QsPaths::instance()->baseRunDir();
+	if (!basePath) return -1; // NOLINT
+
+	QString path;
+	QString configFilePath;
+	if (cmd.instance.all) {
+		path = basePath->filePath("by-pid");
+	} else {
+		auto r = locateConfigFile(cmd, configFilePath);
+
+		if (r != 0) {
+			qCInfo(logBare) << "Use --all to search all instances.";
+			return r;
+		}
+
+		auto pathId =
+		    QCryptographicHash::hash(configFilePath.toUtf8(), QCryptographicHash::Md5).toHex();
+
+		path = QDir(basePath->filePath("by-path")).filePath(pathId);
+	}
+
+	// Logs of dead instances and instances on other displays are searched as well.
+	auto [liveInstances, mismatchedInstances, deadInstances] = QsPaths::collectInstances(path, "");
+
+	auto instances = liveInstances + mismatchedInstances + deadInstances;
+	sortInstances(instances, false);
+
+	auto logs = QList<QPair<QString, QString>>();
+	for (auto& instance: instances) {
+		auto logPath = QDir(QsPaths::basePath(instance.instance.instanceId)).filePath("log.qslog");
+
+		// Instances launched with --no-detailed-logs have nothing to search.
+		if (QFileInfo::exists(logPath)) logs.append({instance.instance.instanceId, logPath});
+	}
+
+	if (logs.isEmpty()) {
+		if (cmd.instance.all) {
+			qCInfo(logBare) << "No instance logs to search.";
+		} else {
+			qCInfo(logBare) << "No instance logs to search for" << configFilePath;
+			qCInfo(logBare) << "Use --all to search all instances.";
+		}
+
+		return -1;
+	}
+
+	auto threads = cmd.search.jobs > 0 ? cmd.search.jobs : QThread::idealThreadCount();
+	return qs::log::searchEncodedLogs(logs, query, cmd.log.timestamp, threads) ? 0 : -1;
+}
+
 int listInstances(CommandState& cmd) {
 	auto* basePath = QsPaths::instance()->baseRunDir();
 	if (!basePath) return -1; // NOLINT
@@ -452,6 +547,8 @@ int ipcCommand(CommandState& cmd) {
 			return qs::io::ipc::comm::listenToSignal(&client, *cmd.ipc.target, *cmd.ipc.name, true);
 		} else if (*cmd.ipc.listen) {
 			return qs::io::ipc::comm::listenToSignal(&client, *cmd.ipc.target, *cmd.ipc.name, false);
+		} else if (cmd.ipc.fromStdin) {
+			return qs::io::ipc::comm::callFunctionsFromStdin(&client);
 		} else {
 			QVector<QString> arguments;
 			for (auto& arg: cmd.ipc.arguments) {
@@ -561,6 +658,8 @@ int runCommand(int argc, char** argv, QCoreApplication* coreApplication) {
 		} else {
 			qCInfo(logBare).noquote() << qs::debuginfo::combinedInfo();
 		}
+	} else if (*state.subcommand.logSearch) {
+		return searchLogs(state);
 	} else if (*state.subcommand.log) {
 		return readLogFile(state);
 	} else if (*state.subcommand.list) {
@@ -39,12 +39,22 @@ struct CommandState {
 		bool sparse = false;
 		size_t verbosity = 0;
 		int tail = 0;
+		QStringOption since;
+		QStringOption until;
 		bool follow = false;
 		QStringOption rules;
 		QStringOption readoutRules;
 		QStringOption file;
 	} log;
 
+	struct {
+		QStringOption pattern;
+		bool ignoreCase = false;
+		std::vector<QStringOption> categories;
+		QStringOption level;
+		int jobs = 0;
+	} search;
+
 	struct {
 		QStringOption path;
 		QStringOption manifest;
@@ -77,6 +87,7 @@ struct CommandState {
 		CLI::App* wait = nullptr;
 		CLI::App* listen = nullptr;
 		bool showOld = false;
+		bool fromStdin = false;
 		QStringOption target;
 		QStringOption name;
 		std::vector<QStringOption> arguments;
@@ -84,6 +95,7 @@ struct CommandState {
 
 	struct {
 		CLI::App* log = nullptr;
+		CLI::App* logSearch = nullptr;
 		CLI::App* list = nullptr;
 		CLI::App* kill = nullptr;
 		CLI::App* msg = nullptr;
@@ -155,6 +155,14 @@ int parseCommand(int argc, char** argv, CommandState& state) {
 		    ->description("Maximum number of lines to print, starting from the bottom.")
 		    ->check(CLI::Range(1, std::numeric_limits<int>::max(), "INT > 0"));
 
+		sub->add_option("--since", state.log.since)
+		    ->description("Only print messages logged at or after the given time.\n"
+		                  "Accepts an ISO 8601 date and time, or a time of day for today.");
+
+		sub->add_option("--until", state.log.until)
+		    ->description("Only print messages logged at or before the given time.\n"
+		                  "Accepts the same formats as --since.");
+
 		sub->add_flag("-f,--follow", state.log.follow)
 		    ->description("Keep reading the log until the logging process terminates.");
 
@@ -166,6 +174,55 @@ int parseCommand(int argc, char** argv, CommandState& state) {
 		addLoggingOptions(sub, false);
 
 		state.subcommand.log = sub;
+
+		{
+			auto* search = sub->add_subcommand("search", "Search the logs of many instances at once.");
+
+			search->add_option("pattern", state.search.pattern)
+			    ->description("Regular expression to match against message bodies.");
+
+			search->add_flag("-i,--ignore-case", state.search.ignoreCase)
+			    ->description("Match the pattern case insensitively.");
+
+			search->add_option("--category", state.search.categories)
+			    ->description("Only include categories matching the given wildcard pattern.\n"
+			                  "May be passed more than once to include more categories.");
+
+			search->add_option("--level", state.search.level)
+			    ->description("Only include messages of at least the given level.")
+			    ->check(CLI::IsMember({"debug", "info", "warn", "error"}));
+
+			search->add_option("--since", state.log.since)
+			    ->description("Only include messages logged at or after the given time.\n"
+			                  "Accepts an ISO 8601 date and time, or a time of day for today.");
+
+			search->add_option("--until", state.log.until)
+			    ->description("Only include messages logged at or before the given time.\n"
+			                  "Accepts the same formats as --since.");
+
+			search->add_option("-r,--rules", state.log.readoutRules)
+			    ->description(
+			        "Rules to apply to the logs being read, in the format of QT_LOGGING_RULES."
+			    );
+
+			search->add_option("-j,--jobs", state.search.jobs)
+			    ->description(
+			        "Number of logs to decode at once.\n"
+			        "Defaults to the number of CPU threads."
+			    )
+			    ->check(CLI::Range(1, std::numeric_limits<int>::max(), "INT > 0"));
+
+			auto* all = search->add_flag("-a,--all", state.instance.all)
+			                ->description(
+			                    "Search the logs of all instances.\n"
+			                    "If unspecified, only instances of the selected config will be searched."
+			                );
+
+			addConfigSelection(search)->excludes(all);
+			addLoggingOptions(search, false);
+
+			state.subcommand.logSearch = search;
+		}
 	}
 
 	{
@@ -217,14 +274,25 @@ int parseCommand(int argc, char** argv, CommandState& state) {
 			auto* call = sub->add_subcommand("call", "Call an IpcHandler function.");
 			state.ipc.call = call;
 
-			call->add_option("target", state.ipc.target, "The target to message.");
+			auto* target = call->add_option("target", state.ipc.target, "The target to message.");
 
-			call->add_option("function", state.ipc.name)
-			    ->description("The function to call in the target.");
+			auto* function = call->add_option("function", state.ipc.name)
+			                     ->description("The function to call in the target.");
 
-			call->add_option("arguments", state.ipc.arguments)
-			    ->description("Arguments to the called function.")
-			    ->allow_extra_args();
+			auto* arguments = call->add_option("arguments", state.ipc.arguments)
+			                      ->description("Arguments to the called function.")
+			                      ->allow_extra_args();
+
+			call->add_flag("--stdin", state.ipc.fromStdin)
+			    ->description(
+			        "Read calls from stdin as lines of `target function [arguments...]` and run them "
+			        "through a single connection, printing one line of output per call.\n"
+			        "Void and failed calls print an empty line. Backslashes and line breaks in "
+			        "results are escaped as `\\\\`, `\\n` and `\\r`."
+			    )
+			    ->excludes(target)
+			    ->excludes(function)
+			    ->excludes(arguments);
 		}
 
 		auto signalCmd = [&](std::string cmd, std::string desc) {
@@ -1,74 +1,81 @@
 #include "dbusimage.hpp"
 
+#include <qbytearray.h>
 #include <qdbusargument.h>
 #include <qimage.h>
 #include <qloggingcategory.h>
 #include <qsize.h>
-#include <qsysinfo.h>
 #include <qtypes.h>
 
 #include "../../core/logcat.hpp"
+#include "../../dbus/image.hpp"
 
 namespace qs::service::notifications {
 
 // NOLINTNEXTLINE(misc-use-internal-linkage)
 QS_DECLARE_LOGGING_CATEGORY(logNotifications); // server.cpp
 
-QImage DBusNotificationImage::createImage() const {
-	auto format = this->hasAlpha ? QImage::Format_RGBA8888 : QImage::Format_RGB888;
+namespace {
 
-	return QImage(
-	    reinterpret_cast<const uchar*>(this->data.data()),
-	    this->width,
-	    this->height,
-	    format
-	);
-}
+// Notification images are displayed far smaller than the avatars some apps send.
+const QSize MAX_IMAGE_SIZE = QSize(512, 512);
+
+} // namespace
 
 const QDBusArgument& operator>>(const QDBusArgument& argument, DBusNotificationImage& pixmap) {
 	argument.beginStructure();
-	argument >> pixmap.width;
-	argument >> pixmap.height;
+	auto width = qdbus_cast<qint32>(argument);
+	auto height = qdbus_cast<qint32>(argument);
 	auto rowstride = qdbus_cast<qint32>(argument);
-	argument >> pixmap.hasAlpha;
+	auto hasAlpha = qdbus_cast<bool>(argument);
 	auto sampleBits = qdbus_cast<qint32>(argument);
 	auto channels = qdbus_cast<qint32>(argument);
-	argument >> pixmap.data;
+	auto data = qdbus_cast<QByteArray>(argument);
 	argument.endStructure();
 
+	pixmap.image = QImage();
+
 	if (sampleBits != 8) {
 		qCWarning(logNotifications) << "Unable to parse pixmap as sample count is incorrect. Got"
 		                            << sampleBits << "expected" << 8;
-	} else if (channels != (pixmap.hasAlpha ? 4 : 3)) {
+	} else if (channels != (hasAlpha ? 4 : 3)) {
 		qCWarning(logNotifications) << "Unable to parse pixmap as channel count is incorrect."
-		                            << "Got " << channels << "expected" << (pixmap.hasAlpha ? 4 : 3);
-	} else if (rowstride != pixmap.width * channels) {
-		qCWarning(logNotifications) << "Unable to parse pixmap as rowstride is incorrect. Got"
-		                            << rowstride << "expected" << (pixmap.width * channels);
+		                            << "Got " << channels << "expected" << (hasAlpha ? 4 : 3);
+	} else {
+		auto info = dbus::DBusImageInfo {
+		    .width = width,
+		    .height = height,
+		    .stride = rowstride,
+		    .layout = hasAlpha ? dbus::DBusImageLayout::Rgba8888 : dbus::DBusImageLayout::Rgb888,
+		};
+
+		pixmap.image = dbus::ingestDBusImage(info, data, MAX_IMAGE_SIZE);
 	}
 
 	return argument;
 }
 
 const QDBusArgument& operator<<(QDBusArgument& argument, const DBusNotificationImage& pixmap) {
+	auto hasAlpha = pixmap.image.hasAlphaChannel();
+	auto image =
+	    pixmap.image.convertToFormat(hasAlpha ? QImage::Format_RGBA8888 : QImage::Format_RGB888);
+
 	argument.beginStructure();
-	argument << pixmap.width;
-	argument << pixmap.height;
-	argument << pixmap.width * (pixmap.hasAlpha ? 4 : 3);
-	argument << pixmap.hasAlpha;
+	argument << image.width();
+	argument << image.height();
+	argument << static_cast<qint32>(image.bytesPerLine());
+	argument << hasAlpha;
 	argument << 8;
-	argument << (pixmap.hasAlpha ? 4 : 3);
-	argument << pixmap.data;
+	argument << (hasAlpha ? 4 : 3);
+	argument << QByteArray(reinterpret_cast<const char*>(image.constBits()), image.sizeInBytes());
 	argument.endStructure();
 	return argument;
 }
 
 QImage
 NotificationImage::requestImage(const QString& /*unused*/, QSize* size, const QSize& /*unused*/) {
-	auto image = this->image.createImage();
-
-	if (size != nullptr) *size = image.size();
-	return image;
+	if (size != nullptr) *size = this->image.image.size();
+	return this->image.image;
 }
 
 } // namespace qs::service::notifications
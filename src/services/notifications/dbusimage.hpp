@@ -9,24 +9,22 @@
 namespace qs::service::notifications {
 
 struct DBusNotificationImage {
-	qint32 width = 0;
-	qint32 height = 0;
-	bool hasAlpha = false;
-	QByteArray data;
-
-	// valid only for the lifetime of the pixmap
-	[[nodiscard]] QImage createImage() const;
+	// Ingested through qs::dbus::ingestDBusImage, so it is premultiplied and size limited.
+	QImage image;
 };
 
 const QDBusArgument& operator>>(const QDBusArgument& argument, DBusNotificationImage& pixmap);
+// Serializes the ingested image, not the data it was read from. Images scaled down on receipt
+// keep their reduced size, and opaque images are sent without an alpha channel.
 const QDBusArgument& operator<<(QDBusArgument& argument, const DBusNotificationImage& pixmap);
 
 class NotificationImage: public QsIndexedImageHandle {
 public:
 	explicit NotificationImage(): QsIndexedImageHandle(QQuickAsyncImageProvider::Image) {}
 
-	[[nodiscard]] bool hasData() const { return !this->image.data.isEmpty(); }
-	void clear() { this->image.data.clear(); }
+	[[nodiscard]] bool hasData() const { return !this->image.image.isNull(); }
+	void clear() { this->image.image = QImage(); }
+	[[nodiscard]] qsizetype memoryUsage() const { return this->image.image.sizeInBytes(); }
 
 	[[nodiscard]] DBusNotificationImage& writeImage() {
 		this->imageChanged();
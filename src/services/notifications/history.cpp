@@ -0,0 +1,477 @@
+#include "history.hpp"
+#include <cerrno>
+
+#include <qabstractitemmodel.h>
+#include <qbytearray.h>
+#include <qcontainerfwd.h>
+#include <qdatastream.h>
+#include <qdatetime.h>
+#include <qendian.h>
+#include <qfile.h>
+#include <qiodevice.h>
+#include <qlist.h>
+#include <qlogging.h>
+#include <qloggingcategory.h>
+#include <qnamespace.h>
+#include <qobject.h>
+#include <qstring.h>
+#include <qtclasshelpermacros.h>
+#include <qtypes.h>
+#include <qvariant.h>
+#include <sys/file.h>
+
+#include "../../core/logcat.hpp"
+#include "../../core/paths.hpp"
+#include "notification.hpp"
+
+namespace qs::service::notifications {
+
+namespace {
+QS_LOGGING_CATEGORY(
+    logNotificationHistory,
+    "quickshell.service.notifications.history",
+    QtWarningMsg
+);
+
+constexpr quint32 HISTORY_MAGIC = 0x51534e48; // QSNH
+constexpr quint32 HISTORY_VERSION = 2;
+// magic, version and generation
+constexpr qint64 HEADER_SIZE = sizeof(quint32) * 3;
+constexpr qint64 LENGTH_SIZE = sizeof(quint32);
+// Amount of the file read at once while indexing.
+constexpr qint64 INDEX_CHUNK_SIZE = 64 * 1024;
+constexpr qsizetype PAGE_SIZE = 64;
+constexpr qsizetype CACHED_PAGES = 4;
+
+QByteArray serializeEntry(const NotificationHistoryEntry& entry) {
+	auto data = QByteArray();
+	auto stream = QDataStream(&data, QIODevice::WriteOnly);
+	stream.setVersion(QDataStream::Qt_6_0);
+
+	stream << entry.id << entry.time << entry.appName << entry.appIcon << entry.summary
+	       << entry.body << entry.desktopEntry << static_cast<quint8>(entry.urgency);
+
+	return data;
+}
+
+// Exclusive advisory lock on the history file, held for the lifetime of the object.
+class HistoryLock {
+public:
+	explicit HistoryLock(QFile* file): fd(file->handle()) {
+		while (flock(this->fd, LOCK_EX) == -1 && errno == EINTR) {}
+	}
+
+	~HistoryLock() { flock(this->fd, LOCK_UN); }
+	Q_DISABLE_COPY_MOVE(HistoryLock);
+
+private:
+	int fd;
+};
+
+bool deserializeEntry(const QByteArray& data, NotificationHistoryEntry& entry) {
+	auto stream = QDataStream(data);
+	stream.setVersion(QDataStream::Qt_6_0);
+
+	quint8 urgency = 0;
+	stream >> entry.id >> entry.time >> entry.appName >> entry.appIcon >> entry.summary
+	    >> entry.body >> entry.desktopEntry >> urgency;
+
+	entry.urgency = static_cast<NotificationUrgency::Enum>(urgency);
+	return stream.status() == QDataStream::Ok;
+}
+
+} // namespace
+
+NotificationHistoryEntry
+NotificationHistoryEntry::fromNotification(const Notification* notification) {
+	return NotificationHistoryEntry {
+	    .id = notification->id(),
+	    .time = notification->time(),
+	    .appName = notification->bindableAppName().value(),
+	    .appIcon = notification->bindableAppIcon().value(),
+	    .summary = notification->bindableSummary().value(),
+	    .body = notification->bindableBody().value(),
+	    .desktopEntry = notification->bindableDesktopEntry().value(),
+	    .urgency = notification->bindableUrgency().value(),
+	};
+}
+
+NotificationHistoryFile* NotificationHistoryFile::instance() {
+	static auto* instance = new NotificationHistoryFile( // NOLINT
+	    QsPaths::instance()->shellStateDir().filePath("notifications.history")
+	);
+
+	return instance;
+}
+
+bool NotificationHistoryFile::open() {
+	if (this->opened) return true;
+	if (this->failed) return false;
+
+	this->file.setFileName(this->path);
+
+	// Unbuffered so nothing written by other instances is missed.
+	if (!this->file.open(QIODevice::ReadWrite | QIODevice::Unbuffered)) {
+		qCWarning(logNotificationHistory)
+		    << "Could not open notification history" << this->path << this->file.errorString();
+		this->failed = true;
+		return false;
+	}
+
+	this->opened = true;
+	return true;
+}
+
+bool NotificationHistoryFile::writeHeader() {
+	auto stream = QDataStream(&this->file);
+	this->file.seek(0);
+	stream << HISTORY_MAGIC << HISTORY_VERSION << this->generation;
+
+	if (stream.status() != QDataStream::Ok) {
+		qCWarning(logNotificationHistory)
+		    << "Could not write notification history" << this->path << this->file.errorString();
+		this->failed = true;
+		return false;
+	}
+
+	this->offsets.clear();
+	this->indexedSize = HEADER_SIZE;
+	return true;
+}
+
+bool NotificationHistoryFile::sync() {
+	auto size = this->file.size();
+	auto wasIndexed = this->indexedSize != 0;
+
+	if (size == 0) {
+		if (!this->writeHeader()) return false;
+		return wasIndexed;
+	}
+
+	auto stream = QDataStream(&this->file);
+	this->file.seek(0);
+
+	quint32 magic = 0;
+	quint32 version = 0;
+	quint32 generation = 0;
+	stream >> magic >> version >> generation;
+
+	if (stream.status() != QDataStream::Ok || magic != HISTORY_MAGIC
+	    || version != HISTORY_VERSION)
+	{
+		qCWarning(logNotificationHistory)
+		    << "Discarding notification history" << this->path << "with unknown format";
+
+		this->file.resize(0);
+		this->generation++;
+		if (!this->writeHeader()) return false;
+		return wasIndexed;
+	}
+
+	if (generation != this->generation || size < this->indexedSize || !wasIndexed) {
+		// Cleared by another instance, or not indexed yet.
+		this->generation = generation;
+		this->offsets.clear();
+		this->indexEntries(HEADER_SIZE);
+		return wasIndexed;
+	}
+
+	if (size == this->indexedSize) return false;
+
+	this->indexEntries(this->indexedSize);
+	return true;
+}
+
+void NotificationHistoryFile::indexEntries(qint64 from) {
+	auto size = this->file.size();
+	auto offset = from;
+
+	// The file is unbuffered, so entry lengths are picked out of larger chunks.
+	auto chunk = QByteArray();
+	auto chunkStart = from;
+
+	while (offset + LENGTH_SIZE <= size) {
+		if (offset + LENGTH_SIZE > chunkStart + chunk.size()) {
+			chunkStart = offset;
+			this->file.seek(offset);
+			chunk = this->file.read(qMin(INDEX_CHUNK_SIZE, size - offset));
+			if (chunk.size() < LENGTH_SIZE) break;
+		}
+
+		auto length = qFromBigEndian<quint32>(chunk.constData() + (offset - chunkStart)); // NOLINT
+		auto next = offset + LENGTH_SIZE + length;
+		if (next > size) break;
+
+		this->offsets.append(offset);
+		offset = next;
+	}
+
+	if (offset != size) {
+		// Entries are written while locked, so this was left by a write that did not finish,
+		// such as when quickshell was killed.
+		qCWarning(logNotificationHistory)
+		    << "Truncating incomplete entry at the end of notification history" << this->path;
+		this->file.resize(offset);
+	}
+
+	this->indexedSize = offset;
+
+	qCDebug(logNotificationHistory) << "Indexed" << this->offsets.length()
+	                                << "notification history entries from" << this->path;
+}
+
+void NotificationHistoryFile::append(const NotificationHistoryEntry& entry) {
+	if (!this->open()) return;
+
+	auto data = serializeEntry(entry);
+	auto reloaded = false;
+
+	{
+		auto lock = HistoryLock(&this->file);
+		reloaded = this->sync();
+		if (this->failed) return;
+
+		auto offset = this->indexedSize;
+		this->file.seek(offset);
+		auto stream = QDataStream(&this->file);
+		stream << static_cast<quint32>(data.size());
+		stream.writeRawData(data.constData(), static_cast<int>(data.size()));
+
+		if (stream.status() != QDataStream::Ok) {
+			qCWarning(logNotificationHistory) << "Could not append notification" << entry.id
+			                                  << "to history" << this->path << this->file.errorString();
+			this->file.resize(offset);
+			return;
+		}
+
+		this->offsets.append(offset);
+		this->indexedSize = offset + LENGTH_SIZE + data.size();
+
+		// Compacted with some slack, so the file is not rewritten on every append.
+		if (this->offsets.length() > this->maxEntries + this->maxEntries / 4
+		    || this->indexedSize > this->maxBytes + this->maxBytes / 4)
+		{
+			reloaded = this->compact() || reloaded;
+		}
+	}
+
+	if (reloaded) emit this->reloaded();
+	else emit this->appended();
+}
+
+bool NotificationHistoryFile::compact() {
+	qsizetype drop = 0;
+	while (drop != this->offsets.length()
+	       && (this->offsets.length() - drop > this->maxEntries
+	           || HEADER_SIZE + this->indexedSize - this->offsets.at(drop) > this->maxBytes))
+	{
+		drop++;
+	}
+
+	if (drop == 0) return false;
+
+	auto keepFrom = drop == this->offsets.length() ? this->indexedSize : this->offsets.at(drop);
+	this->file.seek(keepFrom);
+	auto data = this->file.read(this->indexedSize - keepFrom);
+
+	if (data.size() != this->indexedSize - keepFrom) {
+		qCWarning(logNotificationHistory) << "Could not read notification history" << this->path
+		                                  << this->file.errorString();
+		return false;
+	}
+
+	qCDebug(logNotificationHistory) << "Dropping" << drop << "old entries from notification history"
+	                                << this->path;
+
+	auto offsets = this->offsets.sliced(drop);
+	for (auto& offset: offsets) {
+		offset -= keepFrom - HEADER_SIZE;
+	}
+
+	// A new generation makes other instances reindex the file.
+	this->generation++;
+	if (!this->writeHeader()) return true;
+
+	if (this->file.write(data) != data.size() || !this->file.resize(HEADER_SIZE + data.size())) {
+		qCWarning(logNotificationHistory) << "Could not write notification history" << this->path
+		                                  << this->file.errorString();
+		this->failed = true;
+		return true;
+	}
+
+	this->offsets = offsets;
+	this->indexedSize = HEADER_SIZE + data.size();
+	return true;
+}
+
+void NotificationHistoryFile::clear() {
+	if (!this->open()) return;
+
+	{
+		auto lock = HistoryLock(&this->file);
+		// Picks up the current generation.
+		this->sync();
+		if (this->failed) return;
+
+		this->file.resize(0);
+		this->generation++;
+		if (!this->writeHeader()) return;
+	}
+
+	emit this->cleared();
+}
+
+qsizetype NotificationHistoryFile::count() {
+	if (!this->open()) return 0;
+
+	auto reloaded = false;
+	qsizetype count = 0;
+
+	{
+		auto lock = HistoryLock(&this->file);
+		reloaded = this->sync();
+		count = this->offsets.length();
+	}
+
+	if (reloaded) emit this->reloaded();
+	return count;
+}
+
+QList<NotificationHistoryEntry> NotificationHistoryFile::read(qsizetype index, qsizetype count) {
+	auto entries = QList<NotificationHistoryEntry>();
+	if (!this->open()) return entries;
+
+	auto reloaded = false;
+	auto data = QByteArray();
+
+	{
+		auto lock = HistoryLock(&this->file);
+		reloaded = this->sync();
+
+		auto end = qMin(index + count, this->offsets.length());
+
+		if (index < end) {
+			auto start = this->offsets.at(index);
+			auto stop = end == this->offsets.length() ? this->indexedSize : this->offsets.at(end);
+
+			// Read all requested entries at once, as the file is unbuffered.
+			this->file.seek(start);
+			data = this->file.read(stop - start);
+
+			if (data.size() != stop - start) {
+				qCWarning(logNotificationHistory) << "Could not read notification history" << this->path
+				                                  << this->file.errorString();
+				data.clear();
+			}
+		}
+	}
+
+	qsizetype offset = 0;
+	while (offset + LENGTH_SIZE <= data.size()) {
+		const auto* start = data.constData() + offset; // NOLINT
+		auto length = qFromBigEndian<quint32>(start);
+		auto record = QByteArray::fromRawData(start + LENGTH_SIZE, length); // NOLINT
+
+		auto entry = NotificationHistoryEntry();
+		if (!deserializeEntry(record, entry)) {
+			qCWarning(logNotificationHistory)
+			    << "Could not read notification history entry" << index + entries.length();
+		}
+
+		entries.append(entry);
+		offset += LENGTH_SIZE + length;
+	}
+
+	if (reloaded) emit this->reloaded();
+	return entries;
+}
+
+NotificationHistoryModel::NotificationHistoryModel(QObject* parent)
+    : QAbstractListModel(parent)
+    , pages(CACHED_PAGES) {
+	auto* history = NotificationHistoryFile::instance();
+	this->mCount = history->count();
+
+	// clang-format off
+	QObject::connect(history, &NotificationHistoryFile::appended, this, &NotificationHistoryModel::onAppended);
+	QObject::connect(history, &NotificationHistoryFile::cleared, this, &NotificationHistoryModel::onReset);
+	// May be emitted while reading entries for data(), so the reset waits until that is done.
+	QObject::connect(history, &NotificationHistoryFile::reloaded, this, &NotificationHistoryModel::onReset, Qt::QueuedConnection);
+	// clang-format on
+}
+
+qint32 NotificationHistoryModel::rowCount(const QModelIndex& parent) const {
+	if (parent != QModelIndex()) return 0;
+	return static_cast<qint32>(this->mCount);
+}
+
+QVariant NotificationHistoryModel::data(const QModelIndex& index, qint32 role) const {
+	if (!index.isValid() || index.row() >= this->mCount) return QVariant();
+
+	// Rows are newest first, while the file is oldest first.
+	const auto* entry = this->entry(this->mCount - 1 - index.row());
+	if (entry == nullptr) return QVariant();
+
+	switch (role) {
+	case IdRole: return entry->id;
+	case TimeRole: return QDateTime::fromMSecsSinceEpoch(entry->time);
+	case AppNameRole: return entry->appName;
+	case AppIconRole: return entry->appIcon;
+	case SummaryRole: return entry->summary;
+	case BodyRole: return entry->body;
+	case DesktopEntryRole: return entry->desktopEntry;
+	case UrgencyRole: return QVariant::fromValue(entry->urgency);
+	default: return QVariant();
+	}
+}
+
+QHash<int, QByteArray> NotificationHistoryModel::roleNames() const {
+	return {
+	    {IdRole, "id"},
+	    {TimeRole, "time"},
+	    {AppNameRole, "appName"},
+	    {AppIconRole, "appIcon"},
+	    {SummaryRole, "summary"},
+	    {BodyRole, "body"},
+	    {DesktopEntryRole, "desktopEntry"},
+	    {UrgencyRole, "urgency"},
+	};
+}
+
+void NotificationHistoryModel::clear() { NotificationHistoryFile::instance()->clear(); }
+
+const NotificationHistoryEntry* NotificationHistoryModel::entry(qsizetype index) const {
+	auto page = index / PAGE_SIZE;
+	auto* entries = this->pages.object(page);
+
+	if (entries == nullptr) {
+		entries = new QList<NotificationHistoryEntry>(
+		    NotificationHistoryFile::instance()->read(page * PAGE_SIZE, PAGE_SIZE)
+		);
+
+		this->pages.insert(page, entries);
+	}
+
+	auto offset = index - page * PAGE_SIZE;
+	return offset < entries->length() ? &entries->at(offset) : nullptr;
+}
+
+void NotificationHistoryModel::onAppended() {
+	// The newest page may have been cached before the entry was added.
+	this->pages.remove(this->mCount / PAGE_SIZE);
+
+	this->beginInsertRows(QModelIndex(), 0, 0);
+	this->mCount++;
+	this->endInsertRows();
+	emit this->countChanged();
+}
+
+void NotificationHistoryModel::onReset() {
+	this->beginResetModel();
+	this->pages.clear();
+	this->mCount = NotificationHistoryFile::instance()->count();
+	this->endResetModel();
+	emit this->countChanged();
+}
+
+} // namespace qs::service::notifications
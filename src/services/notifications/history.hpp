@@ -0,0 +1,158 @@
+#pragma once
+
+#include <utility>
+
+#include <qabstractitemmodel.h>
+#include <qbytearray.h>
+#include <qcache.h>
+#include <qcontainerfwd.h>
+#include <qfile.h>
+#include <qhash.h>
+#include <qlist.h>
+#include <qnamespace.h>
+#include <qobject.h>
+#include <qqmlintegration.h>
+#include <qstring.h>
+#include <qtclasshelpermacros.h>
+#include <qtmetamacros.h>
+#include <qtypes.h>
+#include <qvariant.h>
+
+#include "notification.hpp"
+
+namespace qs::service::notifications {
+
+// The parts of a notification kept in the history. Images, actions and hints are not kept.
+struct NotificationHistoryEntry {
+	quint32 id = 0;
+	qint64 time = 0;
+	QString appName;
+	QString appIcon;
+	QString summary;
+	QString body;
+	QString desktopEntry;
+	NotificationUrgency::Enum urgency = NotificationUrgency::Normal;
+
+	static NotificationHistoryEntry fromNotification(const Notification* notification);
+};
+
+// Append-only file of notification history entries in the shell's state directory.
+//
+// Only the offset of each entry is kept in memory. Entries are read back on request.
+// Once the file is over its entry or size limit, the oldest entries are dropped.
+//
+// The file is shared by every instance of the shell, so it is locked during each operation.
+// Changes made by other instances are picked up by the next operation, which then emits
+// reloaded().
+class NotificationHistoryFile: public QObject {
+	Q_OBJECT;
+
+public:
+	// Use instance() outside of tests.
+	explicit NotificationHistoryFile(QString path, QObject* parent = nullptr)
+	    : QObject(parent)
+	    , path(std::move(path)) {}
+
+	static NotificationHistoryFile* instance();
+
+	void append(const NotificationHistoryEntry& entry);
+	void clear();
+
+	[[nodiscard]] qsizetype count();
+	// Reads up to count entries starting at index, in the order they were appended.
+	[[nodiscard]] QList<NotificationHistoryEntry> read(qsizetype index, qsizetype count);
+
+	// Defaults to 10000 entries and 8MiB.
+	void setLimits(qsizetype maxEntries, qint64 maxBytes) {
+		this->maxEntries = maxEntries;
+		this->maxBytes = maxBytes;
+	}
+
+signals:
+	void appended();
+	void cleared();
+	// Emitted when entries were appended or cleared by another instance, or old entries were dropped.
+	void reloaded();
+
+private:
+	bool open();
+	bool writeHeader();
+	// Updates the index to match the file, returning true if another instance changed it.
+	// Must be called while the file is locked.
+	bool sync();
+	void indexEntries(qint64 from);
+	// Drops the oldest entries until the file is within its limits, returning true if any were.
+	// Must be called while the file is locked.
+	bool compact();
+
+	QString path;
+	QFile file;
+	bool opened = false;
+	bool failed = false;
+	// Incremented when the file is cleared, so other instances know to reindex it.
+	quint32 generation = 0;
+	// End of the last indexed entry, or 0 before the file has been indexed.
+	qint64 indexedSize = 0;
+	QList<qint64> offsets;
+	qsizetype maxEntries = 10000;
+	qint64 maxBytes = 8 * 1024 * 1024;
+};
+
+///! Paged model of past notifications.
+/// Notifications moved out of memory by @@NotificationServer.trackedMemoryLimit
+/// are written to a history file in the shell's state directory, and can be viewed using
+/// this model.
+///
+/// Entries are ordered from newest to oldest, and are only read from disk when requested
+/// by a view, so large histories stay cheap. Each entry exposes the following roles:
+/// - `id`: The id the notification had.
+/// - `time`: When the notification was received, as a date.
+/// - `appName`, `appIcon`, `summary`, `body` and `desktopEntry`: As in @@Notification.
+/// - `urgency`: The @@NotificationUrgency of the notification.
+///
+/// Notifications with @@Notification.transient set are not kept in the history.
+class NotificationHistoryModel: public QAbstractListModel {
+	Q_OBJECT;
+	/// The number of notifications in the history.
+	Q_PROPERTY(qsizetype count READ count NOTIFY countChanged);
+	QML_NAMED_ELEMENT(NotificationHistory);
+
+public:
+	enum Role : quint16 {
+		IdRole = Qt::UserRole,
+		TimeRole,
+		AppNameRole,
+		AppIconRole,
+		SummaryRole,
+		BodyRole,
+		DesktopEntryRole,
+		UrgencyRole,
+	};
+
+	explicit NotificationHistoryModel(QObject* parent = nullptr);
+
+	[[nodiscard]] qint32 rowCount(const QModelIndex& parent = QModelIndex()) const override;
+	[[nodiscard]] QVariant data(const QModelIndex& index, qint32 role) const override;
+	[[nodiscard]] QHash<int, QByteArray> roleNames() const override;
+
+	[[nodiscard]] qsizetype count() const { return this->mCount; }
+
+	/// Deletes all entries from the history file.
+	Q_INVOKABLE static void clear();
+
+signals:
+	void countChanged();
+
+private slots:
+	void onAppended();
+	void onReset();
+
+private:
+	[[nodiscard]] const NotificationHistoryEntry* entry(qsizetype index) const;
+
+	qsizetype mCount = 0;
+	// Pages of entries by index in the file, least recently used evicted first.
+	mutable QCache<qsizetype, QList<NotificationHistoryEntry>> pages;
+};
+
+} // namespace qs::service::notifications
@@ -5,10 +5,13 @@
 #include <qlist.h>
 #include <qlogging.h>
 #include <qloggingcategory.h>
+#include <qmetatype.h>
 #include <qobject.h>
 #include <qproperty.h>
+#include <qstring.h>
 #include <qtmetamacros.h>
 #include <qtypes.h>
+#include <qvariant.h>
 
 #include "../../core/desktopentry.hpp"
 #include "../../core/iconimageprovider.hpp"
@@ -21,6 +24,38 @@ namespace qs::service::notifications {
 // NOLINTNEXTLINE(misc-use-internal-linkage)
 QS_DECLARE_LOGGING_CATEGORY(logNotifications); // server.cpp
 
+namespace {
+
+qsizetype stringMemoryUsage(const QString& string) {
+	return string.size() * static_cast<qsizetype>(sizeof(QChar));
+}
+
+// Rough estimate of the heap used by the contents of a hint.
+qsizetype variantMemoryUsage(const QVariant& value) {
+	switch (value.typeId()) {
+	case QMetaType::QString: return stringMemoryUsage(value.toString());
+	case QMetaType::QByteArray: return value.toByteArray().size();
+	case QMetaType::QVariantList: {
+		qsizetype size = 0;
+		for (const auto& item: value.toList()) {
+			size += static_cast<qsizetype>(sizeof(QVariant)) + variantMemoryUsage(item);
+		}
+		return size;
+	}
+	case QMetaType::QVariantMap: {
+		qsizetype size = 0;
+		for (const auto& [key, item]: value.toMap().asKeyValueRange()) {
+			size += stringMemoryUsage(key) + static_cast<qsizetype>(sizeof(QVariant))
+			      + variantMemoryUsage(item);
+		}
+		return size;
+	}
+	default: return 0;
+	}
+}
+
+} // namespace
+
 QString NotificationUrgency::toString(NotificationUrgency::Enum value) {
 	switch (value) {
 	case NotificationUrgency::Low: return "Low";
@@ -223,6 +258,18 @@ void Notification::updateProperties(
 
 	Qt::endPropertyUpdateGroup();
 
+	auto memoryUsage = stringMemoryUsage(appName) + stringMemoryUsage(this->bAppIcon.value())
+	                 + stringMemoryUsage(summary) + stringMemoryUsage(body)
+	                 + stringMemoryUsage(this->bImage.value()) + this->mImagePixmap.memoryUsage()
+	                 + variantMemoryUsage(hints);
+
+	for (auto* action: this->mActions) {
+		memoryUsage += static_cast<qsizetype>(sizeof(NotificationAction))
+		             + stringMemoryUsage(action->identifier()) + stringMemoryUsage(action->text());
+	}
+
+	this->mMemoryUsage = memoryUsage;
+
 	if (actionsChanged) emit this->actionsChanged();
 
 	for (auto* action: deletedActions) {
@@ -3,6 +3,7 @@
 #include <utility>
 
 #include <qcontainerfwd.h>
+#include <qdatetime.h>
 #include <qlist.h>
 #include <qmap.h>
 #include <qobject.h>
@@ -121,7 +122,10 @@ class Notification
 	QML_UNCREATABLE("Notifications must be acquired from a NotificationServer");
 
 public:
-	explicit Notification(quint32 id, QObject* parent): QObject(parent), mId(id) {}
+	explicit Notification(quint32 id, QObject* parent)
+	    : QObject(parent)
+	    , mId(id)
+	    , mTime(QDateTime::currentMSecsSinceEpoch()) {}
 
 	/// Destroy the notification and hint to the remote application that it has
 	/// timed out an expired.
@@ -151,6 +155,11 @@ public:
 	[[nodiscard]] quint32 id() const;
 	[[nodiscard]] bool isTracked() const;
 
+	// Time the notification was first received, in milliseconds since the epoch.
+	[[nodiscard]] qint64 time() const { return this->mTime; }
+	// Estimated heap usage of the notification's contents, updated by updateProperties.
+	[[nodiscard]] qsizetype memoryUsage() const { return this->mMemoryUsage; }
+
 	[[nodiscard]] bool isLastGeneration() const;
 	void setLastGeneration();
 
@@ -206,6 +215,8 @@ signals:
 
 private:
 	quint32 mId;
+	qint64 mTime;
+	qsizetype mMemoryUsage = 0;
 	NotificationCloseReason::Enum mCloseReason = NotificationCloseReason::Dismissed;
 	bool mLastGeneration = false;
 	NotificationImage mImagePixmap;
@@ -15,6 +15,7 @@ namespace qs::service::notifications {
 void NotificationServerQml::onPostReload() {
 	auto* instance = NotificationServer::instance();
 	instance->support = this->support;
+	instance->setTrackedMemoryLimit(this->mTrackedMemoryLimit);
 
 	QObject::connect(
 	    instance,
@@ -141,6 +142,19 @@ ObjectModel<Notification>* NotificationServerQml::trackedNotifications() const {
 	}
 }
 
+qint64 NotificationServerQml::trackedMemoryLimit() const { return this->mTrackedMemoryLimit; }
+
+void NotificationServerQml::setTrackedMemoryLimit(qint64 trackedMemoryLimit) {
+	if (trackedMemoryLimit == this->mTrackedMemoryLimit) return;
+	this->mTrackedMemoryLimit = trackedMemoryLimit;
+
+	if (this->live) {
+		NotificationServer::instance()->setTrackedMemoryLimit(trackedMemoryLimit);
+	}
+
+	emit this->trackedMemoryLimitChanged();
+}
+
 void NotificationServerQml::updateSupported() {
 	if (this->live) {
 		NotificationServer::instance()->support = this->support;
@@ -72,6 +72,12 @@ class NotificationServerQml: public PostReloadHook {
 	Q_PROPERTY(UntypedObjectModel* trackedNotifications READ trackedNotifications NOTIFY trackedNotificationsChanged);
 	/// Extra hints to expose to notification clients.
 	Q_PROPERTY(QVector<QString> extraHints READ extraHints WRITE setExtraHints NOTIFY extraHintsChanged);
+	/// Approximate memory in bytes that tracked notifications may use, including their images.
+	/// Defaults to 0, which disables the limit.
+	///
+	/// When the limit is exceeded, the oldest tracked notifications are expired and written to
+	/// the @@NotificationHistory, except for those with @@Notification.transient set.
+	Q_PROPERTY(qint64 trackedMemoryLimit READ trackedMemoryLimit WRITE setTrackedMemoryLimit NOTIFY trackedMemoryLimitChanged);
 	// clang-format on
 	QML_NAMED_ELEMENT(NotificationServer);
 
@@ -111,6 +117,9 @@ public:
 	[[nodiscard]] QVector<QString> extraHints() const;
 	void setExtraHints(QVector<QString> extraHints);
 
+	[[nodiscard]] qint64 trackedMemoryLimit() const;
+	void setTrackedMemoryLimit(qint64 trackedMemoryLimit);
+
 	[[nodiscard]] ObjectModel<Notification>* trackedNotifications() const;
 
 signals:
@@ -131,12 +140,14 @@ signals:
 	void inlineReplySupportedChanged();
 	void extraHintsChanged();
 	void trackedNotificationsChanged();
+	void trackedMemoryLimitChanged();
 
 private:
 	void updateSupported();
 
 	bool live = false;
 	bool mKeepOnReload = true;
+	qint64 mTrackedMemoryLimit = 0;
 	NotificationServerSupport support;
 };
 
@@ -18,6 +18,7 @@
 #include "../../core/model.hpp"
 #include "dbus_notifications.h"
 #include "dbusimage.hpp"
+#include "history.hpp"
 #include "notification.hpp"
 
 namespace qs::service::notifications {
@@ -68,6 +69,7 @@ void NotificationServer::switchGeneration(bool reEmit, const std::function<void(
 	auto notifications = this->mNotifications.valueList();
 	this->mNotifications.valueList().clear();
 	this->idMap.clear();
+	this->trackedMemory = 0;
 
 	clearHook();
 
@@ -83,8 +85,11 @@ void NotificationServer::switchGeneration(bool reEmit, const std::function<void(
 			} else {
 				this->idMap.insert(notification->id(), notification);
 				this->mNotifications.insertObject(notification);
+				this->trackedMemory += notification->memoryUsage();
 			}
 		}
+
+		this->enforceMemoryLimit();
 	} else {
 		for (auto* notification: notifications) {
 			emit this->NotificationClosed(notification->id(), NotificationCloseReason::Expired);
@@ -107,11 +112,46 @@ void NotificationServer::deleteNotification(
 
 	this->mNotifications.removeObject(notification);
 	this->idMap.remove(notification->id());
+	this->trackedMemory -= notification->memoryUsage();
 
 	emit this->NotificationClosed(notification->id(), reason);
 	notification->retainedDestroy();
 }
 
+void NotificationServer::setTrackedMemoryLimit(qint64 limit) {
+	if (limit == this->trackedMemoryLimit) return;
+	this->trackedMemoryLimit = limit;
+	this->enforceMemoryLimit();
+}
+
+void NotificationServer::enforceMemoryLimit(Notification* keep) {
+	if (this->trackedMemoryLimit <= 0) return;
+
+	auto* history = this->history ? this->history : NotificationHistoryFile::instance();
+
+	while (this->trackedMemory > this->trackedMemoryLimit) {
+		// Notifications are tracked in the order they were received.
+		Notification* oldest = nullptr;
+		for (auto* notification: this->mNotifications.valueList()) {
+			if (notification != keep) {
+				oldest = notification;
+				break;
+			}
+		}
+
+		if (oldest == nullptr) break;
+
+		qCDebug(logNotifications) << "Tracked notifications are using" << this->trackedMemory
+		                          << "bytes, moving" << oldest << "to history";
+
+		if (!oldest->bindableTransient().value()) {
+			history->append(NotificationHistoryEntry::fromNotification(oldest));
+		}
+
+		this->deleteNotification(oldest, NotificationCloseReason::Expired);
+	}
+}
+
 void NotificationServer::tryRegister() {
 	auto bus = QDBusConnection::sessionBus();
 	auto success = bus.registerService("org.freedesktop.Notifications");
@@ -190,10 +230,17 @@ uint NotificationServer::Notify(
 	if (!notification) {
 		notification = new Notification(this->nextId++, this);
 		QQmlEngine::setObjectOwnership(notification, QQmlEngine::CppOwnership);
+	} else {
+		this->trackedMemory -= notification->memoryUsage();
 	}
 
 	notification->updateProperties(appName, appIcon, summary, body, actions, hints, expireTimeout);
 
+	if (old) {
+		this->trackedMemory += notification->memoryUsage();
+		this->enforceMemoryLimit(notification);
+	}
+
 	auto id = notification->id();
 
 	if (!old) {
@@ -213,6 +260,8 @@ uint NotificationServer::Notify(
 		} else {
 			this->idMap.insert(id, notification);
 			this->mNotifications.insertObject(notification);
+			this->trackedMemory += notification->memoryUsage();
+			this->enforceMemoryLimit(notification);
 		}
 	}
 
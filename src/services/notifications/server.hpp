@@ -14,6 +14,8 @@
 
 namespace qs::service::notifications {
 
+class NotificationHistoryFile;
+
 struct NotificationServerSupport {
 	bool persistence = false;
 	bool body = true;
@@ -37,6 +39,15 @@ public:
 	ObjectModel<Notification>* trackedNotifications();
 	void deleteNotification(Notification* notification, NotificationCloseReason::Enum reason);
 
+	// Limit on the estimated memory used by tracked notifications, in bytes. 0 disables the limit.
+	void setTrackedMemoryLimit(qint64 limit);
+	// Estimated memory used by tracked notifications, in bytes.
+	[[nodiscard]] qint64 trackedMemoryUsage() const { return this->trackedMemory; }
+
+	// Replaces the history file notifications over the memory limit are moved into.
+	// Defaults to NotificationHistoryFile::instance(). Used by tests.
+	void setHistoryFile(NotificationHistoryFile* history) { this->history = history; }
+
 	// NOLINTBEGIN
 	void CloseNotification(uint id);
 	QStringList GetCapabilities() const;
@@ -72,10 +83,17 @@ private:
 
 	static void tryRegister();
 
+	// Moves the oldest tracked notifications other than keep into the history until
+	// the tracked memory limit is met.
+	void enforceMemoryLimit(Notification* keep = nullptr);
+
 	QDBusServiceWatcher serviceWatcher;
 	quint32 nextId = 1;
 	QHash<quint32, Notification*> idMap;
 	ObjectModel<Notification> mNotifications {this};
+	qint64 trackedMemory = 0;
+	qint64 trackedMemoryLimit = 0;
+	NotificationHistoryFile* history = nullptr;
 };
 
 } // namespace qs::service::notifications
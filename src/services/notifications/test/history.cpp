@@ -0,0 +1,228 @@
+#include "history.hpp"
+
+#include <qbytearray.h>
+#include <qdatastream.h>
+#include <qfile.h>
+#include <qiodevice.h>
+#include <qlist.h>
+#include <qobject.h>
+#include <qsignalspy.h>
+#include <qstring.h>
+#include <qtemporarydir.h>
+#include <qtest.h>
+#include <qtestcase.h>
+#include <qtypes.h>
+
+#include "../history.hpp"
+#include "../notification.hpp"
+
+using namespace qs::service::notifications;
+
+namespace {
+
+NotificationHistoryEntry makeEntry(quint32 id) {
+	return NotificationHistoryEntry {
+	    .id = id,
+	    .time = 1790000000000 + id,
+	    .appName = QString("app %1").arg(id % 3),
+	    .appIcon = "icon",
+	    .summary = QString("summary %1").arg(id),
+	    .body = id % 2 == 0 ? QString() : QString("body %1").arg(id),
+	    .desktopEntry = "org.quickshell.test",
+	    .urgency = id % 5 == 0 ? NotificationUrgency::Critical : NotificationUrgency::Normal,
+	};
+}
+
+bool sameEntry(const NotificationHistoryEntry& a, const NotificationHistoryEntry& b) {
+	return a.id == b.id && a.time == b.time && a.appName == b.appName && a.appIcon == b.appIcon
+	    && a.summary == b.summary && a.body == b.body && a.desktopEntry == b.desktopEntry
+	    && a.urgency == b.urgency;
+}
+
+bool hasIds(const QList<NotificationHistoryEntry>& entries, quint32 first, qsizetype count) {
+	if (entries.length() != count) return false;
+
+	for (auto i = 0; i != count; i++) {
+		if (!sameEntry(entries.at(i), makeEntry(first + i))) return false;
+	}
+
+	return true;
+}
+
+} // namespace
+
+void TestNotificationHistory::roundTrip() {
+	auto dir = QTemporaryDir();
+	QVERIFY(dir.isValid());
+	auto path = dir.filePath("history");
+
+	{
+		auto history = NotificationHistoryFile(path);
+		auto spy = QSignalSpy(&history, &NotificationHistoryFile::appended);
+
+		for (auto i = 0; i != 3; i++) history.append(makeEntry(i));
+
+		QCOMPARE(spy.count(), 3);
+		QCOMPARE(history.count(), 3);
+		QVERIFY(hasIds(history.read(0, 3), 0, 3));
+	}
+
+	// Reopened from disk.
+	auto history = NotificationHistoryFile(path);
+	QCOMPARE(history.count(), 3);
+	QVERIFY(hasIds(history.read(0, 10), 0, 3));
+	QVERIFY(hasIds(history.read(1, 1), 1, 1));
+	QVERIFY(history.read(3, 1).isEmpty());
+}
+
+void TestNotificationHistory::truncatedTail() {
+	auto dir = QTemporaryDir();
+	QVERIFY(dir.isValid());
+	auto path = dir.filePath("history");
+
+	qint64 completeSize = 0;
+
+	{
+		auto history = NotificationHistoryFile(path);
+		history.append(makeEntry(0));
+		history.append(makeEntry(1));
+		completeSize = QFile(path).size();
+	}
+
+	// An entry cut off partway through, as left by a killed instance.
+	{
+		auto file = QFile(path);
+		QVERIFY(file.open(QIODevice::Append));
+		auto stream = QDataStream(&file);
+		stream << static_cast<quint32>(100);
+		stream.writeRawData("partial", 7);
+	}
+
+	auto history = NotificationHistoryFile(path);
+	QCOMPARE(history.count(), 2);
+	QCOMPARE(QFile(path).size(), completeSize);
+
+	history.append(makeEntry(2));
+	QCOMPARE(history.count(), 3);
+	QVERIFY(hasIds(history.read(0, 3), 0, 3));
+}
+
+void TestNotificationHistory::badHeader_data() { // NOLINT
+	QTest::addColumn<QByteArray>("contents");
+	QTest::addRow("garbage") << QByteArray("not a notification history file");
+	QTest::addRow("short") << QByteArray("QS");
+	// Right magic, unknown version.
+	QTest::addRow("version") << QByteArray("QSNH\xff\xff\xff\xff\0\0\0\0", 12);
+}
+
+void TestNotificationHistory::badHeader() {
+	QFETCH(QByteArray, contents);
+
+	auto dir = QTemporaryDir();
+	QVERIFY(dir.isValid());
+	auto path = dir.filePath("history");
+
+	{
+		auto file = QFile(path);
+		QVERIFY(file.open(QIODevice::WriteOnly));
+		QCOMPARE(file.write(contents), contents.size());
+	}
+
+	auto history = NotificationHistoryFile(path);
+	QCOMPARE(history.count(), 0);
+
+	history.append(makeEntry(0));
+	QCOMPARE(history.count(), 1);
+	QVERIFY(hasIds(history.read(0, 1), 0, 1));
+
+	auto reopened = NotificationHistoryFile(path);
+	QVERIFY(hasIds(reopened.read(0, 1), 0, 1));
+}
+
+void TestNotificationHistory::paging() {
+	auto dir = QTemporaryDir();
+	QVERIFY(dir.isValid());
+
+	auto history = NotificationHistoryFile(dir.filePath("history"));
+	for (auto i = 0; i != 150; i++) history.append(makeEntry(i));
+
+	// The model reads pages of 64 entries.
+	QVERIFY(hasIds(history.read(0, 64), 0, 64));
+	QVERIFY(hasIds(history.read(64, 64), 64, 64));
+	QVERIFY(hasIds(history.read(128, 64), 128, 22));
+	QVERIFY(hasIds(history.read(60, 10), 60, 10));
+	QVERIFY(history.read(192, 64).isEmpty());
+}
+
+void TestNotificationHistory::sharedFile() {
+	auto dir = QTemporaryDir();
+	QVERIFY(dir.isValid());
+	auto path = dir.filePath("history");
+
+	auto first = NotificationHistoryFile(path);
+	auto second = NotificationHistoryFile(path);
+	auto reloadSpy = QSignalSpy(&second, &NotificationHistoryFile::reloaded);
+
+	QCOMPARE(first.count(), 0);
+	QCOMPARE(second.count(), 0);
+	QCOMPARE(reloadSpy.count(), 0);
+
+	first.append(makeEntry(0));
+	first.append(makeEntry(1));
+	QCOMPARE(second.count(), 2);
+	QCOMPARE(reloadSpy.count(), 1);
+	QVERIFY(hasIds(second.read(0, 2), 0, 2));
+
+	second.append(makeEntry(2));
+	QVERIFY(hasIds(first.read(0, 3), 0, 3));
+
+	// Clearing and appending more than was there must not be mistaken for an append.
+	first.clear();
+	for (auto i = 10; i != 15; i++) first.append(makeEntry(i));
+
+	QCOMPARE(second.count(), 5);
+	QCOMPARE(reloadSpy.count(), 2);
+	QVERIFY(hasIds(second.read(0, 5), 10, 5));
+}
+
+void TestNotificationHistory::compaction() {
+	auto dir = QTemporaryDir();
+	QVERIFY(dir.isValid());
+	auto path = dir.filePath("history");
+
+	auto history = NotificationHistoryFile(path);
+	history.setLimits(10, 1024 * 1024);
+	auto other = NotificationHistoryFile(path);
+	QCOMPARE(other.count(), 0);
+
+	auto appendSpy = QSignalSpy(&history, &NotificationHistoryFile::appended);
+	auto reloadSpy = QSignalSpy(&history, &NotificationHistoryFile::reloaded);
+
+	// Entries are allowed a quarter over the limit before the file is compacted.
+	for (auto i = 0; i != 12; i++) history.append(makeEntry(i));
+	QCOMPARE(history.count(), 12);
+	QCOMPARE(appendSpy.count(), 12);
+
+	history.append(makeEntry(12));
+	QCOMPARE(reloadSpy.count(), 1);
+	QCOMPARE(history.count(), 10);
+	QVERIFY(hasIds(history.read(0, 10), 3, 10));
+
+	// Compaction is seen by other instances.
+	QCOMPARE(other.count(), 10);
+	QVERIFY(hasIds(other.read(0, 10), 3, 10));
+
+	history.append(makeEntry(13));
+	QVERIFY(hasIds(other.read(0, 11), 3, 11));
+
+	// The size limit drops entries the same way.
+	auto size = QFile(path).size();
+	history.setLimits(1000, size / 2);
+	while (reloadSpy.count() == 1) history.append(makeEntry(14));
+
+	QVERIFY(QFile(path).size() <= size / 2);
+	QVERIFY(history.count() < 11);
+	QCOMPARE(history.read(history.count() - 1, 1).first().id, quint32(14));
+}
+
+QTEST_MAIN(TestNotificationHistory);
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <qobject.h>
+#include <qtmetamacros.h>
+
+class TestNotificationHistory: public QObject {
+	Q_OBJECT;
+
+private slots:
+	void roundTrip();
+	void truncatedTail();
+	void badHeader_data(); // NOLINT
+	void badHeader();
+	void paging();
+	void sharedFile();
+	void compaction();
+};
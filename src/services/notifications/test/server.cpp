@@ -0,0 +1,194 @@
+#include "server.hpp"
+#include <memory>
+
+#include <qcontainerfwd.h>
+#include <qlist.h>
+#include <qobject.h>
+#include <qsignalspy.h>
+#include <qstring.h>
+#include <qtenvironmentvariables.h>
+#include <qtest.h>
+#include <qtestcase.h>
+#include <qtypes.h>
+#include <qvariant.h>
+
+#include "../history.hpp"
+#include "../notification.hpp"
+#include "../server.hpp"
+
+using namespace qs::service::notifications;
+
+namespace {
+
+quint32 notify(const QString& summary, const QVariantMap& hints = {}, quint32 replacesId = 0) {
+	return NotificationServer::instance()
+	    ->Notify("test", replacesId, "", summary, "", QStringList(), hints, -1);
+}
+
+QStringList trackedSummaries() {
+	auto summaries = QStringList();
+
+	for (auto* notification: NotificationServer::instance()->trackedNotifications()->valueList()) {
+		summaries.append(notification->bindableSummary().value());
+	}
+
+	return summaries;
+}
+
+QStringList historySummaries(NotificationHistoryFile* history) {
+	auto summaries = QStringList();
+
+	for (const auto& entry: history->read(0, history->count())) {
+		summaries.append(entry.summary);
+	}
+
+	return summaries;
+}
+
+} // namespace
+
+void TestNotificationServer::initTestCase() {
+	// Keeps the server off the session bus, where it could replace the real notification daemon.
+	qputenv("DBUS_SESSION_BUS_ADDRESS", "unix:path=/nonexistent/quickshell-test");
+	NotificationServer::instance();
+
+	QVERIFY(this->dir.isValid());
+}
+
+void TestNotificationServer::init() {
+	auto path = this->dir.filePath(QString("history-%1").arg(this->historyCount++));
+	this->history = std::make_unique<NotificationHistoryFile>(path);
+
+	auto* server = NotificationServer::instance();
+	server->setHistoryFile(this->history.get());
+
+	// Tracks every notification, as a shell would.
+	this->trackConnection = QObject::connect(
+	    server,
+	    &NotificationServer::notification,
+	    server,
+	    [](Notification* notification) { notification->setTracked(true); }
+	);
+}
+
+void TestNotificationServer::cleanup() {
+	auto* server = NotificationServer::instance();
+	QObject::disconnect(this->trackConnection);
+	server->setTrackedMemoryLimit(0);
+	server->switchGeneration(false, []() {});
+	server->setHistoryFile(nullptr);
+	this->history.reset();
+}
+
+void TestNotificationServer::evictionOrder() {
+	auto* server = NotificationServer::instance();
+	auto closedSpy = QSignalSpy(server, &NotificationServer::NotificationClosed);
+
+	auto first = notify("n1");
+	notify("n2");
+	notify("n3");
+
+	QCOMPARE(trackedSummaries(), QStringList({"n1", "n2", "n3"}));
+	auto size = server->trackedMemoryUsage() / 3;
+	QVERIFY(size > 0);
+
+	// Oldest first.
+	server->setTrackedMemoryLimit(size * 2);
+	QCOMPARE(trackedSummaries(), QStringList({"n2", "n3"}));
+	QCOMPARE(server->trackedMemoryUsage(), size * 2);
+	QCOMPARE(historySummaries(this->history.get()), QStringList({"n1"}));
+
+	QCOMPARE(closedSpy.count(), 1);
+	QCOMPARE(closedSpy.at(0).at(0).toUInt(), first);
+	QCOMPARE(closedSpy.at(0).at(1).toUInt(), quint32(NotificationCloseReason::Expired));
+
+	notify("n4");
+	QCOMPARE(trackedSummaries(), QStringList({"n3", "n4"}));
+	QCOMPARE(historySummaries(this->history.get()), QStringList({"n1", "n2"}));
+}
+
+void TestNotificationServer::keepExemption() {
+	auto* server = NotificationServer::instance();
+	server->setTrackedMemoryLimit(1);
+
+	// The notification being received is kept even if it alone is over the limit.
+	notify("n1");
+	QCOMPARE(trackedSummaries(), QStringList({"n1"}));
+	QVERIFY(server->trackedMemoryUsage() > 1);
+
+	notify("n2");
+	QCOMPARE(trackedSummaries(), QStringList({"n2"}));
+	QCOMPARE(historySummaries(this->history.get()), QStringList({"n1"}));
+}
+
+void TestNotificationServer::replaceInPlace() {
+	auto* server = NotificationServer::instance();
+
+	auto first = notify("n1");
+	notify("n2");
+	auto size = server->trackedMemoryUsage() / 2;
+	server->setTrackedMemoryLimit(size * 3);
+
+	// The replaced notification is re-accounted at its new size, and kept although it is the oldest.
+	auto replaced = notify(QString(size * 2, 'x'), {}, first);
+	QCOMPARE(replaced, first);
+
+	auto tracked = server->trackedNotifications()->valueList();
+	QCOMPARE(tracked.length(), 1);
+	QCOMPARE(tracked.first()->id(), first);
+	QCOMPARE(server->trackedMemoryUsage(), tracked.first()->memoryUsage());
+	QCOMPARE(historySummaries(this->history.get()), QStringList({"n2"}));
+
+	// Shrinking it again releases the difference.
+	notify("n1", {}, first);
+	QCOMPARE(server->trackedMemoryUsage(), size);
+}
+
+void TestNotificationServer::transientNotRecorded() {
+	auto* server = NotificationServer::instance();
+
+	notify("transient", {{"transient", true}});
+	notify("n1");
+	auto size = server->trackedNotifications()->valueList().last()->memoryUsage();
+
+	// Transient notifications are evicted like any other, but not written to the history.
+	server->setTrackedMemoryLimit(size);
+	QCOMPARE(trackedSummaries(), QStringList({"n1"}));
+	QCOMPARE(this->history->count(), 0);
+
+	notify("n2");
+	QCOMPARE(trackedSummaries(), QStringList({"n2"}));
+	QCOMPARE(historySummaries(this->history.get()), QStringList({"n1"}));
+}
+
+void TestNotificationServer::memoryReleased() {
+	auto* server = NotificationServer::instance();
+
+	auto first = notify("n1");
+	notify("n2");
+	notify("n3");
+
+	auto tracked = server->trackedNotifications()->valueList();
+	server->CloseNotification(first);
+	tracked.at(1)->dismiss();
+	tracked.at(2)->expire();
+
+	QCOMPARE(server->trackedMemoryUsage(), 0);
+	QVERIFY(trackedSummaries().isEmpty());
+
+	// Reloading re-accounts notifications kept by the new generation.
+	notify("n4");
+	notify("n5");
+	auto size = server->trackedMemoryUsage();
+
+	server->switchGeneration(true, []() {});
+	QCOMPARE(trackedSummaries(), QStringList({"n4", "n5"}));
+	QCOMPARE(server->trackedMemoryUsage(), size);
+
+	QObject::disconnect(this->trackConnection);
+	server->switchGeneration(true, []() {});
+	QVERIFY(trackedSummaries().isEmpty());
+	QCOMPARE(server->trackedMemoryUsage(), 0);
+}
+
+QTEST_MAIN(TestNotificationServer);
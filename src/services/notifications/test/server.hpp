@@ -0,0 +1,30 @@
+#pragma once
+
+#include <memory>
+
+#include <qobject.h>
+#include <qtemporarydir.h>
+#include <qtmetamacros.h>
+
+#include "../history.hpp"
+
+class TestNotificationServer: public QObject {
+	Q_OBJECT;
+
+private slots:
+	void initTestCase();
+	void init();
+	void cleanup();
+
+	void evictionOrder();
+	void keepExemption();
+	void replaceInPlace();
+	void transientNotRecorded();
+	void memoryReleased();
+
+private:
+	QTemporaryDir dir;
+	qsizetype historyCount = 0;
+	std::unique_ptr<qs::service::notifications::NotificationHistoryFile> history;
+	QMetaObject::Connection trackConnection;
+};
@@ -0,0 +1,225 @@
+#include "capture.hpp"
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+#include <pipewire/core.h>
+#include <pipewire/keys.h>
+#include <pipewire/port.h>
+#include <pipewire/properties.h>
+#include <pipewire/stream.h>
+#include <qbytearray.h>
+#include <qlogging.h>
+#include <qloggingcategory.h>
+#include <qscopeguard.h>
+#include <qtypes.h>
+#include <spa/param/audio/format.h>
+#include <spa/param/audio/raw-utils.h>
+#include <spa/param/audio/raw.h>
+#include <spa/param/format-utils.h>
+#include <spa/param/format.h>
+#include <spa/param/param.h>
+#include <spa/pod/pod.h>
+
+#include "../../core/logcat.hpp"
+#include "connection.hpp"
+#include "core.hpp"
+#include "node.hpp"
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmissing-designated-field-initializers"
+
+namespace qs::service::pipewire {
+
+namespace {
+QS_LOGGING_CATEGORY(logCapture, "quickshell.service.pipewire.capture", QtWarningMsg);
+}
+
+const pw_stream_events PwAudioCapture::EVENTS = {
+    .version = PW_VERSION_STREAM_EVENTS,
+    .destroy = &PwAudioCapture::onDestroy,
+    .state_changed = &PwAudioCapture::onStateChanged,
+    .param_changed = &PwAudioCapture::onParamChanged,
+    .process = &PwAudioCapture::onProcess,
+};
+
+bool PwAudioCapture::start(const char* streamName, const char* mediaName, const char* appName) {
+	auto* core = PwConnection::instance()->registry.core;
+	if (core == nullptr || !core->isValid()) {
+		qCWarning(logCapture) << "Cannot start" << streamName << "stream: pipewire core is not ready.";
+		return false;
+	}
+
+	auto target =
+	    QByteArray::number(this->node->objectSerial ? this->node->objectSerial : this->node->id);
+
+	// clang-format off
+	auto* props = pw_properties_new(
+	    PW_KEY_MEDIA_TYPE, "Audio",
+	    PW_KEY_MEDIA_CATEGORY, "Monitor",
+	    PW_KEY_MEDIA_NAME, mediaName,
+	    PW_KEY_APP_NAME, appName,
+	    PW_KEY_STREAM_MONITOR, "true",
+		  PW_KEY_STREAM_CAPTURE_SINK, this->node->type.testFlags(PwNodeType::Sink) ? "true" : "false",
+	    PW_KEY_TARGET_OBJECT, target.constData(),
+	    nullptr
+	);
+	// clang-format on
+
+	if (props == nullptr) {
+		qCWarning(logCapture) << "Failed to create properties for" << streamName << "stream.";
+		return false;
+	}
+
+	this->stream = pw_stream_new(core->core, streamName, props);
+	if (this->stream == nullptr) {
+		qCWarning(logCapture) << "Failed to create" << streamName << "stream.";
+		return false;
+	}
+
+	pw_stream_add_listener(this->stream, &this->listener.hook, &PwAudioCapture::EVENTS, this);
+
+	auto buffer = std::array<quint8, 512> {};
+	auto builder = SPA_POD_BUILDER_INIT(buffer.data(), buffer.size()); // NOLINT
+
+	auto params = std::array<const spa_pod*, 1> {};
+	auto raw = SPA_AUDIO_INFO_RAW_INIT(.format = SPA_AUDIO_FORMAT_F32);
+	params[0] = spa_format_audio_raw_build(&builder, SPA_PARAM_EnumFormat, &raw);
+
+	// Buffers are processed on the data loop's realtime thread instead of the main thread,
+	// which only has to wake up to pick up the results.
+	auto flags = static_cast<pw_stream_flags>(
+	    PW_STREAM_FLAG_AUTOCONNECT | PW_STREAM_FLAG_MAP_BUFFERS | PW_STREAM_FLAG_RT_PROCESS
+	);
+	auto res =
+	    pw_stream_connect(this->stream, PW_DIRECTION_INPUT, PW_ID_ANY, flags, params.data(), 1);
+
+	if (res < 0) {
+		qCWarning(logCapture) << "Failed to connect" << streamName << "stream:" << res;
+		this->destroy();
+		return false;
+	}
+
+	return true;
+}
+
+void PwAudioCapture::destroy() {
+	if (this->stream == nullptr) return;
+	this->listener.remove();
+	pw_stream_destroy(this->stream);
+	this->stream = nullptr;
+	this->resetFormat();
+}
+
+void PwAudioCapture::onProcess(void* data) {
+	static_cast<PwAudioCapture*>(data)->handleProcess(); // NOLINT
+}
+
+void PwAudioCapture::onParamChanged(void* data, uint32_t id, const spa_pod* param) {
+	static_cast<PwAudioCapture*>(data)->handleParamChanged(id, param); // NOLINT
+}
+
+void PwAudioCapture::onStateChanged(
+    void* data,
+    pw_stream_state oldState,
+    pw_stream_state state,
+    const char* error
+) {
+	static_cast<PwAudioCapture*>(data)->handleStateChanged(oldState, state, error); // NOLINT
+}
+
+void PwAudioCapture::onDestroy(void* data) {
+	auto* self = static_cast<PwAudioCapture*>(data); // NOLINT
+	self->stream = nullptr;
+	self->listener.remove();
+	self->resetFormat();
+}
+
+void PwAudioCapture::handleStateChanged(
+    pw_stream_state oldState,
+    pw_stream_state state,
+    const char* error
+) {
+	if (state == PW_STREAM_STATE_ERROR) {
+		if (error != nullptr) {
+			qCWarning(logCapture) << "Capture stream error for" << this->node << ":" << error;
+		} else {
+			qCWarning(logCapture) << "Capture stream error for" << this->node;
+		}
+	}
+
+	this->stateChanged(oldState, state);
+}
+
+void PwAudioCapture::handleParamChanged(uint32_t id, const spa_pod* param) {
+	if (param == nullptr || id != SPA_PARAM_Format) return;
+
+	auto info = spa_audio_info {};
+	if (spa_format_parse(param, &info.media_type, &info.media_subtype) < 0) return;
+
+	if (info.media_type != SPA_MEDIA_TYPE_audio || info.media_subtype != SPA_MEDIA_SUBTYPE_raw)
+		return;
+
+	auto raw = SPA_AUDIO_INFO_RAW_INIT(.format = SPA_AUDIO_FORMAT_UNKNOWN); // NOLINT
+	if (spa_format_audio_raw_parse(param, &raw) < 0) return;
+
+	if (raw.format != SPA_AUDIO_FORMAT_F32) {
+		qCWarning(logCapture) << "Unsupported capture format for" << this->node << ":" << raw.format;
+		this->resetFormat();
+		return;
+	}
+
+	if (raw.channels > SPA_AUDIO_MAX_CHANNELS) {
+		qCWarning(logCapture) << "Unsupported capture channel count for" << this->node << ":"
+		                      << raw.channels;
+		this->resetFormat();
+		return;
+	}
+
+	this->mFormat = raw;
+	this->formatReady = raw.channels > 0;
+	this->processChannels.store(raw.channels, std::memory_order_release);
+	this->formatChanged();
+}
+
+void PwAudioCapture::resetFormat() {
+	this->mFormat = SPA_AUDIO_INFO_RAW_INIT(.format = SPA_AUDIO_FORMAT_UNKNOWN);
+	this->formatReady = false;
+	this->processChannels.store(0, std::memory_order_release);
+	this->formatReset();
+}
+
+// Runs on the data loop, so it must not block, allocate or touch state owned by the main thread.
+void PwAudioCapture::handleProcess() {
+	auto* buffer = pw_stream_dequeue_buffer(this->stream);
+	if (buffer == nullptr) return;
+
+	auto requeue = qScopeGuard([&, this] { pw_stream_queue_buffer(this->stream, buffer); });
+
+	auto channels = this->processChannels.load(std::memory_order_acquire);
+	if (channels == 0) return;
+
+	auto* spaBuffer = buffer->buffer;
+	if (spaBuffer == nullptr || spaBuffer->n_datas < 1) {
+		return;
+	}
+
+	auto* data = &spaBuffer->datas[0]; // NOLINT
+	if (data->data == nullptr || data->chunk == nullptr) {
+		return;
+	}
+
+	const auto* base = static_cast<const quint8*>(data->data) + data->chunk->offset; // NOLINT
+	const auto* samples = reinterpret_cast<const float*>(base);
+	auto frames = static_cast<qsizetype>(data->chunk->size / sizeof(float) / channels);
+
+	if (frames == 0) {
+		return;
+	}
+
+	this->process(samples, frames, channels);
+}
+
+} // namespace qs::service::pipewire
+
+#pragma GCC diagnostic pop
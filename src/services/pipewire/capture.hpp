@@ -0,0 +1,105 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+#include <pipewire/stream.h>
+#include <qtclasshelpermacros.h>
+#include <qtypes.h>
+#include <spa/param/audio/raw.h>
+#include <spa/pod/pod.h>
+
+#include "core.hpp"
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmissing-designated-field-initializers"
+
+namespace qs::service::pipewire {
+
+class PwNode;
+
+// Hands values from the data loop to the main thread without locking, as a triple buffer.
+// Each side owns one slot, and swaps it with the shared slot to publish or take a value.
+template <typename T>
+class PwMailbox {
+public:
+	// Data loop only.
+	T& back() { return this->slots.at(this->backIndex); }
+
+	// Data loop only. Publishes the back slot, returning false if the last published slot was
+	// replaced without being taken.
+	bool publish() {
+		auto previous = this->shared.exchange(this->backIndex | DIRTY, std::memory_order_acq_rel);
+		this->backIndex = previous & ~DIRTY;
+		return (previous & DIRTY) == 0;
+	}
+
+	// Main thread only. Returns the last published slot if it has not been taken yet.
+	const T* take() {
+		if ((this->shared.load(std::memory_order_relaxed) & DIRTY) == 0) return nullptr;
+
+		auto previous = this->shared.exchange(this->frontIndex, std::memory_order_acq_rel);
+		this->frontIndex = previous & ~DIRTY;
+		return &this->slots.at(this->frontIndex);
+	}
+
+private:
+	static constexpr quint8 DIRTY = 0b100;
+
+	std::array<T, 3> slots {};
+	quint8 backIndex = 0;
+	quint8 frontIndex = 1;
+	std::atomic<quint8> shared = 2;
+};
+
+// Captures F32 audio from a node, processing buffers on the pipewire data loop.
+//
+// Subclasses must call destroy() in their destructor, as the data loop may otherwise
+// call process() on a partially destroyed object.
+class PwAudioCapture {
+public:
+	explicit PwAudioCapture(PwNode* node): node(node) {}
+	virtual ~PwAudioCapture() = default;
+	Q_DISABLE_COPY_MOVE(PwAudioCapture);
+
+	bool start(const char* streamName, const char* mediaName, const char* appName);
+	void destroy();
+
+	[[nodiscard]] bool isFormatReady() const { return this->formatReady; }
+	[[nodiscard]] const spa_audio_info_raw& format() const { return this->mFormat; }
+
+protected:
+	// Called on the data loop with every captured buffer, which has at least one frame.
+	// Must not block, allocate or touch state owned by the main thread.
+	virtual void process(const float* samples, qsizetype frames, quint32 channels) = 0;
+	virtual void formatChanged() {}
+	virtual void formatReset() {}
+	virtual void stateChanged(pw_stream_state /*oldState*/, pw_stream_state /*state*/) {}
+
+	PwNode* node = nullptr;
+
+private:
+	static const pw_stream_events EVENTS;
+	static void onProcess(void* data);
+	static void onParamChanged(void* data, uint32_t id, const spa_pod* param);
+	static void
+	onStateChanged(void* data, pw_stream_state oldState, pw_stream_state state, const char* error);
+	static void onDestroy(void* data);
+
+	void handleProcess();
+	void handleParamChanged(uint32_t id, const spa_pod* param);
+	void handleStateChanged(pw_stream_state oldState, pw_stream_state state, const char* error);
+	void resetFormat();
+
+	pw_stream* stream = nullptr;
+	SpaHook listener;
+	spa_audio_info_raw mFormat = SPA_AUDIO_INFO_RAW_INIT(.format = SPA_AUDIO_FORMAT_UNKNOWN);
+	bool formatReady = false;
+	// Channel count of the current format, or 0 if there is none. Read by the data loop.
+	std::atomic<quint32> processChannels = 0;
+};
+
+} // namespace qs::service::pipewire
+
+#pragma GCC diagnostic pop
@@ -176,6 +176,7 @@ void PwLinkGroup::onLinkRemoved(QObject* object) {
 	this->links.remove(link->id);
 
 	if (this->links.empty()) {
+		emit this->destroying(this);
 		delete this;
 	} else if (link == this->trackedLink) {
 		this->trackedLink = *this->links.begin();
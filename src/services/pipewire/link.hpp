@@ -86,6 +86,8 @@ public:
 
 signals:
 	void stateChanged();
+	// Emitted before the group is deleted, once its last link has been removed.
+	void destroying(PwLinkGroup* self);
 
 private slots:
 	void onLinkRemoved(QObject* object);
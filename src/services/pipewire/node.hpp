@@ -258,6 +258,9 @@ public:
 signals:
 	void propertiesChanged();
 	void readyChanged();
+	// Emitted by the registry when a link group is added with this node as its output or input.
+	void outputLinkGroupAdded(PwLinkGroup* group);
+	void inputLinkGroupAdded(PwLinkGroup* group);
 
 private slots:
 	void onCoreSync(quint32 id, qint32 seq);
@@ -2,183 +2,122 @@
 #include <algorithm>
 #include <array>
 #include <cmath>
-#include <cstdint>
+#include <numeric>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
-#include <pipewire/core.h>
-#include <pipewire/keys.h>
-#include <pipewire/port.h>
-#include <pipewire/properties.h>
 #include <pipewire/stream.h>
-#include <qbytearray.h>
 #include <qcontainerfwd.h>
 #include <qlogging.h>
 #include <qloggingcategory.h>
-#include <qscopeguard.h>
 #include <qtclasshelpermacros.h>
+#include <qtimer.h>
 #include <qtmetamacros.h>
 #include <qtypes.h>
-#include <spa/param/audio/format.h>
-#include <spa/param/audio/raw-utils.h>
 #include <spa/param/audio/raw.h>
-#include <spa/param/format-utils.h>
-#include <spa/param/format.h>
-#include <spa/param/param.h>
-#include <spa/pod/pod.h>
 
 #include "../../core/logcat.hpp"
-#include "connection.hpp"
-#include "core.hpp"
+#include "capture.hpp"
 #include "node.hpp"
 #include "qml.hpp"
 
-#pragma GCC diagnostic push
-#pragma GCC diagnostic ignored "-Wmissing-designated-field-initializers"
-
 namespace qs::service::pipewire {
 
 namespace {
 QS_LOGGING_CATEGORY(logPeak, "quickshell.service.pipewire.peak", QtWarningMsg);
-}
-
-class PwPeakStream {
-public:
-	PwPeakStream(PwNodePeakMonitor* monitor, PwNode* node): monitor(monitor), node(node) {}
-	~PwPeakStream() { this->destroy(); }
-	Q_DISABLE_COPY_MOVE(PwPeakStream);
-
-	bool start();
-	void destroy();
-
-private:
-	static const pw_stream_events EVENTS;
-	static void onProcess(void* data);
-	static void onParamChanged(void* data, uint32_t id, const spa_pod* param);
-	static void
-	onStateChanged(void* data, pw_stream_state oldState, pw_stream_state state, const char* error);
-	static void onDestroy(void* data);
-
-	void handleProcess();
-	void handleParamChanged(uint32_t id, const spa_pod* param);
-	void handleStateChanged(pw_stream_state oldState, pw_stream_state state, const char* error);
-	void resetFormat();
 
-	PwNodePeakMonitor* monitor = nullptr;
-	PwNode* node = nullptr;
-	pw_stream* stream = nullptr;
-	SpaHook listener;
-	spa_audio_info_raw format = SPA_AUDIO_INFO_RAW_INIT(.format = SPA_AUDIO_FORMAT_UNKNOWN);
-	bool formatReady = false;
-	QVector<float> channelPeaks;
-};
-
-const pw_stream_events PwPeakStream::EVENTS = {
-    .version = PW_VERSION_STREAM_EVENTS,
-    .destroy = &PwPeakStream::onDestroy,
-    .state_changed = &PwPeakStream::onStateChanged,
-    .param_changed = &PwPeakStream::onParamChanged,
-    .process = &PwPeakStream::onProcess,
-};
+using ChannelPeaks = std::array<float, SPA_AUDIO_MAX_CHANNELS>;
+
+// Folds the largest absolute value of each channel in a run of interleaved frames into peaks.
+void accumulatePeaks(const float* samples, qsizetype frames, qsizetype channels, float* peaks) {
+	const auto* sample = samples;
+	const auto* end = samples + frames * channels; // NOLINT
+
+#ifdef __SSE2__
+	// Every channel sits in the same lanes of each block of lcm(channels, 4) samples,
+	// so blocks can be folded with one accumulator per vector and sorted out at the end.
+	auto blockVectors = std::lcm(channels, static_cast<qsizetype>(4)) / 4;
+	auto blockSize = blockVectors * 4;
+
+	if (end - sample >= blockSize) {
+		auto absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+		__m128 accumulators[SPA_AUDIO_MAX_CHANNELS]; // NOLINT
+		for (auto i = 0; i != blockVectors; i++) accumulators[i] = _mm_setzero_ps(); // NOLINT
+
+		for (; end - sample >= blockSize; sample += blockSize) {
+			for (auto i = 0; i != blockVectors; i++) {
+				auto v = _mm_and_ps(_mm_loadu_ps(sample + i * 4), absMask); // NOLINT
+				// Returns the second operand for NaN samples, skipping them like std::max below.
+				accumulators[i] = _mm_max_ps(v, accumulators[i]); // NOLINT
+			}
+		}
 
-bool PwPeakStream::start() {
-	auto* core = PwConnection::instance()->registry.core;
-	if (core == nullptr || !core->isValid()) {
-		qCWarning(logPeak) << "Cannot start peak monitor stream: pipewire core is not ready.";
-		return false;
-	}
+		alignas(16) float lanes[4];
+		for (auto i = 0; i != blockVectors; i++) {
+			_mm_store_ps(lanes, accumulators[i]); // NOLINT
 
-	auto target =
-	    QByteArray::number(this->node->objectSerial ? this->node->objectSerial : this->node->id);
-
-	// clang-format off
-	auto* props = pw_properties_new(
-	    PW_KEY_MEDIA_TYPE, "Audio",
-	    PW_KEY_MEDIA_CATEGORY, "Monitor",
-	    PW_KEY_MEDIA_NAME, "Peak detect",
-	    PW_KEY_APP_NAME, "Quickshell Peak Detect",
-	    PW_KEY_STREAM_MONITOR, "true",
-		  PW_KEY_STREAM_CAPTURE_SINK, this->node->type.testFlags(PwNodeType::Sink) ? "true" : "false",
-	    PW_KEY_TARGET_OBJECT, target.constData(),
-	    nullptr
-	);
-	// clang-format on
-
-	if (props == nullptr) {
-		qCWarning(logPeak) << "Failed to create properties for peak monitor stream.";
-		return false;
+			for (auto lane = 0; lane != 4; lane++) {
+				auto& peak = peaks[(i * 4 + lane) % channels]; // NOLINT
+				peak = std::max(peak, lanes[lane]);
+			}
+		}
 	}
+#endif
 
-	this->stream = pw_stream_new(core->core, "quickshell-peak-monitor", props);
-	if (this->stream == nullptr) {
-		qCWarning(logPeak) << "Failed to create peak monitor stream.";
-		return false;
+	for (qsizetype channel = 0; sample != end; sample++) { // NOLINT
+		peaks[channel] = std::max(peaks[channel], std::abs(*sample)); // NOLINT
+		if (++channel == channels) channel = 0;
 	}
+}
 
-	pw_stream_add_listener(this->stream, &this->listener.hook, &PwPeakStream::EVENTS, this);
-
-	auto buffer = std::array<quint8, 512> {};
-	auto builder = SPA_POD_BUILDER_INIT(buffer.data(), buffer.size()); // NOLINT
-
-	auto params = std::array<const spa_pod*, 1> {};
-	auto raw = SPA_AUDIO_INFO_RAW_INIT(.format = SPA_AUDIO_FORMAT_F32);
-	params[0] = spa_format_audio_raw_build(&builder, SPA_PARAM_EnumFormat, &raw);
+} // namespace
 
-	auto flags =
-	    static_cast<pw_stream_flags>(PW_STREAM_FLAG_AUTOCONNECT | PW_STREAM_FLAG_MAP_BUFFERS);
-	auto res =
-	    pw_stream_connect(this->stream, PW_DIRECTION_INPUT, PW_ID_ANY, flags, params.data(), 1);
+class PwPeakStream: public PwAudioCapture {
+public:
+	PwPeakStream(PwNodePeakMonitor* monitor, PwNode* node): PwAudioCapture(node), monitor(monitor) {}
+	~PwPeakStream() override { this->destroy(); }
+	Q_DISABLE_COPY_MOVE(PwPeakStream);
 
-	if (res < 0) {
-		qCWarning(logPeak) << "Failed to connect peak monitor stream:" << res;
-		this->destroy();
-		return false;
+	bool start() {
+		return this->PwAudioCapture::start(
+		    "quickshell-peak-monitor",
+		    "Peak detect",
+		    "Quickshell Peak Detect"
+		);
 	}
 
-	return true;
-}
+	// Publishes peaks collected by the data loop since the last call, if there are any.
+	void deliverPeaks();
 
-void PwPeakStream::destroy() {
-	if (this->stream == nullptr) return;
-	this->listener.remove();
-	pw_stream_destroy(this->stream);
-	this->stream = nullptr;
-	this->resetFormat();
-}
-
-void PwPeakStream::onProcess(void* data) {
-	static_cast<PwPeakStream*>(data)->handleProcess(); // NOLINT
-}
+protected:
+	void process(const float* samples, qsizetype frames, quint32 channels) override;
+	void formatChanged() override;
+	void formatReset() override;
+	void stateChanged(pw_stream_state oldState, pw_stream_state state) override;
 
-void PwPeakStream::onParamChanged(void* data, uint32_t id, const spa_pod* param) {
-	static_cast<PwPeakStream*>(data)->handleParamChanged(id, param); // NOLINT
-}
+private:
+	struct PeakSlot {
+		quint32 channels = 0;
+		ChannelPeaks peaks {};
+	};
 
-void PwPeakStream::onStateChanged(
-    void* data,
-    pw_stream_state oldState,
-    pw_stream_state state,
-    const char* error
-) {
-	static_cast<PwPeakStream*>(data)->handleStateChanged(oldState, state, error); // NOLINT
-}
+	PwNodePeakMonitor* monitor = nullptr;
+	QVector<float> channelPeaks;
+	QVector<float> volumes;
+	PwMailbox<PeakSlot> mailbox;
 
-void PwPeakStream::onDestroy(void* data) {
-	auto* self = static_cast<PwPeakStream*>(data); // NOLINT
-	self->stream = nullptr;
-	self->listener.remove();
-	self->resetFormat();
-}
+	// Data loop only. Peaks of every buffer since the last published peaks were taken.
+	ChannelPeaks pendingPeaks {};
+	quint32 pendingChannels = 0;
+};
 
-void PwPeakStream::handleStateChanged(
-    pw_stream_state oldState,
-    pw_stream_state state,
-    const char* error
-) {
-	if (state == PW_STREAM_STATE_ERROR) {
-		if (error != nullptr) {
-			qCWarning(logPeak) << "Peak monitor stream error:" << error;
-		} else {
-			qCWarning(logPeak) << "Peak monitor stream error.";
-		}
+void PwPeakStream::stateChanged(pw_stream_state oldState, pw_stream_state state) {
+	if (state == PW_STREAM_STATE_STREAMING) {
+		this->monitor->mUpdateTimer.start();
+	} else {
+		this->monitor->mUpdateTimer.stop();
 	}
 
 	if (state == PW_STREAM_STATE_PAUSED && oldState != PW_STREAM_STATE_PAUSED) {
@@ -186,8 +125,8 @@ void PwPeakStream::handleStateChanged(
 		if (peakCount == 0) {
 			peakCount = this->monitor->mPeaks.length();
 		}
-		if (peakCount == 0 && this->formatReady) {
-			peakCount = static_cast<int>(this->format.channels);
+		if (peakCount == 0 && this->isFormatReady()) {
+			peakCount = static_cast<int>(this->format().channels);
 		}
 
 		if (peakCount > 0) {
@@ -197,26 +136,8 @@ void PwPeakStream::handleStateChanged(
 	}
 }
 
-void PwPeakStream::handleParamChanged(uint32_t id, const spa_pod* param) {
-	if (param == nullptr || id != SPA_PARAM_Format) return;
-
-	auto info = spa_audio_info {};
-	if (spa_format_parse(param, &info.media_type, &info.media_subtype) < 0) return;
-
-	if (info.media_type != SPA_MEDIA_TYPE_audio || info.media_subtype != SPA_MEDIA_SUBTYPE_raw)
-		return;
-
-	auto raw = SPA_AUDIO_INFO_RAW_INIT(.format = SPA_AUDIO_FORMAT_UNKNOWN); // NOLINT
-	if (spa_format_audio_raw_parse(param, &raw) < 0) return;
-
-	if (raw.format != SPA_AUDIO_FORMAT_F32) {
-		qCWarning(logPeak) << "Unsupported peak monitor format for" << this->node << ":" << raw.format;
-		this->resetFormat();
-		return;
-	}
-
-	this->format = raw;
-	this->formatReady = raw.channels > 0;
+void PwPeakStream::formatChanged() {
+	const auto& raw = this->format();
 
 	auto channels = QVector<PwAudioChannel::Enum>();
 	channels.reserve(static_cast<int>(raw.channels));
@@ -234,49 +155,41 @@ void PwPeakStream::handleParamChanged(uint32_t id, const spa_pod* param) {
 	this->monitor->updatePeaks(this->channelPeaks, 0.0f);
 }
 
-void PwPeakStream::resetFormat() {
-	this->format = SPA_AUDIO_INFO_RAW_INIT(.format = SPA_AUDIO_FORMAT_UNKNOWN);
-	this->formatReady = false;
+void PwPeakStream::formatReset() {
 	this->channelPeaks.clear();
 	this->monitor->clearPeaks();
 }
 
-void PwPeakStream::handleProcess() {
-	if (!this->formatReady || this->stream == nullptr) return;
-
-	auto* buffer = pw_stream_dequeue_buffer(this->stream);
-
-	if (buffer == nullptr) {
-		qCWarning(logPeak) << "Peak monitor ran out of buffers.";
-		return;
+void PwPeakStream::process(const float* samples, qsizetype frames, quint32 channels) {
+	if (channels != this->pendingChannels) {
+		this->pendingPeaks.fill(0.0f);
+		this->pendingChannels = channels;
 	}
 
-	auto requeue = qScopeGuard([&, this] { pw_stream_queue_buffer(this->stream, buffer); });
+	auto peaks = ChannelPeaks();
+	accumulatePeaks(samples, frames, channels, peaks.data());
 
-	auto* spaBuffer = buffer->buffer;
-	if (spaBuffer == nullptr || spaBuffer->n_datas < 1) {
-		return;
+	for (quint32 i = 0; i != channels; i++) {
+		this->pendingPeaks.at(i) = std::max(this->pendingPeaks.at(i), peaks.at(i));
 	}
 
-	auto* data = &spaBuffer->datas[0]; // NOLINT
-	if (data->data == nullptr || data->chunk == nullptr) {
-		return;
-	}
+	auto& slot = this->mailbox.back();
+	slot.channels = channels;
+	slot.peaks = this->pendingPeaks;
 
-	auto channelCount = static_cast<int>(this->format.channels);
-	if (channelCount <= 0) {
-		return;
-	}
+	// Once the last published peaks have been taken, only this buffer's peaks are still pending.
+	if (this->mailbox.publish()) this->pendingPeaks = peaks;
+}
 
-	const auto* base = static_cast<const quint8*>(data->data) + data->chunk->offset; // NOLINT
-	const auto* samples = reinterpret_cast<const float*>(base);
-	auto sampleCount = static_cast<int>(data->chunk->size / sizeof(float));
+void PwPeakStream::deliverPeaks() {
+	const auto* slot = this->mailbox.take();
+	if (slot == nullptr || !this->isFormatReady()) return;
 
-	if (sampleCount < channelCount) {
-		return;
-	}
+	auto channelCount = static_cast<int>(this->format().channels);
+	// Collected before a format change.
+	if (slot->channels != this->format().channels) return;
 
-	QVector<float> volumes;
+	this->volumes.clear();
 	if (auto* audioData = dynamic_cast<PwNodeBoundAudio*>(this->node->boundData)) {
 		// Device volumes don't require inverse scaling
 		if (!this->node->shouldUseDevice()) {
@@ -286,13 +199,13 @@ void PwPeakStream::handleProcess() {
 			for (const auto channel: this->monitor->mChannels) {
 				for (auto i = 0; i != nchannels.length(); i++) {
 					if (nchannels[i] == channel) {
-						volumes.push_back(nvolumes[i]);
+						this->volumes.push_back(nvolumes[i]);
 						break;
 					}
 				}
 			}
 
-			if (volumes.length() != channelCount) {
+			if (this->volumes.length() != channelCount) {
 				qCCritical(logPeak) << this->node
 				                    << "is missing channels present in capture stream. Node channels:"
 				                    << nchannels << "Stream channels:" << this->monitor->mChannels;
@@ -305,14 +218,11 @@ void PwPeakStream::handleProcess() {
 
 	auto maxPeak = 0.0f;
 	for (auto channel = 0; channel < channelCount; channel++) {
-		auto peak = 0.0f;
-		for (auto sample = channel; sample < sampleCount; sample += channelCount) {
-			peak = std::max(peak, std::abs(samples[sample])); // NOLINT
+		auto visualPeak = std::cbrt(slot->peaks.at(channel));
+		if (!this->volumes.isEmpty() && this->volumes[channel] != 0.0f) {
+			visualPeak *= 1.0f / this->volumes[channel];
 		}
 
-		auto visualPeak = std::cbrt(peak);
-		if (!volumes.isEmpty() && volumes[channel] != 0.0f) visualPeak *= 1.0f / volumes[channel];
-
 		this->channelPeaks[channel] = visualPeak;
 		maxPeak = std::max(maxPeak, visualPeak);
 	}
@@ -320,7 +230,15 @@ void PwPeakStream::handleProcess() {
 	this->monitor->updatePeaks(this->channelPeaks, maxPeak);
 }
 
-PwNodePeakMonitor::PwNodePeakMonitor(QObject* parent): QObject(parent) {}
+PwNodePeakMonitor::PwNodePeakMonitor(QObject* parent): QObject(parent) {
+	this->mUpdateTimer.setInterval(20);
+	QObject::connect(
+	    &this->mUpdateTimer,
+	    &QTimer::timeout,
+	    this,
+	    &PwNodePeakMonitor::onUpdateTimeout
+	);
+}
 
 PwNodePeakMonitor::~PwNodePeakMonitor() {
 	delete this->mStream;
@@ -355,6 +273,19 @@ void PwNodePeakMonitor::setEnabled(bool enabled) {
 	emit this->enabledChanged();
 }
 
+int PwNodePeakMonitor::updateInterval() const { return this->mUpdateTimer.interval(); }
+
+void PwNodePeakMonitor::setUpdateInterval(int interval) {
+	interval = std::max(interval, 1);
+	if (interval == this->mUpdateTimer.interval()) return;
+	this->mUpdateTimer.setInterval(interval);
+	emit this->updateIntervalChanged();
+}
+
+void PwNodePeakMonitor::onUpdateTimeout() {
+	if (this->mStream != nullptr) this->mStream->deliverPeaks();
+}
+
 void PwNodePeakMonitor::onNodeDestroyed() {
 	this->mNode = nullptr;
 	this->mNodeRef.setObject(nullptr);
@@ -398,6 +329,7 @@ void PwNodePeakMonitor::clearPeaks() {
 }
 
 void PwNodePeakMonitor::rebuildStream() {
+	this->mUpdateTimer.stop();
 	delete this->mStream;
 	this->mStream = nullptr;
 
@@ -421,5 +353,3 @@ void PwNodePeakMonitor::rebuildStream() {
 }
 
 } // namespace qs::service::pipewire
-
-#pragma GCC diagnostic pop
@@ -3,6 +3,7 @@
 #include <qobject.h>
 #include <qqmlintegration.h>
 #include <qtclasshelpermacros.h>
+#include <qtimer.h>
 #include <qtmetamacros.h>
 #include <qtypes.h>
 #include <qvector.h>
@@ -39,6 +40,10 @@ class PwNodePeakMonitor: public QObject {
 	Q_PROPERTY(float peak READ peak NOTIFY peakChanged);
 	/// Channel positions for the captured format. Length matches @@peaks.
 	Q_PROPERTY(QVector<qs::service::pipewire::PwAudioChannel::Enum> channels READ channels NOTIFY channelsChanged);
+	/// Time in milliseconds between updates of @@peaks. Defaults to 20.
+	///
+	/// Peaks are tracked over the whole interval, so short peaks are not missed at longer intervals.
+	Q_PROPERTY(int updateInterval READ updateInterval WRITE setUpdateInterval NOTIFY updateIntervalChanged);
 	// clang-format on
 	QML_ELEMENT;
 
@@ -57,15 +62,20 @@ public:
 	[[nodiscard]] float peak() const { return this->mPeak; }
 	[[nodiscard]] QVector<PwAudioChannel::Enum> channels() const { return this->mChannels; }
 
+	[[nodiscard]] int updateInterval() const;
+	void setUpdateInterval(int interval);
+
 signals:
 	void nodeChanged();
 	void enabledChanged();
 	void peaksChanged();
 	void peakChanged();
 	void channelsChanged();
+	void updateIntervalChanged();
 
 private slots:
 	void onNodeDestroyed();
+	void onUpdateTimeout();
 
 private:
 	friend class PwPeakStream;
@@ -82,6 +92,7 @@ private:
 	float mPeak = 0.0f;
 	QVector<PwAudioChannel::Enum> mChannels;
 	PwPeakStream* mStream = nullptr;
+	QTimer mUpdateTimer;
 };
 
 } // namespace qs::service::pipewire
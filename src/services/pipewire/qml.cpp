@@ -4,6 +4,7 @@
 #include <qlist.h>
 #include <qobject.h>
 #include <qqmllist.h>
+#include <qset.h>
 #include <qtmetamacros.h>
 #include <qtypes.h>
 #include <qvariant.h>
@@ -171,24 +172,54 @@ void Pipewire::setDefaultConfiguredAudioSource(PwNodeIface* node) {
 
 bool Pipewire::isReady() { return PwConnection::instance()->registry.isInitialized(); }
 
+QList<PwNodeIface*> Pipewire::upstreamNodes(PwNodeIface* node, bool recursive) { // NOLINT
+	if (node == nullptr) return {};
+
+	auto nodes = PwConnection::instance()->registry.upstreamNodes(node->id(), recursive);
+	return Pipewire::nodeIfaces(nodes);
+}
+
+QList<PwNodeIface*> Pipewire::downstreamNodes(PwNodeIface* node, bool recursive) { // NOLINT
+	if (node == nullptr) return {};
+
+	auto nodes = PwConnection::instance()->registry.downstreamNodes(node->id(), recursive);
+	return Pipewire::nodeIfaces(nodes);
+}
+
+QList<PwNodeIface*> Pipewire::nodeIfaces(const QList<PwNode*>& nodes) {
+	auto ifaces = QList<PwNodeIface*>();
+	ifaces.reserve(nodes.length());
+
+	for (auto* node: nodes) {
+		ifaces.push_back(PwNodeIface::instance(node));
+	}
+
+	return ifaces;
+}
+
 PwNodeIface* PwNodeLinkTracker::node() const { return this->mNode; }
 
 void PwNodeLinkTracker::setNode(PwNodeIface* node) {
 	if (node == this->mNode) return;
 
 	if (this->mNode != nullptr) {
-		if (node == nullptr) {
-			QObject::disconnect(&PwConnection::instance()->registry, nullptr, this, nullptr);
-		}
-
+		QObject::disconnect(this->mNode->node(), nullptr, this, nullptr);
 		QObject::disconnect(this->mNode, nullptr, this, nullptr);
 	}
 
 	if (node != nullptr) {
-		if (this->mNode == nullptr) {
+		// Only link groups on this node's end of the graph are relevant.
+		if (node->isSink()) {
+			QObject::connect(
+			    node->node(),
+			    &PwNode::inputLinkGroupAdded,
+			    this,
+			    &PwNodeLinkTracker::onLinkGroupCreated
+			);
+		} else {
 			QObject::connect(
-			    &PwConnection::instance()->registry,
-			    &PwRegistry::linkGroupAdded,
+			    node->node(),
+			    &PwNode::outputLinkGroupAdded,
 			    this,
 			    &PwNodeLinkTracker::onLinkGroupCreated
 			);
@@ -206,33 +237,36 @@ void PwNodeLinkTracker::updateLinks() {
 	// done first to avoid unref->reref of nodes
 	auto newLinks = QVector<PwLinkGroupIface*>();
 	if (this->mNode != nullptr) {
-		auto* connection = PwConnection::instance();
-
-		for (auto* link: connection->registry.linkGroups) {
-			if ((!this->mNode->isSink() && link->outputNode() == this->mNode->id())
-			    || (this->mNode->isSink() && link->inputNode() == this->mNode->id()))
-			{
-				auto* iface = PwLinkGroupIface::instance(link);
-				if (iface->target()->node()->isMonitor) return;
-
-				// do not connect twice
-				if (!this->mLinkGroups.contains(iface)) {
-					QObject::connect(
-					    iface,
-					    &QObject::destroyed,
-					    this,
-					    &PwNodeLinkTracker::onLinkGroupDestroyed
-					);
-				}
-
-				newLinks.push_back(iface);
+		auto& registry = PwConnection::instance()->registry;
+		auto groups = this->mNode->isSink() ? registry.inputLinkGroups(this->mNode->id())
+		                                    : registry.outputLinkGroups(this->mNode->id());
+
+		auto oldLinks = QSet<PwLinkGroupIface*>(this->mLinkGroups.begin(), this->mLinkGroups.end());
+
+		for (auto* group: groups) {
+			if (!PwNodeLinkTracker::shouldTrack(group)) continue;
+
+			auto* iface = PwLinkGroupIface::instance(group);
+
+			// do not connect twice
+			if (!oldLinks.remove(iface)) {
+				QObject::connect(
+				    iface,
+				    &QObject::destroyed,
+				    this,
+				    &PwNodeLinkTracker::onLinkGroupDestroyed
+				);
 			}
+
+			newLinks.push_back(iface);
 		}
-	}
 
-	for (auto* iface: this->mLinkGroups) {
 		// only disconnect no longer used nodes
-		if (!newLinks.contains(iface) || iface->target()->node()->isMonitor) {
+		for (auto* iface: oldLinks) {
+			QObject::disconnect(iface, nullptr, this, nullptr);
+		}
+	} else {
+		for (auto* iface: this->mLinkGroups) {
 			QObject::disconnect(iface, nullptr, this, nullptr);
 		}
 	}
@@ -241,6 +275,11 @@ void PwNodeLinkTracker::updateLinks() {
 	emit this->linkGroupsChanged();
 }
 
+bool PwNodeLinkTracker::shouldTrack(PwLinkGroup* group) {
+	auto* target = PwConnection::instance()->registry.nodes.value(group->inputNode());
+	return target == nullptr || !target->isMonitor;
+}
+
 QQmlListProperty<PwLinkGroupIface> PwNodeLinkTracker::linkGroups() {
 	return QQmlListProperty<PwLinkGroupIface>(
 	    this,
@@ -261,23 +300,18 @@ PwNodeLinkTracker::linkGroupAt(QQmlListProperty<PwLinkGroupIface>* property, qsi
 
 void PwNodeLinkTracker::onNodeDestroyed() {
 	this->mNode = nullptr;
-	QObject::disconnect(&PwConnection::instance()->registry, nullptr, this, nullptr);
 
 	this->updateLinks();
 	emit this->nodeChanged();
 }
 
 void PwNodeLinkTracker::onLinkGroupCreated(PwLinkGroup* linkGroup) {
-	if ((!this->mNode->isSink() && linkGroup->outputNode() == this->mNode->id())
-	    || (this->mNode->isSink() && linkGroup->inputNode() == this->mNode->id()))
-	{
-		auto* iface = PwLinkGroupIface::instance(linkGroup);
-		if (iface->target()->node()->isMonitor) return;
-
-		QObject::connect(iface, &QObject::destroyed, this, &PwNodeLinkTracker::onLinkGroupDestroyed);
-		this->mLinkGroups.push_back(iface);
-		emit this->linkGroupsChanged();
-	}
+	if (!PwNodeLinkTracker::shouldTrack(linkGroup)) return;
+
+	auto* iface = PwLinkGroupIface::instance(linkGroup);
+	QObject::connect(iface, &QObject::destroyed, this, &PwNodeLinkTracker::onLinkGroupDestroyed);
+	this->mLinkGroups.push_back(iface);
+	emit this->linkGroupsChanged();
 }
 
 void PwNodeLinkTracker::onLinkGroupDestroyed(QObject* object) {
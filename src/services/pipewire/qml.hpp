@@ -148,6 +148,19 @@ public:
 
 	[[nodiscard]] static bool isReady();
 
+	/// Returns the nodes linked to the inputs of the given node, which feed audio into it.
+	///
+	/// If `recursive` is true, nodes linked to those nodes' inputs are also included, and so on,
+	/// ordered from nearest to furthest.
+	Q_INVOKABLE static QList<qs::service::pipewire::PwNodeIface*>
+	upstreamNodes(qs::service::pipewire::PwNodeIface* node, bool recursive = false);
+	/// Returns the nodes linked to the outputs of the given node, which it feeds audio into.
+	///
+	/// If `recursive` is true, nodes linked to those nodes' outputs are also included, and so on,
+	/// ordered from nearest to furthest.
+	Q_INVOKABLE static QList<qs::service::pipewire::PwNodeIface*>
+	downstreamNodes(qs::service::pipewire::PwNodeIface* node, bool recursive = false);
+
 signals:
 	void defaultAudioSinkChanged();
 	void defaultAudioSourceChanged();
@@ -166,6 +179,8 @@ private slots:
 	void onLinkGroupRemoved(QObject* object);
 
 private:
+	static QList<PwNodeIface*> nodeIfaces(const QList<PwNode*>& nodes);
+
 	ObjectModel<PwNodeIface> mNodes {this};
 	ObjectModel<PwLinkIface> mLinks {this};
 	ObjectModel<PwLinkGroupIface> mLinkGroups {this};
@@ -208,6 +223,7 @@ private:
 	linkGroupAt(QQmlListProperty<PwLinkGroupIface>* property, qsizetype index);
 
 	void updateLinks();
+	static bool shouldTrack(PwLinkGroup* group);
 
 	PwNodeIface* mNode = nullptr;
 	QVector<PwLinkGroupIface*> mLinkGroups;
@@ -7,10 +7,14 @@
 #include <pipewire/link.h>
 #include <pipewire/node.h>
 #include <pipewire/proxy.h>
+#include <qcontainerfwd.h>
 #include <qdebug.h>
+#include <qhash.h>
+#include <qlist.h>
 #include <qlogging.h>
 #include <qloggingcategory.h>
 #include <qobject.h>
+#include <qset.h>
 #include <qstringview.h>
 #include <qtmetamacros.h>
 #include <qtypes.h>
@@ -167,6 +171,8 @@ void PwRegistry::reset() {
 	this->devices.clear();
 
 	this->linkGroups.clear();
+	this->linkGroupsByOutput.clear();
+	this->linkGroupsByInput.clear();
 	this->initState = InitState::SendingObjects;
 	this->coreSyncSeq = 0;
 	this->core = nullptr;
@@ -255,19 +261,39 @@ void PwRegistry::onGlobalRemoved(void* data, quint32 id) {
 }
 
 void PwRegistry::addLinkToGroup(PwLink* link) {
-	for (auto* group: this->linkGroups) {
-		if (group->tryAddLink(link)) return;
+	auto outputNode = link->outputNode();
+	auto inputNode = link->inputNode();
+
+	if (auto* group = this->linkGroupsByOutput.value(outputNode).value(inputNode)) {
+		group->tryAddLink(link);
+		return;
 	}
 
 	auto* group = new PwLinkGroup(link);
-	QObject::connect(group, &QObject::destroyed, this, &PwRegistry::onLinkGroupDestroyed);
+	QObject::connect(group, &PwLinkGroup::destroying, this, &PwRegistry::onLinkGroupDestroyed);
 	this->linkGroups.push_back(group);
+	this->linkGroupsByOutput[outputNode].insert(inputNode, group);
+	this->linkGroupsByInput[inputNode].insert(outputNode, group);
 	emit this->linkGroupAdded(group);
+
+	// Nodes may not exist yet, in which case they will pick up the group from the index.
+	if (auto* node = this->nodes.value(outputNode)) emit node->outputLinkGroupAdded(group);
+	if (auto* node = this->nodes.value(inputNode)) emit node->inputLinkGroupAdded(group);
 }
 
-void PwRegistry::onLinkGroupDestroyed(QObject* object) {
-	auto* group = static_cast<PwLinkGroup*>(object); // NOLINT
+void PwRegistry::onLinkGroupDestroyed(PwLinkGroup* group) {
 	this->linkGroups.removeOne(group);
+
+	auto removeIndexed = [group](LinkGroupIndex& index, quint32 node, quint32 peer) {
+		auto iter = index.find(node);
+		if (iter == index.end() || iter->value(peer) != group) return;
+
+		iter->remove(peer);
+		if (iter->isEmpty()) index.erase(iter);
+	};
+
+	removeIndexed(this->linkGroupsByOutput, group->outputNode(), group->inputNode());
+	removeIndexed(this->linkGroupsByInput, group->inputNode(), group->outputNode());
 }
 
 PwNode* PwRegistry::findNodeByName(QStringView name) const {
@@ -280,4 +306,43 @@ PwNode* PwRegistry::findNodeByName(QStringView name) const {
 	return nullptr;
 }
 
+QList<PwLinkGroup*> PwRegistry::outputLinkGroups(quint32 node) const {
+	return this->linkGroupsByOutput.value(node).values();
+}
+
+QList<PwLinkGroup*> PwRegistry::inputLinkGroups(quint32 node) const {
+	return this->linkGroupsByInput.value(node).values();
+}
+
+QList<PwNode*> PwRegistry::upstreamNodes(quint32 node, bool recursive) const {
+	return this->linkedNodes(this->linkGroupsByInput, node, recursive);
+}
+
+QList<PwNode*> PwRegistry::downstreamNodes(quint32 node, bool recursive) const {
+	return this->linkedNodes(this->linkGroupsByOutput, node, recursive);
+}
+
+QList<PwNode*>
+PwRegistry::linkedNodes(const LinkGroupIndex& index, quint32 node, bool recursive) const {
+	auto result = QList<PwNode*>();
+	auto visited = QSet<quint32> {node};
+	auto queue = QList<quint32> {node};
+
+	// Breadth first, so nearer nodes are listed first.
+	for (qsizetype i = 0; i < queue.length(); i++) {
+		auto iter = index.find(queue.at(i));
+		if (iter == index.end()) continue;
+
+		for (auto peer: iter->keys()) {
+			if (visited.contains(peer)) continue;
+			visited.insert(peer);
+
+			if (auto* peerNode = this->nodes.value(peer)) result.push_back(peerNode);
+			if (recursive) queue.push_back(peer);
+		}
+	}
+
+	return result;
+}
+
 } // namespace qs::service::pipewire
@@ -131,6 +131,15 @@ public:
 
 	[[nodiscard]] PwNode* findNodeByName(QStringView name) const;
 
+	// Link groups with the given node as their output (source) or input (target) node.
+	[[nodiscard]] QList<PwLinkGroup*> outputLinkGroups(quint32 node) const;
+	[[nodiscard]] QList<PwLinkGroup*> inputLinkGroups(quint32 node) const;
+
+	// Nodes linked to the inputs or outputs of the given node, not including the node itself.
+	// If recursive is set, nodes transitively linked to the node are also included.
+	[[nodiscard]] QList<PwNode*> upstreamNodes(quint32 node, bool recursive = false) const;
+	[[nodiscard]] QList<PwNode*> downstreamNodes(quint32 node, bool recursive = false) const;
+
 signals:
 	void nodeAdded(PwNode* node);
 	void linkAdded(PwLink* link);
@@ -140,7 +149,7 @@ signals:
 	void cleared();
 
 private slots:
-	void onLinkGroupDestroyed(QObject* object);
+	void onLinkGroupDestroyed(PwLinkGroup* group);
 	void onCoreSync(quint32 id, qint32 seq);
 
 private:
@@ -159,6 +168,15 @@ private:
 
 	void addLinkToGroup(PwLink* link);
 
+	using LinkGroupIndex = QHash<quint32, QHash<quint32, PwLinkGroup*>>;
+
+	[[nodiscard]] QList<PwNode*>
+	linkedNodes(const LinkGroupIndex& index, quint32 node, bool recursive) const;
+
+	// Link groups by output node and then input node, and by input node and then output node.
+	LinkGroupIndex linkGroupsByOutput;
+	LinkGroupIndex linkGroupsByInput;
+
 	enum class InitState : quint8 {
 		SendingObjects,
 		Binding,
@@ -0,0 +1,415 @@
+#include "spectrum.hpp"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cmath>
+#include <complex>
+#include <numbers>
+
+#include <pipewire/stream.h>
+#include <qlogging.h>
+#include <qloggingcategory.h>
+#include <qobject.h>
+#include <qtclasshelpermacros.h>
+#include <qtimer.h>
+#include <qtmetamacros.h>
+#include <qtypes.h>
+
+#include "capture.hpp"
+#include "node.hpp"
+#include "qml.hpp"
+
+namespace qs::service::pipewire {
+
+namespace {
+
+// Range of levels mapped onto 0.0-1.0, in decibels below full scale.
+constexpr float LEVEL_RANGE_DB = 60.0f;
+
+} // namespace
+
+void SpectrumAnalyzer::configure(
+    qsizetype fftSize,
+    qsizetype bands,
+    float lowerCutoff,
+    float upperCutoff,
+    float rate
+) {
+	if (fftSize == this->mFftSize && bands == this->mBands && lowerCutoff == this->lowerCutoff
+	    && upperCutoff == this->upperCutoff && rate == this->rate)
+	{
+		return;
+	}
+
+	this->mFftSize = fftSize;
+	this->mBands = bands;
+	this->lowerCutoff = lowerCutoff;
+	this->upperCutoff = upperCutoff;
+	this->rate = rate;
+	this->planned = false;
+}
+
+void SpectrumAnalyzer::plan() {
+	auto size = this->mFftSize;
+	auto half = size / 2;
+
+	// Periodic hann window.
+	this->window.resize(size);
+	for (auto i = 0; i != size; i++) {
+		auto phase = 2.0 * std::numbers::pi * i / static_cast<double>(size);
+		this->window[i] = static_cast<float>(0.5 - 0.5 * std::cos(phase));
+	}
+
+	this->twiddles.resize(half);
+	for (auto i = 0; i != half; i++) {
+		auto phase = -2.0 * std::numbers::pi * i / static_cast<double>(size);
+		this->twiddles[i] = std::complex<float>(std::polar(1.0, phase));
+	}
+
+	// The transform runs at half size over pairs of real samples packed into complex ones.
+	auto bits = std::countr_zero(static_cast<quint32>(half));
+	this->bitReverse.resize(half);
+	for (quint32 i = 0; i != half; i++) {
+		quint32 reversed = 0;
+		for (auto bit = 0; bit != bits; bit++) {
+			reversed |= ((i >> bit) & 1) << (bits - 1 - bit);
+		}
+
+		this->bitReverse[i] = reversed;
+	}
+
+	this->buffer.resize(half);
+
+	// Bands are spaced evenly on a log scale, and always cover at least one bin.
+	auto binWidth = this->rate / static_cast<float>(size);
+	auto upper = std::clamp(this->upperCutoff, binWidth * 2, this->rate / 2);
+	auto lower = std::clamp(this->lowerCutoff, binWidth, upper);
+	auto ratio = upper / lower;
+
+	this->bandStart.resize(this->mBands);
+	this->bandEnd.resize(this->mBands);
+
+	for (auto band = 0; band != this->mBands; band++) {
+		auto bandLower = lower * std::pow(ratio, static_cast<float>(band) / this->mBands);
+		auto bandUpper = lower * std::pow(ratio, static_cast<float>(band + 1) / this->mBands);
+
+		auto start = std::clamp<qsizetype>(static_cast<qsizetype>(bandLower / binWidth), 1, half - 1);
+		auto end = std::clamp<qsizetype>(static_cast<qsizetype>(bandUpper / binWidth), start + 1, half);
+
+		this->bandStart[band] = start;
+		this->bandEnd[band] = end;
+	}
+
+	this->planned = true;
+}
+
+void SpectrumAnalyzer::analyze(const float* samples, float* levels) {
+	if (!this->planned) this->plan();
+
+	auto size = this->mFftSize;
+	auto half = size / 2;
+	auto* buffer = this->buffer.data();
+	const auto* window = this->window.constData();
+	const auto* twiddles = this->twiddles.constData();
+
+	for (auto i = 0; i != half; i++) {
+		auto even = samples[i * 2] * window[i * 2];         // NOLINT
+		auto odd = samples[i * 2 + 1] * window[i * 2 + 1]; // NOLINT
+		buffer[this->bitReverse[i]] = std::complex<float>(even, odd); // NOLINT
+	}
+
+	// Iterative radix 2 transform.
+	for (qsizetype length = 2; length <= half; length *= 2) {
+		auto span = length / 2;
+		auto step = size / length;
+
+		for (qsizetype start = 0; start < half; start += length) {
+			for (qsizetype i = 0; i != span; i++) {
+				auto& a = buffer[start + i];        // NOLINT
+				auto& b = buffer[start + i + span]; // NOLINT
+				auto t = twiddles[i * step] * b;   // NOLINT
+				b = a - t;
+				a += t;
+			}
+		}
+	}
+
+	// A full scale sine reaches size / 4 after the window's 0.5 gain.
+	auto scale = 4.0f / static_cast<float>(size);
+
+	for (auto band = 0; band != this->mBands; band++) {
+		auto peak = 0.0f;
+
+		// Unpacks bin k of the real transform from the packed one.
+		for (auto k = this->bandStart[band]; k != this->bandEnd[band]; k++) {
+			auto z = buffer[k];                        // NOLINT
+			auto mirrored = std::conj(buffer[half - k]); // NOLINT
+			auto even = (z + mirrored) * 0.5f;
+			auto odd = (z - mirrored) * std::complex<float>(0.0f, -0.5f);
+			peak = std::max(peak, std::norm(even + twiddles[k] * odd)); // NOLINT
+		}
+
+		auto db = 10.0f * std::log10(std::max(peak * scale * scale, 1e-12f));
+		levels[band] = std::clamp((db + LEVEL_RANGE_DB) / LEVEL_RANGE_DB, 0.0f, 1.0f); // NOLINT
+	}
+}
+
+class PwSpectrumStream: public PwAudioCapture {
+public:
+	PwSpectrumStream(PwNodeSpectrumMonitor* monitor, PwNode* node)
+	    : PwAudioCapture(node)
+	    , monitor(monitor) {
+		this->setCaptureSize(monitor->mFftSize);
+	}
+
+	~PwSpectrumStream() override { this->destroy(); }
+	Q_DISABLE_COPY_MOVE(PwSpectrumStream);
+
+	bool start() {
+		return this->PwAudioCapture::start(
+		    "quickshell-spectrum-monitor",
+		    "Spectrum analyzer",
+		    "Quickshell Spectrum Analyzer"
+		);
+	}
+
+	void setCaptureSize(qsizetype size) { this->captureSize.store(size, std::memory_order_relaxed); }
+
+	// Analyzes the newest samples if any arrived since the last call.
+	void deliverSpectrum();
+
+protected:
+	void process(const float* samples, qsizetype frames, quint32 channels) override;
+	void formatChanged() override { this->monitor->resetValues(); }
+	void formatReset() override { this->monitor->clearValues(); }
+	void stateChanged(pw_stream_state oldState, pw_stream_state state) override;
+
+private:
+	static constexpr auto HISTORY_SIZE = SpectrumAnalyzer::MAX_FFT_SIZE;
+
+	struct SampleSlot {
+		qsizetype size = 0;
+		std::array<float, HISTORY_SIZE> samples {};
+	};
+
+	PwNodeSpectrumMonitor* monitor = nullptr;
+	// Number of samples handed to the main thread for each update. Set by the main thread.
+	std::atomic<qsizetype> captureSize = 0;
+	PwMailbox<SampleSlot> mailbox;
+
+	// Data loop only. Ring of the newest samples, downmixed to mono.
+	std::array<float, HISTORY_SIZE> history {};
+	qsizetype historyPosition = 0;
+};
+
+void PwSpectrumStream::process(const float* samples, qsizetype frames, quint32 channels) {
+	auto scale = 1.0f / static_cast<float>(channels);
+
+	for (qsizetype frame = 0; frame != frames; frame++) {
+		const auto* frameSamples = samples + frame * channels; // NOLINT
+
+		auto sum = 0.0f;
+		for (quint32 channel = 0; channel != channels; channel++) {
+			sum += frameSamples[channel]; // NOLINT
+		}
+
+		this->history.at(this->historyPosition) = sum * scale;
+		this->historyPosition = (this->historyPosition + 1) & (HISTORY_SIZE - 1);
+	}
+
+	auto size = this->captureSize.load(std::memory_order_relaxed);
+	auto& slot = this->mailbox.back();
+	slot.size = size;
+
+	// Oldest first.
+	auto start = (this->historyPosition - size) & (HISTORY_SIZE - 1);
+	auto wrapped = std::max<qsizetype>(start + size - HISTORY_SIZE, 0);
+	std::copy_n(this->history.begin() + start, size - wrapped, slot.samples.begin());
+	std::copy_n(this->history.begin(), wrapped, slot.samples.begin() + (size - wrapped));
+
+	this->mailbox.publish();
+}
+
+void PwSpectrumStream::stateChanged(pw_stream_state oldState, pw_stream_state state) {
+	if (state == PW_STREAM_STATE_STREAMING) {
+		this->monitor->mFrameTimer.start();
+	} else {
+		this->monitor->mFrameTimer.stop();
+	}
+
+	if (state == PW_STREAM_STATE_PAUSED && oldState != PW_STREAM_STATE_PAUSED) {
+		this->monitor->resetValues();
+	}
+}
+
+void PwSpectrumStream::deliverSpectrum() {
+	const auto* slot = this->mailbox.take();
+	if (slot == nullptr || !this->isFormatReady()) return;
+
+	// Captured before the FFT size changed.
+	if (slot->size != this->monitor->mFftSize) return;
+
+	this->monitor->updateSpectrum(slot->samples.data(), static_cast<float>(this->format().rate));
+}
+
+PwNodeSpectrumMonitor::PwNodeSpectrumMonitor(QObject* parent): QObject(parent) {
+	this->mFrameTimer.setInterval(1000 / this->mFrameRate);
+	QObject::connect(
+	    &this->mFrameTimer,
+	    &QTimer::timeout,
+	    this,
+	    &PwNodeSpectrumMonitor::onFrameTimeout
+	);
+}
+
+PwNodeSpectrumMonitor::~PwNodeSpectrumMonitor() {
+	delete this->mStream;
+	this->mStream = nullptr;
+}
+
+PwNodeIface* PwNodeSpectrumMonitor::node() const { return this->mNode; }
+
+void PwNodeSpectrumMonitor::setNode(PwNodeIface* node) {
+	if (node == this->mNode) return;
+
+	if (this->mNode != nullptr) {
+		QObject::disconnect(this->mNode, nullptr, this, nullptr);
+	}
+
+	if (node != nullptr) {
+		QObject::connect(node, &QObject::destroyed, this, &PwNodeSpectrumMonitor::onNodeDestroyed);
+	}
+
+	this->mNode = node;
+	this->mNodeRef.setObject(node != nullptr ? node->node() : nullptr);
+	this->rebuildStream();
+	emit this->nodeChanged();
+}
+
+bool PwNodeSpectrumMonitor::isEnabled() const { return this->mEnabled; }
+
+void PwNodeSpectrumMonitor::setEnabled(bool enabled) {
+	if (enabled == this->mEnabled) return;
+	this->mEnabled = enabled;
+	this->rebuildStream();
+	emit this->enabledChanged();
+}
+
+void PwNodeSpectrumMonitor::setBands(int bands) {
+	bands = std::max(bands, 1);
+	if (bands == this->mBands) return;
+	this->mBands = bands;
+	if (this->mStream != nullptr && this->mStream->isFormatReady()) this->resetValues();
+	emit this->bandsChanged();
+}
+
+void PwNodeSpectrumMonitor::setFftSize(int fftSize) {
+	auto size = std::bit_ceil(static_cast<quint32>(std::clamp(
+	    static_cast<qsizetype>(fftSize),
+	    SpectrumAnalyzer::MIN_FFT_SIZE,
+	    SpectrumAnalyzer::MAX_FFT_SIZE
+	)));
+
+	if (static_cast<int>(size) == this->mFftSize) return;
+	this->mFftSize = static_cast<int>(size);
+	if (this->mStream != nullptr) this->mStream->setCaptureSize(this->mFftSize);
+	emit this->fftSizeChanged();
+}
+
+void PwNodeSpectrumMonitor::setLowerCutoff(qreal lowerCutoff) {
+	if (lowerCutoff == this->mLowerCutoff) return;
+	this->mLowerCutoff = lowerCutoff;
+	emit this->lowerCutoffChanged();
+}
+
+void PwNodeSpectrumMonitor::setUpperCutoff(qreal upperCutoff) {
+	if (upperCutoff == this->mUpperCutoff) return;
+	this->mUpperCutoff = upperCutoff;
+	emit this->upperCutoffChanged();
+}
+
+void PwNodeSpectrumMonitor::setSmoothing(qreal smoothing) {
+	smoothing = std::clamp(smoothing, 0.0, 1.0);
+	if (smoothing == this->mSmoothing) return;
+	this->mSmoothing = smoothing;
+	emit this->smoothingChanged();
+}
+
+void PwNodeSpectrumMonitor::setFrameRate(int frameRate) {
+	frameRate = std::clamp(frameRate, 1, 1000);
+	if (frameRate == this->mFrameRate) return;
+	this->mFrameRate = frameRate;
+	this->mFrameTimer.setInterval(1000 / frameRate);
+	emit this->frameRateChanged();
+}
+
+void PwNodeSpectrumMonitor::onNodeDestroyed() {
+	this->mNode = nullptr;
+	this->mNodeRef.setObject(nullptr);
+	this->rebuildStream();
+	emit this->nodeChanged();
+}
+
+void PwNodeSpectrumMonitor::onFrameTimeout() {
+	if (this->mStream != nullptr) this->mStream->deliverSpectrum();
+}
+
+void PwNodeSpectrumMonitor::updateSpectrum(const float* samples, float rate) {
+	this->analyzer.configure(
+	    this->mFftSize,
+	    this->mBands,
+	    static_cast<float>(this->mLowerCutoff),
+	    static_cast<float>(this->mUpperCutoff),
+	    rate
+	);
+
+	this->levels.resize(this->mBands);
+	this->analyzer.analyze(samples, this->levels.data());
+
+	if (this->mValues.length() != this->mBands) this->mValues.fill(0.0f, this->mBands);
+
+	// Only detaches if the last update's values are still referenced.
+	auto* values = this->mValues.data();
+	auto smoothing = static_cast<float>(this->mSmoothing);
+
+	for (auto i = 0; i != this->mBands; i++) {
+		auto level = this->levels.at(i);
+		auto& value = values[i]; // NOLINT
+		value = level >= value ? level : value * smoothing + level * (1.0f - smoothing);
+	}
+
+	emit this->valuesChanged();
+}
+
+void PwNodeSpectrumMonitor::resetValues() {
+	this->mValues.fill(0.0f, this->mBands);
+	emit this->valuesChanged();
+}
+
+void PwNodeSpectrumMonitor::clearValues() {
+	if (this->mValues.isEmpty()) return;
+	this->mValues.clear();
+	emit this->valuesChanged();
+}
+
+void PwNodeSpectrumMonitor::rebuildStream() {
+	this->mFrameTimer.stop();
+	delete this->mStream;
+	this->mStream = nullptr;
+
+	auto* node = this->mNodeRef.object();
+	if (!this->mEnabled || node == nullptr || !node->type.testFlags(PwNodeType::Audio)) {
+		this->clearValues();
+		return;
+	}
+
+	this->mStream = new PwSpectrumStream(this, node);
+	if (!this->mStream->start()) {
+		delete this->mStream;
+		this->mStream = nullptr;
+		this->clearValues();
+	}
+}
+
+} // namespace qs::service::pipewire
@@ -0,0 +1,167 @@
+#pragma once
+
+#include <complex>
+
+#include <qobject.h>
+#include <qqmlintegration.h>
+#include <qtclasshelpermacros.h>
+#include <qtimer.h>
+#include <qtmetamacros.h>
+#include <qtypes.h>
+#include <qvector.h>
+
+#include "node.hpp"
+#include "peak.hpp" // NOLINT: declares PwNodeIface as an opaque pointer
+
+namespace qs::service::pipewire {
+
+class PwSpectrumStream;
+
+// Windowed FFT of mono samples, grouped into logarithmically spaced bands.
+class SpectrumAnalyzer {
+public:
+	static constexpr qsizetype MIN_FFT_SIZE = 256;
+	static constexpr qsizetype MAX_FFT_SIZE = 8192;
+
+	// Takes effect on the next analysis, which replans if anything changed.
+	void configure(
+	    qsizetype fftSize,
+	    qsizetype bands,
+	    float lowerCutoff,
+	    float upperCutoff,
+	    float rate
+	);
+
+	// Computes the level of each band from 0.0 to 1.0 from the last fftSize samples.
+	void analyze(const float* samples, float* levels);
+
+	[[nodiscard]] qsizetype fftSize() const { return this->mFftSize; }
+	[[nodiscard]] qsizetype bands() const { return this->mBands; }
+
+private:
+	void plan();
+
+	qsizetype mFftSize = 0;
+	qsizetype mBands = 0;
+	float lowerCutoff = 0;
+	float upperCutoff = 0;
+	float rate = 0;
+	bool planned = false;
+
+	QVector<float> window;
+	// e^(-2πik/fftSize) for k below fftSize / 2.
+	QVector<std::complex<float>> twiddles;
+	QVector<quint32> bitReverse;
+	QVector<std::complex<float>> buffer;
+	// Range of FFT bins making up each band.
+	QVector<qsizetype> bandStart;
+	QVector<qsizetype> bandEnd;
+};
+
+///! Frequency spectrum of an audio node.
+/// Computes the frequency spectrum of a node's audio for use in visualizers, as a set of
+/// logarithmically spaced frequency bands.
+///
+/// The spectrum monitor binds nodes similarly to @@PwObjectTracker when enabled.
+class PwNodeSpectrumMonitor: public QObject {
+	Q_OBJECT;
+	// clang-format off
+	/// The node to monitor. Must be an audio node.
+	Q_PROPERTY(qs::service::pipewire::PwNodeIface* node READ node WRITE setNode NOTIFY nodeChanged);
+	/// If true, the monitor is actively capturing and computing the spectrum. Defaults to true.
+	Q_PROPERTY(bool enabled READ isEnabled WRITE setEnabled NOTIFY enabledChanged);
+	/// Number of frequency bands in @@values. Defaults to 32.
+	Q_PROPERTY(int bands READ bands WRITE setBands NOTIFY bandsChanged);
+	/// Number of samples analyzed for each update. Larger sizes resolve low frequencies better,
+	/// but respond more slowly. Rounded up to a power of two between 256 and 8192. Defaults to 2048.
+	Q_PROPERTY(int fftSize READ fftSize WRITE setFftSize NOTIFY fftSizeChanged);
+	/// Lowest frequency shown, in Hz. Defaults to 50.
+	Q_PROPERTY(qreal lowerCutoff READ lowerCutoff WRITE setLowerCutoff NOTIFY lowerCutoffChanged);
+	/// Highest frequency shown, in Hz. Defaults to 10000.
+	Q_PROPERTY(qreal upperCutoff READ upperCutoff WRITE setUpperCutoff NOTIFY upperCutoffChanged);
+	/// How slowly bands fall after rising, from 0.0 (not smoothed) to 1.0 (never fall). Defaults to 0.7.
+	///
+	/// Bands always rise immediately.
+	Q_PROPERTY(qreal smoothing READ smoothing WRITE setSmoothing NOTIFY smoothingChanged);
+	/// Maximum number of times per second @@values is updated. Defaults to 60.
+	Q_PROPERTY(int frameRate READ frameRate WRITE setFrameRate NOTIFY frameRateChanged);
+	/// Level of each frequency band (0.0-1.0), from the lowest frequency to the highest.
+	/// Length matches @@bands.
+	///
+	/// Levels are scaled over a 60dB range, and are not affected by the node's volume.
+	Q_PROPERTY(QVector<float> values READ values NOTIFY valuesChanged);
+	// clang-format on
+	QML_ELEMENT;
+
+public:
+	explicit PwNodeSpectrumMonitor(QObject* parent = nullptr);
+	~PwNodeSpectrumMonitor() override;
+	Q_DISABLE_COPY_MOVE(PwNodeSpectrumMonitor);
+
+	[[nodiscard]] PwNodeIface* node() const;
+	void setNode(PwNodeIface* node);
+
+	[[nodiscard]] bool isEnabled() const;
+	void setEnabled(bool enabled);
+
+	[[nodiscard]] int bands() const { return this->mBands; }
+	void setBands(int bands);
+
+	[[nodiscard]] int fftSize() const { return this->mFftSize; }
+	void setFftSize(int fftSize);
+
+	[[nodiscard]] qreal lowerCutoff() const { return this->mLowerCutoff; }
+	void setLowerCutoff(qreal lowerCutoff);
+
+	[[nodiscard]] qreal upperCutoff() const { return this->mUpperCutoff; }
+	void setUpperCutoff(qreal upperCutoff);
+
+	[[nodiscard]] qreal smoothing() const { return this->mSmoothing; }
+	void setSmoothing(qreal smoothing);
+
+	[[nodiscard]] int frameRate() const { return this->mFrameRate; }
+	void setFrameRate(int frameRate);
+
+	[[nodiscard]] QVector<float> values() const { return this->mValues; }
+
+signals:
+	void nodeChanged();
+	void enabledChanged();
+	void bandsChanged();
+	void fftSizeChanged();
+	void lowerCutoffChanged();
+	void upperCutoffChanged();
+	void smoothingChanged();
+	void frameRateChanged();
+	void valuesChanged();
+
+private slots:
+	void onNodeDestroyed();
+	void onFrameTimeout();
+
+private:
+	friend class PwSpectrumStream;
+
+	void updateSpectrum(const float* samples, float rate);
+	void resetValues();
+	void clearValues();
+	void rebuildStream();
+
+	PwNodeIface* mNode = nullptr;
+	PwBindableRef<PwNode> mNodeRef;
+	bool mEnabled = true;
+	int mBands = 32;
+	int mFftSize = 2048;
+	qreal mLowerCutoff = 50;
+	qreal mUpperCutoff = 10000;
+	qreal mSmoothing = 0.7;
+	int mFrameRate = 60;
+	QVector<float> mValues;
+	// Unsmoothed levels of the last update.
+	QVector<float> levels;
+	SpectrumAnalyzer analyzer;
+	PwSpectrumStream* mStream = nullptr;
+	QTimer mFrameTimer;
+};
+
+} // namespace qs::service::pipewire
@@ -1,16 +1,27 @@
 #include "dbus_item_types.hpp"
 
+#include <qbytearray.h>
 #include <qdbusargument.h>
 #include <qdebug.h>
 #include <qendian.h>
 #include <qimage.h>
 #include <qlogging.h>
 #include <qmetatype.h>
-#include <qsysinfo.h>
+#include <qnamespace.h>
+#include <qsize.h>
 #include <qtypes.h>
 
+#include "../../dbus/image.hpp"
+
+namespace {
+
+// Larger pixmaps than any tray or tooltip could reasonably display are scaled down on receipt.
+const QSize MAX_PIXMAP_SIZE = QSize(256, 256);
+
+} // namespace
+
 bool DBusSniIconPixmap::operator==(const DBusSniIconPixmap& other) const {
-	return this->width == other.width && this->height == other.height && this->data == other.data;
+	return this->width == other.width && this->height == other.height && this->image == other.image;
 }
 
 bool DBusSniTooltip::operator==(const DBusSniTooltip& other) const {
@@ -18,48 +29,41 @@ bool DBusSniTooltip::operator==(const DBusSniTooltip& other) const {
 	    && this->description == other.description && this->iconPixmaps == other.iconPixmaps;
 }
 
-QImage DBusSniIconPixmap::createImage() const {
-	// fix byte order if on a little endian machine
-	if (QSysInfo::ByteOrder == QSysInfo::LittleEndian) {
-		auto* newbuf = new quint32[this->data.size()];
-		const auto* oldbuf = reinterpret_cast<const quint32*>(this->data.constData());
-
-		for (uint i = 0; i < this->data.size() / sizeof(quint32); ++i) {
-			newbuf[i] = qFromBigEndian(oldbuf[i]); // NOLINT
-		}
-
-		return QImage(
-		    reinterpret_cast<const uchar*>(newbuf),
-		    this->width,
-		    this->height,
-		    QImage::Format_ARGB32,
-		    [](void* ptr) { delete[] reinterpret_cast<quint32*>(ptr); },
-		    newbuf
-		);
-	} else {
-		return QImage(
-		    reinterpret_cast<const uchar*>(this->data.constData()),
-		    this->width,
-		    this->height,
-		    QImage::Format_ARGB32
-		);
-	}
-}
-
 const QDBusArgument& operator>>(const QDBusArgument& argument, DBusSniIconPixmap& pixmap) {
 	argument.beginStructure();
-	argument >> pixmap.width;
-	argument >> pixmap.height;
-	argument >> pixmap.data;
+	auto width = qdbus_cast<qint32>(argument);
+	auto height = qdbus_cast<qint32>(argument);
+	auto data = qdbus_cast<QByteArray>(argument);
 	argument.endStructure();
+
+	auto info = qs::dbus::DBusImageInfo {
+	    .width = width,
+	    .height = height,
+	    .layout = qs::dbus::DBusImageLayout::Argb32BigEndian,
+	};
+
+	pixmap.image = qs::dbus::ingestDBusImage(info, data, MAX_PIXMAP_SIZE);
+	pixmap.width = pixmap.image.width();
+	pixmap.height = pixmap.image.height();
 	return argument;
 }
 
 const QDBusArgument& operator<<(QDBusArgument& argument, const DBusSniIconPixmap& pixmap) {
+	auto image = pixmap.image.convertToFormat(QImage::Format_ARGB32);
+	auto data = QByteArray(image.width() * image.height() * 4, Qt::Uninitialized);
+
+	for (auto y = 0; y != image.height(); y++) {
+		qToBigEndian<quint32>(
+		    image.constScanLine(y),
+		    image.width(),
+		    data.data() + static_cast<qsizetype>(y) * image.width() * 4 // NOLINT
+		);
+	}
+
 	argument.beginStructure();
-	argument << pixmap.width;
-	argument << pixmap.height;
-	argument << pixmap.data;
+	argument << image.width();
+	argument << image.height();
+	argument << data;
 	argument.endStructure();
 	return argument;
 }
@@ -69,7 +73,8 @@ const QDBusArgument& operator>>(const QDBusArgument& argument, DBusSniIconPixmap
 	pixmaps.clear();
 
 	while (!argument.atEnd()) {
-		pixmaps.append(qdbus_cast<DBusSniIconPixmap>(argument));
+		auto pixmap = qdbus_cast<DBusSniIconPixmap>(argument);
+		if (!pixmap.image.isNull()) pixmaps.append(pixmap);
 	}
 
 	argument.endArray();
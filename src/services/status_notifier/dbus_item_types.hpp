@@ -2,15 +2,15 @@
 
 #include <qdbusargument.h>
 #include <qdebug.h>
+#include <qimage.h>
 #include <qlist.h>
 
 struct DBusSniIconPixmap {
 	qint32 width = 0;
 	qint32 height = 0;
-	QByteArray data;
-
-	// valid only for the lifetime of the pixmap
-	[[nodiscard]] QImage createImage() const;
+	// Ingested through qs::dbus::ingestDBusImage, so it is premultiplied and size limited.
+	// Null if the pixmap was malformed.
+	QImage image;
 
 	bool operator==(const DBusSniIconPixmap& other) const;
 };
@@ -27,6 +27,8 @@ struct DBusSniTooltip {
 };
 
 const QDBusArgument& operator>>(const QDBusArgument& argument, DBusSniIconPixmap& pixmap);
+// Serializes the ingested image, not the data it was read from. Pixmaps scaled down on receipt
+// keep their reduced size, and premultiplication may round the color of translucent pixels.
 const QDBusArgument& operator<<(QDBusArgument& argument, const DBusSniIconPixmap& pixmap);
 const QDBusArgument& operator>>(const QDBusArgument& argument, DBusSniIconPixmapList& pixmaps);
 const QDBusArgument& operator<<(QDBusArgument& argument, const DBusSniIconPixmapList& pixmaps);
@@ -1,4 +1,5 @@
 #include "item.hpp"
+#include <utility>
 
 #include <qdbuserror.h>
 #include <qdbusextratypes.h>
@@ -6,6 +7,8 @@
 #include <qdbuspendingcall.h>
 #include <qdbuspendingreply.h>
 #include <qicon.h>
+#include <qimage.h>
+#include <qlist.h>
 #include <qlogging.h>
 #include <qloggingcategory.h>
 #include <qnamespace.h>
@@ -16,6 +19,7 @@
 #include <qrect.h>
 #include <qsize.h>
 #include <qstring.h>
+#include <qthreadpool.h>
 #include <qtmetamacros.h>
 #include <qtypes.h>
 
@@ -123,6 +127,8 @@ StatusNotifierItem::StatusNotifierItem(const QString& address, QObject* parent)
 	    }
 	);
 
+	// Some apps send icon change signals many times a second.
+	this->properties.setRefreshWindow(50);
 	this->properties.setInterface(this->item);
 	this->properties.updateAllViaGetAll();
 }
@@ -130,62 +136,130 @@ StatusNotifierItem::StatusNotifierItem(const QString& address, QObject* parent)
 bool StatusNotifierItem::isValid() const { return this->item->isValid(); }
 bool StatusNotifierItem::isReady() const { return this->mReady; }
 
-QPixmap StatusNotifierItem::createPixmap(const QSize& size) const {
-	auto needsAttention = this->bStatus.value() == Status::NeedsAttention;
+namespace {
 
-	auto closestPixmap = [](const QSize& size, const DBusSniIconPixmapList& pixmaps) {
-		const DBusSniIconPixmap* ret = nullptr;
+const DBusSniIconPixmap* closestPixmap(const QSize& size, const DBusSniIconPixmapList& pixmaps) {
+	const DBusSniIconPixmap* ret = nullptr;
 
-		for (const auto& pixmap: pixmaps) {
-			if (ret == nullptr) {
-				ret = &pixmap;
-				continue;
-			}
+	for (const auto& pixmap: pixmaps) {
+		if (ret == nullptr) {
+			ret = &pixmap;
+			continue;
+		}
 
-			auto existingAdequate = ret->width >= size.width() && ret->height >= size.height();
-			auto newAdequite = pixmap.width >= size.width() && pixmap.height >= size.height();
-			auto newSmaller = pixmap.width < ret->width || pixmap.height < ret->height;
+		auto existingAdequate = ret->width >= size.width() && ret->height >= size.height();
+		auto newAdequite = pixmap.width >= size.width() && pixmap.height >= size.height();
+		auto newSmaller = pixmap.width < ret->width || pixmap.height < ret->height;
 
-			if ((existingAdequate && newAdequite && newSmaller) || (!existingAdequate && !newSmaller)) {
-				ret = &pixmap;
-			}
+		if ((existingAdequate && newAdequite && newSmaller) || (!existingAdequate && !newSmaller)) {
+			ret = &pixmap;
 		}
+	}
+
+	return ret;
+}
+
+QImage scaledImage(const DBusSniIconPixmap* icon, const QSize& size) {
+	if (icon == nullptr) return QImage();
+	if (icon->image.size() == size) return icon->image;
+	return icon->image.scaled(size, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+}
+
+} // namespace
+
+QImage TrayIconSource::render(const QSize& size) const {
+	if (this->needsAttention) {
+		const auto* icon = closestPixmap(size, this->attention);
+		if (icon == nullptr) icon = closestPixmap(size, this->icon);
+		return scaledImage(icon, size);
+	}
+
+	auto image = scaledImage(closestPixmap(size, this->icon), size);
+	if (image.isNull()) return image;
+
+	auto overlay = scaledImage(closestPixmap(image.size(), this->overlay), size);
+
+	if (!overlay.isNull()) {
+		image.convertTo(QImage::Format_ARGB32_Premultiplied);
+		auto painter = QPainter(&image);
+		painter.drawImage(QRect(0, 0, image.width(), image.height()), overlay);
+		painter.end();
+	}
 
-		return ret;
+	return image;
+}
+
+TrayIconRenderOperation::TrayIconRenderOperation(TrayIconSource source, QList<TrayIconKey> keys)
+    : source(std::move(source))
+    , keys(std::move(keys)) {
+	this->setAutoDelete(false);
+}
+
+void TrayIconRenderOperation::run() {
+	for (const auto& key: this->keys) {
+		if (this->shouldCancel.loadAcquire()) break;
+		this->images.append(this->source.render(key.size));
+	}
+
+	QMetaObject::invokeMethod(this, &TrayIconRenderOperation::finished, Qt::QueuedConnection);
+}
+
+void TrayIconRenderOperation::tryCancel() { this->shouldCancel.storeRelease(true); }
+
+void TrayIconRenderOperation::finished() {
+	if (!this->shouldCancel.loadAcquire()) emit this->done(this->keys, this->images);
+	delete this;
+}
+
+StatusNotifierItem::~StatusNotifierItem() { this->cancelIconRender(); }
+
+QPixmap StatusNotifierItem::createPixmap(const QSize& size) {
+	auto key = TrayIconKey {
+	    .pixmapIndex = this->pixmapIndex.value(),
+	    .size = size,
+	    .status = this->bStatus.value(),
 	};
 
-	QPixmap pixmap;
-	if (needsAttention) {
-		if (!this->bAttentionIconName.value().isEmpty()) {
-			auto icon = QIcon::fromTheme(this->bAttentionIconName.value());
-			pixmap = icon.pixmap(size.width(), size.height());
-		} else {
-			const auto* icon = closestPixmap(size, this->bAttentionIconPixmaps.value());
+	if (auto* cached = this->iconCache.object(key)) return *cached;
 
-			if (icon == nullptr) {
-				icon = closestPixmap(size, this->bIconPixmaps.value());
-			}
+	auto pixmap = this->renderPixmap(size);
+	if (!pixmap.isNull()) this->iconCache.insert(key, new QPixmap(pixmap));
 
-			if (icon != nullptr) {
-				const auto image =
-				    icon->createImage().scaled(size, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+	return pixmap;
+}
 
-				pixmap = QPixmap::fromImage(image);
-			}
-		}
+bool StatusNotifierItem::usesThemeIcons() const {
+	if (this->bStatus.value() == Status::NeedsAttention) {
+		return !this->bAttentionIconName.value().isEmpty();
+	} else {
+		return !this->bIconName.value().isEmpty() || !this->bOverlayIconName.value().isEmpty();
+	}
+}
+
+TrayIconSource StatusNotifierItem::iconSource() const {
+	return TrayIconSource {
+	    .needsAttention = this->bStatus.value() == Status::NeedsAttention,
+	    .icon = this->bIconPixmaps.value(),
+	    .overlay = this->bOverlayIconPixmaps.value(),
+	    .attention = this->bAttentionIconPixmaps.value(),
+	};
+}
+
+QPixmap StatusNotifierItem::renderPixmap(const QSize& size) const {
+	if (!this->usesThemeIcons()) return QPixmap::fromImage(this->iconSource().render(size));
+
+	// Theme icons are looked up through QIcon, which is only usable from the main thread.
+	QPixmap pixmap;
+	if (this->bStatus.value() == Status::NeedsAttention) {
+		auto icon = QIcon::fromTheme(this->bAttentionIconName.value());
+		pixmap = icon.pixmap(size.width(), size.height());
 	} else {
 		if (!this->bIconName.value().isEmpty()) {
 			auto icon = QIcon::fromTheme(this->bIconName.value());
 			pixmap = icon.pixmap(size.width(), size.height());
 		} else {
 			const auto* icon = closestPixmap(size, this->bIconPixmaps.value());
-
-			if (icon != nullptr) {
-				const auto image =
-				    icon->createImage().scaled(size, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
-
-				pixmap = QPixmap::fromImage(image);
-			}
+			pixmap = QPixmap::fromImage(scaledImage(icon, size));
 		}
 
 		QPixmap overlay;
@@ -194,13 +268,7 @@ QPixmap StatusNotifierItem::createPixmap(const QSize& size) const {
 			overlay = icon.pixmap(pixmap.width(), pixmap.height());
 		} else {
 			const auto* icon = closestPixmap(pixmap.size(), this->bOverlayIconPixmaps.value());
-
-			if (icon != nullptr) {
-				const auto image =
-				    icon->createImage().scaled(size, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
-
-				overlay = QPixmap::fromImage(image);
-			}
+			overlay = QPixmap::fromImage(scaledImage(icon, size));
 		}
 
 		if (!overlay.isNull()) {
@@ -267,7 +335,73 @@ void StatusNotifierItem::scroll(qint32 delta, bool horizontal) const {
 	this->item->Scroll(delta, horizontal ? "horizontal" : "vertical");
 }
 
-void StatusNotifierItem::updatePixmapIndex() { this->pixmapIndex = this->pixmapIndex + 1; }
+void StatusNotifierItem::updatePixmapIndex() {
+	this->cancelIconRender();
+	auto nextIndex = this->pixmapIndex.value() + 1;
+
+	if (this->usesThemeIcons()) {
+		this->setPixmapIndex(nextIndex);
+		return;
+	}
+
+	// Re-render sizes that are already in use before changing the icon url, so consumers find
+	// the new icon in the cache instead of rasterizing it on the main thread.
+	auto keys = QList<TrayIconKey>();
+	auto status = this->bStatus.value();
+
+	for (const auto& key: this->iconCache.keys()) {
+		auto renderKey = TrayIconKey {.pixmapIndex = nextIndex, .size = key.size, .status = status};
+		if (!keys.contains(renderKey)) keys.append(renderKey);
+	}
+
+	if (keys.isEmpty()) {
+		this->setPixmapIndex(nextIndex);
+		return;
+	}
+
+	this->liveIconRender = new TrayIconRenderOperation(this->iconSource(), keys);
+
+	QObject::connect(
+	    this->liveIconRender,
+	    &TrayIconRenderOperation::done,
+	    this,
+	    &StatusNotifierItem::onIconRenderFinished
+	);
+
+	QThreadPool::globalInstance()->start(this->liveIconRender);
+}
+
+void StatusNotifierItem::onIconRenderFinished(
+    const QList<TrayIconKey>& keys,
+    const QList<QImage>& images
+) {
+	this->liveIconRender = nullptr;
+
+	for (auto i = 0; i != images.length(); i++) {
+		if (images.at(i).isNull()) continue;
+		this->iconCache.insert(keys.at(i), new QPixmap(QPixmap::fromImage(images.at(i))));
+	}
+
+	this->setPixmapIndex(keys.first().pixmapIndex);
+}
+
+void StatusNotifierItem::cancelIconRender() {
+	if (!this->liveIconRender) return;
+
+	// The operation deletes itself once the worker returns.
+	this->liveIconRender->tryCancel();
+	QObject::disconnect(this->liveIconRender, nullptr, this, nullptr);
+	this->liveIconRender = nullptr;
+}
+
+void StatusNotifierItem::setPixmapIndex(quint32 index) {
+	// Icons of older indexes can no longer be requested.
+	for (const auto& key: this->iconCache.keys()) {
+		if (key.pixmapIndex != index) this->iconCache.remove(key);
+	}
+
+	this->pixmapIndex = index;
+}
 
 DBusMenuHandle* StatusNotifierItem::menuHandle() {
 	return this->bMenuPath.value().path().isEmpty() ? nullptr : &this->mMenuHandle;
@@ -1,12 +1,19 @@
 #pragma once
 
+#include <qatomic.h>
+#include <qcache.h>
 #include <qdbusextratypes.h>
 #include <qdbuspendingcall.h>
+#include <qhashfunctions.h>
 #include <qicon.h>
+#include <qimage.h>
+#include <qlist.h>
 #include <qloggingcategory.h>
 #include <qobject.h>
 #include <qpixmap.h>
 #include <qproperty.h>
+#include <qrunnable.h>
+#include <qsize.h>
 #include <qtmetamacros.h>
 #include <qtypes.h>
 
@@ -82,6 +89,61 @@ namespace qs::service::sni {
 
 class StatusNotifierItem;
 
+// Identifies a rasterized tray icon in an item's icon cache.
+struct TrayIconKey {
+	quint32 pixmapIndex = 0;
+	QSize size;
+	Status::Enum status = Status::Passive;
+
+	[[nodiscard]] bool operator==(const TrayIconKey& other) const = default;
+};
+
+inline size_t qHash(const TrayIconKey& key, size_t seed = 0) {
+	return qHashMulti(
+	    seed,
+	    key.pixmapIndex,
+	    key.size.width(),
+	    key.size.height(),
+	    static_cast<quint8>(key.status)
+	);
+}
+
+// Icon pixmaps sent over dbus, copied so they can be rasterized off the main thread.
+struct TrayIconSource {
+	bool needsAttention = false;
+	DBusSniIconPixmapList icon;
+	DBusSniIconPixmapList overlay;
+	DBusSniIconPixmapList attention;
+
+	// Safe to call from any thread.
+	[[nodiscard]] QImage render(const QSize& size) const;
+};
+
+class TrayIconRenderOperation
+    : public QObject
+    , public QRunnable {
+	Q_OBJECT;
+
+public:
+	explicit TrayIconRenderOperation(TrayIconSource source, QList<TrayIconKey> keys);
+
+	void run() override;
+	void tryCancel();
+
+signals:
+	// Images are in the same order as keys.
+	void done(const QList<TrayIconKey>& keys, const QList<QImage>& images);
+
+private slots:
+	void finished();
+
+private:
+	QAtomicInteger<bool> shouldCancel = false;
+	TrayIconSource source;
+	QList<TrayIconKey> keys;
+	QList<QImage> images;
+};
+
 class TrayImageHandle: public QsImageHandle {
 public:
 	explicit TrayImageHandle(StatusNotifierItem* item);
@@ -125,6 +187,8 @@ class StatusNotifierItem: public QObject {
 
 public:
 	explicit StatusNotifierItem(const QString& address, QObject* parent = nullptr);
+	~StatusNotifierItem() override;
+	Q_DISABLE_COPY_MOVE(StatusNotifierItem);
 
 	/// Primary activation action, generally triggered via a left click.
 	Q_INVOKABLE void activate();
@@ -138,7 +202,8 @@ public:
 	[[nodiscard]] bool isValid() const;
 	[[nodiscard]] bool isReady() const;
 	[[nodiscard]] QBindable<QString> bindableIcon() const { return &this->bIcon; }
-	[[nodiscard]] QPixmap createPixmap(const QSize& size) const;
+	// Returns a cached pixmap if one was already created for the current icon.
+	[[nodiscard]] QPixmap createPixmap(const QSize& size);
 
 	[[nodiscard]] dbus::dbusmenu::DBusMenuHandle* menuHandle();
 
@@ -167,16 +232,26 @@ signals:
 private slots:
 	void onGetAllFinished();
 	void onGetAllFailed() const;
+	void onIconRenderFinished(const QList<TrayIconKey>& keys, const QList<QImage>& images);
 
 private:
 	void updateMenuState();
 	void updatePixmapIndex();
 	void onMenuPathChanged();
+	void setPixmapIndex(quint32 index);
+	void cancelIconRender();
+	[[nodiscard]] bool usesThemeIcons() const;
+	[[nodiscard]] TrayIconSource iconSource() const;
+	[[nodiscard]] QPixmap renderPixmap(const QSize& size) const;
 
 	DBusStatusNotifierItem* item = nullptr;
 	TrayImageHandle imageHandle {this};
 	bool mReady = false;
 
+	// Rasterized icons shared by every consumer of imageHandle, with the least recently used evicted.
+	QCache<TrayIconKey, QPixmap> iconCache {8};
+	TrayIconRenderOperation* liveIconRender = nullptr;
+
 	dbus::dbusmenu::DBusMenuHandle mMenuHandle {this};
 
 	QString watcherId;
@@ -13,6 +13,7 @@
 #include <qlocalsocket.h>
 #include <qlogging.h>
 #include <qloggingcategory.h>
+#include <qnamespace.h>
 #include <qobject.h>
 #include <qproperty.h>
 #include <qqml.h>
@@ -106,7 +107,7 @@ void HyprlandIpc::eventSocketError(QLocalSocket::LocalSocketError error) const {
 
 void HyprlandIpc::eventSocketStateChanged(QLocalSocket::LocalSocketState state) {
 	if (state == QLocalSocket::ConnectedState) {
-		this->eventReader.setDevice(&this->eventSocket);
+		this->eventTokenizer.reset();
 		qCInfo(logHyprlandIpc) << "Hyprland event socket connected.";
 		emit this->connected();
 	} else if (state == QLocalSocket::UnconnectedState && this->valid) {
@@ -117,21 +118,16 @@ void HyprlandIpc::eventSocketStateChanged(QLocalSocket::LocalSocketState state)
 }
 
 void HyprlandIpc::eventSocketReady() {
-	while (true) {
-		this->eventReader.startTransaction();
-		auto rawEvent = this->eventReader.readUntil('\n');
-		if (!this->eventReader.commitTransaction()) return;
-
-		rawEvent.chop(1); // remove trailing \n
-		auto splitIdx = rawEvent.indexOf(">>");
-		auto event = QByteArrayView(rawEvent.data(), splitIdx);
-		auto data = QByteArrayView(
-		    rawEvent.data() + splitIdx + 2,     // NOLINT
-		    rawEvent.data() + rawEvent.length() // NOLINT
-		);
-		qCDebug(logHyprlandIpcEvents) << "Received event:" << rawEvent << "parsed as" << event << data;
-
-		this->event.name = event;
+	if (!this->eventTokenizer.fill(&this->eventSocket)) return;
+
+	auto name = QByteArrayView();
+	auto data = QByteArrayView();
+
+	while (this->eventTokenizer.next(name, data)) {
+		qCDebug(logHyprlandIpcEvents) << "Received event:" << name << data;
+
+		this->event.type = hyprlandEventType(name);
+		this->event.name = name;
 		this->event.data = data;
 		this->onEvent(&this->event);
 		emit this->rawEvent(&this->event);
@@ -271,12 +267,15 @@ HyprlandIpc* HyprlandIpc::instance() {
 }
 
 void HyprlandIpc::onEvent(HyprlandIpcEvent* event) {
-	if (event->name == "configreloaded") {
+	switch (event->type) {
+	case HyprlandEventType::ConfigReloaded: {
 		this->refreshMonitors(true);
 		this->refreshWorkspaces(true);
 		this->refreshToplevels();
-	} else if (event->name == "monitoraddedv2") {
-		auto args = event->parseView(3);
+		break;
+	}
+	case HyprlandEventType::MonitorAddedV2: {
+		auto args = event->args<3>();
 
 		auto id = args.at(0).toInt();
 		auto name = QString::fromUtf8(args.at(1));
@@ -301,7 +300,9 @@ void HyprlandIpc::onEvent(HyprlandIpcEvent* event) {
 
 		// refresh even if it already existed because workspace focus might have changed.
 		this->refreshMonitors(false);
-	} else if (event->name == "monitorremoved") {
+		break;
+	}
+	case HyprlandEventType::MonitorRemoved: {
 		const auto& mList = this->mMonitors.valueList();
 		auto name = QString::fromUtf8(event->data);
 
@@ -327,8 +328,10 @@ void HyprlandIpc::onEvent(HyprlandIpcEvent* event) {
 		// If we get to the next cycle and things still reference it (unlikely), nulls
 		// can make it to the frontend.
 		monitor->deleteLater();
-	} else if (event->name == "createworkspacev2") {
-		auto args = event->parseView(2);
+		break;
+	}
+	case HyprlandEventType::CreateWorkspaceV2: {
+		auto args = event->args<2>();
 
 		auto id = args.at(0).toInt();
 		auto name = QString::fromUtf8(args.at(1));
@@ -348,8 +351,10 @@ void HyprlandIpc::onEvent(HyprlandIpcEvent* event) {
 			this->refreshWorkspaces(false);
 			this->mWorkspaces.insertObjectSorted(workspace, &HyprlandIpc::compareWorkspaces);
 		}
-	} else if (event->name == "destroyworkspacev2") {
-		auto args = event->parseView(2);
+		break;
+	}
+	case HyprlandEventType::DestroyWorkspaceV2: {
+		auto args = event->args<2>();
 
 		auto id = args.at(0).toInt();
 		auto name = QString::fromUtf8(args.at(1));
@@ -384,8 +389,10 @@ void HyprlandIpc::onEvent(HyprlandIpcEvent* event) {
 				break;
 			}
 		}
-	} else if (event->name == "focusedmon") {
-		auto args = event->parseView(2);
+		break;
+	}
+	case HyprlandEventType::FocusedMon: {
+		auto args = event->args<2>();
 		auto name = QString::fromUtf8(args.at(0));
 		auto workspaceName = QString::fromUtf8(args.at(1));
 
@@ -399,8 +406,10 @@ void HyprlandIpc::onEvent(HyprlandIpcEvent* event) {
 		monitor->setActiveWorkspace(workspace);
 		qCDebug(logHyprlandIpc) << "Monitor" << name << "focused with workspace"
 		                        << (workspace ? workspace->bindableId().value() : -1);
-	} else if (event->name == "workspacev2") {
-		auto args = event->parseView(2);
+		break;
+	}
+	case HyprlandEventType::WorkspaceV2: {
+		auto args = event->args<2>();
 		auto id = args.at(0).toInt();
 		auto name = QString::fromUtf8(args.at(1));
 
@@ -410,8 +419,10 @@ void HyprlandIpc::onEvent(HyprlandIpcEvent* event) {
 			qCDebug(logHyprlandIpc) << "Workspace" << id << "activated on"
 			                        << this->bFocusedMonitor->bindableName().value();
 		}
-	} else if (event->name == "moveworkspacev2") {
-		auto args = event->parseView(3);
+		break;
+	}
+	case HyprlandEventType::MoveWorkspaceV2: {
+		auto args = event->args<3>();
 		auto id = args.at(0).toInt();
 		auto name = QString::fromUtf8(args.at(1));
 		auto monitorName = QString::fromUtf8(args.at(2));
@@ -421,8 +432,10 @@ void HyprlandIpc::onEvent(HyprlandIpcEvent* event) {
 
 		qCDebug(logHyprlandIpc) << "Workspace" << id << "moved to monitor" << monitorName;
 		workspace->setMonitor(monitor);
-	} else if (event->name == "renameworkspace") {
-		auto args = event->parseView(2);
+		break;
+	}
+	case HyprlandEventType::RenameWorkspace: {
+		auto args = event->args<2>();
 		auto id = args.at(0).toInt();
 		auto name = QString::fromUtf8(args.at(1));
 
@@ -438,7 +451,9 @@ void HyprlandIpc::onEvent(HyprlandIpcEvent* event) {
 		                        << (*workspaceIter)->bindableName().value() << "to" << name;
 
 		(*workspaceIter)->bindableName().setValue(name);
-	} else if (event->name == "fullscreen") {
+		break;
+	}
+	case HyprlandEventType::Fullscreen: {
 		if (auto* workspace = this->bFocusedWorkspace.value()) {
 			workspace->bindableHasFullscreen().setValue(event->data == "1");
 		}
@@ -447,8 +462,10 @@ void HyprlandIpc::onEvent(HyprlandIpcEvent* event) {
 		// the fullscreen state changed, but this falls apart if you move a fullscreen
 		// window between workspaces.
 		this->refreshWorkspaces(false);
-	} else if (event->name == "openwindow") {
-		auto args = event->parseView(4);
+		break;
+	}
+	case HyprlandEventType::OpenWindow: {
+		auto args = event->args<4>();
 		auto ok = false;
 		auto windowAddress = args.at(0).toULongLong(&ok, 16);
 
@@ -478,8 +495,10 @@ void HyprlandIpc::onEvent(HyprlandIpcEvent* event) {
 			qCDebug(logHyprlandIpc) << "New toplevel created with address" << windowAddress << ", title"
 			                        << windowTitle << ", workspace" << workspaceName;
 		}
-	} else if (event->name == "closewindow") {
-		auto args = event->parseView(1);
+		break;
+	}
+	case HyprlandEventType::CloseWindow: {
+		auto args = event->args<1>();
 		auto ok = false;
 		auto windowAddress = args.at(0).toULongLong(&ok, 16);
 
@@ -508,8 +527,10 @@ void HyprlandIpc::onEvent(HyprlandIpcEvent* event) {
 		}
 
 		delete toplevel;
-	} else if (event->name == "movewindowv2") {
-		auto args = event->parseView(3);
+		break;
+	}
+	case HyprlandEventType::MoveWindowV2: {
+		auto args = event->args<3>();
 		auto ok = false;
 		auto windowAddress = args.at(0).toULongLong(&ok, 16);
 		auto workspaceName = QString::fromUtf8(args.at(2));
@@ -536,8 +557,10 @@ void HyprlandIpc::onEvent(HyprlandIpcEvent* event) {
 		}
 
 		workspace->insertToplevel(toplevel);
-	} else if (event->name == "windowtitlev2") {
-		auto args = event->parseView(2);
+		break;
+	}
+	case HyprlandEventType::WindowTitleV2: {
+		auto args = event->args<2>();
 		auto ok = false;
 		auto windowAddress = args.at(0).toULongLong(&ok, 16);
 		auto windowTitle = QString::fromUtf8(args.at(1));
@@ -554,8 +577,10 @@ void HyprlandIpc::onEvent(HyprlandIpcEvent* event) {
 		}
 
 		toplevel->bindableTitle().setValue(windowTitle);
-	} else if (event->name == "activewindowv2") {
-		auto args = event->parseView(1);
+		break;
+	}
+	case HyprlandEventType::ActiveWindowV2: {
+		auto args = event->args<1>();
 		auto ok = false;
 		auto windowAddress = args.at(0).toULongLong(&ok, 16);
 
@@ -565,8 +590,10 @@ void HyprlandIpc::onEvent(HyprlandIpcEvent* event) {
 		// but better safe than sorry, so create if missing.
 		auto* toplevel = this->findToplevelByAddress(windowAddress, true);
 		this->bActiveToplevel = toplevel;
-	} else if (event->name == "urgent") {
-		auto args = event->parseView(1);
+		break;
+	}
+	case HyprlandEventType::Urgent: {
+		auto args = event->args<1>();
 		auto ok = false;
 		auto windowAddress = args.at(0).toULongLong(&ok, 16);
 
@@ -575,6 +602,9 @@ void HyprlandIpc::onEvent(HyprlandIpcEvent* event) {
 		// It happens that Hyprland sends urgent before "openwindow"
 		auto* toplevel = this->findToplevelByAddress(windowAddress, true);
 		toplevel->bindableUrgent().setValue(true);
+		break;
+	}
+	case HyprlandEventType::Unknown: break;
 	}
 }
 
@@ -614,12 +644,46 @@ HyprlandIpc::findWorkspaceByName(const QString& name, bool createIfMissing, qint
 	}
 }
 
+void HyprlandIpc::queueRefresh(RefreshState& state, bool canCreate) {
+	state.queued = true;
+	// A refresh that can create objects covers one that can't.
+	state.canCreate = state.canCreate || canCreate;
+}
+
+void HyprlandIpc::scheduleRefresh() {
+	if (this->refreshScheduled) return;
+	this->refreshScheduled = true;
+
+	// Bursts of events each requesting a refresh collapse into a single request.
+	QMetaObject::invokeMethod(this, &HyprlandIpc::runQueuedRefreshes, Qt::QueuedConnection);
+}
+
+void HyprlandIpc::runQueuedRefreshes() {
+	this->refreshScheduled = false;
+
+	// Refreshes queued while a request is in flight are sent once it completes, as the
+	// in flight response may predate the change that queued them.
+	if (this->monitorsRefresh.queued && !this->monitorsRefresh.requesting) this->requestMonitors();
+	if (this->workspacesRefresh.queued && !this->workspacesRefresh.requesting) {
+		this->requestWorkspaces();
+	}
+	if (this->toplevelsRefresh.queued && !this->toplevelsRefresh.requesting) {
+		this->requestToplevels();
+	}
+}
+
 void HyprlandIpc::refreshWorkspaces(bool canCreate) {
-	if (this->requestingWorkspaces) return;
-	this->requestingWorkspaces = true;
+	HyprlandIpc::queueRefresh(this->workspacesRefresh, canCreate);
+	this->scheduleRefresh();
+}
+
+void HyprlandIpc::requestWorkspaces() {
+	auto canCreate = this->workspacesRefresh.canCreate;
+	this->workspacesRefresh = {.requesting = true};
 
 	this->makeRequest("j/workspaces", [this, canCreate](bool success, const QByteArray& resp) {
-		this->requestingWorkspaces = false;
+		this->workspacesRefresh.requesting = false;
+		if (this->workspacesRefresh.queued) this->scheduleRefresh();
 		if (!success) return;
 
 		qCDebug(logHyprlandIpc) << "Parsing workspaces response";
@@ -703,11 +767,16 @@ HyprlandToplevel* HyprlandIpc::findToplevelByAddress(quint64 address, bool creat
 }
 
 void HyprlandIpc::refreshToplevels() {
-	if (this->requestingToplevels) return;
-	this->requestingToplevels = true;
+	HyprlandIpc::queueRefresh(this->toplevelsRefresh, false);
+	this->scheduleRefresh();
+}
+
+void HyprlandIpc::requestToplevels() {
+	this->toplevelsRefresh = {.requesting = true};
 
 	this->makeRequest("j/clients", [this](bool success, const QByteArray& resp) {
-		this->requestingToplevels = false;
+		this->toplevelsRefresh.requesting = false;
+		if (this->toplevelsRefresh.queued) this->scheduleRefresh();
 		if (!success) return;
 
 		qCDebug(logHyprlandIpc) << "Parsing j/clients response";
@@ -716,7 +785,7 @@ void HyprlandIpc::refreshToplevels() {
 		const auto& mList = this->mToplevels.valueList();
 
 		for (auto entry: json) {
-			auto object = entry.toObject().toVariantMap();
+			auto object = entry.toObject();
 
 			bool ok = false;
 			auto address = object.value("address").toString().toULongLong(&ok, 16);
@@ -733,7 +802,7 @@ void HyprlandIpc::refreshToplevels() {
 			auto exists = toplevel != nullptr;
 
 			if (!exists) toplevel = new HyprlandToplevel(this);
-			toplevel->updateFromObject(object);
+			if (!toplevel->updateFromJson(object)) continue;
 
 			if (!exists) {
 				qCDebug(logHyprlandIpc) << "New toplevel created with address" << address;
@@ -799,11 +868,17 @@ void HyprlandIpc::onFocusedMonitorDestroyed() {
 }
 
 void HyprlandIpc::refreshMonitors(bool canCreate) {
-	if (this->requestingMonitors) return;
-	this->requestingMonitors = true;
+	HyprlandIpc::queueRefresh(this->monitorsRefresh, canCreate);
+	this->scheduleRefresh();
+}
+
+void HyprlandIpc::requestMonitors() {
+	auto canCreate = this->monitorsRefresh.canCreate;
+	this->monitorsRefresh = {.requesting = true};
 
 	this->makeRequest("j/monitors", [this, canCreate](bool success, const QByteArray& resp) {
-		this->requestingMonitors = false;
+		this->monitorsRefresh.requesting = false;
+		if (this->monitorsRefresh.queued) this->scheduleRefresh();
 		if (!success) return;
 
 		this->monitorsRequested = true;
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <array>
 #include <functional>
 
 #include <qbytearrayview.h>
@@ -14,8 +15,8 @@
 
 #include "../../../core/model.hpp"
 #include "../../../core/qmlscreen.hpp"
-#include "../../../core/streamreader.hpp"
 #include "../../../wayland/toplevel/wlr_toplevel.hpp"
+#include "eventparser.hpp"
 
 namespace qs::hyprland::ipc {
 
@@ -58,10 +59,16 @@ public:
 	Q_INVOKABLE [[nodiscard]] QVector<QString> parse(qint32 argumentCount) const;
 	[[nodiscard]] QVector<QByteArrayView> parseView(qint32 argumentCount) const;
 
+	template <qsizetype Count>
+	[[nodiscard]] std::array<QByteArrayView, Count> args() const {
+		return splitEventArgs<Count>(this->data);
+	}
+
 	[[nodiscard]] QString nameStr() const;
 	[[nodiscard]] QString dataStr() const;
 
 	void reset();
+	HyprlandEventType type = HyprlandEventType::Unknown;
 	QByteArrayView name;
 	QByteArrayView data;
 };
@@ -106,7 +113,9 @@ public:
 	HyprlandMonitor* findMonitorByName(const QString& name, bool createIfMissing, qint32 id = -1);
 	HyprlandToplevel* findToplevelByAddress(quint64 address, bool createIfMissing);
 
-	// canCreate avoids making ghost workspaces when the connection races
+	// canCreate avoids making ghost workspaces when the connection races.
+	// Refreshes are coalesced until the next event loop iteration, and a refresh requested
+	// while one is in flight is re-sent once it completes.
 	void refreshWorkspaces(bool canCreate);
 	void refreshMonitors(bool canCreate);
 	void refreshToplevels();
@@ -139,14 +148,29 @@ private:
 
 	static bool compareWorkspaces(HyprlandWorkspace* a, HyprlandWorkspace* b);
 
+	struct RefreshState {
+		bool queued = false;
+		bool requesting = false;
+		bool canCreate = false;
+	};
+
+	static void queueRefresh(RefreshState& state, bool canCreate);
+	void scheduleRefresh();
+	void runQueuedRefreshes();
+
+	void requestWorkspaces();
+	void requestMonitors();
+	void requestToplevels();
+
 	QLocalSocket eventSocket;
-	StreamReader eventReader;
+	HyprlandEventTokenizer eventTokenizer;
 	QString mRequestSocketPath;
 	QString mEventSocketPath;
 	bool valid = false;
-	bool requestingMonitors = false;
-	bool requestingWorkspaces = false;
-	bool requestingToplevels = false;
+	RefreshState monitorsRefresh;
+	RefreshState workspacesRefresh;
+	RefreshState toplevelsRefresh;
+	bool refreshScheduled = false;
 	bool monitorsRequested = false;
 
 	ObjectModel<HyprlandMonitor> mMonitors {this};
@@ -0,0 +1,142 @@
+#include "eventparser.hpp"
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+#include <qbytearrayview.h>
+#include <qiodevice.h>
+#include <qtypes.h>
+
+namespace qs::hyprland::ipc {
+
+namespace {
+
+struct EventName {
+	QByteArrayView name;
+	HyprlandEventType type;
+};
+
+constexpr auto EVENT_NAMES = std::to_array<EventName>({
+    {"configreloaded", HyprlandEventType::ConfigReloaded},
+    {"monitoraddedv2", HyprlandEventType::MonitorAddedV2},
+    {"monitorremoved", HyprlandEventType::MonitorRemoved},
+    {"createworkspacev2", HyprlandEventType::CreateWorkspaceV2},
+    {"destroyworkspacev2", HyprlandEventType::DestroyWorkspaceV2},
+    {"focusedmon", HyprlandEventType::FocusedMon},
+    {"workspacev2", HyprlandEventType::WorkspaceV2},
+    {"moveworkspacev2", HyprlandEventType::MoveWorkspaceV2},
+    {"renameworkspace", HyprlandEventType::RenameWorkspace},
+    {"fullscreen", HyprlandEventType::Fullscreen},
+    {"openwindow", HyprlandEventType::OpenWindow},
+    {"closewindow", HyprlandEventType::CloseWindow},
+    {"movewindowv2", HyprlandEventType::MoveWindowV2},
+    {"windowtitlev2", HyprlandEventType::WindowTitleV2},
+    {"activewindowv2", HyprlandEventType::ActiveWindowV2},
+    {"urgent", HyprlandEventType::Urgent},
+});
+
+constexpr qsizetype EVENT_TABLE_SIZE = 32;
+
+// Chosen to be collision free over EVENT_NAMES. Adding an event may require new constants,
+// which the static_assert below enforces.
+constexpr quint32 eventNameHash(QByteArrayView name) {
+	auto size = static_cast<quint32>(name.size());
+	auto first = static_cast<quint8>(name.at(0));
+	auto middle = static_cast<quint8>(name.at(name.size() / 2));
+	return (size * 3 + first * 5 + middle) % EVENT_TABLE_SIZE;
+}
+
+constexpr bool eventNamesCollisionFree() {
+	auto used = std::array<bool, EVENT_TABLE_SIZE>();
+
+	for (const auto& entry: EVENT_NAMES) {
+		auto& slot = used.at(eventNameHash(entry.name));
+		if (slot) return false;
+		slot = true;
+	}
+
+	return true;
+}
+
+static_assert(eventNamesCollisionFree(), "Hyprland event name hash has collisions");
+
+// Index into EVENT_NAMES by hash, or -1.
+constexpr auto EVENT_TABLE = []() {
+	auto table = std::array<qint8, EVENT_TABLE_SIZE>();
+	table.fill(-1);
+
+	for (auto i = 0; i != static_cast<qint32>(EVENT_NAMES.size()); i++) {
+		table.at(eventNameHash(EVENT_NAMES.at(i).name)) = static_cast<qint8>(i);
+	}
+
+	return table;
+}();
+
+} // namespace
+
+HyprlandEventType hyprlandEventType(QByteArrayView name) {
+	if (name.isEmpty()) return HyprlandEventType::Unknown;
+
+	auto index = EVENT_TABLE.at(eventNameHash(name));
+	if (index == -1) return HyprlandEventType::Unknown;
+
+	const auto& entry = EVENT_NAMES.at(index);
+	return entry.name == name ? entry.type : HyprlandEventType::Unknown;
+}
+
+bool HyprlandEventTokenizer::fill(QIODevice* device) {
+	this->compact();
+
+	auto available = device->bytesAvailable();
+	if (available <= 0) return false;
+
+	auto oldSize = this->buffer.size();
+	this->buffer.resize(oldSize + available);
+	auto bytesRead = device->read(this->buffer.data() + oldSize, available); // NOLINT
+
+	this->buffer.resize(oldSize + std::max<qint64>(bytesRead, 0));
+	return bytesRead > 0;
+}
+
+void HyprlandEventTokenizer::append(QByteArrayView data) {
+	this->compact();
+	this->buffer.append(data);
+}
+
+bool HyprlandEventTokenizer::next(QByteArrayView& name, QByteArrayView& data) {
+	const auto* start = this->buffer.constData() + this->cursor; // NOLINT
+	auto remaining = static_cast<size_t>(this->buffer.size() - this->cursor);
+
+	const auto* end = static_cast<const char*>(std::memchr(start, '\n', remaining));
+	if (!end) return false;
+
+	auto line = QByteArrayView(start, end);
+	this->cursor += line.size() + 1;
+
+	auto splitIdx = line.indexOf(">>");
+
+	if (splitIdx == -1) {
+		name = line;
+		data = QByteArrayView();
+	} else {
+		name = line.first(splitIdx);
+		data = line.sliced(splitIdx + 2);
+	}
+
+	return true;
+}
+
+void HyprlandEventTokenizer::reset() {
+	this->buffer.clear();
+	this->cursor = 0;
+}
+
+void HyprlandEventTokenizer::compact() {
+	if (this->cursor == 0) return;
+
+	// Removing from the front of an unshared QByteArray keeps its capacity.
+	this->buffer.remove(0, this->cursor);
+	this->cursor = 0;
+}
+
+} // namespace qs::hyprland::ipc
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <array>
+
+#include <qbytearray.h>
+#include <qbytearrayview.h>
+#include <qiodevice.h>
+#include <qtypes.h>
+
+namespace qs::hyprland::ipc {
+
+enum class HyprlandEventType : quint8 {
+	Unknown,
+	ConfigReloaded,
+	MonitorAddedV2,
+	MonitorRemoved,
+	CreateWorkspaceV2,
+	DestroyWorkspaceV2,
+	FocusedMon,
+	WorkspaceV2,
+	MoveWorkspaceV2,
+	RenameWorkspace,
+	Fullscreen,
+	OpenWindow,
+	CloseWindow,
+	MoveWindowV2,
+	WindowTitleV2,
+	ActiveWindowV2,
+	Urgent,
+};
+
+// Resolves an event name with a perfect hash, costing one table lookup and one comparison.
+// Events quickshell does not handle resolve to Unknown.
+HyprlandEventType hyprlandEventType(QByteArrayView name);
+
+// Splits event data into a known number of arguments. The last argument may contain commas.
+// Missing arguments are left empty.
+template <qsizetype Count>
+std::array<QByteArrayView, Count> splitEventArgs(QByteArrayView data) {
+	auto args = std::array<QByteArrayView, Count>();
+	qsizetype i = 0;
+
+	for (; i < Count - 1; i++) {
+		auto splitIdx = data.indexOf(',');
+		if (splitIdx == -1) break;
+		args[i] = data.sliced(0, splitIdx);
+		data = data.sliced(splitIdx + 1);
+	}
+
+	if (!data.isEmpty()) args[i] = data;
+	return args;
+}
+
+// Splits the hyprland event socket stream into events without copying them.
+//
+// Read bytes are consumed by moving a cursor, and only the trailing partial event is moved to
+// the front of the buffer on the next fill, so steady state parsing does not allocate.
+class HyprlandEventTokenizer {
+public:
+	// Reads all available bytes from the device. Invalidates previously returned events.
+	bool fill(QIODevice* device);
+	// Appends bytes to the buffer. Invalidates previously returned events.
+	void append(QByteArrayView data);
+
+	// Returns the next complete event, if any. The returned views point into the tokenizer's
+	// buffer and are valid until the next call to fill(), append() or reset().
+	bool next(QByteArrayView& name, QByteArrayView& data);
+
+	void reset();
+
+private:
+	void compact();
+
+	QByteArray buffer;
+	qsizetype cursor = 0;
+};
+
+} // namespace qs::hyprland::ipc
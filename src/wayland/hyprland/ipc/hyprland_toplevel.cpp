@@ -1,6 +1,7 @@
 #include "hyprland_toplevel.hpp"
 
 #include <qcontainerfwd.h>
+#include <qjsonobject.h>
 #include <qobject.h>
 #include <qproperty.h>
 #include <qtmetamacros.h>
@@ -65,9 +66,21 @@ void HyprlandToplevel::updateInitial(
 	Qt::endPropertyUpdateGroup();
 }
 
-void HyprlandToplevel::updateFromObject(const QVariantMap& object) {
-	auto addressStr = object.value("address").value<QString>();
-	auto title = object.value("title").value<QString>();
+bool HyprlandToplevel::updateFromJson(const QJsonObject& object) {
+	auto addressStr = object.value("address").toString();
+	auto title = object.value("title").toString();
+	auto workspaceName = object.value("workspace").toObject().value("name").toString();
+
+	// Most clients are unchanged between refreshes, so skip converting them to a QVariantMap.
+	// Title and workspace are also updated by events, so they are checked separately.
+	auto* currentWorkspace = this->bWorkspace.value();
+	if (object == this->mLastJson && title == this->bTitle.value() && currentWorkspace
+	    && currentWorkspace->bindableName().value() == workspaceName)
+	{
+		return false;
+	}
+
+	this->mLastJson = object;
 
 	Qt::beginPropertyUpdateGroup();
 	bool ok = false;
@@ -76,14 +89,13 @@ void HyprlandToplevel::updateFromObject(const QVariantMap& object) {
 
 	this->bTitle = title;
 
-	auto workspaceMap = object.value("workspace").toMap();
-	auto workspaceName = workspaceMap.value("name").toString();
-
 	auto* workspace = this->ipc->findWorkspaceByName(workspaceName, true);
 	if (workspace) this->setWorkspace(workspace);
 
-	this->bLastIpcObject = object;
+	this->bLastIpcObject = object.toVariantMap();
 	Qt::endPropertyUpdateGroup();
+
+	return true;
 }
 
 void HyprlandToplevel::setWorkspace(HyprlandWorkspace* workspace) {
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <qcontainerfwd.h>
+#include <qjsonobject.h>
 #include <qobject.h>
 #include <qproperty.h>
 #include <qqmlintegration.h>
@@ -59,7 +60,8 @@ public:
 
 	void updateInitial(quint64 address, const QString& title, const QString& workspaceName);
 
-	void updateFromObject(const QVariantMap& object);
+	// Returns false if the object is identical to the last one and nothing was updated.
+	bool updateFromJson(const QJsonObject& object);
 
 	[[nodiscard]] QString addressStr() const { return QString::number(this->mAddress, 16); }
 	[[nodiscard]] quint64 address() const { return this->mAddress; }
@@ -107,6 +109,7 @@ private:
 
 	qs::wayland::toplevel::wlr::ToplevelHandle* mWaylandHandle = nullptr;
 	HyprlandToplevel* mHyprlandHandle = nullptr;
+	QJsonObject mLastJson;
 
 	// clang-format off
 	Q_OBJECT_BINDABLE_PROPERTY(HyprlandToplevel, QString, bTitle, &HyprlandToplevel::titleChanged);
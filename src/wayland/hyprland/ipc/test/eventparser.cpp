@@ -0,0 +1,197 @@
+#include "eventparser.hpp"
+
+#include <qbuffer.h>
+#include <qbytearray.h>
+#include <qbytearrayview.h>
+#include <qfile.h>
+#include <qiodevice.h>
+#include <qlist.h>
+#include <qobject.h>
+#include <qpair.h>
+#include <qtenvironmentvariables.h>
+#include <qtest.h>
+#include <qtestcase.h>
+#include <qtypes.h>
+
+#include "../eventparser.hpp"
+
+using namespace qs::hyprland::ipc;
+
+namespace {
+
+// Recorded from the event socket while switching workspaces across two monitors.
+constexpr const char* WORKSPACE_SWITCH_LOG = "workspace>>2\n"
+                                             "workspacev2>>2,2\n"
+                                             "activewindow>>kitty,~\n"
+                                             "activewindowv2>>55d1c8a3e2f0\n"
+                                             "focusedmon>>DP-1,3\n"
+                                             "focusedmonv2>>DP-1,3\n"
+                                             "workspace>>3\n"
+                                             "workspacev2>>3,3\n"
+                                             "activewindow>>firefox,Hyprland Wiki — Mozilla Firefox\n"
+                                             "activewindowv2>>55d1c8b01a40\n"
+                                             "windowtitle>>55d1c8b01a40\n"
+                                             "windowtitlev2>>55d1c8b01a40,IPC, Events — Firefox\n"
+                                             "focusedmon>>HDMI-A-1,1\n"
+                                             "focusedmonv2>>HDMI-A-1,1\n"
+                                             "workspace>>1\n"
+                                             "workspacev2>>1,1\n"
+                                             "fullscreen>>0\n"
+                                             "activewindow>>,\n"
+                                             "activewindowv2>>\n"
+                                             "movewindow>>55d1c8a3e2f0,4\n"
+                                             "movewindowv2>>55d1c8a3e2f0,4,4\n"
+                                             "createworkspace>>special:scratch\n"
+                                             "createworkspacev2>>-98,special:scratch\n"
+                                             "destroyworkspace>>special:scratch\n"
+                                             "destroyworkspacev2>>-98,special:scratch\n";
+
+QList<QPair<QByteArray, QByteArray>> drain(HyprlandEventTokenizer& tokenizer) {
+	auto events = QList<QPair<QByteArray, QByteArray>>();
+	auto name = QByteArrayView();
+	auto data = QByteArrayView();
+
+	while (tokenizer.next(name, data)) {
+		events.append({name.toByteArray(), data.toByteArray()});
+	}
+
+	return events;
+}
+
+} // namespace
+
+void TestHyprlandEventParser::tokenize() {
+	auto bytes = QByteArray("workspacev2>>2,2\nconfigreloaded>>\nnodata\nfocusedmon>>DP-1,3\n");
+	auto buffer = QBuffer(&bytes);
+	buffer.open(QIODevice::ReadOnly);
+
+	auto tokenizer = HyprlandEventTokenizer();
+	QVERIFY(tokenizer.fill(&buffer));
+
+	auto events = drain(tokenizer);
+	QCOMPARE(events.length(), 4);
+	QCOMPARE(events.at(0), qMakePair(QByteArray("workspacev2"), QByteArray("2,2")));
+	QCOMPARE(events.at(1), qMakePair(QByteArray("configreloaded"), QByteArray()));
+	QCOMPARE(events.at(2), qMakePair(QByteArray("nodata"), QByteArray()));
+	QCOMPARE(events.at(3), qMakePair(QByteArray("focusedmon"), QByteArray("DP-1,3")));
+
+	QVERIFY(!tokenizer.fill(&buffer));
+}
+
+void TestHyprlandEventParser::tokenizeChunked() {
+	auto log = QByteArray(WORKSPACE_SWITCH_LOG);
+
+	auto expected = QList<QPair<QByteArray, QByteArray>>();
+	for (const auto& line: log.split('\n')) {
+		if (line.isEmpty()) continue;
+		auto splitIdx = line.indexOf(">>");
+		expected.append({line.first(splitIdx), line.sliced(splitIdx + 2)});
+	}
+
+	for (qsizetype chunkSize: {1, 3, 7, 64, 4096}) {
+		auto tokenizer = HyprlandEventTokenizer();
+		auto events = QList<QPair<QByteArray, QByteArray>>();
+
+		for (qsizetype i = 0; i < log.size(); i += chunkSize) {
+			tokenizer.append(QByteArrayView(log).sliced(i, qMin(chunkSize, log.size() - i)));
+			events.append(drain(tokenizer));
+		}
+
+		QCOMPARE(events, expected);
+	}
+}
+
+void TestHyprlandEventParser::eventType_data() { // NOLINT
+	QTest::addColumn<QByteArray>("name");
+	QTest::addColumn<HyprlandEventType>("type");
+
+	// clang-format off
+	QTest::addRow("configreloaded") << QByteArray("configreloaded") << HyprlandEventType::ConfigReloaded;
+	QTest::addRow("monitoraddedv2") << QByteArray("monitoraddedv2") << HyprlandEventType::MonitorAddedV2;
+	QTest::addRow("monitorremoved") << QByteArray("monitorremoved") << HyprlandEventType::MonitorRemoved;
+	QTest::addRow("createworkspacev2") << QByteArray("createworkspacev2") << HyprlandEventType::CreateWorkspaceV2;
+	QTest::addRow("destroyworkspacev2") << QByteArray("destroyworkspacev2") << HyprlandEventType::DestroyWorkspaceV2;
+	QTest::addRow("focusedmon") << QByteArray("focusedmon") << HyprlandEventType::FocusedMon;
+	QTest::addRow("workspacev2") << QByteArray("workspacev2") << HyprlandEventType::WorkspaceV2;
+	QTest::addRow("moveworkspacev2") << QByteArray("moveworkspacev2") << HyprlandEventType::MoveWorkspaceV2;
+	QTest::addRow("renameworkspace") << QByteArray("renameworkspace") << HyprlandEventType::RenameWorkspace;
+	QTest::addRow("fullscreen") << QByteArray("fullscreen") << HyprlandEventType::Fullscreen;
+	QTest::addRow("openwindow") << QByteArray("openwindow") << HyprlandEventType::OpenWindow;
+	QTest::addRow("closewindow") << QByteArray("closewindow") << HyprlandEventType::CloseWindow;
+	QTest::addRow("movewindowv2") << QByteArray("movewindowv2") << HyprlandEventType::MoveWindowV2;
+	QTest::addRow("windowtitlev2") << QByteArray("windowtitlev2") << HyprlandEventType::WindowTitleV2;
+	QTest::addRow("activewindowv2") << QByteArray("activewindowv2") << HyprlandEventType::ActiveWindowV2;
+	QTest::addRow("urgent") << QByteArray("urgent") << HyprlandEventType::Urgent;
+
+	QTest::addRow("v1 workspace") << QByteArray("workspace") << HyprlandEventType::Unknown;
+	QTest::addRow("v1 activewindow") << QByteArray("activewindow") << HyprlandEventType::Unknown;
+	QTest::addRow("focusedmonv2") << QByteArray("focusedmonv2") << HyprlandEventType::Unknown;
+	QTest::addRow("prefix") << QByteArray("urgen") << HyprlandEventType::Unknown;
+	QTest::addRow("empty") << QByteArray() << HyprlandEventType::Unknown;
+	// clang-format on
+}
+
+void TestHyprlandEventParser::eventType() {
+	QFETCH(QByteArray, name);
+	QFETCH(HyprlandEventType, type);
+
+	QCOMPARE(hyprlandEventType(name), type);
+}
+
+void TestHyprlandEventParser::args() {
+	auto three = splitEventArgs<3>("55d1c8a3e2f0,4,name, with, commas");
+	QCOMPARE(three.at(0), "55d1c8a3e2f0");
+	QCOMPARE(three.at(1), "4");
+	QCOMPARE(three.at(2), "name, with, commas");
+
+	auto missing = splitEventArgs<3>("1");
+	QCOMPARE(missing.at(0), "1");
+	QVERIFY(missing.at(1).isEmpty());
+	QVERIFY(missing.at(2).isEmpty());
+
+	auto empty = splitEventArgs<2>("");
+	QVERIFY(empty.at(0).isEmpty());
+	QVERIFY(empty.at(1).isEmpty());
+}
+
+void TestHyprlandEventParser::benchmarkReplay() {
+	// A captured event log can be replayed instead of the built in one, e.g. one recorded with
+	// `socat -u UNIX-CONNECT:$XDG_RUNTIME_DIR/hypr/$HYPRLAND_INSTANCE_SIGNATURE/.socket2.sock -`.
+	auto log = QByteArray();
+	auto logPath = qEnvironmentVariable("QS_HYPRLAND_EVENT_LOG");
+
+	if (!logPath.isEmpty()) {
+		auto file = QFile(logPath);
+		QVERIFY(file.open(QIODevice::ReadOnly));
+		log = file.readAll();
+	} else {
+		log = QByteArray(WORKSPACE_SWITCH_LOG).repeated(2000);
+	}
+
+	// Socket reads deliver the stream in arbitrary chunks.
+	constexpr qsizetype CHUNK_SIZE = 4096;
+	auto tokenizer = HyprlandEventTokenizer();
+	qsizetype handled = 0;
+
+	QBENCHMARK {
+		tokenizer.reset();
+		handled = 0;
+
+		for (qsizetype i = 0; i < log.size(); i += CHUNK_SIZE) {
+			tokenizer.append(QByteArrayView(log).sliced(i, qMin(CHUNK_SIZE, log.size() - i)));
+
+			auto name = QByteArrayView();
+			auto data = QByteArrayView();
+
+			while (tokenizer.next(name, data)) {
+				if (hyprlandEventType(name) == HyprlandEventType::Unknown) continue;
+				auto args = splitEventArgs<3>(data);
+				handled += args.at(0).size();
+			}
+		}
+	}
+
+	QVERIFY(handled != 0);
+}
+
+QTEST_MAIN(TestHyprlandEventParser);
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <qobject.h>
+#include <qtmetamacros.h>
+
+class TestHyprlandEventParser: public QObject {
+	Q_OBJECT;
+
+private slots:
+	void tokenize();
+	void tokenizeChunked();
+	void eventType_data(); // NOLINT
+	void eventType();
+	void args();
+	void benchmarkReplay();
+};